@@ -36,6 +36,7 @@ ConnectionConfig::ConnectionConfig()
   m_requestSharedSession(true), m_deiconifyOnRemoteBell(false),
   m_isClipboardEnabled(true),
   m_customCompressionLevel(-1), m_jpegCompressionLevel(6),
+  m_isAutoTuningEnabled(false),
   m_fitWindow(false), m_requestShapeUpdates(true),
   m_ignoreShapeUpdates(false), m_scaleNumerator(1), m_scaleDenominator(1),
   m_localCursor(DOT_CURSOR), m_allowedCopyRect(true)
@@ -58,6 +59,7 @@ ConnectionConfig& ConnectionConfig::operator=(const ConnectionConfig& other)
   bool use8BitColor;
   int customCompressionLevel;
   int jpegCompressionLevel;
+  bool isAutoTuningEnabled;
   bool viewOnly;
   bool isClipboardEnabled;
   bool useFullscreen;
@@ -78,6 +80,7 @@ ConnectionConfig& ConnectionConfig::operator=(const ConnectionConfig& other)
     use8BitColor = other.m_use8BitColor;
     customCompressionLevel = other.m_customCompressionLevel;
     jpegCompressionLevel = other.m_jpegCompressionLevel;
+    isAutoTuningEnabled = other.m_isAutoTuningEnabled;
     viewOnly = other.m_viewOnly;
     isClipboardEnabled = other.m_isClipboardEnabled;
     useFullscreen = other.m_useFullscreen;
@@ -99,6 +102,7 @@ ConnectionConfig& ConnectionConfig::operator=(const ConnectionConfig& other)
     m_use8BitColor = use8BitColor;
     m_customCompressionLevel = customCompressionLevel;
     m_jpegCompressionLevel = jpegCompressionLevel;
+    m_isAutoTuningEnabled = isAutoTuningEnabled;
     m_viewOnly = viewOnly;
     m_isClipboardEnabled = isClipboardEnabled;
     m_useFullscreen = useFullscreen;
@@ -139,6 +143,18 @@ int ConnectionConfig::getPreferredEncoding()
   return m_preferredEncoding;
 }
 
+void ConnectionConfig::enableAutoTuning(bool enabled)
+{
+  AutoLock l(&m_cs);
+  m_isAutoTuningEnabled = enabled;
+}
+
+bool ConnectionConfig::isAutoTuningEnabled()
+{
+  AutoLock l(&m_cs);
+  return m_isAutoTuningEnabled;
+}
+
 void ConnectionConfig::use8BitColor(bool use)
 {
   AutoLock l(&m_cs);
@@ -400,6 +416,7 @@ bool ConnectionConfig::saveToStorage(SettingsManager *sm) const
   TEST_FAIL(sm->setBoolean(_T("fitwindow"),        m_fitWindow), saveAllOk);
   TEST_FAIL(sm->setBoolean(_T("cursorshape"),      m_requestShapeUpdates), saveAllOk);
   TEST_FAIL(sm->setBoolean(_T("noremotecursor"),   m_ignoreShapeUpdates), saveAllOk);
+  TEST_FAIL(sm->setBoolean(_T("autotuning"),       m_isAutoTuningEnabled), saveAllOk);
 
   TEST_FAIL(sm->setByte(_T("preferred_encoding"),  m_preferredEncoding), saveAllOk);
   TEST_FAIL(sm->setInt(_T("compresslevel"),        m_customCompressionLevel), saveAllOk);
@@ -439,6 +456,8 @@ bool ConnectionConfig::loadFromStorage(SettingsManager *sm)
   TEST_FAIL(sm->getBoolean(_T("fitwindow"),        &m_fitWindow), loadAllOk);
   TEST_FAIL(sm->getBoolean(_T("cursorshape"),      &m_requestShapeUpdates), loadAllOk);
   TEST_FAIL(sm->getBoolean(_T("noremotecursor"),   &m_ignoreShapeUpdates), loadAllOk);
+  // Older settings have no "autotuning" option, then it stays disabled.
+  sm->getBoolean(_T("autotuning"), &m_isAutoTuningEnabled);
 
   TEST_FAIL(sm->getByte(_T("preferred_encoding"),  (char *)&m_preferredEncoding), loadAllOk);
 
@@ -61,6 +61,13 @@ public:
   // Returns prefered encoding
   int getPreferredEncoding();
 
+  // Sets auto-tuning flag: the viewer chooses the encoding, the compression
+  // level and the jpeg quality level from the measured updates instead of
+  // the preferred ones.
+  void enableAutoTuning(bool enabled);
+  // Returns auto-tuning flag
+  bool isAutoTuningEnabled();
+
   // Sets 8 bit flag
   void use8BitColor(bool use);
 
@@ -192,6 +199,8 @@ protected:
   int m_customCompressionLevel;
   // Jpeg compression level
   int m_jpegCompressionLevel;
+  // Choose the encoding and the levels automatically
+  bool m_isAutoTuningEnabled;
 
   //
   // "Restrictions" group members
@@ -23,13 +23,40 @@
 //
 
 #include "BlockingGate.h"
+#include "thread/AutoLock.h"
 
 BlockingGate::BlockingGate(Channel *stream)
-: DataInputStream(stream),
-  DataOutputStream(stream)
+: DataInputStream(&m_bufferedInput),
+  DataOutputStream(&m_bufferedOutput),
+  m_flushingInput(stream, this),
+  m_bufferedInput(&m_flushingInput),
+  m_bufferedOutput(stream)
 {
 }
 
 BlockingGate::~BlockingGate()
 {
 }
+
+void BlockingGate::flush()
+{
+  AutoLock al(this);
+  m_bufferedOutput.flush();
+}
+
+BlockingGate::FlushingInput::FlushingInput(Channel *channel,
+                                           BlockingGate *gate)
+: m_channel(channel),
+  m_gate(gate)
+{
+}
+
+BlockingGate::FlushingInput::~FlushingInput()
+{
+}
+
+size_t BlockingGate::FlushingInput::read(void *buffer, size_t len)
+{
+  m_gate->flush();
+  return m_channel->read(buffer, len);
+}
@@ -29,13 +29,44 @@
 #include "io-lib/Channel.h"
 #include "io-lib/DataOutputStream.h"
 #include "io-lib/DataInputStream.h"
+#include "io-lib/BufferedInputStream.h"
+#include "io-lib/BufferedOutputStream.h"
 
+// Buffered gate to a channel. Written data is kept in the gate until the
+// flush() call, so a whole message goes by a single channel write. Reading
+// goes through a read-ahead buffer, so small fields of a message don't cost
+// a channel read each.
 class BlockingGate : public LocalMutex, public DataOutputStream,
                      public DataInputStream
 {
 public:
   BlockingGate(Channel *stream);
   virtual ~BlockingGate();
+
+  // Writes the buffered data to the channel. A sender must call it at the
+  // end of each message which is not followed by reading from this gate.
+  // The gate flushes itself before it waits for data from the channel, so
+  // a request can never stay in the buffer while its reply is expected.
+  void flush();
+
+private:
+  // Reads from the channel flushing the gate output beforehand.
+  class FlushingInput : public InputStream
+  {
+  public:
+    FlushingInput(Channel *channel, BlockingGate *gate);
+    virtual ~FlushingInput();
+
+    virtual size_t read(void *buffer, size_t len);
+
+  private:
+    Channel *m_channel;
+    BlockingGate *m_gate;
+  };
+
+  FlushingInput m_flushingInput;
+  BufferedInputStream m_bufferedInput;
+  BufferedOutputStream m_bufferedOutput;
 };
 
 #endif // _BLOCKING_GATE_H_
@@ -40,6 +40,7 @@ void DesktopConfigClient::updateByNewSettings(BlockingGate *gate)
   AutoLock al(gate);
   gate->writeUInt8(CONFIG_RELOAD_REQ);
   sendConfigSettings(gate);
+  gate->flush();
 }
 
 bool DesktopConfigClient::isRemoteInputAllowed()
@@ -226,37 +226,37 @@ void DesktopServerProto::readNewClipboard(StringStorage *newClipboard,
 }
 
 void DesktopServerProto::sendNewPointerPos(const Point *newPos, UINT8 keyFlag,
-                                           BlockingGate *gate)
+                                           DataOutputStream *output)
 {
   // Send pointer position
-  gate->writeUInt16(newPos->x);
-  gate->writeUInt16(newPos->y);
+  output->writeUInt16(newPos->x);
+  output->writeUInt16(newPos->y);
   // Send key flags
-  gate->writeUInt8(keyFlag);
+  output->writeUInt8(keyFlag);
 }
 
 void DesktopServerProto::readNewPointerPos(Point *newPos, UINT8 *keyFlag,
-                                           BlockingGate *gate)
+                                           DataInputStream *input)
 {
   // Read pointer position
-  newPos->x = gate->readUInt16();
-  newPos->y = gate->readUInt16();
+  newPos->x = input->readUInt16();
+  newPos->y = input->readUInt16();
   // Read key flags
-  *keyFlag = gate->readUInt8();
+  *keyFlag = input->readUInt8();
 }
 
 void DesktopServerProto::sendKeyEvent(UINT32 keySym, bool down,
-                                      BlockingGate *gate)
+                                      DataOutputStream *output)
 {
-  gate->writeUInt32(keySym);
-  gate->writeUInt8((UINT8)down);
+  output->writeUInt32(keySym);
+  output->writeUInt8((UINT8)down);
 }
 
 void DesktopServerProto::readKeyEvent(UINT32 *keySym, bool *down,
-                                      BlockingGate *gate)
+                                      DataInputStream *input)
 {
-  *keySym = gate->readUInt32();
-  *down = gate->readUInt8() != 0;
+  *keySym = input->readUInt32();
+  *down = input->readUInt8() != 0;
 }
 
 void DesktopServerProto::sendUserInfo(const StringStorage *desktopName,
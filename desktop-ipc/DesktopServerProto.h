@@ -67,14 +67,16 @@ protected:
                                 BlockingGate *gate);
   virtual void readNewClipboard(StringStorage *newClipboard,
                                 BlockingGate *gate);
+  // The input events are also written to and read from the INPUT_BATCH
+  // messages, so they work on any data stream.
   virtual void sendNewPointerPos(const Point *newPos, UINT8 keyFlag,
-                                 BlockingGate *gate);
+                                 DataOutputStream *output);
   virtual void readNewPointerPos(Point *newPos, UINT8 *keyFlag,
-                                 BlockingGate *gate);
+                                 DataInputStream *input);
   virtual void sendKeyEvent(UINT32 keySym, bool down,
-                            BlockingGate *gate);
+                            DataOutputStream *output);
   virtual void readKeyEvent(UINT32 *keySym, bool *down,
-                            BlockingGate *gate);
+                            DataInputStream *input);
   virtual void sendUserInfo(const StringStorage *desktopName,
                             const StringStorage *userName,
                             BlockingGate *gate);
@@ -88,12 +90,15 @@ protected:
   // Forward gate will send requests
   BlockingGate *m_forwGate;
 
-  static const UINT8 EXTRACT_REQ = 0;
   static const UINT8 SCREEN_PROP_REQ = 1;
   static const UINT8 FRAME_BUFFER_INIT = 2;
   static const UINT8 SET_FULL_UPD_REQ_REGION = 3;
   static const UINT8 SET_EXCLUDING_REGION = 4;
-  static const UINT8 UPDATE_DETECTED = 10;
+  // The client has taken the last pushed update, so the server can push
+  // the next one.
+  static const UINT8 UPDATE_CONSUMED = 5;
+  // An update container pushed by the server without a request.
+  static const UINT8 UPDATE_PUSHED = 11;
 
   static const UINT8 CLIPBOARD_CHANGED = 30;
   static const UINT8 POINTER_POS_CHANGED = 31;
@@ -106,6 +111,9 @@ protected:
   static const UINT8 DISPLAY_NUMBER_COORDS_REQ = 38;
   static const UINT8 APPLICATION_REGION_REQ = 39;
   static const UINT8 NORMALIZE_RECT_REQ = 40;
+  // UINT32 length of the rest, UINT32 number of events and the events, each
+  // one is a POINTER_POS_CHANGED or KEYBOARD_EVENT code with its data.
+  static const UINT8 INPUT_BATCH = 41;
 
   static const UINT8 CONFIG_RELOAD_REQ = 50;
   static const UINT8 SOFT_INPUT_ENABLING_REQ = 51;
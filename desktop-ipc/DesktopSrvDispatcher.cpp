@@ -67,6 +67,8 @@ void DesktopSrvDispatcher::execute()
         throw Exception(errMess.getString());
       }
       (*iter).second->onRequest(code, m_gate);
+      // Send the reply (if any) by a single write.
+      m_gate->flush();
     } catch (ReconnectException &) {
       m_log->message(_T("The DesktopServerApplication dispatcher has been reconnected"));
     } catch (Exception &e) {
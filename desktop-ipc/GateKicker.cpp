@@ -50,6 +50,7 @@ void GateKicker::execute()
       try {
         AutoLock al(m_gate);
         m_gate->writeUInt8(255);
+        m_gate->flush();
       } catch (...) {
       }
     }
@@ -0,0 +1,118 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "SharedFrameBuffer.h"
+#include "util/Exception.h"
+
+SharedFrameBuffer::SharedFrameBuffer(UnnamedSharedMemory *memory)
+: m_memory(memory),
+  m_committedSize(0),
+  m_header((Header *)memory->getMemPointer()),
+  m_pixels((char *)memory->getMemPointer() + HEADER_SIZE),
+  m_pixelsSize(memory->getSize() > HEADER_SIZE ?
+               memory->getSize() - HEADER_SIZE : 0)
+{
+  _ASSERT(sizeof(Header) <= HEADER_SIZE);
+  _ASSERT(memory->getSize() >= HEADER_SIZE);
+}
+
+SharedFrameBuffer::~SharedFrameBuffer()
+{
+  // The buffer is not owned by the view.
+  m_view.setBuffer(0);
+}
+
+void SharedFrameBuffer::initMemory(UnnamedSharedMemory *memory)
+{
+  memory->commit(HEADER_SIZE);
+}
+
+bool SharedFrameBuffer::fits(const Dimension *dim,
+                             const PixelFormat *pf) const
+{
+  return (UINT64)dim->width * dim->height * (pf->bitsPerPixel / 8) <=
+         (UINT64)m_pixelsSize;
+}
+
+UINT32 SharedFrameBuffer::write(const FrameBuffer *srcFb,
+                                const std::vector<Rect> *rects)
+{
+  Dimension dim = srcFb->getDimension();
+  PixelFormat pf = srcFb->getPixelFormat();
+  if (!fits(&dim, &pf)) {
+    throw Exception(_T("The frame buffer does not fit to the shared memory"));
+  }
+  size_t usedSize = HEADER_SIZE +
+                    (size_t)dim.width * dim.height * (pf.bitsPerPixel / 8);
+  if (usedSize > m_committedSize) {
+    m_memory->commit(usedSize);
+    m_committedSize = usedSize;
+  }
+
+  // Odd sequence: the pixels are being changed.
+  InterlockedIncrement(&m_header->sequence);
+
+  m_header->width = dim.width;
+  m_header->height = dim.height;
+  m_header->pixelFormat = pf;
+  setViewProperties(&dim, &pf);
+
+  std::vector<Rect>::const_iterator iRect;
+  for (iRect = rects->begin(); iRect < rects->end(); iRect++) {
+    m_view.copyFrom(&(*iRect), srcFb, iRect->left, iRect->top);
+  }
+
+  return (UINT32)InterlockedIncrement(&m_header->sequence);
+}
+
+bool SharedFrameBuffer::read(UINT32 sequence, FrameBuffer *dstFb,
+                             const std::vector<Rect> *rects)
+{
+  Dimension dim = dstFb->getDimension();
+  PixelFormat pf = dstFb->getPixelFormat();
+
+  if ((UINT32)m_header->sequence != sequence) {
+    return false;
+  }
+  MemoryBarrier();
+  if (m_header->width != dim.width || m_header->height != dim.height ||
+      !m_header->pixelFormat.isEqualTo(&pf) || !fits(&dim, &pf)) {
+    return false;
+  }
+  setViewProperties(&dim, &pf);
+
+  std::vector<Rect>::const_iterator iRect;
+  for (iRect = rects->begin(); iRect < rects->end(); iRect++) {
+    dstFb->copyFrom(&(*iRect), &m_view, iRect->left, iRect->top);
+  }
+
+  MemoryBarrier();
+  return (UINT32)m_header->sequence == sequence;
+}
+
+void SharedFrameBuffer::setViewProperties(const Dimension *dim,
+                                          const PixelFormat *pf)
+{
+  m_view.setBuffer(m_pixels);
+  m_view.setPropertiesWithoutResize(dim, pf);
+}
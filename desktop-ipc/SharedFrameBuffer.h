@@ -0,0 +1,103 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef __SHAREDFRAMEBUFFER_H__
+#define __SHAREDFRAMEBUFFER_H__
+
+#include "util/CommonHeader.h"
+#include "rfb/FrameBuffer.h"
+#include "region/Rect.h"
+#include "win-system/UnnamedSharedMemory.h"
+
+#include <vector>
+
+// Frame buffer pixels placed in a memory block that is shared between the
+// service and the desktop server processes. Only one side (the desktop
+// server) writes to it, and the writer and the reader never work on it at
+// the same time by the protocol. A sequence number (seqlock) still protects
+// the reader from a writer which was left over from a previous connection:
+// it is odd while the writer changes the pixels.
+//
+// The memory may be only reserved: the writer commits the pages that the
+// current frame buffer needs before writing to them, so a small screen
+// doesn't take the memory of the largest one. The committed pages stay
+// committed until the memory is closed.
+class SharedFrameBuffer
+{
+public:
+  // The memory is not owned by the object. It must be prepared by the
+  // initMemory() function.
+  SharedFrameBuffer(UnnamedSharedMemory *memory);
+  virtual ~SharedFrameBuffer();
+
+  // Commits the header of a new memory block, which both sides read.
+  // Must be called by the creator of the memory before it is passed to
+  // the other process.
+  // @throw Exception
+  static void initMemory(UnnamedSharedMemory *memory);
+
+  // Returns true if a frame buffer with the given properties fits into the
+  // memory block.
+  bool fits(const Dimension *dim, const PixelFormat *pf) const;
+
+  // Copies the rects of the srcFb to the same positions of the shared
+  // pixels and returns the new sequence number that must be passed to the
+  // read() function by the other side.
+  // @throw Exception if the frame buffer does not fit or its pixels cannot
+  // be committed.
+  UINT32 write(const FrameBuffer *srcFb, const std::vector<Rect> *rects);
+
+  // Copies the rects from the shared pixels to the dstFb. Returns false if
+  // the shared pixels were not written with the given sequence number or
+  // with the dstFb properties, or were changed during the copying. The
+  // dstFb content of the rects is undefined in this case.
+  bool read(UINT32 sequence, FrameBuffer *dstFb,
+            const std::vector<Rect> *rects);
+
+private:
+  struct Header
+  {
+    volatile LONG sequence;
+    INT32 width;
+    INT32 height;
+    // Both processes are built from the same sources, so the layout of
+    // PixelFormat is the same on both sides.
+    PixelFormat pixelFormat;
+  };
+  static const size_t HEADER_SIZE = 64;
+
+  // Points m_view to the shared pixels with the given properties.
+  void setViewProperties(const Dimension *dim, const PixelFormat *pf);
+
+  UnnamedSharedMemory *m_memory;
+  // Size of the memory that is committed by this object.
+  size_t m_committedSize;
+
+  Header *m_header;
+  void *m_pixels;
+  size_t m_pixelsSize;
+
+  FrameBuffer m_view;
+};
+
+#endif // __SHAREDFRAMEBUFFER_H__
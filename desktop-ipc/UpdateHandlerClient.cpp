@@ -29,12 +29,15 @@
 UpdateHandlerClient::UpdateHandlerClient(BlockingGate *forwGate,
                                          DesktopSrvDispatcher *dispatcher,
                                          UpdateListener *externalUpdateListener,
+                                         SharedFrameBuffer *sharedFrameBuffer,
                                          LogWriter *log)
 : DesktopServerProto(forwGate),
   m_externalUpdateListener(externalUpdateListener),
+  m_sharedFrameBuffer(sharedFrameBuffer),
+  m_hasPushedUpdate(false),
   m_log(log)
 {
-  dispatcher->registerNewHandle(UPDATE_DETECTED, this);
+  dispatcher->registerNewHandle(UPDATE_PUSHED, this);
 
   // m_backupFrameBuffer building
   PixelFormat termPF;
@@ -42,6 +45,7 @@ UpdateHandlerClient::UpdateHandlerClient(BlockingGate *forwGate,
   getScreenProperties(&termPF, &termDim);
 
   m_backupFrameBuffer.setProperties(&termDim, &termPF);
+  m_pushFrameBuffer.setProperties(&termDim, &termPF);
 
   // Synchronize our FrameBuffer and the server FrameBuffer
   sendInit(m_forwGate);
@@ -54,7 +58,8 @@ UpdateHandlerClient::~UpdateHandlerClient()
 void UpdateHandlerClient::onRequest(UINT8 reqCode, BlockingGate *backGate)
 {
   switch (reqCode) {
-  case UPDATE_DETECTED:
+  case UPDATE_PUSHED:
+    receiveUpdate(backGate);
     m_externalUpdateListener->onUpdate();
     break;
   default:
@@ -66,103 +71,197 @@ void UpdateHandlerClient::onRequest(UINT8 reqCode, BlockingGate *backGate)
   }
 }
 
-void UpdateHandlerClient::extract(UpdateContainer *updateContainer)
+void UpdateHandlerClient::receiveUpdate(BlockingGate *gate)
 {
-  updateContainer->clear();
-
-  AutoLock al(m_forwGate);
+  AutoLock al(&m_pushLock);
 
   UpdateContainer updCont;
-  try {
-    m_log->info(_T("UpdateHandlerClient: send EXTRACT_REQ"));
-    m_forwGate->writeUInt8(EXTRACT_REQ); // query for extract
-
-    // Get screen size changed
-    updCont.screenSizeChanged = m_forwGate->readUInt8() != 0;
-
-    if (updCont.screenSizeChanged) {
-      m_log->info(_T("UpdateHandlerClient: screen size changed"));
-      // Store old screen properties
-      PixelFormat oldPf = m_backupFrameBuffer.getPixelFormat();
-      Dimension oldDim = m_backupFrameBuffer.getDimension();
-      // Get new screen properties
-      PixelFormat newPf;
-      readPixelFormat(&newPf, m_forwGate);
-      Dimension newDim = readDimension(m_forwGate);;
-      if (!newPf.isEqualTo(&oldPf) || !newDim.isEqualTo(&oldDim)) {
-        m_log->info(_T("UpdateHandlerClient: new screen size: %dx%d"), newDim.width,
-                                                                     newDim.height);
-        m_log->info(_T("UpdateHandlerClient: new pixel format: ")
-                  _T("%d, %d, %d, %d, %d, %d, %d, %d"),
-                                (int)newPf.bigEndian,
-                                (int)newPf.bitsPerPixel,
-                                (int)newPf.redMax,
-                                (int)newPf.greenMax,
-                                (int)newPf.blueMax,
-                                (int)newPf.redShift,
-                                (int)newPf.greenShift,
-                                (int)newPf.blueShift);
-        AutoLock al(&m_fbLocMut);
-        m_backupFrameBuffer.setProperties(&newDim, &newPf);
-      }
-      // Equalizing this frame buffer by other side frame buffer.
-      Rect fbRect = m_backupFrameBuffer.getDimension().getRect();
-      readFrameBuffer(&m_backupFrameBuffer, &fbRect, m_forwGate);
-    }
 
-    // Get video region
-    readRegion(&updCont.videoRegion, m_forwGate);
-    // Get changed region
-    unsigned int countChangedRect = m_forwGate->readUInt32();
-    m_log->info(_T("UpdateHandlerClient: count changed rectangles = %u"), countChangedRect);
-    for (unsigned int i = 0; i < countChangedRect; i++) {
-      Rect r = readRect(m_forwGate);
-      updCont.changedRegion.addRect(&r);
-      readFrameBuffer(&m_backupFrameBuffer, &r, m_forwGate);
+  // Get screen size changed
+  updCont.screenSizeChanged = gate->readUInt8() != 0;
+  // Get the place of the pixels
+  bool pixelsShared = gate->readUInt8() != 0;
+  UINT32 sequence = 0;
+  if (pixelsShared) {
+    sequence = gate->readUInt32();
+  }
+  // Rects with the shared pixels which are read after the whole message.
+  std::vector<Rect> pixelRects;
+
+  if (updCont.screenSizeChanged) {
+    m_log->info(_T("UpdateHandlerClient: screen size changed"));
+    // Store old screen properties
+    PixelFormat oldPf = m_pushFrameBuffer.getPixelFormat();
+    Dimension oldDim = m_pushFrameBuffer.getDimension();
+    // Get new screen properties
+    PixelFormat newPf;
+    readPixelFormat(&newPf, gate);
+    Dimension newDim = readDimension(gate);
+    if (!newPf.isEqualTo(&oldPf) || !newDim.isEqualTo(&oldDim)) {
+      m_log->info(_T("UpdateHandlerClient: new screen size: %dx%d"), newDim.width,
+                                                                   newDim.height);
+      m_log->info(_T("UpdateHandlerClient: new pixel format: ")
+                _T("%d, %d, %d, %d, %d, %d, %d, %d"),
+                              (int)newPf.bigEndian,
+                              (int)newPf.bitsPerPixel,
+                              (int)newPf.redMax,
+                              (int)newPf.greenMax,
+                              (int)newPf.blueMax,
+                              (int)newPf.redShift,
+                              (int)newPf.greenShift,
+                              (int)newPf.blueShift);
+      m_pushFrameBuffer.setProperties(&newDim, &newPf);
     }
+    // Equalizing this frame buffer by other side frame buffer.
+    Rect fbRect = m_pushFrameBuffer.getDimension().getRect();
+    readRectPixels(&fbRect, pixelsShared, &pixelRects, gate);
+  }
+
+  // Get video region
+  readRegion(&updCont.videoRegion, gate);
+  // Get changed region
+  unsigned int countChangedRect = gate->readUInt32();
+  m_log->info(_T("UpdateHandlerClient: count changed rectangles = %u"), countChangedRect);
+  for (unsigned int i = 0; i < countChangedRect; i++) {
+    Rect r = readRect(gate);
+    updCont.changedRegion.addRect(&r);
+    readRectPixels(&r, pixelsShared, &pixelRects, gate);
+  }
+
+  // Get "copyrect"
+  unsigned char hasCopyRect = gate->readUInt8();
+  if (hasCopyRect) {
+    m_log->info(_T("UpdateHandlerClient: has \"CopyRect\""));
+    updCont.copySrc = readPoint(gate);
+    Rect r = readRect(gate);
+    updCont.copiedRegion.addRect(&r);
+    readRectPixels(&r, pixelsShared, &pixelRects, gate);
+  }
+
+  // Get cursor position if it has been changed.
+  updCont.cursorPosChanged = gate->readUInt8() != 0;
+  if (updCont.cursorPosChanged) {
+    m_log->info(_T("UpdateHandlerClient: cursor pos changed"));
+  }
+  updCont.cursorPos = readPoint(gate);
+
+  // Get cursor shape if it has been changed.
+  updCont.cursorShapeChanged = gate->readUInt8() != 0;
+  if (updCont.cursorShapeChanged) {
+    m_log->info(_T("UpdateHandlerClient: cursor shape changed"));
+    PixelFormat newPf = m_pushFrameBuffer.getPixelFormat();
+    Dimension newDim = readDimension(gate);
+    Point newHotSpot = readPoint(gate);
 
-    // Get "copyrect"
-    unsigned char hasCopyRect = m_forwGate->readUInt8();
-    if (hasCopyRect) {
-      m_log->info(_T("UpdateHandlerClient: has \"CopyRect\""));
-      updCont.copySrc = readPoint(m_forwGate);
-      Rect r = readRect(m_forwGate);
-      updCont.copiedRegion.addRect(&r);
-      readFrameBuffer(&m_backupFrameBuffer, &r, m_forwGate);
+    m_pushCursorShape.setProperties(&newDim, &newPf);
+    m_pushCursorShape.setHotSpot(newHotSpot.x, newHotSpot.y);
+
+    // Get pixels
+    gate->readFully(m_pushCursorShape.getPixels()->getBuffer(),
+                    m_pushCursorShape.getPixelsSize());
+    // Get mask
+    if (m_pushCursorShape.getMaskSize()) {
+      gate->readFully((void *)m_pushCursorShape.getMask(),
+                      m_pushCursorShape.getMaskSize());
     }
+  }
 
-    // Get cursor position if it has been changed.
-    updCont.cursorPosChanged = m_forwGate->readUInt8() != 0;
-    if (updCont.cursorPosChanged) {
-      m_log->info(_T("UpdateHandlerClient: cursor pos changed"));
+  if (pixelsShared) {
+    readSharedPixels(sequence, &pixelRects);
+  }
+
+  if (!m_hasPushedUpdate) {
+    m_pushedUpdate = updCont;
+    m_hasPushedUpdate = true;
+  } else {
+    // The server pushes the next update after the previous one is
+    // consumed, but a restarted desktop server doesn't know of the update
+    // kept from the old one. The pixels of both are in m_pushFrameBuffer,
+    // so the copied regions are simply sent as changed ones.
+    m_log->info(_T("UpdateHandlerClient: merging pushed updates"));
+    m_pushedUpdate.changedRegion.add(&m_pushedUpdate.copiedRegion);
+    m_pushedUpdate.changedRegion.add(&updCont.changedRegion);
+    m_pushedUpdate.changedRegion.add(&updCont.copiedRegion);
+    m_pushedUpdate.copiedRegion.clear();
+    m_pushedUpdate.videoRegion = updCont.videoRegion;
+    m_pushedUpdate.screenSizeChanged |= updCont.screenSizeChanged;
+    m_pushedUpdate.cursorPosChanged |= updCont.cursorPosChanged;
+    m_pushedUpdate.cursorPos = updCont.cursorPos;
+    m_pushedUpdate.cursorShapeChanged |= updCont.cursorShapeChanged;
+  }
+}
+
+void UpdateHandlerClient::extract(UpdateContainer *updateContainer)
+{
+  updateContainer->clear();
+
+  {
+    AutoLock al(&m_pushLock);
+    if (!m_hasPushedUpdate) {
+      return;
     }
-    updCont.cursorPos = readPoint(m_forwGate);
-
-    // Get cursor shape if it has been changed.
-    updCont.cursorShapeChanged = m_forwGate->readUInt8() != 0;
-    if (updCont.cursorShapeChanged) {
-      m_log->info(_T("UpdateHandlerClient: cursor shape changed"));
-      PixelFormat newPf = m_backupFrameBuffer.getPixelFormat();
-      Dimension newDim = readDimension(m_forwGate);
-      Point newHotSpot = readPoint(m_forwGate);
-
-      m_cursorShape.setProperties(&newDim, &newPf);
-      m_cursorShape.setHotSpot(newHotSpot.x, newHotSpot.y);
-
-      // Get pixels
-      m_forwGate->readFully(m_cursorShape.getPixels()->getBuffer(),
-                            m_cursorShape.getPixelsSize());
-      // Get mask
-      if (m_cursorShape.getMaskSize()) {
-        m_forwGate->readFully((void *)m_cursorShape.getMask(),
-                              m_cursorShape.getMaskSize());
+
+    // The pixels are moved to m_backupFrameBuffer here because its content
+    // must not change until the next extract() call.
+    if (m_pushedUpdate.screenSizeChanged) {
+      AutoLock al(&m_fbLocMut);
+      m_backupFrameBuffer.clone(&m_pushFrameBuffer);
+    } else {
+      Region pixelRegion = m_pushedUpdate.changedRegion;
+      pixelRegion.add(&m_pushedUpdate.copiedRegion);
+      std::vector<Rect> rects;
+      pixelRegion.getRectVector(&rects);
+      std::vector<Rect>::iterator iRect;
+      for (iRect = rects.begin(); iRect < rects.end(); iRect++) {
+        m_backupFrameBuffer.copyFrom(&(*iRect), &m_pushFrameBuffer,
+                                     iRect->left, iRect->top);
       }
     }
+    if (m_pushedUpdate.cursorShapeChanged) {
+      m_cursorShape.clone(&m_pushCursorShape);
+    }
 
+    *updateContainer = m_pushedUpdate;
+    m_pushedUpdate.clear();
+    m_hasPushedUpdate = false;
+  }
+
+  // Let the server push the next update.
+  AutoLock al(m_forwGate);
+  try {
+    m_forwGate->writeUInt8(UPDATE_CONSUMED);
+    m_forwGate->flush();
   } catch (ReconnectException &) {
-    m_log->info(_T("UpdateHandlerClient: ReconnectException catching in the extract function"));
   }
-  *updateContainer = updCont;
+}
+
+void UpdateHandlerClient::readRectPixels(const Rect *rect, bool pixelsShared,
+                                         std::vector<Rect> *sharedRects,
+                                         BlockingGate *gate)
+{
+  if (pixelsShared) {
+    sharedRects->push_back(*rect);
+  } else {
+    readFrameBuffer(&m_pushFrameBuffer, rect, gate);
+  }
+}
+
+void UpdateHandlerClient::readSharedPixels(UINT32 sequence,
+                                           const std::vector<Rect> *rects)
+{
+  if (m_sharedFrameBuffer == 0) {
+    throw Exception(_T("The server has sent pixels by the shared memory")
+                    _T(" that is absent"));
+  }
+  if (!m_sharedFrameBuffer->read(sequence, &m_pushFrameBuffer, rects)) {
+    // The memory has been changed by a server of other connection. Any
+    // pixels of the frame buffer can be wrong, so all of them are requested.
+    m_log->error(_T("UpdateHandlerClient: the shared frame buffer is out of")
+                 _T(" date (sequence %u), requesting full update"), sequence);
+    Rect fbRect = m_pushFrameBuffer.getDimension().getRect();
+    Region fullRegion(&fbRect);
+    setFullUpdateRequested(&fullRegion);
+  }
 }
 
 void UpdateHandlerClient::setFullUpdateRequested(const Region *region)
@@ -172,6 +271,7 @@ void UpdateHandlerClient::setFullUpdateRequested(const Region *region)
   try {
     m_forwGate->writeUInt8(SET_FULL_UPD_REQ_REGION);
     sendRegion(region, m_forwGate);
+    m_forwGate->flush();
   } catch (ReconnectException &) {
   }
 }
@@ -183,6 +283,7 @@ void UpdateHandlerClient::setExcludedRegion(const Region *excludedRegion)
   try {
     m_forwGate->writeUInt8(SET_EXCLUDING_REGION);
     sendRegion(excludedRegion, m_forwGate);
+    m_forwGate->flush();
   } catch (ReconnectException &) {
   }
 }
@@ -210,4 +311,5 @@ void UpdateHandlerClient::sendInit(BlockingGate *gate)
   Dimension dim = m_backupFrameBuffer.getDimension();
   sendDimension(&dim, gate);
   sendFrameBuffer(&m_backupFrameBuffer, &dim.getRect(), gate);
+  gate->flush();
 }
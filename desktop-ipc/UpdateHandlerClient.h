@@ -28,14 +28,25 @@
 #include "desktop/UpdateHandler.h"
 #include "DesktopServerProto.h"
 #include "DesktopSrvDispatcher.h"
+#include "SharedFrameBuffer.h"
+#include "thread/LocalMutex.h"
 #include "log-writer/LogWriter.h"
 
+// Updates are pushed by the desktop server. The dispatcher thread receives
+// an UPDATE_PUSHED container into m_pushFrameBuffer and notifies the
+// listener, and the extract() call takes it without a round trip. The
+// extract() answers by UPDATE_CONSUMED, so the server pushes one update
+// at a time and coalesces the rest meanwhile.
 class UpdateHandlerClient : public UpdateHandler, public DesktopServerProto,
                             public ClientListener
 {
 public:
+  // sharedFrameBuffer is used to receive pixels of the updates if it is
+  // not zero and the server has the same memory. It is not owned by
+  // the object.
   UpdateHandlerClient(BlockingGate *forwGate, DesktopSrvDispatcher *dispatcher,
-                      UpdateListener *externalUpdateListener, LogWriter *log);
+                      UpdateListener *externalUpdateListener,
+                      SharedFrameBuffer *sharedFrameBuffer, LogWriter *log);
   virtual ~UpdateHandlerClient();
 
   virtual void extract(UpdateContainer *updateContainer);
@@ -47,10 +58,29 @@ protected:
   virtual void getScreenProperties(PixelFormat *pf, Dimension *dim);
   virtual void sendInit(BlockingGate *gate);
 
-  // To catch update event
+  // To catch pushed updates
   virtual void onRequest(UINT8 reqCode, BlockingGate *backGate);
 
+  // Reads an UPDATE_PUSHED container and keeps it for the extract() call.
+  void receiveUpdate(BlockingGate *gate);
+  // Reads the rect pixels from the pipe or, if they are shared, adds the
+  // rect to the sharedRects to read them by the readSharedPixels() later.
+  void readRectPixels(const Rect *rect, bool pixelsShared,
+                      std::vector<Rect> *sharedRects, BlockingGate *gate);
+  // @throw Exception if there is no shared frame buffer.
+  void readSharedPixels(UINT32 sequence, const std::vector<Rect> *rects);
+
   UpdateListener *m_externalUpdateListener;
+  SharedFrameBuffer *m_sharedFrameBuffer;
+
+  // The pushed update which is not extracted yet, protected by
+  // m_pushLock. Its pixels and cursor shape are kept aside until the
+  // extract() call.
+  LocalMutex m_pushLock;
+  UpdateContainer m_pushedUpdate;
+  bool m_hasPushedUpdate;
+  FrameBuffer m_pushFrameBuffer;
+  CursorShape m_pushCursorShape;
 
   LogWriter *m_log;
 };
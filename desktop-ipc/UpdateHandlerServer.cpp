@@ -27,15 +27,20 @@
 UpdateHandlerServer::UpdateHandlerServer(BlockingGate *forwGate,
                                          DesktopSrvDispatcher *dispatcher,
                                          AnEventListener *extTerminationListener,
+                                         SharedFrameBuffer *sharedFrameBuffer,
                                          LogWriter *log)
 : DesktopServerProto(forwGate),
   m_extTerminationListener(extTerminationListener),
+  m_sharedFrameBuffer(sharedFrameBuffer),
+  m_clientInitialized(false),
+  m_updatePushed(false),
+  m_updatePending(false),
   m_log(log),
   m_scrDriverFactory(Configurator::getInstance()->getServerConfig())
 {
   m_updateHandler = new UpdateHandlerImpl(this, &m_scrDriverFactory, log);
 
-  dispatcher->registerNewHandle(EXTRACT_REQ, this);
+  dispatcher->registerNewHandle(UPDATE_CONSUMED, this);
   dispatcher->registerNewHandle(SCREEN_PROP_REQ, this);
   dispatcher->registerNewHandle(SET_FULL_UPD_REQ_REGION, this);
   dispatcher->registerNewHandle(SET_EXCLUDING_REGION, this);
@@ -44,27 +49,72 @@ UpdateHandlerServer::UpdateHandlerServer(BlockingGate *forwGate,
 
 UpdateHandlerServer::~UpdateHandlerServer()
 {
+  terminate();
+  wait();
   delete m_updateHandler;
 }
 
 void UpdateHandlerServer::onUpdate()
 {
-  AutoLock al(m_forwGate);
-  try {
-    m_forwGate->writeUInt8(UPDATE_DETECTED);
-  } catch (Exception &e) {
-    m_log->error(_T("An error has been occurred while sending the")
-                 _T(" UPDATE_DETECTED message from UpdateHandlerServer: %s"),
-               e.getMessage());
-    m_extTerminationListener->onAnObjectEvent();
+  {
+    AutoLock al(&m_pushLock);
+    m_updatePending = true;
+  }
+  m_pushEvent.notify();
+}
+
+void UpdateHandlerServer::onTerminate()
+{
+  m_pushEvent.notify();
+}
+
+void UpdateHandlerServer::execute()
+{
+  while (!isTerminating()) {
+    m_pushEvent.waitForEvent();
+
+    bool mustPush;
+    {
+      AutoLock al(&m_pushLock);
+      mustPush = m_clientInitialized && !m_updatePushed && m_updatePending;
+      if (mustPush) {
+        m_updatePending = false;
+        m_updatePushed = true;
+      }
+    }
+    if (!mustPush || isTerminating()) {
+      continue;
+    }
+
+    try {
+      if (!pushUpdate()) {
+        AutoLock al(&m_pushLock);
+        m_updatePushed = false;
+      }
+    } catch (Exception &e) {
+      // The client hasn't got the updates, so the next attempt must push
+      // them again.
+      {
+        AutoLock al(&m_pushLock);
+        m_updatePushed = false;
+        m_updatePending = true;
+      }
+      m_log->error(_T("An error has been occurred while pushing an update")
+                   _T(" from UpdateHandlerServer: %s"), e.getMessage());
+      m_extTerminationListener->onAnObjectEvent();
+    }
   }
 }
 
 void UpdateHandlerServer::onRequest(UINT8 reqCode, BlockingGate *backGate)
 {
   switch (reqCode) {
-  case EXTRACT_REQ:
-    extractReply(backGate);
+  case UPDATE_CONSUMED:
+    {
+      AutoLock al(&m_pushLock);
+      m_updatePushed = false;
+    }
+    m_pushEvent.notify();
     break;
   case SCREEN_PROP_REQ:
     screenPropReply(backGate);
@@ -88,79 +138,140 @@ void UpdateHandlerServer::onRequest(UINT8 reqCode, BlockingGate *backGate)
   }
 }
 
-void UpdateHandlerServer::extractReply(BlockingGate *backGate)
+bool UpdateHandlerServer::pushUpdate()
 {
   UpdateContainer updCont;
-  m_updateHandler->extract(&updCont);
+  {
+    AutoLock al(&m_updateHandlerLock);
+    m_updateHandler->extract(&updCont);
 
-  const FrameBuffer *fb = m_updateHandler->getFrameBuffer();
+    PixelFormat newPf = m_updateHandler->getFrameBuffer()->getPixelFormat();
+    if (!m_oldPf.isEqualTo(&newPf)) {
+      updCont.screenSizeChanged = true;
+      m_oldPf = newPf;
+    }
+  }
+  if (updCont.isEmpty()) {
+    return false;
+  }
+
+  // After the client initialization the frame buffer is changed by the
+  // extract() of this thread only, so it can be sent without the lock.
+  AutoLock al(m_forwGate);
+  m_forwGate->writeUInt8(UPDATE_PUSHED);
+  writeUpdate(&updCont, m_forwGate);
+  m_forwGate->flush();
+  return true;
+}
 
+void UpdateHandlerServer::writeUpdate(UpdateContainer *updCont,
+                                      BlockingGate *gate)
+{
+  const FrameBuffer *fb = m_updateHandler->getFrameBuffer();
   PixelFormat newPf = fb->getPixelFormat();
 
-  if (!m_oldPf.isEqualTo(&newPf)) {
-    updCont.screenSizeChanged = true;
-    m_oldPf = newPf;
+  Rect fbRect = fb->getDimension().getRect();
+  std::vector<Rect> rects;
+  std::vector<Rect>::iterator iRect;
+  updCont->changedRegion.getRectVector(&rects);
+  std::vector<Rect> copiedRects;
+  updCont->copiedRegion.getRectVector(&copiedRects);
+  bool hasCopyRect = !copiedRects.empty();
+
+  // Pixels of all rects are placed to the shared memory at once if it's
+  // possible, so the message itself carries metadata only.
+  std::vector<Rect> pixelRects;
+  if (updCont->screenSizeChanged) {
+    pixelRects.push_back(fbRect);
+  } else {
+    pixelRects = rects;
+    if (hasCopyRect) {
+      pixelRects.push_back(copiedRects.front());
+    }
   }
+  UINT32 sequence = 0;
+  bool pixelsShared = sharePixels(fb, &pixelRects, &sequence);
 
-  backGate->writeUInt8(updCont.screenSizeChanged);
-  if (updCont.screenSizeChanged) {
+  gate->writeUInt8(updCont->screenSizeChanged);
+  gate->writeUInt8(pixelsShared);
+  if (pixelsShared) {
+    gate->writeUInt32(sequence);
+  }
+  if (updCont->screenSizeChanged) {
     // Send new screen properties
-    sendPixelFormat(&newPf, backGate);
+    sendPixelFormat(&newPf, gate);
     Dimension fbDim = fb->getDimension();
-    Rect fbRect = fbDim.getRect();
-    sendDimension(&fbDim, backGate);
-    sendFrameBuffer(fb, &fbRect, backGate);
+    sendDimension(&fbDim, gate);
+    if (!pixelsShared) {
+      sendFrameBuffer(fb, &fbRect, gate);
+    }
   }
 
   // Send video region
-  sendRegion(&updCont.videoRegion, backGate);
+  sendRegion(&updCont->videoRegion, gate);
   // Send changed region
-  std::vector<Rect> rects;
-  std::vector<Rect>::iterator iRect;
-  updCont.changedRegion.getRectVector(&rects);
   unsigned int countChangedRect = (unsigned int)rects.size();
   _ASSERT(countChangedRect == rects.size());
-  backGate->writeUInt32(countChangedRect);
+  gate->writeUInt32(countChangedRect);
 
   for (iRect = rects.begin(); iRect < rects.end(); iRect++) {
     Rect *rect = &(*iRect);
-    sendRect(rect, backGate);
-    sendFrameBuffer(fb, rect, backGate);
+    sendRect(rect, gate);
+    if (!pixelsShared) {
+      sendFrameBuffer(fb, rect, gate);
+    }
   }
 
   // Send "copyrect"
-  bool hasCopyRect = !updCont.copiedRegion.isEmpty();
-  backGate->writeUInt8(hasCopyRect);
+  gate->writeUInt8(hasCopyRect);
   if (hasCopyRect) {
-    sendPoint(&updCont.copySrc, backGate);
-    updCont.copiedRegion.getRectVector(&rects);
-    iRect = rects.begin();
-    sendRect(&(*iRect), backGate);
-    sendFrameBuffer(fb, &(*iRect), backGate);
+    sendPoint(&updCont->copySrc, gate);
+    iRect = copiedRects.begin();
+    sendRect(&(*iRect), gate);
+    if (!pixelsShared) {
+      sendFrameBuffer(fb, &(*iRect), gate);
+    }
   }
 
   // Send cursor position if it has been changed.
-  backGate->writeUInt8(updCont.cursorPosChanged);
-  sendPoint(&updCont.cursorPos, backGate);
+  gate->writeUInt8(updCont->cursorPosChanged);
+  sendPoint(&updCont->cursorPos, gate);
 
   // Send cursor shape if it has been changed.
-  backGate->writeUInt8(updCont.cursorShapeChanged);
-  if (updCont.cursorShapeChanged) {
+  gate->writeUInt8(updCont->cursorShapeChanged);
+  if (updCont->cursorShapeChanged) {
     const CursorShape *curSh = m_updateHandler->getCursorShape();
-    sendDimension(&curSh->getDimension(), backGate);
-    sendPoint(&curSh->getHotSpot(), backGate);
+    sendDimension(&curSh->getDimension(), gate);
+    sendPoint(&curSh->getHotSpot(), gate);
 
     // Send pixels
-    backGate->writeFully(curSh->getPixels()->getBuffer(), curSh->getPixelsSize());
+    gate->writeFully(curSh->getPixels()->getBuffer(), curSh->getPixelsSize());
     // Send mask
     if (curSh->getMaskSize()) {
-      backGate->writeFully((void *)curSh->getMask(), curSh->getMaskSize());
+      gate->writeFully((void *)curSh->getMask(), curSh->getMaskSize());
     }
   }
 }
 
+bool UpdateHandlerServer::sharePixels(const FrameBuffer *fb,
+                                      const std::vector<Rect> *rects,
+                                      UINT32 *sequence)
+{
+  if (m_sharedFrameBuffer == 0) {
+    return false;
+  }
+  Dimension dim = fb->getDimension();
+  PixelFormat pf = fb->getPixelFormat();
+  if (!m_sharedFrameBuffer->fits(&dim, &pf)) {
+    return false;
+  }
+  *sequence = m_sharedFrameBuffer->write(fb, rects);
+  return true;
+}
+
 void UpdateHandlerServer::screenPropReply(BlockingGate *backGate)
 {
+  AutoLock al(&m_updateHandlerLock);
   const FrameBuffer *fb = m_updateHandler->getFrameBuffer();
   sendPixelFormat(&fb->getPixelFormat(), backGate);
   sendDimension(&fb->getDimension(), backGate);
@@ -170,13 +281,19 @@ void UpdateHandlerServer::receiveFullReqReg(BlockingGate *backGate)
 {
   Region region;
   readRegion(&region, backGate);
-  m_updateHandler->setFullUpdateRequested(&region);
+  {
+    AutoLock al(&m_updateHandlerLock);
+    m_updateHandler->setFullUpdateRequested(&region);
+  }
+  // The requested region must be pushed even if nothing has changed.
+  onUpdate();
 }
 
 void UpdateHandlerServer::receiveExcludingReg(BlockingGate *backGate)
 {
   Region region;
   readRegion(&region, backGate);
+  AutoLock al(&m_updateHandlerLock);
   m_updateHandler->setExcludedRegion(&region);
 }
 
@@ -185,10 +302,23 @@ void UpdateHandlerServer::serverInit(BlockingGate *backGate)
   // FIXME: Use another method to initialize m_backupFrameBuffer
   // because this method use a lot of memory.
   FrameBuffer fb;
-  readPixelFormat(&m_oldPf, backGate);
+  PixelFormat pf;
+  readPixelFormat(&pf, backGate);
   Dimension dim = readDimension(backGate);
-  fb.setProperties(&dim, &m_oldPf);
+  fb.setProperties(&dim, &pf);
 
   readFrameBuffer(&fb, &dim.getRect(), backGate);
-  m_updateHandler->initFrameBuffer(&fb);
+  {
+    AutoLock al(&m_updateHandlerLock);
+    m_oldPf = pf;
+    m_updateHandler->initFrameBuffer(&fb);
+  }
+
+  // The first push brings the client up to date with the screen.
+  {
+    AutoLock al(&m_pushLock);
+    m_clientInitialized = true;
+    m_updatePending = true;
+  }
+  m_pushEvent.notify();
 }
@@ -28,16 +28,25 @@
 #include "DesktopServerProto.h"
 #include "desktop/UpdateHandlerImpl.h"
 #include "DesktopSrvDispatcher.h"
+#include "SharedFrameBuffer.h"
 #include "log-writer/LogWriter.h"
 #include "desktop/Win32ScreenDriverFactory.h"
+#include "thread/Thread.h"
+#include "thread/LocalMutex.h"
+#include "win-system/WindowsEvent.h"
 
+// Pushes the updates to the client: the own thread writes an UPDATE_PUSHED
+// container as soon as the update handler has collected one and the client
+// has consumed the previous one. Updates which come meanwhile are
+// coalesced by the update handler and go by the next container.
 class UpdateHandlerServer: public DesktopServerProto, public ClientListener,
-                           public UpdateListener
+                           public UpdateListener, public Thread
 {
 public:
   UpdateHandlerServer(BlockingGate *forwGate,
                       DesktopSrvDispatcher *dispatcher,
                       AnEventListener *extTerminationListener,
+                      SharedFrameBuffer *sharedFrameBuffer,
                       LogWriter *log);
   virtual ~UpdateHandlerServer();
 
@@ -47,10 +56,21 @@ public:
 protected:
   virtual void onUpdate();
 
+  virtual void execute();
+  virtual void onTerminate();
+
   // At first time server must get init information.
   void serverInit(BlockingGate *backGate);
 
-  void extractReply(BlockingGate *backGate);
+  // Extracts the collected updates and pushes them to the client. Returns
+  // false without writing anything if there is nothing to send.
+  bool pushUpdate();
+  void writeUpdate(UpdateContainer *updCont, BlockingGate *gate);
+  // Writes pixels of the rects to the shared frame buffer and returns true
+  // with the sequence number to send, or false if the pixels must be sent
+  // by the pipe.
+  bool sharePixels(const FrameBuffer *fb, const std::vector<Rect> *rects,
+                   UINT32 *sequence);
   void screenPropReply(BlockingGate *backGate);
   void receiveFullReqReg(BlockingGate *backGate);
   void receiveExcludingReg(BlockingGate *backGate);
@@ -60,7 +80,21 @@ protected:
   PixelFormat m_oldPf;
 
   UpdateHandlerImpl *m_updateHandler;
+  // Serializes the m_updateHandler calls of the push thread and of the
+  // dispatcher.
+  LocalMutex m_updateHandlerLock;
   AnEventListener *m_extTerminationListener;
+  SharedFrameBuffer *m_sharedFrameBuffer;
+
+  // Push state, protected by m_pushLock.
+  LocalMutex m_pushLock;
+  // The client has sent FRAME_BUFFER_INIT.
+  bool m_clientInitialized;
+  // An update has been pushed but not consumed by the client yet.
+  bool m_updatePushed;
+  // Updates have been detected after the last push.
+  bool m_updatePending;
+  WindowsEvent m_pushEvent;
 
   LogWriter *m_log;
 };
@@ -32,13 +32,17 @@ UserInputClient::UserInputClient(BlockingGate *forwGate,
                                  ClipboardListener *clipboardListener)
 : DesktopServerProto(forwGate),
   m_clipboardListener(clipboardListener),
-  m_sendMouseFlags(0)
+  m_sendMouseFlags(0),
+  m_pendingInput(new ByteArrayOutputStream),
+  m_numPendingInput(0),
+  m_sendingInput(false)
 {
   dispatcher->registerNewHandle(CLIPBOARD_CHANGED, this);
 }
 
 UserInputClient::~UserInputClient()
 {
+  delete m_pendingInput;
 }
 
 void UserInputClient::onRequest(UINT8 reqCode, BlockingGate *backGate)
@@ -65,18 +69,20 @@ void UserInputClient::sendInit(BlockingGate *gate)
   AutoLock al(gate);
   gate->writeUInt8(USER_INPUT_INIT);
   gate->writeUInt8(m_sendMouseFlags);
+  gate->flush();
 }
 
 void UserInputClient::setMouseEvent(const Point *newPos, UINT8 keyFlag)
 {
-  AutoLock al(m_forwGate);
-  try {
-    // Send mouse data
-    m_forwGate->writeUInt8(POINTER_POS_CHANGED);
-    sendNewPointerPos(newPos, keyFlag, m_forwGate);
+  {
+    AutoLock al(&m_inputLock);
+    DataOutputStream output(m_pendingInput);
+    output.writeUInt8(POINTER_POS_CHANGED);
+    sendNewPointerPos(newPos, keyFlag, &output);
+    m_numPendingInput++;
     m_sendMouseFlags = keyFlag;
-  } catch (ReconnectException &) {
   }
+  sendPendingInput();
 }
 
 void UserInputClient::setNewClipboard(const StringStorage *newClipboard)
@@ -86,18 +92,61 @@ void UserInputClient::setNewClipboard(const StringStorage *newClipboard)
     // Send clipboard data
     m_forwGate->writeUInt8(CLIPBOARD_CHANGED);
     sendNewClipboard(newClipboard, m_forwGate);
+    m_forwGate->flush();
   } catch (ReconnectException &) {
   }
 }
 
 void UserInputClient::setKeyboardEvent(UINT32 keySym, bool down)
 {
-  AutoLock al(m_forwGate);
-  try {
-    // Send keyboard data
-    m_forwGate->writeUInt8(KEYBOARD_EVENT);
-    sendKeyEvent(keySym, down, m_forwGate);
-  } catch (ReconnectException &) {
+  {
+    AutoLock al(&m_inputLock);
+    DataOutputStream output(m_pendingInput);
+    output.writeUInt8(KEYBOARD_EVENT);
+    sendKeyEvent(keySym, down, &output);
+    m_numPendingInput++;
+  }
+  sendPendingInput();
+}
+
+void UserInputClient::sendPendingInput()
+{
+  {
+    AutoLock al(&m_inputLock);
+    if (m_sendingInput) {
+      return;
+    }
+    m_sendingInput = true;
+  }
+  while (true) {
+    ByteArrayOutputStream *batch;
+    UINT32 numEvents;
+    {
+      AutoLock al(&m_inputLock);
+      if (m_numPendingInput == 0) {
+        m_sendingInput = false;
+        return;
+      }
+      batch = m_pendingInput;
+      numEvents = m_numPendingInput;
+      m_pendingInput = new ByteArrayOutputStream;
+      m_numPendingInput = 0;
+    }
+    try {
+      AutoLock al(m_forwGate);
+      m_forwGate->writeUInt8(INPUT_BATCH);
+      m_forwGate->writeUInt32((UINT32)(sizeof(UINT32) + batch->size()));
+      m_forwGate->writeUInt32(numEvents);
+      m_forwGate->writeFully(batch->toByteArray(), batch->size());
+      m_forwGate->flush();
+    } catch (ReconnectException &) {
+    } catch (...) {
+      delete batch;
+      AutoLock al(&m_inputLock);
+      m_sendingInput = false;
+      throw;
+    }
+    delete batch;
   }
 }
 
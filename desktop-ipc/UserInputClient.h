@@ -31,7 +31,14 @@
 #include "util/inttypes.h"
 #include "DesktopServerProto.h"
 #include "DesktopSrvDispatcher.h"
+#include "thread/LocalMutex.h"
+#include "io-lib/ByteArrayOutputStream.h"
 
+// The pointer and keyboard events are queued and sent by INPUT_BATCH
+// messages. A thread that finds no batch being sent sends the queue at
+// once; events that come while the pipe is busy wait for the current
+// batch and go by the next one, so a burst of events costs a few pipe
+// writes instead of one per event.
 class UserInputClient : public UserInput, public DesktopServerProto,
                         public ClientListener
 {
@@ -58,8 +65,17 @@ public:
   virtual void onRequest(UINT8 reqCode, BlockingGate *backGate);
 
 protected:
+  // Sends the queued input events unless another thread does it already.
+  void sendPendingInput();
+
   UINT8 m_sendMouseFlags;
   ClipboardListener *m_clipboardListener;
+
+  // Input queue, protected by m_inputLock.
+  LocalMutex m_inputLock;
+  ByteArrayOutputStream *m_pendingInput;
+  UINT32 m_numPendingInput;
+  bool m_sendingInput;
 };
 
 #endif // __USERINPUTCLIENT_H__
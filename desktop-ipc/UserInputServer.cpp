@@ -25,6 +25,9 @@
 #include "UserInputServer.h"
 #include "thread/AutoLock.h"
 #include "util/BrokenHandleException.h"
+#include "io-lib/ByteArrayInputStream.h"
+
+#include <vector>
 
 UserInputServer::UserInputServer(BlockingGate *forwGate,
                                  DesktopSrvDispatcher *dispatcher,
@@ -40,6 +43,7 @@ UserInputServer::UserInputServer(BlockingGate *forwGate,
   dispatcher->registerNewHandle(POINTER_POS_CHANGED, this);
   dispatcher->registerNewHandle(CLIPBOARD_CHANGED, this);
   dispatcher->registerNewHandle(KEYBOARD_EVENT, this);
+  dispatcher->registerNewHandle(INPUT_BATCH, this);
   dispatcher->registerNewHandle(USER_INFO_REQ, this);
   dispatcher->registerNewHandle(DESKTOP_COORDS_REQ, this);
   dispatcher->registerNewHandle(WINDOW_COORDS_REQ, this);
@@ -64,6 +68,7 @@ void UserInputServer::onClipboardUpdate(const StringStorage *newClipboard)
     if (newClipboard->getLength() != 0) {
       m_forwGate->writeUInt8(CLIPBOARD_CHANGED);
       sendNewClipboard(newClipboard, m_forwGate);
+      m_forwGate->flush();
     }
   } catch (Exception &e) {
     m_log->error(_T("An error has been occurred while sending a")
@@ -85,6 +90,9 @@ void UserInputServer::onRequest(UINT8 reqCode, BlockingGate *backGate)
   case KEYBOARD_EVENT:
     applyKeyEvent(backGate);
     break;
+  case INPUT_BATCH:
+    applyInputBatch(backGate);
+    break;
   case USER_INFO_REQ:
     ansUserInfo(backGate);
     break;
@@ -124,11 +132,11 @@ void UserInputServer::serverInit(BlockingGate *backGate)
   m_userInput->initKeyFlag(keyFlags);
 }
 
-void UserInputServer::applyNewPointerPos(BlockingGate *backGate)
+void UserInputServer::applyNewPointerPos(DataInputStream *input)
 {
   Point newPointerPos;
   UINT8 keyFlags;
-  readNewPointerPos(&newPointerPos, &keyFlags, backGate);
+  readNewPointerPos(&newPointerPos, &keyFlags, input);
   m_userInput->setMouseEvent(&newPointerPos, keyFlags);
 }
 
@@ -139,14 +147,44 @@ void UserInputServer::applyNewClipboard(BlockingGate *backGate)
   m_userInput->setNewClipboard(&newClipboard);
 }
 
-void UserInputServer::applyKeyEvent(BlockingGate *backGate)
+void UserInputServer::applyKeyEvent(DataInputStream *input)
 {
   UINT32 keySym;
   bool down;
-  readKeyEvent(&keySym, &down, backGate);
+  readKeyEvent(&keySym, &down, input);
   m_userInput->setKeyboardEvent(keySym, down);
 }
 
+void UserInputServer::applyInputBatch(BlockingGate *backGate)
+{
+  UINT32 length = backGate->readUInt32();
+  if (length < sizeof(UINT32)) {
+    throw Exception(_T("Wrong length of an input batch"));
+  }
+  std::vector<char> batch(length);
+  backGate->readFully(&batch.front(), length);
+
+  ByteArrayInputStream batchStream(&batch.front(), length);
+  DataInputStream input(&batchStream);
+  UINT32 numEvents = input.readUInt32();
+  for (UINT32 i = 0; i < numEvents; i++) {
+    UINT8 eventCode = input.readUInt8();
+    switch (eventCode) {
+    case POINTER_POS_CHANGED:
+      applyNewPointerPos(&input);
+      break;
+    case KEYBOARD_EVENT:
+      applyKeyEvent(&input);
+      break;
+    default:
+      StringStorage errMess;
+      errMess.format(_T("Unknown %d event code in an input batch"),
+                     (int)eventCode);
+      throw Exception(errMess.getString());
+    }
+  }
+}
+
 void UserInputServer::ansUserInfo(BlockingGate *backGate)
 {
   StringStorage desktopName, userName;
@@ -49,9 +49,11 @@ public:
   virtual void onClipboardUpdate(const StringStorage *newClipboard);
 
 protected:
-  virtual void applyNewPointerPos(BlockingGate *backGate);
+  virtual void applyNewPointerPos(DataInputStream *input);
   virtual void applyNewClipboard(BlockingGate *backGate);
-  virtual void applyKeyEvent(BlockingGate *backGate);
+  virtual void applyKeyEvent(DataInputStream *input);
+  // Reads the whole batch by its length and applies its events in order.
+  virtual void applyInputBatch(BlockingGate *backGate);
   virtual void ansDesktopCoords(BlockingGate *backGate);
   virtual void ansWindowCoords(BlockingGate *backGate);
   virtual void ansUserInfo(BlockingGate *backGate);
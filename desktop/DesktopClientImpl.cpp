@@ -42,6 +42,7 @@ DesktopClientImpl::DesktopClientImpl(ClipboardListener *extClipListener,
   m_srvToClGate(0),
   m_deskServWatcher(0),
   m_dispatcher(0),
+  m_sharedFrameBuffer(0),
   m_userInputClient(0),
   m_deskConf(0),
   m_gateKicker(0),
@@ -52,6 +53,10 @@ DesktopClientImpl::DesktopClientImpl(ClipboardListener *extClipListener,
   try {
     m_log->debug(_T("DesktopClientImpl: Try to initialize DesktopServerWatcher"));
     m_deskServWatcher = new DesktopServerWatcher(this, m_log);
+    UnnamedSharedMemory *fbMem = m_deskServWatcher->getFrameBufferMemory();
+    if (fbMem != 0) {
+      m_sharedFrameBuffer = new SharedFrameBuffer(fbMem);
+    }
 
     // Transport initialization
     m_log->debug(_T("DesktopClientImpl: Initializing ReconnectingChannel(s)..."));
@@ -71,7 +76,8 @@ DesktopClientImpl::DesktopClientImpl(ClipboardListener *extClipListener,
 
     m_log->debug(_T("DesktopClientImpl: Initializing UpdateHandlerClient..."));
     m_updateHandler = new UpdateHandlerClient(m_clToSrvGate, m_dispatcher,
-                                              this, m_log);
+                                              this, m_sharedFrameBuffer,
+                                              m_log);
 
     m_log->debug(_T("DesktopClientImpl: Initializing UserInputClient..."));
     UserInputClient *userInputClient =
@@ -131,6 +137,8 @@ void DesktopClientImpl::freeResource()
 
   if (m_srvToClChan) delete m_srvToClChan;
   if (m_clToSrvChan) delete m_clToSrvChan;
+
+  if (m_sharedFrameBuffer) delete m_sharedFrameBuffer;
 }
 
 void DesktopClientImpl::closeDesktopServerTransport()
@@ -32,6 +32,7 @@
 #include "desktop-ipc/BlockingGate.h"
 #include "desktop-ipc/GateKicker.h"
 #include "desktop-ipc/DesktopSrvDispatcher.h"
+#include "desktop-ipc/SharedFrameBuffer.h"
 #include "DesktopBaseImpl.h"
 #include "log-writer/LogWriter.h"
 
@@ -75,6 +76,8 @@ private:
 
   DesktopServerWatcher *m_deskServWatcher;
   DesktopSrvDispatcher *m_dispatcher;
+  // Frame buffer pixels shared with the desktop server (can be zero).
+  SharedFrameBuffer *m_sharedFrameBuffer;
 
   GateKicker *m_gateKicker;
   UserInput *m_userInputClient; // It uses for delegation by the SasUserInput.
@@ -30,6 +30,7 @@
 #include "win-system/AnonymousPipeFactory.h"
 #include "win-system/WTS.h"
 #include "win-system/WinStaLibrary.h"
+#include "desktop-ipc/SharedFrameBuffer.h"
 
 #include <time.h>
 
@@ -38,6 +39,7 @@ DesktopServerWatcher::DesktopServerWatcher(ReconnectionListener *recListener, Lo
   m_process(0),
   m_sharedMem(0),
   m_shMemName(_T("Global\\")),
+  m_frameBufferMem(0),
   m_log(log)
 {
   // Desktop server folder.
@@ -58,6 +60,8 @@ DesktopServerWatcher::DesktopServerWatcher(ReconnectionListener *recListener, Lo
     (UINT64 *)[2] - otherSidePipeChanTo read handle;
     (UINT64 *)[3] - otherSidePipeChanFrom write handle;
     (UINT64 *)[4] - otherSidePipeChanFrom read handle;
+    (UINT64 *)[5] - frame buffer memory handle (zero if absent);
+    (UINT64 *)[6] - frame buffer memory size;
     */
     srand((unsigned)time(0));
     for (int i = 0; i < 20; i++) {
@@ -69,6 +73,19 @@ DesktopServerWatcher::DesktopServerWatcher(ReconnectionListener *recListener, Lo
     if (m_sharedMem) delete m_sharedMem;
     throw;
   }
+
+  // Pixels can be passed through the pipes as well, so it is not
+  // an error if there is no memory for them.
+  try {
+    m_frameBufferMem = new UnnamedSharedMemory(FRAME_BUFFER_MEM_SIZE, true);
+    SharedFrameBuffer::initMemory(m_frameBufferMem);
+  } catch (Exception &e) {
+    m_log->error(_T("Cannot allocate frame buffer shared memory,")
+                 _T(" the pixels will be passed by the pipes: %s"),
+                 e.getMessage());
+    if (m_frameBufferMem) delete m_frameBufferMem;
+    m_frameBufferMem = 0;
+  }
 }
 
 DesktopServerWatcher::~DesktopServerWatcher()
@@ -77,6 +94,7 @@ DesktopServerWatcher::~DesktopServerWatcher()
   wait();
   delete m_process;
   delete m_sharedMem;
+  if (m_frameBufferMem) delete m_frameBufferMem;
 }
 
 void DesktopServerWatcher::execute()
@@ -125,6 +143,13 @@ void DesktopServerWatcher::execute()
       mem[2] = (UINT64)otherSidePipeChanTo->getReadHandle();
       mem[3] = (UINT64)otherSidePipeChanFrom->getWriteHandle();
       mem[4] = (UINT64)otherSidePipeChanFrom->getReadHandle();
+      mem[5] = 0;
+      mem[6] = 0;
+      if (m_frameBufferMem != 0) {
+        HANDLE hProcess = m_process->getProcessHandle();
+        mem[5] = (UINT64)m_frameBufferMem->duplicateHandleFor(hProcess);
+        mem[6] = (UINT64)m_frameBufferMem->getSize();
+      }
       // Sets memory ready flag to true.
       mem[0] = 1;
 
@@ -30,6 +30,7 @@
 #include "log-writer/LogWriter.h"
 #include "desktop-ipc/ReconnectionListener.h"
 #include "win-system/SharedMemory.h"
+#include "win-system/UnnamedSharedMemory.h"
 
 /**
  * Thread that used to execute desktop server application.
@@ -45,6 +46,10 @@ public:
   DesktopServerWatcher(ReconnectionListener *recListener, LogWriter *log);
   virtual ~DesktopServerWatcher();
 
+  // Returns memory that is shared with each desktop server instance to pass
+  // frame buffer pixels or zero if the memory couldn't be allocated.
+  UnnamedSharedMemory *getFrameBufferMemory() { return m_frameBufferMem; }
+
 protected:
   virtual void execute();
   virtual void onTerminate();
@@ -62,6 +67,11 @@ protected:
   SharedMemory *m_sharedMem;
   StringStorage m_shMemName;
 
+  // Address space for 8192x8192 at 32 bits per pixel. The memory is only
+  // reserved, the desktop server commits the part the screen needs.
+  static const size_t FRAME_BUFFER_MEM_SIZE = 256 * 1024 * 1024 + 64;
+  UnnamedSharedMemory *m_frameBufferMem;
+
   LogWriter *m_log;
 };
 
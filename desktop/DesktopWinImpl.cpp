@@ -33,6 +33,11 @@
 #include "DesktopConfigLocal.h"
 #include "win-system/Environment.h"
 #include "win-system/WindowsDisplays.h"
+#include "SyntheticScreenDriverFactory.h"
+
+// Screen size of the synthetic desktop.
+static const int SYNTHETIC_SCREEN_WIDTH = 1920;
+static const int SYNTHETIC_SCREEN_HEIGHT = 1080;
 
 DesktopWinImpl::DesktopWinImpl(ClipboardListener *extClipListener,
                        UpdateSendingListener *extUpdSendingListener,
@@ -42,14 +47,24 @@ DesktopWinImpl::DesktopWinImpl(ClipboardListener *extClipListener,
   m_wallPaper(0),
   m_deskConf(0),
   m_log(log),
-  m_scrDriverFactory(Configurator::getInstance()->getServerConfig())
+  m_scrDriverFactory(0)
 {
   m_log->info(_T("Creating DesktopWinImpl"));
 
   logDesktopInfo();
 
   try {
-    m_updateHandler = new UpdateHandlerImpl(this, &m_scrDriverFactory, m_log);
+    ServerConfig *srvConf = Configurator::getInstance()->getServerConfig();
+    unsigned int workload = srvConf->getSyntheticScreenWorkload();
+    if (workload >= SyntheticScreenDriver::IDLE &&
+        workload <= SyntheticScreenDriver::TYPING) {
+      Dimension dim(SYNTHETIC_SCREEN_WIDTH, SYNTHETIC_SCREEN_HEIGHT);
+      m_scrDriverFactory = new SyntheticScreenDriverFactory(
+        (SyntheticScreenDriver::Workload)workload, &dim);
+    } else {
+      m_scrDriverFactory = new Win32ScreenDriverFactory(srvConf);
+    }
+    m_updateHandler = new UpdateHandlerImpl(this, m_scrDriverFactory, m_log);
     bool ctrlAltDelEnabled = false;
     m_userInput = new WindowsUserInput(this, ctrlAltDelEnabled, m_log);
     m_deskConf = new DesktopConfigLocal(m_log);
@@ -82,6 +97,7 @@ void DesktopWinImpl::freeResource()
   if (m_wallPaper) delete m_wallPaper;
 
   if (m_updateHandler) delete m_updateHandler;
+  if (m_scrDriverFactory) delete m_scrDriverFactory;
   if (m_deskConf) delete m_deskConf;
   if (m_userInput) delete m_userInput;
 }
@@ -55,7 +55,9 @@ private:
   virtual bool isRemoteInputTempBlocked();
   virtual void applyNewConfiguration();
 
-  Win32ScreenDriverFactory m_scrDriverFactory;
+  // Win32ScreenDriverFactory or SyntheticScreenDriverFactory, depending on
+  // the server configuration.
+  ScreenDriverFactory *m_scrDriverFactory;
 
   WallpaperUtil *m_wallPaper;
 
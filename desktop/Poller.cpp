@@ -26,6 +26,7 @@
 #include "Poller.h"
 #include "region/Region.h"
 #include "server-config-lib/Configurator.h"
+#include "log-writer/Tracer.h"
 
 Poller::Poller(UpdateKeeper *updateKeeper,
                UpdateListener *updateListener,
@@ -70,6 +71,7 @@ void Poller::execute()
     Region region;
 
     {
+      TRACE_SPAN(span, "Poller::poll");
       AutoLock al(m_fbMutex);
 
       screenFrameBuffer = m_screenGrabber->getScreenBuffer();
@@ -33,6 +33,8 @@
 class ScreenDriverFactory
 {
 public:
+  virtual ~ScreenDriverFactory() {}
+
   virtual ScreenDriver *createScreenDriver(UpdateKeeper *updateKeeper,
                                              UpdateListener *updateListener,
                                              FrameBuffer *fb,
@@ -0,0 +1,358 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "SyntheticScreenDriver.h"
+#include "rfb/StandardPixelFormatFactory.h"
+
+SyntheticScreenDriver::SyntheticScreenDriver(Workload workload,
+                                             const Dimension *dim,
+                                             UpdateKeeper *updateKeeper,
+                                             UpdateListener *updateListener,
+                                             LogWriter *log)
+: m_workload(workload),
+  m_updateKeeper(updateKeeper),
+  m_updateListener(updateListener),
+  m_seed(1),
+  m_windowDx(7),
+  m_windowDy(5),
+  m_detectionEnabled(false),
+  m_log(log)
+{
+  PixelFormat pf = StandardPixelFormatFactory::create32bppPixelFormat();
+  m_desktop.setProperties(dim, &pf);
+  m_screenBuffer.setProperties(dim, &pf);
+  m_cursorShape.setPixelFormat(&pf);
+  m_cursorPos.setPoint(dim->width / 2, dim->height / 2);
+
+  m_window.setRect(0, 0, min(640, dim->width), min(480, dim->height));
+
+  drawBackground();
+  if (m_workload == WINDOW_DRAG) {
+    drawWindow(&m_window);
+  } else if (m_workload == VIDEO) {
+    Rect video(0, 0, min(640, dim->width), min(360, dim->height));
+    video.move((dim->width - video.getWidth()) / 2,
+               (dim->height - video.getHeight()) / 2);
+    m_videoRegion.addRect(&video);
+  }
+  m_screenBuffer.copyFrom(&m_desktop, 0, 0);
+
+  m_log->info(_T("Using the synthetic screen driver, workload %d, %dx%d"),
+              (int)m_workload, dim->width, dim->height);
+  resume();
+}
+
+SyntheticScreenDriver::~SyntheticScreenDriver()
+{
+  terminate();
+  wait();
+}
+
+void SyntheticScreenDriver::executeDetection()
+{
+  AutoLock al(&m_desktopMutex);
+  m_detectionEnabled = true;
+}
+
+void SyntheticScreenDriver::terminateDetection()
+{
+  AutoLock al(&m_desktopMutex);
+  m_detectionEnabled = false;
+}
+
+Dimension SyntheticScreenDriver::getScreenDimension()
+{
+  return m_screenBuffer.getDimension();
+}
+
+bool SyntheticScreenDriver::grabFb(const Rect *rect)
+{
+  AutoLock al(&m_desktopMutex);
+  if (rect == 0) {
+    return m_screenBuffer.copyFrom(&m_desktop, 0, 0);
+  }
+  return m_screenBuffer.copyFrom(rect, &m_desktop, rect->left, rect->top);
+}
+
+FrameBuffer *SyntheticScreenDriver::getScreenBuffer()
+{
+  return &m_screenBuffer;
+}
+
+bool SyntheticScreenDriver::getScreenPropertiesChanged()
+{
+  return false;
+}
+
+bool SyntheticScreenDriver::getScreenSizeChanged()
+{
+  return false;
+}
+
+bool SyntheticScreenDriver::applyNewScreenProperties()
+{
+  return true;
+}
+
+bool SyntheticScreenDriver::grabCursorShape(const PixelFormat *pf)
+{
+  // The synthetic desktop has no cursor of its own.
+  m_cursorShape.setPixelFormat(pf);
+  m_cursorShape.resetToEmpty();
+  return true;
+}
+
+const CursorShape *SyntheticScreenDriver::getCursorShape()
+{
+  return &m_cursorShape;
+}
+
+Point SyntheticScreenDriver::getCursorPosition()
+{
+  return m_cursorPos;
+}
+
+void SyntheticScreenDriver::getCopiedRegion(Rect *copyRect, Point *source)
+{
+  // Copies are reported directly to the update keeper.
+  copyRect->clear();
+  source->clear();
+}
+
+void SyntheticScreenDriver::getVideoRegion(Region *dstVidRegion)
+{
+  AutoLock al(&m_desktopMutex);
+  *dstVidRegion = m_videoRegion;
+}
+
+void SyntheticScreenDriver::execute()
+{
+  while (!isTerminating()) {
+    m_timer.waitForEvent(FRAME_INTERVAL);
+    if (isTerminating()) {
+      break;
+    }
+    bool notify;
+    {
+      AutoLock al(&m_desktopMutex);
+      notify = m_detectionEnabled && m_workload != IDLE;
+      if (notify) {
+        drawFrame();
+      }
+    }
+    if (notify) {
+      m_updateListener->onUpdate();
+    }
+  }
+}
+
+void SyntheticScreenDriver::onTerminate()
+{
+  m_timer.notify();
+}
+
+void SyntheticScreenDriver::drawFrame()
+{
+  switch (m_workload) {
+  case SCROLLING_TEXT:
+    scrollText();
+    break;
+  case WINDOW_DRAG:
+    dragWindow();
+    break;
+  case VIDEO:
+    playVideo();
+    break;
+  case TYPING:
+    typeChar();
+    break;
+  default:
+    break;
+  }
+}
+
+void SyntheticScreenDriver::drawBackground()
+{
+  Rect screen = m_desktop.getDimension().getRect();
+  m_desktop.fillRect(&screen, getColor(0xF0, 0xF0, 0xF0));
+  if (m_workload == SCROLLING_TEXT) {
+    for (int y = 0; y + GLYPH_HEIGHT <= screen.bottom; y += GLYPH_HEIGHT) {
+      Rect line(0, y, screen.right, y + GLYPH_HEIGHT);
+      drawTextLine(&line);
+    }
+  }
+}
+
+void SyntheticScreenDriver::drawWindow(const Rect *window)
+{
+  m_desktop.fillRect(window, getColor(0xFF, 0xFF, 0xFF));
+  Rect title(window->left, window->top, window->right,
+             min(window->top + 24, window->bottom));
+  m_desktop.fillRect(&title, getColor(0x20, 0x50, 0xA0));
+  for (int y = title.bottom + 4; y + GLYPH_HEIGHT <= window->bottom;
+       y += GLYPH_HEIGHT) {
+    Rect line(window->left + 8, y, window->right - 8, y + GLYPH_HEIGHT);
+    drawTextLine(&line);
+  }
+}
+
+void SyntheticScreenDriver::drawGlyph(int x, int y)
+{
+  UINT32 color = getColor(0x20, 0x20, 0x20);
+  // A few strokes are enough to produce text-like content.
+  int numStrokes = 2 + random() % 3;
+  for (int i = 0; i < numStrokes; i++) {
+    Rect stroke;
+    if (random() % 2 == 0) {
+      int sy = y + 2 + random() % (GLYPH_HEIGHT - 5);
+      stroke.setRect(x + 1, sy, x + GLYPH_WIDTH - 1, sy + 1);
+    } else {
+      int sx = x + 1 + random() % (GLYPH_WIDTH - 2);
+      stroke.setRect(sx, y + 2, sx + 1, y + GLYPH_HEIGHT - 3);
+    }
+    m_desktop.fillRect(&stroke, color);
+  }
+}
+
+void SyntheticScreenDriver::drawTextLine(const Rect *line)
+{
+  m_desktop.fillRect(line, getColor(0xF0, 0xF0, 0xF0));
+  int length = random() % (line->getWidth() / GLYPH_WIDTH + 1);
+  for (int i = 0; i < length; i++) {
+    int x = line->left + i * GLYPH_WIDTH;
+    if (random() % 6 != 0) {
+      drawGlyph(x, line->top);
+    }
+  }
+}
+
+void SyntheticScreenDriver::drawNoise(const Rect *area)
+{
+  UINT32 phase = random();
+  for (int y = area->top; y < area->bottom; y++) {
+    UINT32 *pixel = (UINT32 *)m_desktop.getBufferPtr(area->left, y);
+    for (int x = area->left; x < area->right; x++) {
+      UINT8 value = (UINT8)(x + y + phase);
+      *pixel++ = getColor(value, (UINT8)(value + (random() & 0x0F)),
+                          (UINT8)(255 - value));
+    }
+  }
+}
+
+void SyntheticScreenDriver::scrollText()
+{
+  Rect screen = m_desktop.getDimension().getRect();
+  if (screen.getHeight() <= GLYPH_HEIGHT) {
+    return;
+  }
+  Rect scrolled(0, 0, screen.right, screen.bottom - GLYPH_HEIGHT);
+  Point src(0, GLYPH_HEIGHT);
+  m_desktop.move(&scrolled, src.x, src.y);
+  Rect newLine(0, scrolled.bottom, screen.right, screen.bottom);
+  drawTextLine(&newLine);
+
+  m_updateKeeper->addCopyRect(&scrolled, &src);
+  m_updateKeeper->addChangedRect(&newLine);
+}
+
+void SyntheticScreenDriver::dragWindow()
+{
+  Rect screen = m_desktop.getDimension().getRect();
+  Rect newWindow(&m_window);
+  newWindow.move(m_windowDx, m_windowDy);
+  if (newWindow.left < 0 || newWindow.right > screen.right) {
+    m_windowDx = -m_windowDx;
+    newWindow.move(2 * m_windowDx, 0);
+  }
+  if (newWindow.top < 0 || newWindow.bottom > screen.bottom) {
+    m_windowDy = -m_windowDy;
+    newWindow.move(0, 2 * m_windowDy);
+  }
+  if (!screen.isFullyContainRect(&newWindow)) {
+    // The window is as big as the screen, there is no room to move.
+    return;
+  }
+
+  Point src(m_window.left, m_window.top);
+  m_desktop.move(&newWindow, src.x, src.y);
+
+  // Repaint the uncovered part of the old window area.
+  Region exposed(&m_window);
+  Region windowRegion(&newWindow);
+  exposed.subtract(&windowRegion);
+  std::vector<Rect> rects;
+  exposed.getRectVector(&rects);
+  for (std::vector<Rect>::iterator it = rects.begin(); it < rects.end(); it++) {
+    m_desktop.fillRect(&*it, getColor(0xF0, 0xF0, 0xF0));
+  }
+
+  m_updateKeeper->addCopyRect(&newWindow, &src);
+  m_updateKeeper->addChangedRegion(&exposed);
+  m_window = newWindow;
+}
+
+void SyntheticScreenDriver::playVideo()
+{
+  std::vector<Rect> rects;
+  m_videoRegion.getRectVector(&rects);
+  for (std::vector<Rect>::iterator it = rects.begin(); it < rects.end(); it++) {
+    drawNoise(&*it);
+  }
+  m_updateKeeper->addChangedRegion(&m_videoRegion);
+}
+
+void SyntheticScreenDriver::typeChar()
+{
+  Rect screen = m_desktop.getDimension().getRect();
+  if (m_textPos.x + GLYPH_WIDTH > screen.right) {
+    m_textPos.x = 0;
+    m_textPos.y += GLYPH_HEIGHT;
+  }
+  if (m_textPos.y + GLYPH_HEIGHT > screen.bottom) {
+    // The page is full, start a new one.
+    m_desktop.fillRect(&screen, getColor(0xF0, 0xF0, 0xF0));
+    m_updateKeeper->addChangedRect(&screen);
+    m_textPos.setPoint(0, 0);
+    return;
+  }
+  Rect cell(m_textPos.x, m_textPos.y,
+            m_textPos.x + GLYPH_WIDTH, m_textPos.y + GLYPH_HEIGHT);
+  if (random() % 6 != 0) {
+    drawGlyph(cell.left, cell.top);
+    m_updateKeeper->addChangedRect(&cell);
+  }
+  m_textPos.x += GLYPH_WIDTH;
+}
+
+UINT32 SyntheticScreenDriver::random()
+{
+  m_seed = m_seed * 1103515245 + 12345;
+  return (m_seed >> 16) & 0x7FFF;
+}
+
+UINT32 SyntheticScreenDriver::getColor(UINT8 red, UINT8 green,
+                                       UINT8 blue) const
+{
+  return ((UINT32)red << 16) | ((UINT32)green << 8) | blue;
+}
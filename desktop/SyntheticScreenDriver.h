@@ -0,0 +1,139 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __SYNTHETICSCREENDRIVER_H__
+#define __SYNTHETICSCREENDRIVER_H__
+
+#include "ScreenDriver.h"
+#include "UpdateKeeper.h"
+#include "UpdateListener.h"
+#include "thread/Thread.h"
+#include "thread/LocalMutex.h"
+#include "win-system/WindowsEvent.h"
+#include "log-writer/LogWriter.h"
+
+// This screen driver does not use the real desktop. Instead, its own thread
+// draws a selected workload into an internal frame buffer and reports the
+// exact damage (changed and copied areas) to the update keeper. It allows
+// running the server under a deterministic load on machines without an
+// interactive desktop.
+class SyntheticScreenDriver : public ScreenDriver, private Thread
+{
+public:
+  // The values are used in the server configuration (see
+  // ServerConfig::getSyntheticScreenWorkload()), so they must not change.
+  enum Workload {
+    // Nothing changes on the screen.
+    IDLE = 1,
+    // The screen scrolls up by one text line, a new line appears below.
+    SCROLLING_TEXT = 2,
+    // A window is dragged around the screen.
+    WINDOW_DRAG = 3,
+    // A video-like noise area in the middle of the screen.
+    VIDEO = 4,
+    // Characters are typed one by one.
+    TYPING = 5
+  };
+
+  SyntheticScreenDriver(Workload workload,
+                        const Dimension *dim,
+                        UpdateKeeper *updateKeeper,
+                        UpdateListener *updateListener,
+                        LogWriter *log);
+  virtual ~SyntheticScreenDriver();
+
+  virtual void executeDetection();
+  virtual void terminateDetection();
+
+  virtual Dimension getScreenDimension();
+  virtual bool grabFb(const Rect *rect = 0);
+  virtual FrameBuffer *getScreenBuffer();
+  virtual bool getScreenPropertiesChanged();
+  virtual bool getScreenSizeChanged();
+  virtual bool applyNewScreenProperties();
+
+  virtual bool grabCursorShape(const PixelFormat *pf);
+  virtual const CursorShape *getCursorShape();
+  virtual Point getCursorPosition();
+
+  virtual void getCopiedRegion(Rect *copyRect, Point *source);
+  virtual void getVideoRegion(Region *dstVidRegion);
+
+private:
+  virtual void execute();
+  virtual void onTerminate();
+
+  // Draw the next frame of the workload into m_desktop and report the
+  // damage. Must be called with m_desktopMutex locked.
+  void drawFrame();
+
+  void drawBackground();
+  void drawWindow(const Rect *window);
+  void drawGlyph(int x, int y);
+  void drawTextLine(const Rect *line);
+  void drawNoise(const Rect *area);
+
+  void scrollText();
+  void dragWindow();
+  void playVideo();
+  void typeChar();
+
+  // Simple linear congruential generator, so that all runs would produce
+  // the same picture.
+  UINT32 random();
+  UINT32 getColor(UINT8 red, UINT8 green, UINT8 blue) const;
+
+  static const int FRAME_INTERVAL = 40;
+  static const int GLYPH_WIDTH = 8;
+  static const int GLYPH_HEIGHT = 16;
+
+  Workload m_workload;
+
+  UpdateKeeper *m_updateKeeper;
+  UpdateListener *m_updateListener;
+
+  // The "live" desktop picture drawn by the driver thread.
+  FrameBuffer m_desktop;
+  // The picture copied from m_desktop by grabFb().
+  FrameBuffer m_screenBuffer;
+  LocalMutex m_desktopMutex;
+  Region m_videoRegion;
+
+  CursorShape m_cursorShape;
+  Point m_cursorPos;
+
+  // Workload state.
+  UINT32 m_seed;
+  Rect m_window;
+  int m_windowDx;
+  int m_windowDy;
+  Point m_textPos;
+
+  bool m_detectionEnabled;
+  WindowsEvent m_timer;
+
+  LogWriter *m_log;
+};
+
+#endif // __SYNTHETICSCREENDRIVER_H__
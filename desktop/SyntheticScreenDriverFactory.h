@@ -0,0 +1,50 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __SYNTHETICSCREENDRIVERFACTORY_H__
+#define __SYNTHETICSCREENDRIVERFACTORY_H__
+
+#include "ScreenDriverFactory.h"
+#include "SyntheticScreenDriver.h"
+
+// Creates SyntheticScreenDriver objects with the given workload and screen
+// size.
+class SyntheticScreenDriverFactory : public ScreenDriverFactory
+{
+public:
+  SyntheticScreenDriverFactory(SyntheticScreenDriver::Workload workload,
+                               const Dimension *dim);
+  virtual ~SyntheticScreenDriverFactory();
+
+  virtual ScreenDriver *createScreenDriver(UpdateKeeper *updateKeeper,
+                                             UpdateListener *updateListener,
+                                             FrameBuffer *fb,
+                                             LocalMutex *fbLocalMutex,
+                                             LogWriter *log);
+private:
+  SyntheticScreenDriver::Workload m_workload;
+  Dimension m_dim;
+};
+
+#endif // __SYNTHETICSCREENDRIVERFACTORY_H__
@@ -24,6 +24,7 @@
 
 #include "UpdateFilter.h"
 #include "util/CommonHeader.h"
+#include "log-writer/Tracer.h"
 
 static const int BLOCK_SIZE = 32;
 
@@ -45,6 +46,7 @@ UpdateFilter::~UpdateFilter()
 
 void UpdateFilter::filter(UpdateContainer *updateContainer)
 {
+  TRACE_SPAN_ARGS(span, "UpdateFilter::filter", "rects", 0);
   AutoLock al(m_fbMutex);
 
   FrameBuffer *screenFrameBuffer = m_screenDriver->getScreenBuffer();
@@ -70,9 +72,11 @@ void UpdateFilter::filter(UpdateContainer *updateContainer)
 
 
   toCheck.getRectVector(&rects);
+  span.setArgs(rects.size());
   // Grabbing
   m_log->debug(_T("grabbing region, %d rectangles"), (int)rects.size());
   try {
+    TRACE_SPAN(grabSpan, "GrabOptimizator::grab");
     m_grabOptimizator.grab(&toCheck, m_screenDriver);
   } catch (...) {
     return;
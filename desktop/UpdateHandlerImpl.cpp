@@ -23,10 +23,16 @@
 //
 
 #include "UpdateHandlerImpl.h"
+#include "server-config-lib/Configurator.h"
+#include "log-writer/Tracer.h"
+
+// Maximum size of the recorded data waiting to be written to disk.
+static const size_t MAX_RECORDER_QUEUE_SIZE = 64 * 1024 * 1024;
 
 UpdateHandlerImpl::UpdateHandlerImpl(UpdateListener *externalUpdateListener, ScreenDriverFactory *scrDriverFactory,
                                      LogWriter *log)
 : m_externalUpdateListener(externalUpdateListener),
+  m_recorder(0),
   m_fullUpdateRequested(false),
   m_log(log)
 {
@@ -44,6 +50,8 @@ UpdateHandlerImpl::UpdateHandlerImpl(UpdateListener *externalUpdateListener, Scr
   // At this point all common resources will be covered the mutex for changes.
   m_screenDriver->executeDetection();
 
+  startRecording();
+
   // Force first update with full screen grab
   m_absoluteRect = m_backupFrameBuffer.getDimension().getRect();
   m_updateKeeper.addChangedRect(&m_absoluteRect);
@@ -52,6 +60,7 @@ UpdateHandlerImpl::UpdateHandlerImpl(UpdateListener *externalUpdateListener, Scr
 
 UpdateHandlerImpl::~UpdateHandlerImpl()
 {
+  delete m_recorder;
   m_screenDriver->terminateDetection();
   delete m_updateFilter;
   delete m_screenDriver;
@@ -59,6 +68,8 @@ UpdateHandlerImpl::~UpdateHandlerImpl()
 
 void UpdateHandlerImpl::extract(UpdateContainer *updateContainer)
 {
+  TRACE_SPAN(span, "UpdateHandlerImpl::extract");
+
   Rect copyRect;
   Point copySrc;
   m_screenDriver->getCopiedRegion(&copyRect, &copySrc);
@@ -119,6 +130,10 @@ void UpdateHandlerImpl::extract(UpdateContainer *updateContainer)
 
     m_fullUpdateRequested = false;
   }
+
+  if (m_recorder != 0) {
+    m_recorder->record(updateContainer, &m_backupFrameBuffer);
+  }
 }
 
 void UpdateHandlerImpl::applyNewScreenProperties()
@@ -139,6 +154,25 @@ void UpdateHandlerImpl::applyNewScreenProperties()
   }
 }
 
+void UpdateHandlerImpl::startRecording()
+{
+  ServerConfig *srvConf = Configurator::getInstance()->getServerConfig();
+  if (!srvConf->isUpdateRecordingEnabled()) {
+    return;
+  }
+  StringStorage logDir;
+  srvConf->getLogFileDir(&logDir);
+  StringStorage fileName;
+  fileName.format(_T("%s\\updates-%I64u.tvtrace"), logDir.getString(),
+                  DateTime::now().getTime());
+  try {
+    m_recorder = new UpdateRecorder(fileName.getString(),
+                                    MAX_RECORDER_QUEUE_SIZE, m_log);
+  } catch (Exception &e) {
+    m_log->error(_T("Cannot start recording updates: %s"), e.getMessage());
+  }
+}
+
 void UpdateHandlerImpl::setFullUpdateRequested(const Region *region)
 {
   m_updateKeeper.addChangedRegion(region);
@@ -28,6 +28,7 @@
 #include "UpdateHandler.h"
 #include "ScreenDriver.h"
 #include "ScreenDriverFactory.h"
+#include "UpdateRecorder.h"
 
 // This class contain a base architecture implementation of the UpdateHandler class.
 class UpdateHandlerImpl : public UpdateHandler, public UpdateListener
@@ -58,10 +59,16 @@ private:
 
   void applyNewScreenProperties();
 
+  // Creates m_recorder if update recording is enabled in the server
+  // configuration.
+  void startRecording();
+
   UpdateKeeper m_updateKeeper;
   ScreenDriver *m_screenDriver;
   UpdateFilter *m_updateFilter;
   UpdateListener *m_externalUpdateListener;
+  // Optional update recorder, zero if recording is disabled.
+  UpdateRecorder *m_recorder;
 
   Rect m_absoluteRect;
 
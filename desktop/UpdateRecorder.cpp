@@ -0,0 +1,281 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "UpdateRecorder.h"
+
+#include "io-lib/DataOutputStream.h"
+#include "thread/AutoLock.h"
+#include "util/Exception.h"
+
+UpdateRecorder::UpdateRecorder(const TCHAR *fileName, size_t maxQueueSize,
+                               LogWriter *log)
+: m_file(0),
+  m_queueSize(0),
+  m_maxQueueSize(maxQueueSize),
+  m_failed(false),
+  m_keyFrameNeeded(false),
+  m_numDropped(0),
+  m_startTime(DateTime::now()),
+  m_log(log)
+{
+  m_file = new WinFileChannel(fileName, F_WRITE, FM_CREATE);
+
+  try {
+    DataOutputStream output(m_file);
+    output.writeFully(UpdateTraceDefs::SIGNATURE,
+                      UpdateTraceDefs::SIGNATURE_LENGTH);
+    output.writeUInt32(UpdateTraceDefs::VERSION);
+  } catch (...) {
+    delete m_file;
+    throw;
+  }
+
+  m_log->info(_T("Recording updates to %s"), fileName);
+  resume();
+}
+
+UpdateRecorder::~UpdateRecorder()
+{
+  terminate();
+  wait();
+
+  std::list<ByteArrayOutputStream *>::iterator it;
+  for (it = m_queue.begin(); it != m_queue.end(); it++) {
+    delete *it;
+  }
+  delete m_file;
+
+  if (m_numDropped != 0) {
+    m_log->info(_T("Update recorder dropped %u updates"), m_numDropped);
+  }
+}
+
+void UpdateRecorder::record(const UpdateContainer *updateContainer,
+                            const FrameBuffer *fb)
+{
+  if (m_failed) {
+    return;
+  }
+
+  Dimension dim = fb->getDimension();
+  PixelFormat pf = fb->getPixelFormat();
+  if (!dim.isEqualTo(&m_lastDim) || !pf.isEqualTo(&m_lastPf)) {
+    ByteArrayOutputStream *chunk = new ByteArrayOutputStream(32);
+    writeFormat(chunk, fb);
+    // Format chunks are small and must never be lost.
+    enqueue(chunk, true);
+    m_lastDim = dim;
+    m_lastPf = pf;
+  }
+
+  int flags = 0;
+  if (updateContainer->screenSizeChanged) {
+    flags |= UpdateTraceDefs::FLAG_SCREEN_SIZE_CHANGED;
+  }
+  if (updateContainer->cursorPosChanged) {
+    flags |= UpdateTraceDefs::FLAG_CURSOR_POS_CHANGED;
+  }
+  if (updateContainer->cursorShapeChanged) {
+    flags |= UpdateTraceDefs::FLAG_CURSOR_SHAPE_CHANGED;
+  }
+
+  Region changedRegion = updateContainer->changedRegion;
+  if (m_keyFrameNeeded) {
+    flags |= UpdateTraceDefs::FLAG_KEY_FRAME;
+    Rect fbRect = dim.getRect();
+    changedRegion.addRect(&fbRect);
+  }
+
+  size_t pixelSize = fb->getBytesPerPixel();
+  size_t chunkSize = 1 + 4 + 4 + 1 + 16 + getRegionSize(&changedRegion) +
+                     getRegionSize(&updateContainer->copiedRegion) +
+                     getRegionSize(&updateContainer->videoRegion);
+  std::vector<Rect> rects;
+  changedRegion.getRectVector(&rects);
+  for (std::vector<Rect>::iterator it = rects.begin(); it < rects.end(); it++) {
+    chunkSize += it->area() * pixelSize;
+  }
+
+  // A key frame is queued even if it's bigger than the limit, otherwise the
+  // recording could stop forever on a large screen.
+  bool force = m_keyFrameNeeded;
+  {
+    AutoLock al(&m_queueMutex);
+    if (!force && m_queueSize != 0 &&
+        m_queueSize + chunkSize > m_maxQueueSize) {
+      m_keyFrameNeeded = true;
+      m_numDropped++;
+      return;
+    }
+  }
+
+  ByteArrayOutputStream *chunk = new ByteArrayOutputStream(chunkSize);
+  writeUpdate(chunk, updateContainer, &changedRegion, fb, flags);
+  enqueue(chunk, true);
+  m_keyFrameNeeded = false;
+}
+
+void UpdateRecorder::execute()
+{
+  while (!isTerminating()) {
+    m_queueEvent.waitForEvent();
+    writeQueue();
+  }
+  // Write out the updates recorded before the termination.
+  writeQueue();
+}
+
+void UpdateRecorder::onTerminate()
+{
+  m_queueEvent.notify();
+}
+
+void UpdateRecorder::writeFormat(ByteArrayOutputStream *chunk,
+                                 const FrameBuffer *fb)
+{
+  Dimension dim = fb->getDimension();
+  PixelFormat pf = fb->getPixelFormat();
+
+  DataOutputStream output(chunk);
+  output.writeUInt8(UpdateTraceDefs::CHUNK_FORMAT);
+  output.writeUInt32(17);
+  output.writeUInt16(dim.width);
+  output.writeUInt16(dim.height);
+  output.writeUInt8(pf.bitsPerPixel);
+  output.writeUInt8(pf.colorDepth);
+  output.writeUInt8(pf.bigEndian ? 1 : 0);
+  output.writeUInt16(pf.redMax);
+  output.writeUInt16(pf.greenMax);
+  output.writeUInt16(pf.blueMax);
+  output.writeUInt8(pf.redShift);
+  output.writeUInt8(pf.greenShift);
+  output.writeUInt8(pf.blueShift);
+}
+
+void UpdateRecorder::writeUpdate(ByteArrayOutputStream *chunk,
+                                 const UpdateContainer *updateContainer,
+                                 const Region *changedRegion,
+                                 const FrameBuffer *fb,
+                                 int flags)
+{
+  DataOutputStream output(chunk);
+  output.writeUInt8(UpdateTraceDefs::CHUNK_UPDATE);
+  // The payload length is patched below when the size is known.
+  output.writeUInt32(0);
+
+  output.writeUInt32((UINT32)(DateTime::now() - m_startTime).getTime());
+  output.writeUInt8(flags);
+  output.writeInt32(updateContainer->cursorPos.x);
+  output.writeInt32(updateContainer->cursorPos.y);
+  output.writeInt32(updateContainer->copySrc.x);
+  output.writeInt32(updateContainer->copySrc.y);
+  writeRegion(&output, changedRegion);
+  writeRegion(&output, &updateContainer->copiedRegion);
+  writeRegion(&output, &updateContainer->videoRegion);
+
+  size_t pixelSize = fb->getBytesPerPixel();
+  std::vector<Rect> rects;
+  changedRegion->getRectVector(&rects);
+  for (std::vector<Rect>::iterator it = rects.begin(); it < rects.end(); it++) {
+    size_t rowSize = it->getWidth() * pixelSize;
+    for (int y = it->top; y < it->bottom; y++) {
+      output.writeFully(fb->getBufferPtr(it->left, y), rowSize);
+    }
+  }
+
+  UINT32 length = (UINT32)(chunk->size() - 5);
+  UINT8 *lengthPtr = (UINT8 *)chunk->toByteArray() + 1;
+  lengthPtr[0] = (UINT8)(length >> 24);
+  lengthPtr[1] = (UINT8)(length >> 16);
+  lengthPtr[2] = (UINT8)(length >> 8);
+  lengthPtr[3] = (UINT8)length;
+}
+
+void UpdateRecorder::writeRegion(DataOutputStream *output,
+                                 const Region *region)
+{
+  std::vector<Rect> rects;
+  region->getRectVector(&rects);
+  output->writeUInt32((UINT32)rects.size());
+  for (std::vector<Rect>::iterator it = rects.begin(); it < rects.end(); it++) {
+    output->writeUInt16(it->left);
+    output->writeUInt16(it->top);
+    output->writeUInt16(it->getWidth());
+    output->writeUInt16(it->getHeight());
+  }
+}
+
+size_t UpdateRecorder::getRegionSize(const Region *region)
+{
+  std::vector<Rect> rects;
+  region->getRectVector(&rects);
+  return 4 + rects.size() * 8;
+}
+
+bool UpdateRecorder::enqueue(ByteArrayOutputStream *chunk, bool force)
+{
+  {
+    AutoLock al(&m_queueMutex);
+    if (force || m_queueSize + chunk->size() <= m_maxQueueSize) {
+      m_queue.push_back(chunk);
+      m_queueSize += chunk->size();
+      chunk = 0;
+    }
+  }
+  if (chunk != 0) {
+    delete chunk;
+    return false;
+  }
+  m_queueEvent.notify();
+  return true;
+}
+
+void UpdateRecorder::writeQueue()
+{
+  while (true) {
+    ByteArrayOutputStream *chunk;
+    {
+      AutoLock al(&m_queueMutex);
+      if (m_queue.empty()) {
+        return;
+      }
+      chunk = m_queue.front();
+    }
+    if (!m_failed) {
+      try {
+        DataOutputStream output(m_file);
+        output.writeFully(chunk->toByteArray(), chunk->size());
+      } catch (Exception &e) {
+        m_log->error(_T("Cannot write the update trace: %s"), e.getMessage());
+        m_failed = true;
+      }
+    }
+    {
+      AutoLock al(&m_queueMutex);
+      m_queue.pop_front();
+      m_queueSize -= chunk->size();
+    }
+    delete chunk;
+  }
+}
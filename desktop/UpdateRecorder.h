@@ -0,0 +1,98 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __UPDATERECORDER_H__
+#define __UPDATERECORDER_H__
+
+#include <list>
+
+#include "thread/Thread.h"
+#include "thread/LocalMutex.h"
+#include "win-system/WindowsEvent.h"
+#include "io-lib/ByteArrayOutputStream.h"
+#include "file-lib/WinFileChannel.h"
+#include "rfb/FrameBuffer.h"
+#include "rfb/UpdateTraceDefs.h"
+#include "util/DateTime.h"
+#include "log-writer/LogWriter.h"
+#include "UpdateContainer.h"
+
+// UpdateRecorder writes update containers together with the changed pixels
+// to an update trace file (see rfb/UpdateTraceDefs.h). The caller thread
+// only serializes the data to memory, the file is written by the recorder
+// thread. The amount of memory used by the chunks waiting to be written is
+// limited, updates which do not fit are dropped and the next recorded
+// update carries the whole frame buffer.
+class UpdateRecorder : public Thread
+{
+public:
+  // Creates the trace file and starts the writer thread. Throws Exception
+  // if the file cannot be created.
+  UpdateRecorder(const TCHAR *fileName, size_t maxQueueSize, LogWriter *log);
+  virtual ~UpdateRecorder();
+
+  // Add the update to the trace. The changed pixels are taken from *fb
+  // which must have been already updated with this update container.
+  void record(const UpdateContainer *updateContainer, const FrameBuffer *fb);
+
+protected:
+  virtual void execute();
+  virtual void onTerminate();
+
+  void writeFormat(ByteArrayOutputStream *chunk, const FrameBuffer *fb);
+  void writeUpdate(ByteArrayOutputStream *chunk,
+                   const UpdateContainer *updateContainer,
+                   const Region *changedRegion,
+                   const FrameBuffer *fb,
+                   int flags);
+  static void writeRegion(DataOutputStream *output, const Region *region);
+  static size_t getRegionSize(const Region *region);
+
+  // Put the chunk to the queue. If force is false and the queue is full,
+  // the chunk is deleted and false is returned.
+  bool enqueue(ByteArrayOutputStream *chunk, bool force);
+  // Write out all the queued chunks.
+  void writeQueue();
+
+  WinFileChannel *m_file;
+
+  std::list<ByteArrayOutputStream *> m_queue;
+  size_t m_queueSize;
+  size_t m_maxQueueSize;
+  LocalMutex m_queueMutex;
+  WindowsEvent m_queueEvent;
+  // Set when the writer fails, after that all updates are ignored.
+  bool m_failed;
+
+  // The following members are used only by the thread calling record().
+  Dimension m_lastDim;
+  PixelFormat m_lastPf;
+  bool m_keyFrameNeeded;
+  unsigned int m_numDropped;
+  DateTime m_startTime;
+
+  LogWriter *m_log;
+};
+
+#endif // __UPDATERECORDER_H__
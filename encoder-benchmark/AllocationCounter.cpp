@@ -0,0 +1,65 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "AllocationCounter.h"
+
+#include <new>
+#include <stdlib.h>
+
+// A thread-local variable needs no synchronization and, unlike TlsAlloc(),
+// is usable before any static constructor has run.
+static __declspec(thread) UINT64 s_threadCount = 0;
+
+UINT64 AllocationCounter::getThreadCount()
+{
+  return s_threadCount;
+}
+
+// The replacements allocate with malloc() as the default operator new of
+// the CRT does, so memory allocated by the CRT itself can be freed by them.
+
+void *operator new(size_t size)
+{
+  s_threadCount++;
+  void *p = malloc(size != 0 ? size : 1);
+  if (p == 0) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void *operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete(void *p)
+{
+  free(p);
+}
+
+void operator delete[](void *p)
+{
+  free(p);
+}
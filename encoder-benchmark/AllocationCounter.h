@@ -0,0 +1,43 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __ALLOCATIONCOUNTER_H__
+#define __ALLOCATIONCOUNTER_H__
+
+#include "util/CommonHeader.h"
+
+// Counts heap allocations made with operator new by each thread. The
+// benchmark replaces the global operator new to do it, so the count covers
+// all the code linked into the benchmark, including the viewer core.
+class AllocationCounter
+{
+public:
+  // Returns the number of allocations made by the calling thread.
+  static UINT64 getThreadCount();
+
+private:
+  AllocationCounter();
+};
+
+#endif // __ALLOCATIONCOUNTER_H__
@@ -0,0 +1,141 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "ClientRequestReader.h"
+
+#include "rfb/MsgDefs.h"
+#include "thread/AutoLock.h"
+
+ClientRequestReader::ClientRequestReader(DataInputStream *input)
+: m_input(input),
+  m_numRequests(0),
+  m_isFailed(false),
+  m_hasNewEncodings(false)
+{
+  resume();
+}
+
+ClientRequestReader::~ClientRequestReader()
+{
+  terminate();
+  wait();
+}
+
+bool ClientRequestReader::waitForRequest(DWORD milliseconds)
+{
+  DWORD startTime = GetTickCount();
+  while (true) {
+    {
+      AutoLock al(&m_requestLock);
+      if (m_numRequests > 0) {
+        m_numRequests--;
+        return true;
+      }
+      if (m_isFailed) {
+        return false;
+      }
+    }
+    DWORD elapsed = GetTickCount() - startTime;
+    if (elapsed >= milliseconds) {
+      return false;
+    }
+    m_requestEvent.waitForEvent(milliseconds - elapsed);
+  }
+}
+
+bool ClientRequestReader::getEncodings(std::vector<int> *encodings)
+{
+  AutoLock al(&m_requestLock);
+  if (!m_hasNewEncodings) {
+    return false;
+  }
+  *encodings = m_encodings;
+  m_hasNewEncodings = false;
+  return true;
+}
+
+void ClientRequestReader::execute()
+{
+  try {
+    while (!isTerminating()) {
+      UINT8 messageType = m_input->readUInt8();
+      if (messageType == ClientMsgDefs::FB_UPDATE_REQUEST) {
+        // Incremental flag and the requested area.
+        char request[9];
+        m_input->readFully(request, sizeof(request));
+        AutoLock al(&m_requestLock);
+        m_numRequests++;
+        m_requestEvent.notify();
+      } else if (messageType == ClientMsgDefs::SET_ENCODINGS) {
+        readEncodings();
+      } else {
+        skipMessage(messageType);
+      }
+    }
+  } catch (...) {
+  }
+  AutoLock al(&m_requestLock);
+  m_isFailed = true;
+  m_requestEvent.notify();
+}
+
+void ClientRequestReader::readEncodings()
+{
+  m_input->readUInt8(); // padding
+  UINT16 numEncodings = m_input->readUInt16();
+  std::vector<int> encodings(numEncodings);
+  for (UINT16 i = 0; i < numEncodings; i++) {
+    encodings[i] = m_input->readInt32();
+  }
+  AutoLock al(&m_requestLock);
+  m_encodings.swap(encodings);
+  m_hasNewEncodings = true;
+}
+
+void ClientRequestReader::skipMessage(UINT8 messageType)
+{
+  char buffer[32];
+  switch (messageType) {
+  case ClientMsgDefs::SET_PIXEL_FORMAT:
+    m_input->readFully(buffer, 3 + 16);
+    break;
+  case ClientMsgDefs::KEYBOARD_EVENT:
+    m_input->readFully(buffer, 7);
+    break;
+  case ClientMsgDefs::POINTER_EVENT:
+    m_input->readFully(buffer, 5);
+    break;
+  case ClientMsgDefs::CLIENT_CUT_TEXT:
+    {
+      m_input->readFully(buffer, 3);
+      UINT32 length = m_input->readUInt32();
+      for (UINT32 i = 0; i < length; i++) {
+        m_input->readUInt8();
+      }
+    }
+    break;
+  default:
+    throw Exception(_T("Unsupported client message"));
+  }
+}
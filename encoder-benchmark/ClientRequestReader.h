@@ -0,0 +1,74 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __CLIENTREQUESTREADER_H__
+#define __CLIENTREQUESTREADER_H__
+
+#include "io-lib/DataInputStream.h"
+#include "thread/Thread.h"
+#include "thread/LocalMutex.h"
+#include "win-system/WindowsEvent.h"
+
+#include <vector>
+
+// Reads client-to-server messages on the server side of the loopback
+// benchmark and counts framebuffer update requests. The encodings set by
+// the viewer are kept for the benchmark, which uses them only if the viewer
+// tunes its encoding. Other messages are skipped, the server always uses
+// its own pixel format.
+class ClientRequestReader : public Thread
+{
+public:
+  // The input stream must remain valid until the thread is finished. It
+  // is finished when reading fails, e.g. after the connection is closed.
+  ClientRequestReader(DataInputStream *input);
+  virtual ~ClientRequestReader();
+
+  // Waits for an update request not answered yet and marks it answered.
+  // Returns false if there was no request within the timeout or the
+  // connection is broken.
+  bool waitForRequest(DWORD milliseconds);
+
+  // Returns true and the encodings of the last SetEncodings message if the
+  // message has come after the previous call.
+  bool getEncodings(std::vector<int> *encodings);
+
+protected:
+  virtual void execute();
+
+private:
+  void readEncodings();
+  void skipMessage(UINT8 messageType);
+
+  DataInputStream *m_input;
+
+  int m_numRequests;
+  bool m_isFailed;
+  std::vector<int> m_encodings;
+  bool m_hasNewEncodings;
+  LocalMutex m_requestLock;
+  WindowsEvent m_requestEvent;
+};
+
+#endif // __CLIENTREQUESTREADER_H__
@@ -0,0 +1,269 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "EncoderBenchmark.h"
+
+#include "rfb/EncodingDefs.h"
+#include "rfb/PixelConverter.h"
+#include "rfb-sconn/EncoderStore.h"
+#include "io-lib/DataOutputStream.h"
+#include "util/PreciseTimer.h"
+#include "NullOutputStream.h"
+
+EncoderBenchmark::EncoderBenchmark(FrameSource *source, FILE *report)
+: m_source(source),
+  m_report(report)
+{
+}
+
+EncoderBenchmark::~EncoderBenchmark()
+{
+}
+
+void EncoderBenchmark::addConfig(int encoding, int compressionLevel,
+                                 int jpegQuality)
+{
+  Config config;
+  config.encoding = encoding;
+  config.compressionLevel = compressionLevel;
+  config.jpegQuality = jpegQuality;
+  config.isSolidAreaExtraction = true;
+  addConfig(&config);
+}
+
+void EncoderBenchmark::addConfig(const Config *config)
+{
+  m_configs.push_back(*config);
+}
+
+void EncoderBenchmark::addDefaultConfigs()
+{
+  addConfig(EncodingDefs::RAW);
+  addConfig(EncodingDefs::RRE);
+  addConfig(EncodingDefs::HEXTILE);
+  addConfig(EncodingDefs::ZRLE);
+  for (int level = 0; level <= 9; level++) {
+    addConfig(EncodingDefs::TIGHT, level);
+  }
+  for (int quality = 0; quality <= 9; quality++) {
+    addConfig(EncodingDefs::TIGHT, 6, quality);
+  }
+}
+
+void EncoderBenchmark::addSolidAreaConfigs()
+{
+  static const int jpegQualities[] = { -1, 1, 5, 9 };
+  Config config;
+  config.encoding = EncodingDefs::TIGHT;
+  for (int level = 0; level <= 9; level++) {
+    for (size_t i = 0; i < sizeof(jpegQualities) / sizeof(int); i++) {
+      // The JPEG quality is tested at the default compression level only.
+      if (jpegQualities[i] >= 0 && level != 6) {
+        continue;
+      }
+      config.compressionLevel = level;
+      config.jpegQuality = jpegQualities[i];
+      config.isSolidAreaExtraction = false;
+      addConfig(&config);
+      config.isSolidAreaExtraction = true;
+      addConfig(&config);
+    }
+  }
+}
+
+void EncoderBenchmark::run()
+{
+  Dimension dim = m_source->getDimension();
+  _ftprintf(m_report, _T("Workload: %s, %dx%d, %d bpp\n\n"),
+            m_source->getName(), dim.width, dim.height,
+            (int)m_source->getPixelFormat().bitsPerPixel);
+  printHeader();
+
+  for (size_t i = 0; i < m_configs.size(); i++) {
+    testConfig(&m_configs[i]);
+  }
+}
+
+void EncoderBenchmark::testConfig(const Config *config)
+{
+  Result result;
+  runConfig(config, &result);
+  printResult(config, &result);
+}
+
+void EncoderBenchmark::runConfig(const Config *config, Result *result)
+{
+  memset(result, 0, sizeof(Result));
+
+  m_source->rewind();
+  Dimension dim = m_source->getDimension();
+  PixelFormat pf = m_source->getPixelFormat();
+
+  FrameBuffer frameBuffer;
+  frameBuffer.setProperties(&dim, &pf);
+
+  // The client is assumed to use the server pixel format, so the encoders
+  // work with the same pixels UpdateSender would give them in most cases.
+  PixelConverter pixelConverter;
+  pixelConverter.setPixelFormats(&pf, &pf);
+
+  NullOutputStream nullOutput;
+  DataOutputStream output(&nullOutput);
+  EncoderStore encoders(&pixelConverter, &output);
+  encoders.setTightSolidAreaExtraction(config->isSolidAreaExtraction);
+
+  EncodeOptions options;
+  getEncodeOptions(config, &options);
+
+  encoders.selectEncoder(options.getPreferredEncoding());
+  Encoder *encoder = encoders.getEncoder();
+
+  Region damage;
+  std::vector<Rect> damageRects;
+  std::vector<Rect> rects;
+  while (true) {
+    double startTime = getTime();
+    if (!m_source->getNextFrame(&frameBuffer, &damage)) {
+      break;
+    }
+    double loadedTime = getTime();
+
+    damageRects.clear();
+    damage.getRectVector(&damageRects);
+    rects.clear();
+    std::vector<Rect>::iterator it;
+    for (it = damageRects.begin(); it < damageRects.end(); it++) {
+      encoder->splitRectangle(&*it, &rects, &frameBuffer, &options);
+      result->numPixels += it->area();
+    }
+    double splitTime = getTime();
+
+    encoder->sendRectangles(&rects, &frameBuffer, &options);
+    output.flush();
+    double encodedTime = getTime();
+
+    result->numFrames++;
+    result->numRects += rects.size();
+    result->loadTime += loadedTime - startTime;
+    result->splitTime += splitTime - loadedTime;
+    result->encodeTime += encodedTime - splitTime;
+  }
+  result->numBytes = nullOutput.getBytesWritten();
+}
+
+void EncoderBenchmark::getEncodeOptions(const Config *config,
+                                        EncodeOptions *options)
+{
+  std::vector<int> encodings;
+  encodings.push_back(config->encoding);
+  if (config->compressionLevel >= 0) {
+    encodings.push_back(PseudoEncDefs::COMPR_LEVEL_0 +
+                        config->compressionLevel);
+  }
+  if (config->jpegQuality >= 0) {
+    encodings.push_back(PseudoEncDefs::QUALITY_LEVEL_0 + config->jpegQuality);
+  }
+  options->setEncodings(&encodings);
+}
+
+void EncoderBenchmark::printHeader()
+{
+  _ftprintf(m_report,
+            _T("%-10s %5s %5s %-8s %9s %12s %9s %9s %9s %9s %7s\n"),
+            _T("Encoding"), _T("Compr"), _T("JPEG"), _T("Variant"),
+            _T("MPix/s"),
+            _T("Bytes/frame"), _T("Rects/fr"), _T("Load ms"),
+            _T("Split ms"), _T("Enc ms"), _T("Ratio"));
+}
+
+void EncoderBenchmark::printResult(const Config *config, const Result *result)
+{
+  TCHAR compressionLevel[16] = _T("-");
+  if (config->compressionLevel >= 0) {
+    _stprintf_s(compressionLevel, 16, _T("%d"), config->compressionLevel);
+  }
+  TCHAR jpegQuality[16] = _T("-");
+  if (config->jpegQuality >= 0) {
+    _stprintf_s(jpegQuality, 16, _T("%d"), config->jpegQuality);
+  }
+
+  double numFrames = result->numFrames != 0 ? (double)result->numFrames : 1.0;
+  double codingTime = result->splitTime + result->encodeTime;
+  double mpixPerSecond = 0.0;
+  if (codingTime > 0.0) {
+    mpixPerSecond = (double)result->numPixels / codingTime / 1000000.0;
+  }
+  // The ratio is computed against the size of the damaged pixels in the
+  // server pixel format.
+  double rawSize = (double)result->numPixels *
+                   (m_source->getPixelFormat().bitsPerPixel / 8);
+  double ratio = 0.0;
+  if (result->numBytes != 0) {
+    ratio = rawSize / (double)result->numBytes;
+  }
+
+  _ftprintf(m_report,
+            _T("%-10s %5s %5s %-8s %9.2f %12.0f %9.1f %9.3f %9.3f %9.3f")
+            _T(" %7.2f\n"),
+            getEncodingName(config->encoding), compressionLevel, jpegQuality,
+            getVariantName(config), mpixPerSecond,
+            (double)result->numBytes / numFrames,
+            (double)result->numRects / numFrames,
+            result->loadTime * 1000.0 / numFrames,
+            result->splitTime * 1000.0 / numFrames,
+            result->encodeTime * 1000.0 / numFrames,
+            ratio);
+  fflush(m_report);
+}
+
+double EncoderBenchmark::getTime()
+{
+  return (double)PreciseTimer::getMicroseconds() / 1000000.0;
+}
+
+const TCHAR *EncoderBenchmark::getEncodingName(int encoding)
+{
+  switch (encoding) {
+  case EncodingDefs::RAW:
+    return _T("Raw");
+  case EncodingDefs::RRE:
+    return _T("RRE");
+  case EncodingDefs::HEXTILE:
+    return _T("Hextile");
+  case EncodingDefs::ZRLE:
+    return _T("ZRLE");
+  case EncodingDefs::TIGHT:
+    return _T("Tight");
+  default:
+    return _T("Unknown");
+  }
+}
+
+const TCHAR *EncoderBenchmark::getVariantName(const Config *config)
+{
+  if (!config->isSolidAreaExtraction) {
+    return _T("nosolid");
+  }
+  return _T("-");
+}
@@ -0,0 +1,113 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __ENCODERBENCHMARK_H__
+#define __ENCODERBENCHMARK_H__
+
+#include <stdio.h>
+#include <vector>
+
+#include "FrameSource.h"
+#include "rfb-sconn/EncodeOptions.h"
+
+// Runs a sequence of frames through RFB encoders the same way UpdateSender
+// does (splitRectangle() and then sendRectangles() via EncoderStore) and
+// reports throughput, output size and the time spent in each stage.
+// The encoded data is counted and thrown away.
+class EncoderBenchmark
+{
+public:
+  // The source must remain valid during the life of this object.
+  EncoderBenchmark(FrameSource *source, FILE *report);
+  virtual ~EncoderBenchmark();
+
+  // Add an encoder configuration to test. Negative compression level or
+  // JPEG quality means the option is not requested, as if the client did
+  // not include the corresponding pseudo-encoding.
+  void addConfig(int encoding, int compressionLevel = -1,
+                 int jpegQuality = -1);
+
+  // Add Raw, RRE, Hextile, ZRLE, Tight at each compression level and Tight
+  // at each JPEG quality level.
+  void addDefaultConfigs();
+
+  // Add Tight at each compression level and at a few JPEG quality levels,
+  // each one without and with the extraction of solid-color areas, to show
+  // the effect of the pre-pass on the number of rectangles, the output size
+  // and the time.
+  void addSolidAreaConfigs();
+
+  // Run all the configurations one by one, printing a line for each.
+  void run();
+
+protected:
+  struct Config
+  {
+    int encoding;
+    int compressionLevel;
+    int jpegQuality;
+    // Passed to EncoderStore::setTightSolidAreaExtraction().
+    bool isSolidAreaExtraction;
+  };
+
+  struct Result
+  {
+    int numFrames;
+    UINT64 numPixels;
+    UINT64 numBytes;
+    UINT64 numRects;
+    double loadTime;
+    double splitTime;
+    double encodeTime;
+  };
+
+  void addConfig(const Config *config);
+
+  // Run one configuration and print its results.
+  virtual void testConfig(const Config *config);
+
+  void runConfig(const Config *config, Result *result);
+
+  // Fill the options with the encodings a client would send for the
+  // configuration.
+  static void getEncodeOptions(const Config *config, EncodeOptions *options);
+
+  virtual void printHeader();
+  void printResult(const Config *config, const Result *result);
+
+  // Return the current value of PreciseTimer in seconds.
+  static double getTime();
+
+  static const TCHAR *getEncodingName(int encoding);
+
+  // Return a short description of the encoder settings the configuration
+  // changes from their defaults, or "-" if there are none.
+  static const TCHAR *getVariantName(const Config *config);
+
+  FrameSource *m_source;
+  FILE *m_report;
+  std::vector<Config> m_configs;
+};
+
+#endif // __ENCODERBENCHMARK_H__
@@ -0,0 +1,149 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "FrameSequenceFile.h"
+
+#include "file-lib/EOFException.h"
+#include "util/Exception.h"
+
+const char FrameSequenceFile::SIGNATURE[8] = {
+  'T', 'V', 'N', 'F', 'B', 'S', 'E', 'Q'
+};
+
+FrameSequenceFile::FrameSequenceFile(const TCHAR *fileName)
+: m_fileName(fileName),
+  m_file(0),
+  m_input(0)
+{
+  open();
+}
+
+FrameSequenceFile::~FrameSequenceFile()
+{
+  close();
+}
+
+Dimension FrameSequenceFile::getDimension() const
+{
+  return m_dim;
+}
+
+PixelFormat FrameSequenceFile::getPixelFormat() const
+{
+  return m_pf;
+}
+
+const TCHAR *FrameSequenceFile::getName() const
+{
+  return m_fileName.getString();
+}
+
+void FrameSequenceFile::rewind()
+{
+  close();
+  open();
+}
+
+bool FrameSequenceFile::getNextFrame(FrameBuffer *fb, Region *damage)
+{
+  damage->clear();
+
+  UINT32 numRects;
+  try {
+    numRects = m_input->readUInt32();
+  } catch (EOFException &) {
+    return false;
+  }
+
+  Rect screen = m_dim.getRect();
+  size_t pixelSize = m_pf.bitsPerPixel / 8;
+  for (UINT32 i = 0; i < numRects; i++) {
+    Rect r;
+    r.left = m_input->readUInt16();
+    r.top = m_input->readUInt16();
+    r.setWidth(m_input->readUInt16());
+    r.setHeight(m_input->readUInt16());
+    if (!screen.isFullyContainRect(&r)) {
+      throw Exception(_T("A rectangle in the frame sequence is out of")
+                      _T(" the frame bounds"));
+    }
+    size_t rowSize = r.getWidth() * pixelSize;
+    for (int y = r.top; y < r.bottom; y++) {
+      m_input->readFully(fb->getBufferPtr(r.left, y), rowSize);
+    }
+    damage->addRect(&r);
+  }
+  return true;
+}
+
+void FrameSequenceFile::open()
+{
+  m_file = new WinFileChannel(m_fileName.getString(), F_READ, FM_OPEN);
+  m_input = new DataInputStream(m_file);
+  try {
+    readHeader();
+  } catch (...) {
+    close();
+    throw;
+  }
+}
+
+void FrameSequenceFile::close()
+{
+  if (m_input != 0) {
+    delete m_input;
+    m_input = 0;
+  }
+  if (m_file != 0) {
+    delete m_file;
+    m_file = 0;
+  }
+}
+
+void FrameSequenceFile::readHeader()
+{
+  char signature[sizeof(SIGNATURE)];
+  m_input->readFully(signature, sizeof(signature));
+  if (memcmp(signature, SIGNATURE, sizeof(SIGNATURE)) != 0) {
+    throw Exception(_T("Not a frame sequence file"));
+  }
+
+  int width = m_input->readUInt16();
+  int height = m_input->readUInt16();
+  m_dim.setDim(width, height);
+
+  m_pf.initBigEndianByNative();
+  m_pf.bitsPerPixel = m_input->readUInt8();
+  m_pf.colorDepth = m_input->readUInt8();
+  m_pf.redMax = m_input->readUInt16();
+  m_pf.greenMax = m_input->readUInt16();
+  m_pf.blueMax = m_input->readUInt16();
+  m_pf.redShift = m_input->readUInt8();
+  m_pf.greenShift = m_input->readUInt8();
+  m_pf.blueShift = m_input->readUInt8();
+
+  if (m_pf.bitsPerPixel != 16 && m_pf.bitsPerPixel != 32) {
+    throw Exception(_T("Unsupported pixel format in the frame sequence"));
+  }
+}
@@ -0,0 +1,77 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __FRAMESEQUENCEFILE_H__
+#define __FRAMESEQUENCEFILE_H__
+
+#include "file-lib/WinFileChannel.h"
+#include "io-lib/DataInputStream.h"
+#include "util/StringStorage.h"
+#include "FrameSource.h"
+
+// Reads a recorded sequence of frames from a file. The file format is:
+//
+//   8 bytes   signature "TVNFBSEQ"
+//   UINT16    frame width
+//   UINT16    frame height
+//   UINT8     bits per pixel (16 or 32)
+//   UINT8     color depth
+//   UINT16    red max, green max, blue max
+//   UINT8     red shift, green shift, blue shift
+//   then, for each frame until the end of the file:
+//     UINT32  number of damaged rectangles
+//     for each rectangle:
+//       UINT16  x, y, width, height
+//       pixels  width * height pixels in the native byte order, row by row
+//
+// All integers are in network byte order.
+class FrameSequenceFile : public FrameSource
+{
+public:
+  // Opens the file and reads its header. Throws Exception on errors.
+  FrameSequenceFile(const TCHAR *fileName);
+  virtual ~FrameSequenceFile();
+
+  virtual Dimension getDimension() const;
+  virtual PixelFormat getPixelFormat() const;
+  virtual const TCHAR *getName() const;
+  virtual void rewind();
+  virtual bool getNextFrame(FrameBuffer *fb, Region *damage);
+
+  static const char SIGNATURE[8];
+
+protected:
+  void open();
+  void close();
+  void readHeader();
+
+  StringStorage m_fileName;
+  WinFileChannel *m_file;
+  DataInputStream *m_input;
+
+  Dimension m_dim;
+  PixelFormat m_pf;
+};
+
+#endif // __FRAMESEQUENCEFILE_H__
@@ -0,0 +1,56 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __FRAMESOURCE_H__
+#define __FRAMESOURCE_H__
+
+#include "rfb/FrameBuffer.h"
+#include "region/Region.h"
+
+// An abstract source of framebuffer frames for the encoder benchmark. Each
+// frame is a set of changed pixels together with the damage region which
+// covers all the changes made since the previous frame.
+class FrameSource
+{
+public:
+  virtual ~FrameSource() {}
+
+  // Return the frame size and the pixel format. They don't change during
+  // the sequence.
+  virtual Dimension getDimension() const = 0;
+  virtual PixelFormat getPixelFormat() const = 0;
+
+  // Return a short human-readable description of the workload.
+  virtual const TCHAR *getName() const = 0;
+
+  // Start the sequence from the beginning.
+  virtual void rewind() = 0;
+
+  // Apply the next frame to fb (which must have the dimension and the pixel
+  // format reported by this source) and store the changed area in *damage.
+  // Return false if there are no more frames.
+  virtual bool getNextFrame(FrameBuffer *fb, Region *damage) = 0;
+};
+
+#endif // __FRAMESOURCE_H__
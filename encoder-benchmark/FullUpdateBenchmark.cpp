@@ -0,0 +1,283 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "FullUpdateBenchmark.h"
+
+#include "rfb/EncodingDefs.h"
+#include "rfb/PixelConverter.h"
+#include "rfb-sconn/EncoderStore.h"
+#include "io-lib/ByteArrayInputStream.h"
+#include "io-lib/DataOutputStream.h"
+#include "log-writer/LogWriter.h"
+#include "network/RfbInputGate.h"
+#include "util/Exception.h"
+#include "util/PreciseTimer.h"
+
+FullUpdateBenchmark::FullUpdateBenchmark(FrameSource *source, FILE *report)
+: m_source(source),
+  m_report(report)
+{
+}
+
+FullUpdateBenchmark::~FullUpdateBenchmark()
+{
+}
+
+void FullUpdateBenchmark::runTightParallel()
+{
+  printHeader();
+
+  // The lossless configurations must decode to the same pixels, the JPEG
+  // one shows the speedup of the photo-like content.
+  static const int compressionLevels[] = { 1, 6, 9, 6 };
+  static const int jpegQualities[] = { -1, -1, -1, 6 };
+  for (size_t i = 0; i < sizeof(compressionLevels) / sizeof(int); i++) {
+    for (int isParallel = 0; isParallel <= 1; isParallel++) {
+      Config config;
+      config.compressionLevel = compressionLevels[i];
+      config.jpegQuality = jpegQualities[i];
+      config.isParallel = isParallel != 0;
+      config.isVideo = false;
+      config.numJpegThreads = 1;
+      Result result;
+      runConfig(&config, &result);
+      printResult(&config, &result);
+    }
+  }
+}
+
+void FullUpdateBenchmark::runVideo(int maxThreads)
+{
+  printHeader();
+
+  for (int numThreads = 1; ; numThreads *= 2) {
+    if (numThreads > maxThreads) {
+      // The last line is for the requested number of threads.
+      if (numThreads / 2 == maxThreads) {
+        break;
+      }
+      numThreads = maxThreads;
+    }
+    Config config;
+    config.compressionLevel = 6;
+    config.jpegQuality = 6;
+    config.isParallel = false;
+    config.isVideo = true;
+    config.numJpegThreads = numThreads;
+    Result result;
+    runConfig(&config, &result);
+    printResult(&config, &result);
+  }
+}
+
+void FullUpdateBenchmark::printHeader()
+{
+  Dimension dim = m_source->getDimension();
+  _ftprintf(m_report, _T("Workload: %s, %dx%d, %d bpp\n\n"),
+            m_source->getName(), dim.width, dim.height,
+            (int)m_source->getPixelFormat().bitsPerPixel);
+  _ftprintf(m_report, _T("%-10s %5s %5s %-9s %9s %9s %12s %9s %10s\n"),
+            _T("Encoding"), _T("Compr"), _T("JPEG"), _T("Variant"),
+            _T("Upd ms"), _T("Upd/s"), _T("Bytes/upd"), _T("Rects/upd"),
+            _T("Diff px"));
+}
+
+void FullUpdateBenchmark::runConfig(const Config *config, Result *result)
+{
+  memset(result, 0, sizeof(Result));
+
+  m_source->rewind();
+  Dimension dim = m_source->getDimension();
+  PixelFormat pf = m_source->getPixelFormat();
+
+  FrameBuffer frameBuffer;
+  frameBuffer.setProperties(&dim, &pf);
+
+  PixelConverter pixelConverter;
+  pixelConverter.setPixelFormats(&pf, &pf);
+
+  MemoryOutputStream update;
+  DataOutputStream output(&update);
+  EncoderStore encoders(&pixelConverter, &output);
+  encoders.setTightParallelMode(config->isParallel);
+  encoders.setJpegThreadCount(config->numJpegThreads);
+
+  EncodeOptions options;
+  getEncodeOptions(config, &options);
+  encoders.selectEncoder(options.getPreferredEncoding());
+  Encoder *encoder = encoders.getEncoder();
+  if (config->isVideo) {
+    encoders.validateJpegEncoder();
+    encoder = encoders.getJpegEncoder();
+  }
+
+  // The viewer side. The decoder keeps its zlib streams between updates,
+  // as the encoder does, so both live through the whole run.
+  LogWriter log(0);
+  FrameBuffer viewerFrameBuffer;
+  viewerFrameBuffer.setProperties(&dim, &pf);
+  FrameBuffer secondFrameBuffer;
+  secondFrameBuffer.setProperties(&dim, &pf);
+  LocalMutex fbLock;
+  FbUpdateNotifier notifier(&viewerFrameBuffer, &fbLock, &log);
+  TightDecoder decoder(&log);
+
+  Rect screenRect = dim.getRect();
+  Region damage;
+  std::vector<Rect> rects;
+  while (m_source->getNextFrame(&frameBuffer, &damage)) {
+    update.clear();
+    UINT64 startTime = PreciseTimer::getMicroseconds();
+
+    rects.clear();
+    encoder->splitRectangle(&screenRect, &rects, &frameBuffer, &options);
+    encoder->sendRectangles(&rects, &frameBuffer, &options);
+    output.flush();
+
+    UINT64 encodedTime = PreciseTimer::getMicroseconds();
+
+    decodeUpdate(&update, rects.size(), &decoder, &viewerFrameBuffer,
+                 &secondFrameBuffer, &fbLock, &notifier);
+
+    result->numFrames++;
+    result->numBytes += update.getSize();
+    result->numRects += rects.size();
+    result->encodeTime += encodedTime - startTime;
+    result->numDifferentPixels += countDifferentPixels(&viewerFrameBuffer,
+                                                       &frameBuffer);
+  }
+}
+
+void FullUpdateBenchmark::decodeUpdate(const MemoryOutputStream *update,
+                                       size_t numRects,
+                                       TightDecoder *decoder,
+                                       FrameBuffer *frameBuffer,
+                                       FrameBuffer *secondFrameBuffer,
+                                       LocalMutex *fbLock,
+                                       FbUpdateNotifier *notifier)
+{
+  ByteArrayInputStream stream(update->getData(), update->getSize());
+  RfbInputGate input(&stream);
+  for (size_t i = 0; i < numRects; i++) {
+    int x = input.readUInt16();
+    int y = input.readUInt16();
+    int width = input.readUInt16();
+    int height = input.readUInt16();
+    if (input.readInt32() != EncodingDefs::TIGHT) {
+      throw Exception(_T("The encoder has sent a rectangle which is not")
+                      _T(" Tight"));
+    }
+    Rect rect(x, y, x + width, y + height);
+    decoder->process(&input, frameBuffer, secondFrameBuffer, &rect, fbLock,
+                     notifier);
+  }
+  decoder->flush();
+}
+
+void FullUpdateBenchmark::getEncodeOptions(const Config *config,
+                                           EncodeOptions *options)
+{
+  std::vector<int> encodings;
+  encodings.push_back(EncodingDefs::TIGHT);
+  encodings.push_back(PseudoEncDefs::COMPR_LEVEL_0 +
+                      config->compressionLevel);
+  if (config->jpegQuality >= 0) {
+    encodings.push_back(PseudoEncDefs::QUALITY_LEVEL_0 + config->jpegQuality);
+  }
+  options->setEncodings(&encodings);
+}
+
+void FullUpdateBenchmark::getVariantName(const Config *config,
+                                         TCHAR *name, size_t nameSize)
+{
+  if (config->isVideo) {
+    _stprintf_s(name, nameSize, _T("video x%d"), config->numJpegThreads);
+  } else if (config->isParallel) {
+    _tcscpy_s(name, nameSize, _T("parallel"));
+  } else {
+    _tcscpy_s(name, nameSize, _T("serial"));
+  }
+}
+
+void FullUpdateBenchmark::printResult(const Config *config,
+                                      const Result *result)
+{
+  TCHAR jpegQuality[16] = _T("-");
+  if (config->jpegQuality >= 0) {
+    _stprintf_s(jpegQuality, 16, _T("%d"), config->jpegQuality);
+  }
+  TCHAR variant[32];
+  getVariantName(config, variant, 32);
+
+  double numFrames = result->numFrames != 0 ? (double)result->numFrames : 1.0;
+  double updatesPerSecond = 0.0;
+  if (result->encodeTime != 0) {
+    updatesPerSecond = (double)result->numFrames * 1000000.0 /
+                       (double)result->encodeTime;
+  }
+  _ftprintf(m_report,
+            _T("%-10s %5d %5s %-9s %9.3f %9.1f %12.0f %9.1f %10I64u\n"),
+            _T("Tight"), config->compressionLevel, jpegQuality, variant,
+            (double)result->encodeTime / 1000.0 / numFrames,
+            updatesPerSecond,
+            (double)result->numBytes / numFrames,
+            (double)result->numRects / numFrames,
+            result->numDifferentPixels);
+  fflush(m_report);
+}
+
+UINT64 FullUpdateBenchmark::countDifferentPixels(const FrameBuffer *actual,
+                                                 const FrameBuffer *expected)
+{
+  switch (expected->getBitsPerPixel()) {
+  case 8:
+    return countDifferentPixelsT<UINT8>(actual, expected);
+  case 16:
+    return countDifferentPixelsT<UINT16>(actual, expected);
+  default:
+    return countDifferentPixelsT<UINT32>(actual, expected);
+  }
+}
+
+template<class PIXEL_T>
+UINT64 FullUpdateBenchmark::countDifferentPixelsT(const FrameBuffer *actual,
+                                                  const FrameBuffer *expected)
+{
+  // Padding bits of pixels are not transmitted by the Tight encoder.
+  PixelFormat pf = expected->getPixelFormat();
+  PIXEL_T mask = (PIXEL_T)((pf.redMax << pf.redShift) |
+                           (pf.greenMax << pf.greenShift) |
+                           (pf.blueMax << pf.blueShift));
+
+  const PIXEL_T *actualPixels = (const PIXEL_T *)actual->getBuffer();
+  const PIXEL_T *expectedPixels = (const PIXEL_T *)expected->getBuffer();
+  size_t numPixels = (size_t)expected->getDimension().area();
+  UINT64 numDifferent = 0;
+  for (size_t i = 0; i < numPixels; i++) {
+    if (((actualPixels[i] ^ expectedPixels[i]) & mask) != 0) {
+      numDifferent++;
+    }
+  }
+  return numDifferent;
+}
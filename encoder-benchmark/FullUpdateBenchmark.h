@@ -0,0 +1,110 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __FULLUPDATEBENCHMARK_H__
+#define __FULLUPDATEBENCHMARK_H__
+
+#include <stdio.h>
+#include <vector>
+
+#include "FrameSource.h"
+#include "MemoryOutputStream.h"
+#include "rfb-sconn/EncodeOptions.h"
+#include "thread/LocalMutex.h"
+#include "viewer-core/FbUpdateNotifier.h"
+#include "viewer-core/TightDecoder.h"
+
+// Encodes every frame as a full-screen update, as on a change of the scale,
+// on a full update request or in a video region covering the screen, and
+// reports the wall time of an update. Every update is decoded back with the
+// viewer TightDecoder and compared with the source frame, so an error of the
+// multithreaded encoding can't pass for a speedup.
+class FullUpdateBenchmark
+{
+public:
+  // The source must remain valid during the life of this object.
+  FullUpdateBenchmark(FrameSource *source, FILE *report);
+  virtual ~FullUpdateBenchmark();
+
+  // Encode the updates with Tight at a few levels, once in the usual serial
+  // way and once in the parallel mode of TightEncoder (see
+  // EncoderStore::setTightParallelMode()), printing a line for each.
+  void runTightParallel();
+
+  // Encode the updates as video, with JpegEncoder, in 1, 2, 4 and so on up
+  // to maxThreads threads (see EncoderStore::setJpegThreadCount()), printing
+  // a line for each.
+  void runVideo(int maxThreads);
+
+protected:
+  struct Config
+  {
+    int compressionLevel;
+    // Negative value means JPEG is not allowed.
+    int jpegQuality;
+    bool isParallel;
+    // Use JpegEncoder, as UpdateSender does for video regions.
+    bool isVideo;
+    int numJpegThreads;
+  };
+
+  void printHeader();
+
+  struct Result
+  {
+    int numFrames;
+    UINT64 numBytes;
+    UINT64 numRects;
+    // Encoding time of all the updates in microseconds.
+    UINT64 encodeTime;
+    // Number of pixels which differ in the decoded frames.
+    UINT64 numDifferentPixels;
+  };
+
+  void runConfig(const Config *config, Result *result);
+  void printResult(const Config *config, const Result *result);
+
+  static void getEncodeOptions(const Config *config, EncodeOptions *options);
+  static void getVariantName(const Config *config, TCHAR *name,
+                             size_t nameSize);
+
+  // Decodes the update which consists of numRects Tight rectangles.
+  void decodeUpdate(const MemoryOutputStream *update, size_t numRects,
+                    TightDecoder *decoder, FrameBuffer *frameBuffer,
+                    FrameBuffer *secondFrameBuffer, LocalMutex *fbLock,
+                    FbUpdateNotifier *notifier);
+
+  // Returns the number of pixels which differ in the two frame buffers of
+  // the same dimension and pixel format, ignoring the padding bits.
+  static UINT64 countDifferentPixels(const FrameBuffer *actual,
+                                     const FrameBuffer *expected);
+  template<class PIXEL_T>
+  static UINT64 countDifferentPixelsT(const FrameBuffer *actual,
+                                      const FrameBuffer *expected);
+
+  FrameSource *m_source;
+  FILE *m_report;
+};
+
+#endif // __FULLUPDATEBENCHMARK_H__
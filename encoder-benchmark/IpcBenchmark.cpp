@@ -0,0 +1,357 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "IpcBenchmark.h"
+
+#include <algorithm>
+
+#include "desktop-ipc/BlockingGate.h"
+#include "desktop-ipc/DesktopSrvDispatcher.h"
+#include "desktop-ipc/UserInputClient.h"
+#include "network/LoopbackConnection.h"
+#include "io-lib/ByteArrayInputStream.h"
+#include "thread/AutoLock.h"
+#include "util/Exception.h"
+#include "util/PreciseTimer.h"
+
+// Handles the benchmark messages on one side of the connection, saving
+// the time each of them is handled at. Each event of an input batch is
+// counted as a message.
+class IpcReceiver : public DesktopServerProto, public ClientListener
+{
+public:
+  // The notifications are sent to the forwGate.
+  IpcReceiver(BlockingGate *forwGate)
+  : DesktopServerProto(forwGate),
+    m_numReceived(0),
+    m_numAwaited(0)
+  {
+  }
+
+  virtual ~IpcReceiver()
+  {
+  }
+
+  void registerHandles(DesktopSrvDispatcher *dispatcher)
+  {
+    dispatcher->registerNewHandle(INPUT_BATCH, this);
+    dispatcher->registerNewHandle(DESKTOP_COORDS_REQ, this);
+    dispatcher->registerNewHandle(UPDATE_PUSHED, this);
+  }
+
+  // Forgets the handled messages and reserves the place for the times of
+  // numMessages next ones.
+  void reset(size_t numMessages)
+  {
+    AutoLock al(&m_lock);
+    m_receiveTimes.assign(numMessages, 0);
+    m_numReceived = 0;
+    m_numAwaited = 0;
+  }
+
+  // Blocks until numMessages messages are handled after the reset().
+  void waitForMessages(size_t numMessages)
+  {
+    while (true) {
+      {
+        AutoLock al(&m_lock);
+        if (m_numReceived >= numMessages) {
+          return;
+        }
+        m_numAwaited = numMessages;
+      }
+      m_received.waitForEvent();
+    }
+  }
+
+  // Sends a message without a reply, like UpdateHandlerServer does on an
+  // update. It has no payload, only the framing is measured.
+  void sendNotification()
+  {
+    AutoLock al(m_forwGate);
+    m_forwGate->writeUInt8(UPDATE_PUSHED);
+    m_forwGate->flush();
+  }
+
+  const std::vector<UINT64> *getReceiveTimes() const
+  {
+    return &m_receiveTimes;
+  }
+
+  virtual void onRequest(UINT8 reqCode, BlockingGate *backGate)
+  {
+    size_t numMessages = 1;
+    switch (reqCode) {
+    case INPUT_BATCH:
+      numMessages = readInputBatch(backGate);
+      break;
+    case DESKTOP_COORDS_REQ:
+      {
+        Rect rect(1920, 1080);
+        sendRect(&rect, backGate);
+      }
+      break;
+    case UPDATE_PUSHED:
+      break;
+    default:
+      StringStorage errMess;
+      errMess.format(_T("Unknown %d protocol code received by")
+                     _T(" the benchmark"), (int)reqCode);
+      throw Exception(errMess.getString());
+    }
+
+    UINT64 receiveTime = PreciseTimer::getNanoseconds();
+    AutoLock al(&m_lock);
+    for (size_t i = 0; i < numMessages; i++) {
+      if (m_numReceived < m_receiveTimes.size()) {
+        m_receiveTimes[m_numReceived] = receiveTime;
+      }
+      m_numReceived++;
+    }
+    if (m_numAwaited != 0 && m_numReceived >= m_numAwaited) {
+      m_received.notify();
+    }
+  }
+
+protected:
+  // Reads the events like UserInputServer does and returns their number.
+  size_t readInputBatch(BlockingGate *backGate)
+  {
+    UINT32 length = backGate->readUInt32();
+    if (length < sizeof(UINT32)) {
+      throw Exception(_T("Wrong length of an input batch"));
+    }
+    std::vector<char> batch(length);
+    backGate->readFully(&batch.front(), length);
+
+    ByteArrayInputStream batchStream(&batch.front(), length);
+    DataInputStream input(&batchStream);
+    UINT32 numEvents = input.readUInt32();
+    for (UINT32 i = 0; i < numEvents; i++) {
+      UINT8 eventCode = input.readUInt8();
+      if (eventCode == POINTER_POS_CHANGED) {
+        Point pointerPos;
+        UINT8 keyFlags;
+        readNewPointerPos(&pointerPos, &keyFlags, &input);
+      } else {
+        UINT32 keySym;
+        bool down;
+        readKeyEvent(&keySym, &down, &input);
+      }
+    }
+    return numEvents;
+  }
+
+  LocalMutex m_lock;
+  WindowsEvent m_received;
+  std::vector<UINT64> m_receiveTimes;
+  size_t m_numReceived;
+  size_t m_numAwaited;
+};
+
+// Both ends of the desktop IPC. Requests and their replies go from the
+// client to the server and notifications go back by another connection,
+// like over the two pipes between the service and the desktop server.
+class IpcSession
+{
+public:
+  IpcSession(LogWriter *log)
+  : m_clientRequestGate(m_requestConnection.getClientChannel()),
+    m_serverRequestGate(m_requestConnection.getServerChannel()),
+    m_clientNotificationGate(m_notificationConnection.getClientChannel()),
+    m_serverNotificationGate(m_notificationConnection.getServerChannel()),
+    m_serverDispatcher(&m_serverRequestGate, 0, log),
+    m_clientDispatcher(&m_clientNotificationGate, 0, log),
+    m_serverReceiver(&m_serverNotificationGate),
+    m_clientReceiver(&m_clientRequestGate),
+    m_userInputClient(&m_clientRequestGate, &m_clientDispatcher, 0)
+  {
+    m_serverReceiver.registerHandles(&m_serverDispatcher);
+    m_clientReceiver.registerHandles(&m_clientDispatcher);
+    m_serverDispatcher.resume();
+    m_clientDispatcher.resume();
+  }
+
+  virtual ~IpcSession()
+  {
+    // Break the reading of the dispatchers, so they can be stopped.
+    m_requestConnection.close();
+    m_notificationConnection.close();
+  }
+
+  IpcReceiver *getServerReceiver() { return &m_serverReceiver; }
+  IpcReceiver *getClientReceiver() { return &m_clientReceiver; }
+  UserInputClient *getUserInputClient() { return &m_userInputClient; }
+
+private:
+  LoopbackConnection m_requestConnection;
+  LoopbackConnection m_notificationConnection;
+  BlockingGate m_clientRequestGate;
+  BlockingGate m_serverRequestGate;
+  BlockingGate m_clientNotificationGate;
+  BlockingGate m_serverNotificationGate;
+  DesktopSrvDispatcher m_serverDispatcher;
+  DesktopSrvDispatcher m_clientDispatcher;
+  IpcReceiver m_serverReceiver;
+  IpcReceiver m_clientReceiver;
+  UserInputClient m_userInputClient;
+};
+
+IpcBenchmark::IpcBenchmark(FILE *report, int numMessages)
+: m_report(report),
+  m_numMessages(numMessages)
+{
+}
+
+IpcBenchmark::~IpcBenchmark()
+{
+}
+
+void IpcBenchmark::run()
+{
+  _ftprintf(m_report, _T("%d messages per test\n\n"), m_numMessages);
+  _ftprintf(m_report, _T("%-14s %11s %9s %9s %9s\n"),
+            _T("Test"), _T("Msg/s"), _T("Avg us"), _T("99% us"),
+            _T("Max us"));
+
+  static const TestKind kinds[] = {
+    INPUT_BURST,
+    INPUT_PACED,
+    REQUEST_REPLY,
+    NOTIFICATION
+  };
+  for (size_t i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++) {
+    Result result;
+    runTest(kinds[i], &result);
+    printResult(kinds[i], &result);
+  }
+}
+
+void IpcBenchmark::runTest(TestKind kind, Result *result)
+{
+  size_t numMessages = (size_t)m_numMessages;
+  result->numMessages = numMessages;
+
+  // The dispatchers log the closing of the connections as errors.
+  LogWriter log(0);
+  IpcSession session(&log);
+  IpcReceiver *receiver = kind == NOTIFICATION ?
+                          session.getClientReceiver() :
+                          session.getServerReceiver();
+  receiver->reset(numMessages);
+
+  std::vector<UINT64> sendTimes(numMessages);
+  std::vector<UINT64> replyTimes(numMessages);
+  UINT64 startTime = PreciseTimer::getNanoseconds();
+  for (size_t i = 0; i < numMessages; i++) {
+    sendTimes[i] = PreciseTimer::getNanoseconds();
+    switch (kind) {
+    case INPUT_BURST:
+      sendInputEvent(session.getUserInputClient(), i);
+      break;
+    case INPUT_PACED:
+      sendInputEvent(session.getUserInputClient(), i);
+      receiver->waitForMessages(i + 1);
+      break;
+    case REQUEST_REPLY:
+      {
+        Rect rect;
+        session.getUserInputClient()->getPrimaryDisplayCoords(&rect);
+        replyTimes[i] = PreciseTimer::getNanoseconds();
+      }
+      break;
+    case NOTIFICATION:
+      session.getServerReceiver()->sendNotification();
+      receiver->waitForMessages(i + 1);
+      break;
+    }
+  }
+  receiver->waitForMessages(numMessages);
+  result->totalTime = PreciseTimer::getNanoseconds() - startTime;
+
+  // A request is complete when its reply is read, other messages when
+  // they are handled on the other side.
+  const std::vector<UINT64> *receiveTimes = kind == REQUEST_REPLY ?
+                                            &replyTimes :
+                                            receiver->getReceiveTimes();
+  result->latencies.resize(numMessages);
+  for (size_t i = 0; i < numMessages; i++) {
+    result->latencies[i] = (*receiveTimes)[i] - sendTimes[i];
+  }
+}
+
+void IpcBenchmark::sendInputEvent(UserInputClient *client, size_t i)
+{
+  // Pointer moves alternate with presses and releases of the "a" key.
+  if (i % 2 == 0) {
+    Point pointerPos((int)(i % 1920), (int)(i % 1080));
+    client->setMouseEvent(&pointerPos, 0);
+  } else {
+    client->setKeyboardEvent(0x61, i % 4 == 1);
+  }
+}
+
+void IpcBenchmark::printResult(TestKind kind, Result *result)
+{
+  double messagesPerSecond = 0.0;
+  if (result->totalTime != 0) {
+    messagesPerSecond = (double)result->numMessages * 1000000000.0 /
+                        (double)result->totalTime;
+  }
+  double averageLatency = 0.0;
+  double percentileLatency = 0.0;
+  double maxLatency = 0.0;
+  std::vector<UINT64> *latencies = &result->latencies;
+  if (!latencies->empty()) {
+    UINT64 sum = 0;
+    for (size_t i = 0; i < latencies->size(); i++) {
+      sum += (*latencies)[i];
+    }
+    averageLatency = (double)sum / (double)latencies->size() / 1000.0;
+    std::vector<UINT64>::iterator percentile =
+      latencies->begin() + latencies->size() * 99 / 100;
+    std::nth_element(latencies->begin(), percentile, latencies->end());
+    percentileLatency = (double)*percentile / 1000.0;
+    maxLatency = (double)*std::max_element(latencies->begin(),
+                                           latencies->end()) / 1000.0;
+  }
+  _ftprintf(m_report, _T("%-14s %11.0f %9.2f %9.2f %9.2f\n"),
+            getTestName(kind), messagesPerSecond, averageLatency,
+            percentileLatency, maxLatency);
+  fflush(m_report);
+}
+
+const TCHAR *IpcBenchmark::getTestName(TestKind kind)
+{
+  switch (kind) {
+  case INPUT_BURST:
+    return _T("input-burst");
+  case INPUT_PACED:
+    return _T("input-paced");
+  case REQUEST_REPLY:
+    return _T("request-reply");
+  case NOTIFICATION:
+    return _T("notification");
+  }
+  return _T("Unknown");
+}
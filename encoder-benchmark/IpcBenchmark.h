@@ -0,0 +1,84 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef __IPCBENCHMARK_H__
+#define __IPCBENCHMARK_H__
+
+#include <stdio.h>
+#include <vector>
+
+#include "util/inttypes.h"
+
+class UserInputClient;
+
+// Runs the desktop IPC in one process: UserInputClient and the server
+// side listeners talk over BlockingGate and DesktopSrvDispatcher pairs
+// connected with LoopbackConnection, like DesktopClientImpl and
+// DesktopServerApplication do over the pipes. Reports the messages per
+// second and the time from sending each message until its handler runs
+// on the other side.
+class IpcBenchmark
+{
+public:
+  IpcBenchmark(FILE *report, int numMessages);
+  virtual ~IpcBenchmark();
+
+  // Run all the tests one by one, printing a line for each.
+  void run();
+
+protected:
+  enum TestKind
+  {
+    // Pointer and keyboard events sent as fast as the client can, so they
+    // go by INPUT_BATCH messages of many events.
+    INPUT_BURST,
+    // One input event at a time, the next one after the previous one is
+    // handled.
+    INPUT_PACED,
+    // Synchronous requests with a reply, like DESKTOP_COORDS_REQ.
+    REQUEST_REPLY,
+    // Server to client messages without a reply, like UPDATE_PUSHED.
+    NOTIFICATION
+  };
+
+  struct Result
+  {
+    UINT64 numMessages;
+    // Times in nanoseconds.
+    UINT64 totalTime;
+    std::vector<UINT64> latencies;
+  };
+
+  void runTest(TestKind kind, Result *result);
+  void printResult(TestKind kind, Result *result);
+
+  static const TCHAR *getTestName(TestKind kind);
+
+  // Sends the i-th input event from the client.
+  static void sendInputEvent(UserInputClient *client, size_t i);
+
+  FILE *m_report;
+  int m_numMessages;
+};
+
+#endif // __IPCBENCHMARK_H__
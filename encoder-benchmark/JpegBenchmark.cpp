@@ -0,0 +1,142 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "JpegBenchmark.h"
+
+#include "util/Exception.h"
+#include "util/PreciseTimer.h"
+
+JpegBenchmark::JpegBenchmark(FrameSource *source, FILE *report)
+: m_source(source),
+  m_report(report)
+{
+}
+
+JpegBenchmark::~JpegBenchmark()
+{
+}
+
+void JpegBenchmark::run()
+{
+  Dimension dim = m_source->getDimension();
+  PixelFormat pf = m_source->getPixelFormat();
+  _ftprintf(m_report, _T("Workload: %s, %dx%d, %d bpp\n"),
+            m_source->getName(), dim.width, dim.height,
+            (int)pf.bitsPerPixel);
+  _ftprintf(m_report, _T("JPEG quality %d\n\n"), (int)JPEG_QUALITY);
+  // JpegCompressor::compress() accepts only these formats.
+  if (pf.bitsPerPixel != 32 && pf.bitsPerPixel != 16) {
+    throw Exception(_T("The pixel format of the frames can't be compressed")
+                    _T(" with JPEG"));
+  }
+  bool isDirectSupported = StandardJpegCompressor::isDirectInputSupported(&pf);
+  if (!isDirectSupported) {
+    _ftprintf(m_report, _T("The pixel format can't be passed to the JPEG")
+                        _T(" library directly\n\n"));
+  }
+  _ftprintf(m_report, _T("%-11s %-8s %9s %9s %12s\n"),
+            _T("Subsampling"), _T("Input"), _T("Frame ms"), _T("MPix/s"),
+            _T("Bytes/frame"));
+
+  static const JpegCompressor::ChromaSubsampling subsamplings[] = {
+    JpegCompressor::SUBSAMPLING_444,
+    JpegCompressor::SUBSAMPLING_422,
+    JpegCompressor::SUBSAMPLING_420
+  };
+  for (size_t i = 0; i < sizeof(subsamplings) / sizeof(subsamplings[0]);
+       i++) {
+    for (int isDirect = 0; isDirect <= 1; isDirect++) {
+      if (isDirect != 0 && !isDirectSupported) {
+        continue;
+      }
+      Result result;
+      runPath(subsamplings[i], isDirect != 0, &result);
+      printResult(subsamplings[i], isDirect != 0, &result);
+    }
+  }
+}
+
+void JpegBenchmark::runPath(JpegCompressor::ChromaSubsampling subsampling,
+                            bool isDirect, Result *result)
+{
+  memset(result, 0, sizeof(Result));
+
+  m_source->rewind();
+  Dimension dim = m_source->getDimension();
+  PixelFormat pf = m_source->getPixelFormat();
+
+  FrameBuffer frameBuffer;
+  frameBuffer.setProperties(&dim, &pf);
+
+  StandardJpegCompressor compressor;
+  compressor.setQuality(JPEG_QUALITY);
+  compressor.setSubsampling(subsampling);
+  compressor.enableDirectInput(isDirect);
+
+  Region damage;
+  while (m_source->getNextFrame(&frameBuffer, &damage)) {
+    UINT64 startTime = PreciseTimer::getMicroseconds();
+    compressor.compress(frameBuffer.getBuffer(), &pf, dim.width, dim.height,
+                        frameBuffer.getBytesPerRow());
+    UINT64 compressedTime = PreciseTimer::getMicroseconds();
+
+    result->numFrames++;
+    result->numBytes += compressor.getOutputLength();
+    result->compressTime += compressedTime - startTime;
+  }
+}
+
+void JpegBenchmark::printResult(JpegCompressor::ChromaSubsampling subsampling,
+                                bool isDirect, const Result *result)
+{
+  Dimension dim = m_source->getDimension();
+  double numFrames = result->numFrames != 0 ? (double)result->numFrames : 1.0;
+  // Pixels per microsecond are megapixels per second.
+  double mpixPerSecond = 0.0;
+  if (result->compressTime != 0) {
+    mpixPerSecond = (double)dim.area() * result->numFrames /
+                    (double)result->compressTime;
+  }
+  _ftprintf(m_report, _T("%-11s %-8s %9.3f %9.2f %12.0f\n"),
+            getSubsamplingName(subsampling),
+            isDirect ? _T("direct") : _T("fallback"),
+            (double)result->compressTime / 1000.0 / numFrames,
+            mpixPerSecond,
+            (double)result->numBytes / numFrames);
+  fflush(m_report);
+}
+
+const TCHAR *JpegBenchmark::getSubsamplingName(
+  JpegCompressor::ChromaSubsampling subsampling)
+{
+  switch (subsampling) {
+  case JpegCompressor::SUBSAMPLING_444:
+    return _T("4:4:4");
+  case JpegCompressor::SUBSAMPLING_422:
+    return _T("4:2:2");
+  case JpegCompressor::SUBSAMPLING_420:
+    return _T("4:2:0");
+  }
+  return _T("Unknown");
+}
@@ -0,0 +1,72 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __JPEGBENCHMARK_H__
+#define __JPEGBENCHMARK_H__
+
+#include <stdio.h>
+
+#include "FrameSource.h"
+#include "rfb-sconn/JpegCompressor.h"
+
+// Compresses every frame entirely with StandardJpegCompressor at each chroma
+// subsampling mode, once passing the pixels to the JPEG library directly
+// and once through the conversion to RGB, which is the fallback path for
+// pixel formats the library can't read.
+class JpegBenchmark
+{
+public:
+  // The source must remain valid during the life of this object.
+  JpegBenchmark(FrameSource *source, FILE *report);
+  virtual ~JpegBenchmark();
+
+  // Run all the combinations one by one, printing a line for each.
+  void run();
+
+protected:
+  struct Result
+  {
+    int numFrames;
+    UINT64 numBytes;
+    // Compression time in microseconds.
+    UINT64 compressTime;
+  };
+
+  void runPath(JpegCompressor::ChromaSubsampling subsampling,
+               bool isDirect, Result *result);
+  void printResult(JpegCompressor::ChromaSubsampling subsampling,
+                   bool isDirect, const Result *result);
+
+  static const TCHAR *getSubsamplingName(
+    JpegCompressor::ChromaSubsampling subsampling);
+
+  // JPEG quality level (0..100) used for all the frames. The subsampling
+  // mode is set explicitly, so it only affects the quantization tables.
+  static const int JPEG_QUALITY = 75;
+
+  FrameSource *m_source;
+  FILE *m_report;
+};
+
+#endif // __JPEGBENCHMARK_H__
@@ -0,0 +1,225 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "LogBenchmark.h"
+
+#include <algorithm>
+
+#include "log-writer/AsyncFileLogger.h"
+#include "log-writer/LogWriter.h"
+#include "thread/Thread.h"
+#include "util/Exception.h"
+#include "util/PreciseTimer.h"
+
+// Logs lines like the ones UpdateSender logs at the detail level, saving
+// the time of each call.
+class LoggingThread : public Thread
+{
+public:
+  LoggingThread(Logger *logger, int numLines)
+  : m_logger(logger),
+    m_latencies(numLines)
+  {
+  }
+
+  virtual ~LoggingThread()
+  {
+    wait();
+  }
+
+  const std::vector<UINT64> *getLatencies() const
+  {
+    return &m_latencies;
+  }
+
+protected:
+  virtual void execute()
+  {
+    LogWriter log(m_logger);
+    for (size_t i = 0; i < m_latencies.size(); i++) {
+      UINT64 startTime = PreciseTimer::getNanoseconds();
+      log.detail(_T("Sent update %u to %s: %d rectangles, %I64u bytes")
+                 _T(" in %.3f ms"), (unsigned int)i, _T("192.168.0.10"),
+                 (int)(i % 64), (UINT64)i * 1500, (double)(i % 100) / 10.0);
+      m_latencies[i] = PreciseTimer::getNanoseconds() - startTime;
+    }
+  }
+
+  Logger *m_logger;
+  std::vector<UINT64> m_latencies;
+};
+
+LogBenchmark::LogBenchmark(FILE *report, int numLines)
+: m_report(report),
+  m_numLines(numLines)
+{
+  TCHAR tempDir[MAX_PATH + 1];
+  DWORD length = GetTempPath(MAX_PATH + 1, tempDir);
+  if (length == 0 || length > MAX_PATH) {
+    throw Exception(_T("Can't get the temporary directory"));
+  }
+  // FileAccount adds the path separator itself.
+  if (tempDir[length - 1] == _T('\\')) {
+    tempDir[length - 1] = 0;
+  }
+  m_logDir.setString(tempDir);
+}
+
+LogBenchmark::~LogBenchmark()
+{
+}
+
+void LogBenchmark::run()
+{
+  _ftprintf(m_report, _T("Log file: %s\\encoder-benchmark.log\n"),
+            m_logDir.getString());
+  _ftprintf(m_report, _T("%d lines per thread, async-drop counts the")
+                      _T(" dropped lines too\n\n"), m_numLines);
+  _ftprintf(m_report, _T("%-14s %7s %11s %9s %9s %9s\n"),
+            _T("Logger"), _T("Threads"), _T("Lines/s"), _T("Avg us"),
+            _T("99% us"), _T("Max us"));
+
+  static const LoggerKind kinds[] = {
+    SYNC_LOGGER,
+    ASYNC_PREFORMATTED_LOGGER,
+    ASYNC_PACKED_LOGGER,
+    ASYNC_DROPPING_LOGGER
+  };
+  static const int threadCounts[] = { 1, 4 };
+  for (size_t i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++) {
+    for (size_t j = 0; j < sizeof(threadCounts) / sizeof(int); j++) {
+      Result result;
+      runLogger(kinds[i], threadCounts[j], &result);
+      printResult(kinds[i], threadCounts[j], &result);
+    }
+  }
+}
+
+void LogBenchmark::runLogger(LoggerKind kind, int numThreads, Result *result)
+{
+  result->numLines = (UINT64)m_numLines * numThreads;
+  result->latencies.clear();
+
+  Logger *logger = createLogger(kind);
+  std::vector<LoggingThread *> threads;
+  UINT64 startTime = 0;
+  try {
+    for (int i = 0; i < numThreads; i++) {
+      threads.push_back(new LoggingThread(logger, m_numLines));
+    }
+    startTime = PreciseTimer::getNanoseconds();
+    for (size_t i = 0; i < threads.size(); i++) {
+      threads[i]->resume();
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+      threads[i]->wait();
+      const std::vector<UINT64> *latencies = threads[i]->getLatencies();
+      result->latencies.insert(result->latencies.end(),
+                               latencies->begin(), latencies->end());
+    }
+  } catch (...) {
+    for (size_t i = 0; i < threads.size(); i++) {
+      delete threads[i];
+    }
+    delete logger;
+    throw;
+  }
+  for (size_t i = 0; i < threads.size(); i++) {
+    delete threads[i];
+  }
+  // The async logger writes the remaining lines on its destruction.
+  delete logger;
+  result->totalTime = PreciseTimer::getNanoseconds() - startTime;
+}
+
+Logger *LogBenchmark::createLogger(LoggerKind kind)
+{
+  const TCHAR *fileName = _T("encoder-benchmark");
+  // The level of LogWriter::detail().
+  unsigned char logLevel = 5;
+  switch (kind) {
+  case SYNC_LOGGER:
+    return new FileLogger(m_logDir.getString(), fileName, logLevel, false);
+  case ASYNC_PREFORMATTED_LOGGER:
+    {
+      AsyncFileLogger *logger =
+        new AsyncFileLogger(m_logDir.getString(), fileName, logLevel, false,
+                            AsyncFileLogger::BLOCK_CALLER);
+      logger->enableLazyFormatting(false);
+      return logger;
+    }
+  case ASYNC_PACKED_LOGGER:
+    return new AsyncFileLogger(m_logDir.getString(), fileName, logLevel,
+                               false, AsyncFileLogger::BLOCK_CALLER);
+  default:
+    return new AsyncFileLogger(m_logDir.getString(), fileName, logLevel,
+                               false, AsyncFileLogger::DROP_VERBOSE_LINES);
+  }
+}
+
+void LogBenchmark::printResult(LoggerKind kind, int numThreads,
+                               Result *result)
+{
+  double linesPerSecond = 0.0;
+  if (result->totalTime != 0) {
+    linesPerSecond = (double)result->numLines * 1000000000.0 /
+                     (double)result->totalTime;
+  }
+  double averageLatency = 0.0;
+  double percentileLatency = 0.0;
+  double maxLatency = 0.0;
+  std::vector<UINT64> *latencies = &result->latencies;
+  if (!latencies->empty()) {
+    UINT64 sum = 0;
+    for (size_t i = 0; i < latencies->size(); i++) {
+      sum += (*latencies)[i];
+    }
+    averageLatency = (double)sum / (double)latencies->size() / 1000.0;
+    std::vector<UINT64>::iterator percentile =
+      latencies->begin() + latencies->size() * 99 / 100;
+    std::nth_element(latencies->begin(), percentile, latencies->end());
+    percentileLatency = (double)*percentile / 1000.0;
+    maxLatency = (double)*std::max_element(latencies->begin(),
+                                           latencies->end()) / 1000.0;
+  }
+  _ftprintf(m_report, _T("%-14s %7d %11.0f %9.2f %9.2f %9.2f\n"),
+            getLoggerName(kind), numThreads, linesPerSecond,
+            averageLatency, percentileLatency, maxLatency);
+  fflush(m_report);
+}
+
+const TCHAR *LogBenchmark::getLoggerName(LoggerKind kind)
+{
+  switch (kind) {
+  case SYNC_LOGGER:
+    return _T("sync");
+  case ASYNC_PREFORMATTED_LOGGER:
+    return _T("async-format");
+  case ASYNC_PACKED_LOGGER:
+    return _T("async-packed");
+  case ASYNC_DROPPING_LOGGER:
+    return _T("async-drop");
+  }
+  return _T("Unknown");
+}
@@ -0,0 +1,76 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __LOGBENCHMARK_H__
+#define __LOGBENCHMARK_H__
+
+#include <stdio.h>
+#include <vector>
+
+#include "log-writer/Logger.h"
+#include "util/StringStorage.h"
+
+// Logs lines through LogWriter from one and from several threads into
+// FileLogger and into AsyncFileLogger, with the lines formatted in the
+// caller thread or packed for the writing thread. Reports the lines per
+// second, from the first line until all of them are in the file, and the
+// time each call takes in the caller thread.
+class LogBenchmark
+{
+public:
+  LogBenchmark(FILE *report, int numLines);
+  virtual ~LogBenchmark();
+
+  // Run all the loggers one by one, printing a line for each.
+  void run();
+
+protected:
+  enum LoggerKind
+  {
+    SYNC_LOGGER,
+    ASYNC_PREFORMATTED_LOGGER,
+    ASYNC_PACKED_LOGGER,
+    ASYNC_DROPPING_LOGGER
+  };
+
+  struct Result
+  {
+    UINT64 numLines;
+    // Times in nanoseconds.
+    UINT64 totalTime;
+    std::vector<UINT64> latencies;
+  };
+
+  void runLogger(LoggerKind kind, int numThreads, Result *result);
+  void printResult(LoggerKind kind, int numThreads, Result *result);
+
+  Logger *createLogger(LoggerKind kind);
+  static const TCHAR *getLoggerName(LoggerKind kind);
+
+  FILE *m_report;
+  int m_numLines;
+  StringStorage m_logDir;
+};
+
+#endif // __LOGBENCHMARK_H__
@@ -0,0 +1,320 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "LoopbackBenchmark.h"
+#include "LoopbackViewer.h"
+#include "ClientRequestReader.h"
+
+#include "rfb/AuthDefs.h"
+#include "rfb/MsgDefs.h"
+#include "rfb/PixelConverter.h"
+#include "rfb-sconn/EncoderStore.h"
+#include "network/LoopbackConnection.h"
+
+// Time limits for the viewer to respond, in milliseconds.
+static const DWORD REQUEST_TIMEOUT = 10000;
+static const DWORD UPDATE_TIMEOUT = 10000;
+// The viewer framebuffer copy is updated asynchronously, so the last
+// changes may come a bit later than the update itself.
+static const DWORD COMPARE_TIMEOUT = 2000;
+
+LoopbackBenchmark::Options::Options()
+: bandwidth(0),
+  latency(0)
+{
+}
+
+LoopbackBenchmark::LoopbackBenchmark(FrameSource *source, FILE *report,
+                                     const Options *options)
+: EncoderBenchmark(source, report),
+  m_options(*options)
+{
+}
+
+LoopbackBenchmark::~LoopbackBenchmark()
+{
+}
+
+void LoopbackBenchmark::testConfig(const Config *config)
+{
+  LoopbackResult result;
+  runLoopback(config, &result);
+  printLoopbackResult(config, &result);
+}
+
+void LoopbackBenchmark::runLoopback(const Config *config,
+                                    LoopbackResult *result)
+{
+  memset(result, 0, sizeof(LoopbackResult));
+
+  m_source->rewind();
+  Dimension dim = m_source->getDimension();
+  PixelFormat pf = m_source->getPixelFormat();
+
+  FrameBuffer frameBuffer;
+  frameBuffer.setProperties(&dim, &pf);
+
+  LoopbackConnection connection(LoopbackConnection::DEFAULT_CAPACITY,
+                                m_options.bandwidth, m_options.latency);
+  RfbInputGate input(connection.getServerChannel());
+  RfbOutputGate output(connection.getServerChannel());
+  LoopbackViewer viewer(connection.getClientChannel(), config->encoding,
+                        &m_options.viewer);
+  ClientRequestReader *requests = 0;
+
+  viewer.start();
+  try {
+    acceptViewer(&input, &output);
+    requests = new ClientRequestReader(&input);
+
+    // The viewer doesn't change the pixel format, so it is the same on
+    // both sides.
+    PixelConverter pixelConverter;
+    pixelConverter.setPixelFormats(&pf, &pf);
+    EncoderStore encoders(&pixelConverter, &output);
+    EncodeOptions options;
+    getEncodeOptions(config, &options);
+    encoders.selectEncoder(options.getPreferredEncoding());
+    Encoder *encoder = encoders.getEncoder();
+
+    UINT64 startBytes = output.getBytesWritten();
+    double startTime = getTime();
+
+    std::vector<int> encodings;
+    Region damage;
+    std::vector<Rect> damageRects;
+    std::vector<Rect> rects;
+    while (m_source->getNextFrame(&frameBuffer, &damage)) {
+      if (result->numFrames == 0) {
+        // The viewer has nothing yet.
+        Rect screenRect = dim.getRect();
+        damage.clear();
+        damage.addRect(&screenRect);
+      }
+      if (!requests->waitForRequest(REQUEST_TIMEOUT)) {
+        StringStorage error = viewer.getError();
+        throw Exception(error.isEmpty() ?
+                        _T("The viewer does not request updates") :
+                        error.getString());
+      }
+      // The tuned encodings come before the request asking for them.
+      if (m_options.viewer.isAutoTuning &&
+          requests->getEncodings(&encodings)) {
+        options.setEncodings(&encodings);
+        encoders.selectEncoder(options.getPreferredEncoding());
+        encoder = encoders.getEncoder();
+      }
+      double encodeStartTime = getTime();
+
+      damageRects.clear();
+      damage.getRectVector(&damageRects);
+      rects.clear();
+      std::vector<Rect>::iterator it;
+      for (it = damageRects.begin(); it < damageRects.end(); it++) {
+        encoder->splitRectangle(&*it, &rects, &frameBuffer, &options);
+        result->numPixels += it->area();
+      }
+
+      output.writeUInt8(ServerMsgDefs::FB_UPDATE);
+      output.writeUInt8(0); // padding
+      output.writeUInt16((UINT16)rects.size());
+      encoder->sendRectangles(&rects, &frameBuffer, &options);
+      output.flush();
+
+      result->encodeTime += getTime() - encodeStartTime;
+      result->numFrames++;
+    }
+
+    if (!viewer.waitForUpdates(result->numFrames, UPDATE_TIMEOUT)) {
+      StringStorage error = viewer.getError();
+      throw Exception(error.isEmpty() ?
+                      _T("The viewer does not receive updates") :
+                      error.getString());
+    }
+    result->totalTime = getTime() - startTime;
+    result->numBytes = output.getBytesWritten() - startBytes;
+    result->decodeTime = viewer.getDecodeTime();
+    result->latency = viewer.getLatency();
+    result->numAllocations = viewer.getNumAllocations();
+
+    DWORD compareStartTime = GetTickCount();
+    while (true) {
+      result->numDifferentPixels = viewer.countDifferentPixels(&frameBuffer);
+      if (result->numDifferentPixels == 0 ||
+          GetTickCount() - compareStartTime >= COMPARE_TIMEOUT) {
+        break;
+      }
+      Sleep(10);
+    }
+    // The notifications may come after the updates, so these are taken
+    // when the viewer has the final picture.
+    result->numUiCalls = viewer.getNumUiCalls();
+    result->uiLockTime = viewer.getUiLockTime();
+    result->numTunings = viewer.getNumTunings();
+    result->tunedSettings = viewer.getTunedSettings();
+  } catch (...) {
+    viewer.stop();
+    connection.close();
+    viewer.waitTermination();
+    delete requests;
+    throw;
+  }
+  viewer.stop();
+  connection.close();
+  viewer.waitTermination();
+  delete requests;
+}
+
+void LoopbackBenchmark::acceptViewer(RfbInputGate *input,
+                                     RfbOutputGate *output)
+{
+  output->writeFully("RFB 003.008\n", 12);
+  output->flush();
+  char clientProtocol[12];
+  input->readFully(clientProtocol, sizeof(clientProtocol));
+
+  // Security types: None only.
+  output->writeUInt8(1);
+  output->writeUInt8(SecurityDefs::NONE);
+  output->flush();
+  if (input->readUInt8() != SecurityDefs::NONE) {
+    throw Exception(_T("The viewer has chosen an unexpected security type"));
+  }
+  // Security result: OK.
+  output->writeUInt32(0);
+  output->flush();
+
+  // ClientInit (shared flag) and ServerInit.
+  input->readUInt8();
+  Dimension dim = m_source->getDimension();
+  PixelFormat pf = m_source->getPixelFormat();
+  output->writeUInt16((UINT16)dim.width);
+  output->writeUInt16((UINT16)dim.height);
+  output->writeUInt8((UINT8)pf.bitsPerPixel);
+  output->writeUInt8((UINT8)pf.colorDepth);
+  output->writeUInt8((UINT8)pf.bigEndian);
+  output->writeUInt8(1); // true colour
+  output->writeUInt16((UINT16)pf.redMax);
+  output->writeUInt16((UINT16)pf.greenMax);
+  output->writeUInt16((UINT16)pf.blueMax);
+  output->writeUInt8((UINT8)pf.redShift);
+  output->writeUInt8((UINT8)pf.greenShift);
+  output->writeUInt8((UINT8)pf.blueShift);
+  output->writeUInt8(0); // padding
+  output->writeUInt16(0);
+  static const char desktopName[] = "loopback";
+  output->writeUInt32(sizeof(desktopName) - 1);
+  output->writeFully(desktopName, sizeof(desktopName) - 1);
+  output->flush();
+}
+
+void LoopbackBenchmark::printHeader()
+{
+  if (m_options.bandwidth != 0 || m_options.latency != 0) {
+    _ftprintf(m_report, _T("Link: %I64u bytes/s (0 = unlimited), ")
+                        _T("%I64u us latency\n\n"),
+              m_options.bandwidth, m_options.latency);
+  }
+  if (m_options.viewer.isPipelined) {
+    _ftprintf(m_report, _T("Update requests are pipelined\n\n"));
+  }
+  if (m_options.viewer.isReadingAhead) {
+    _ftprintf(m_report, _T("Viewer reads ahead of the decoding\n\n"));
+  }
+  if (m_options.viewer.numDecodingThreads >= 2) {
+    _ftprintf(m_report, _T("Viewer decompresses JPEG in %d threads\n\n"),
+              m_options.viewer.numDecodingThreads);
+  }
+  if (m_options.viewer.frameRate != 0) {
+    _ftprintf(m_report, _T("Viewer notifications are limited to %d fps\n\n"),
+              m_options.viewer.frameRate);
+  }
+  if (m_options.viewer.isAutoTuning) {
+    _ftprintf(m_report, _T("Viewer tunes the encoding automatically\n\n"));
+  }
+  _ftprintf(m_report,
+            _T("%-10s %5s %5s %8s %9s %12s %9s %9s %10s %10s %9s %8s %8s")
+            _T(" %10s\n"),
+            _T("Encoding"), _T("Compr"), _T("JPEG"), _T("Frames/s"),
+            _T("MPix/s"), _T("Bytes/frame"), _T("Enc ms"), _T("Dec ms"),
+            _T("Dec MPix/s"), _T("Allocs/upd"), _T("Lat ms"), _T("UI/upd"),
+            _T("UI ms"), _T("Diff px"));
+}
+
+void LoopbackBenchmark::printLoopbackResult(const Config *config,
+                                            const LoopbackResult *result)
+{
+  TCHAR compressionLevel[16] = _T("-");
+  if (config->compressionLevel >= 0) {
+    _stprintf_s(compressionLevel, 16, _T("%d"), config->compressionLevel);
+  }
+  TCHAR jpegQuality[16] = _T("-");
+  if (config->jpegQuality >= 0) {
+    _stprintf_s(jpegQuality, 16, _T("%d"), config->jpegQuality);
+  }
+
+  double numFrames = result->numFrames != 0 ? (double)result->numFrames : 1.0;
+  double framesPerSecond = 0.0;
+  double mpixPerSecond = 0.0;
+  if (result->totalTime > 0.0) {
+    framesPerSecond = (double)result->numFrames / result->totalTime;
+    mpixPerSecond = (double)result->numPixels / result->totalTime / 1000000.0;
+  }
+  // Pixels per microsecond are megapixels per second.
+  double decodeMpixPerSecond = 0.0;
+  if (result->decodeTime != 0) {
+    decodeMpixPerSecond = (double)result->numPixels /
+                          (double)result->decodeTime;
+  }
+  // The viewer doesn't count allocations of the first update.
+  double allocationsPerUpdate = 0.0;
+  if (result->numFrames > 1) {
+    allocationsPerUpdate = (double)result->numAllocations /
+                           (double)(result->numFrames - 1);
+  }
+
+  _ftprintf(m_report,
+            _T("%-10s %5s %5s %8.1f %9.2f %12.0f %9.3f %9.3f %10.2f %10.1f")
+            _T(" %9.3f %8.1f %8.3f %10I64u\n"),
+            getEncodingName(config->encoding), compressionLevel, jpegQuality,
+            framesPerSecond, mpixPerSecond,
+            (double)result->numBytes / numFrames,
+            result->encodeTime * 1000.0 / numFrames,
+            (double)result->decodeTime / 1000.0 / numFrames,
+            decodeMpixPerSecond,
+            allocationsPerUpdate,
+            (double)result->latency / 1000.0 / numFrames,
+            (double)result->numUiCalls / numFrames,
+            (double)result->uiLockTime / 1000.0 / numFrames,
+            result->numDifferentPixels);
+  if (m_options.viewer.isAutoTuning) {
+    const EncodingAutoTuner::Settings *tuned = &result->tunedSettings;
+    _ftprintf(m_report,
+              _T("  tuned to %s, compression level %d, JPEG quality %d")
+              _T(" after %d changes\n"),
+              getEncodingName(tuned->encoding), tuned->compressionLevel,
+              tuned->jpegQualityLevel, result->numTunings);
+  }
+  fflush(m_report);
+}
@@ -0,0 +1,95 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __LOOPBACKBENCHMARK_H__
+#define __LOOPBACKBENCHMARK_H__
+
+#include "EncoderBenchmark.h"
+#include "LoopbackViewer.h"
+#include "network/RfbInputGate.h"
+#include "network/RfbOutputGate.h"
+#include "viewer-core/EncodingAutoTuner.h"
+
+// Runs the frames end to end: the server side encodes them and sends them
+// over an in-process loopback connection to RemoteViewerCore, one frame
+// per framebuffer update request, as a real server would do for a client
+// which is always behind. The connection can emulate a network link with
+// limited bandwidth and latency.
+//
+// Besides throughput and latency, the picture decoded by the viewer is
+// compared with the last frame after all the updates are received.
+// Differences are expected only when JPEG quality is set.
+class LoopbackBenchmark : public EncoderBenchmark
+{
+public:
+  struct Options
+  {
+    Options();
+
+    // Bandwidth of the link in bytes per second, zero means unlimited.
+    UINT64 bandwidth;
+    // One-way delay of the link in microseconds.
+    UINT64 latency;
+    // Settings of the viewer. If the viewer tunes the encoding itself, the
+    // server follows the encodings set by the viewer, so the configuration
+    // gives only the settings of the server before that.
+    LoopbackViewer::Options viewer;
+  };
+
+  LoopbackBenchmark(FrameSource *source, FILE *report,
+                    const Options *options);
+  virtual ~LoopbackBenchmark();
+
+protected:
+  struct LoopbackResult
+  {
+    int numFrames;
+    UINT64 numPixels;
+    UINT64 numBytes;
+    double totalTime;
+    double encodeTime;
+    UINT64 decodeTime;
+    UINT64 latency;
+    UINT64 numAllocations;
+    UINT64 numUiCalls;
+    UINT64 uiLockTime;
+    int numTunings;
+    EncodingAutoTuner::Settings tunedSettings;
+    UINT64 numDifferentPixels;
+  };
+
+  virtual void testConfig(const Config *config);
+  virtual void printHeader();
+
+  void runLoopback(const Config *config, LoopbackResult *result);
+  void printLoopbackResult(const Config *config,
+                           const LoopbackResult *result);
+
+  // Plays the server part of the RFB handshake without authentication.
+  void acceptViewer(RfbInputGate *input, RfbOutputGate *output);
+
+  Options m_options;
+};
+
+#endif // __LOOPBACKBENCHMARK_H__
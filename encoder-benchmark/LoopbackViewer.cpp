@@ -0,0 +1,273 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "LoopbackViewer.h"
+#include "AllocationCounter.h"
+
+#include "thread/AutoLock.h"
+#include "util/PreciseTimer.h"
+
+LoopbackViewer::Options::Options()
+: isPipelined(false),
+  isReadingAhead(false),
+  numDecodingThreads(0),
+  frameRate(0),
+  isAutoTuning(false)
+{
+}
+
+LoopbackViewer::LoopbackViewer(Channel *channel, int preferredEncoding,
+                               const Options *options)
+: m_input(channel),
+  m_output(channel),
+  m_numUpdates(0),
+  m_decodeTime(0),
+  m_latency(0),
+  m_numAllocations(0),
+  m_prevAllocationCount(0),
+  m_numUiCalls(0),
+  m_uiLockTime(0),
+  m_numTunings(0),
+  m_isStopped(false)
+{
+  // The core starts the auto-tuning from the default settings.
+  m_tunedSettings = *EncodingAutoTuner::getDefaultSettings();
+
+  m_core.setPreferredEncoding(preferredEncoding);
+  m_core.enableUpdatePipelining(options->isPipelined);
+  m_core.enableReadAhead(options->isReadingAhead);
+  m_core.setDecodingThreadCount(options->numDecodingThreads);
+  m_core.setFrameRate(options->frameRate);
+  m_core.enableAutoTuning(options->isAutoTuning);
+}
+
+LoopbackViewer::~LoopbackViewer()
+{
+}
+
+void LoopbackViewer::start()
+{
+  m_core.start(&m_input, &m_output, this, true);
+}
+
+void LoopbackViewer::stop()
+{
+  {
+    AutoLock al(&m_statsLock);
+    // Errors caused by closing the connection are not reported.
+    m_isStopped = true;
+  }
+  m_core.stop();
+}
+
+void LoopbackViewer::waitTermination()
+{
+  m_core.waitTermination();
+}
+
+bool LoopbackViewer::waitForUpdates(int numUpdates, DWORD milliseconds)
+{
+  DWORD startTime = GetTickCount();
+  while (true) {
+    {
+      AutoLock al(&m_statsLock);
+      if (m_numUpdates >= numUpdates) {
+        return true;
+      }
+      if (!m_error.isEmpty()) {
+        return false;
+      }
+    }
+    DWORD elapsed = GetTickCount() - startTime;
+    if (elapsed >= milliseconds) {
+      return false;
+    }
+    m_updateEvent.waitForEvent(milliseconds - elapsed);
+  }
+}
+
+UINT64 LoopbackViewer::countDifferentPixels(const FrameBuffer *expected)
+{
+  AutoLock al(&m_fbLock);
+  const Dimension &dim = expected->getDimension();
+  if (!m_frameBuffer.getDimension().cmpDim(&dim) ||
+      !m_frameBuffer.getPixelFormat().isEqualTo(&expected->getPixelFormat())) {
+    return (UINT64)dim.area();
+  }
+  switch (expected->getBitsPerPixel()) {
+  case 8:
+    return countDifferentPixelsT<UINT8>(expected);
+  case 16:
+    return countDifferentPixelsT<UINT16>(expected);
+  default:
+    return countDifferentPixelsT<UINT32>(expected);
+  }
+}
+
+template<class PIXEL_T>
+UINT64 LoopbackViewer::countDifferentPixelsT(const FrameBuffer *expected)
+{
+  // Padding bits of pixels are not transmitted by some encoders.
+  PixelFormat pf = expected->getPixelFormat();
+  PIXEL_T mask = (PIXEL_T)((pf.redMax << pf.redShift) |
+                           (pf.greenMax << pf.greenShift) |
+                           (pf.blueMax << pf.blueShift));
+
+  const PIXEL_T *actualPixels = (const PIXEL_T *)m_frameBuffer.getBuffer();
+  const PIXEL_T *expectedPixels = (const PIXEL_T *)expected->getBuffer();
+  size_t numPixels = (size_t)expected->getDimension().area();
+  UINT64 numDifferent = 0;
+  for (size_t i = 0; i < numPixels; i++) {
+    if (((actualPixels[i] ^ expectedPixels[i]) & mask) != 0) {
+      numDifferent++;
+    }
+  }
+  return numDifferent;
+}
+
+UINT64 LoopbackViewer::getDecodeTime()
+{
+  AutoLock al(&m_statsLock);
+  return m_decodeTime;
+}
+
+UINT64 LoopbackViewer::getLatency()
+{
+  AutoLock al(&m_statsLock);
+  return m_latency;
+}
+
+UINT64 LoopbackViewer::getNumAllocations()
+{
+  AutoLock al(&m_statsLock);
+  return m_numAllocations;
+}
+
+UINT64 LoopbackViewer::getNumUiCalls()
+{
+  AutoLock al(&m_statsLock);
+  return m_numUiCalls;
+}
+
+UINT64 LoopbackViewer::getUiLockTime()
+{
+  AutoLock al(&m_statsLock);
+  return m_uiLockTime;
+}
+
+int LoopbackViewer::getNumTunings()
+{
+  AutoLock al(&m_statsLock);
+  return m_numTunings;
+}
+
+EncodingAutoTuner::Settings LoopbackViewer::getTunedSettings()
+{
+  AutoLock al(&m_statsLock);
+  return m_tunedSettings;
+}
+
+StringStorage LoopbackViewer::getError()
+{
+  AutoLock al(&m_statsLock);
+  return m_error;
+}
+
+void LoopbackViewer::onDisconnect(const StringStorage *message)
+{
+  AutoLock al(&m_statsLock);
+  if (m_error.isEmpty() && !m_isStopped) {
+    m_error = *message;
+  }
+  m_updateEvent.notify();
+}
+
+void LoopbackViewer::onError(const Exception *exception)
+{
+  AutoLock al(&m_statsLock);
+  if (m_error.isEmpty() && !m_isStopped) {
+    m_error.setString(exception->getMessage());
+  }
+  m_updateEvent.notify();
+}
+
+void LoopbackViewer::onFrameBufferUpdate(const FrameBuffer *fb,
+                                         const Rect *update)
+{
+  AutoLock al(&m_fbLock);
+  m_frameBuffer.copyFrom(update, fb, update->left, update->top);
+}
+
+void LoopbackViewer::onFrameBufferUpdates(const FrameBuffer *fb,
+                                          const std::vector<Rect> *updates)
+{
+  // The core holds the frame buffer lock during this call.
+  UINT64 startTime = PreciseTimer::getMicroseconds();
+  CoreEventsAdapter::onFrameBufferUpdates(fb, updates);
+  UINT64 lockTime = PreciseTimer::getMicroseconds() - startTime;
+
+  AutoLock al(&m_statsLock);
+  m_numUiCalls += updates->size();
+  m_uiLockTime += lockTime;
+}
+
+void LoopbackViewer::onFrameBufferPropChange(const FrameBuffer *fb)
+{
+  AutoLock al(&m_fbLock);
+  Dimension dim = fb->getDimension();
+  PixelFormat pf = fb->getPixelFormat();
+  m_frameBuffer.setProperties(&dim, &pf);
+}
+
+void LoopbackViewer::onFrameBufferUpdateReceived(int numRects,
+                                                 UINT64 decodeTime,
+                                                 UINT64 latency)
+{
+  // Called by the core thread, so the allocations between two calls are
+  // the allocations made to receive and decode an update. The first update
+  // also includes the connection setup, so it is not counted.
+  UINT64 allocationCount = AllocationCounter::getThreadCount();
+
+  AutoLock al(&m_statsLock);
+  if (m_numUpdates != 0) {
+    m_numAllocations += allocationCount - m_prevAllocationCount;
+  }
+  m_prevAllocationCount = allocationCount;
+  m_numUpdates++;
+  m_decodeTime += decodeTime;
+  m_latency += latency;
+  m_updateEvent.notify();
+}
+
+void LoopbackViewer::onEncodingTuned(const EncodingAutoTuner::Settings *settings,
+                                     const EncodingAutoTuner::Measurements *measurements)
+{
+  AutoLock al(&m_statsLock);
+  if (settings->encoding != m_tunedSettings.encoding ||
+      settings->compressionLevel != m_tunedSettings.compressionLevel ||
+      settings->jpegQualityLevel != m_tunedSettings.jpegQualityLevel) {
+    m_numTunings++;
+    m_tunedSettings = *settings;
+  }
+}
@@ -0,0 +1,146 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __LOOPBACKVIEWER_H__
+#define __LOOPBACKVIEWER_H__
+
+#include "viewer-core/RemoteViewerCore.h"
+#include "viewer-core/CoreEventsAdapter.h"
+#include "network/RfbInputGate.h"
+#include "network/RfbOutputGate.h"
+#include "thread/LocalMutex.h"
+#include "win-system/WindowsEvent.h"
+
+// The viewer side of the loopback benchmark: RemoteViewerCore working over
+// the given channel. It keeps a copy of the viewer framebuffer made from
+// the update notifications, so the decoded picture can be compared with
+// the one the server has encoded.
+class LoopbackViewer : public CoreEventsAdapter
+{
+public:
+  // Settings of the viewer core. By default, all the optional features are
+  // disabled.
+  struct Options
+  {
+    Options();
+
+    // Request the next update as soon as an update starts.
+    bool isPipelined;
+    // Read the connection in a separate thread.
+    bool isReadingAhead;
+    // Number of threads decompressing JPEG rectangles.
+    int numDecodingThreads;
+    // Limit of the rate of update notifications, zero means no limit.
+    int frameRate;
+    // Choose the encoding from the measured updates.
+    bool isAutoTuning;
+  };
+
+  LoopbackViewer(Channel *channel, int preferredEncoding,
+                 const Options *options);
+  virtual ~LoopbackViewer();
+
+  void start();
+  // Stops the viewer core. The channel must be closed after calling this
+  // to unblock the core thread, and before calling waitTermination().
+  void stop();
+  void waitTermination();
+
+  // Waits until the viewer receives the given number of framebuffer
+  // updates in total. Returns false on timeout or if the viewer is
+  // disconnected.
+  bool waitForUpdates(int numUpdates, DWORD milliseconds);
+
+  // Returns the number of pixels which differ from the expected picture,
+  // taking into account only the meaningful bits of pixels. If the viewer
+  // framebuffer has different dimensions, all pixels are considered
+  // different.
+  UINT64 countDifferentPixels(const FrameBuffer *expected);
+
+  // Returns the sum of decoding times and the sum of latencies (the time
+  // from an update request to the end of the update) in microseconds.
+  UINT64 getDecodeTime();
+  UINT64 getLatency();
+
+  // Returns the number of heap allocations made by the viewer core thread
+  // after the first framebuffer update, i.e. in the steady state.
+  UINT64 getNumAllocations();
+
+  // Returns the number of onFrameBufferUpdate() calls, i.e. of repaints of
+  // a real viewer, and the time in microseconds the frame buffer has been
+  // locked for the update callbacks.
+  UINT64 getNumUiCalls();
+  UINT64 getUiLockTime();
+
+  // Returns the number of changes made by the encoding auto-tuner and the
+  // settings it has chosen last.
+  int getNumTunings();
+  EncodingAutoTuner::Settings getTunedSettings();
+
+  // Returns the error which broke the connection or an empty string.
+  StringStorage getError();
+
+  //
+  // Inherited from CoreEventsAdapter.
+  //
+
+  virtual void onDisconnect(const StringStorage *message);
+  virtual void onError(const Exception *exception);
+  virtual void onFrameBufferUpdate(const FrameBuffer *fb, const Rect *update);
+  virtual void onFrameBufferUpdates(const FrameBuffer *fb,
+                                    const std::vector<Rect> *updates);
+  virtual void onFrameBufferPropChange(const FrameBuffer *fb);
+  virtual void onFrameBufferUpdateReceived(int numRects,
+                                           UINT64 decodeTime,
+                                           UINT64 latency);
+  virtual void onEncodingTuned(const EncodingAutoTuner::Settings *settings,
+                               const EncodingAutoTuner::Measurements *measurements);
+
+private:
+  template<class PIXEL_T>
+  UINT64 countDifferentPixelsT(const FrameBuffer *expected);
+
+  RemoteViewerCore m_core;
+  RfbInputGate m_input;
+  RfbOutputGate m_output;
+
+  FrameBuffer m_frameBuffer;
+  LocalMutex m_fbLock;
+
+  int m_numUpdates;
+  UINT64 m_decodeTime;
+  UINT64 m_latency;
+  UINT64 m_numAllocations;
+  UINT64 m_prevAllocationCount;
+  UINT64 m_numUiCalls;
+  UINT64 m_uiLockTime;
+  int m_numTunings;
+  EncodingAutoTuner::Settings m_tunedSettings;
+  bool m_isStopped;
+  StringStorage m_error;
+  LocalMutex m_statsLock;
+  WindowsEvent m_updateEvent;
+};
+
+#endif // __LOOPBACKVIEWER_H__
@@ -0,0 +1,56 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __MEMORYOUTPUTSTREAM_H__
+#define __MEMORYOUTPUTSTREAM_H__
+
+#include <vector>
+
+#include "io-lib/OutputStream.h"
+
+// Output stream which keeps the data written to it in memory, so an encoded
+// update can be decoded back. Unlike ByteArrayOutputStream, it grows
+// geometrically and can be cleared without freeing the memory, so it can be
+// reused for many large updates.
+class MemoryOutputStream : public OutputStream
+{
+public:
+  MemoryOutputStream();
+  virtual ~MemoryOutputStream();
+
+  virtual size_t write(const void *buffer, size_t len) throw(IOException);
+
+  // Return the data written since the last clear() call. The pointer is
+  // valid until the next write() or clear() call.
+  const char *getData() const;
+  size_t getSize() const;
+
+  // Forget the data written, keeping the memory for the next writes.
+  void clear();
+
+protected:
+  std::vector<char> m_data;
+};
+
+#endif // __MEMORYOUTPUTSTREAM_H__
@@ -0,0 +1,50 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "NullOutputStream.h"
+
+NullOutputStream::NullOutputStream()
+: m_bytesWritten(0)
+{
+}
+
+NullOutputStream::~NullOutputStream()
+{
+}
+
+size_t NullOutputStream::write(const void *buffer, size_t len)
+{
+  m_bytesWritten += len;
+  return len;
+}
+
+UINT64 NullOutputStream::getBytesWritten() const
+{
+  return m_bytesWritten;
+}
+
+void NullOutputStream::resetCounter()
+{
+  m_bytesWritten = 0;
+}
@@ -0,0 +1,149 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "ScalerBenchmark.h"
+
+#include "util/Exception.h"
+#include "util/PreciseTimer.h"
+
+ScalerBenchmark::ScalerBenchmark(FrameSource *source, FILE *report,
+                                 const Dimension *scaledDim)
+: m_source(source),
+  m_report(report),
+  m_scaledDim(*scaledDim)
+{
+}
+
+ScalerBenchmark::~ScalerBenchmark()
+{
+}
+
+void ScalerBenchmark::run()
+{
+  Dimension dim = m_source->getDimension();
+  PixelFormat pf = m_source->getPixelFormat();
+  _ftprintf(m_report, _T("Workload: %s, %dx%d, %d bpp\n"),
+            m_source->getName(), dim.width, dim.height,
+            (int)pf.bitsPerPixel);
+  _ftprintf(m_report, _T("Scaled to %dx%d\n\n"),
+            m_scaledDim.width, m_scaledDim.height);
+  if (!FrameBufferScaler::isSupportedFormat(&pf)) {
+    throw Exception(_T("The pixel format of the frames can't be scaled"));
+  }
+  _ftprintf(m_report, _T("%-10s %5s %9s %11s %9s %11s\n"),
+            _T("Filter"), _T("SIMD"), _T("Full ms"), _T("Full MPix/s"),
+            _T("Upd ms"), _T("Upd MPix/s"));
+
+  static const FrameBufferScaler::Filter filters[] = {
+    FrameBufferScaler::FILTER_BOX,
+    FrameBufferScaler::FILTER_BILINEAR,
+    FrameBufferScaler::FILTER_AREA
+  };
+  for (size_t i = 0; i < sizeof(filters) / sizeof(filters[0]); i++) {
+    for (int isSimd = 0; isSimd <= 1; isSimd++) {
+      Result result;
+      runFilter(filters[i], isSimd != 0, &result);
+      printResult(filters[i], isSimd != 0, &result);
+    }
+  }
+}
+
+void ScalerBenchmark::runFilter(FrameBufferScaler::Filter filter,
+                                bool isSimd, Result *result)
+{
+  memset(result, 0, sizeof(Result));
+
+  m_source->rewind();
+  Dimension dim = m_source->getDimension();
+  PixelFormat pf = m_source->getPixelFormat();
+
+  FrameBuffer frameBuffer;
+  frameBuffer.setProperties(&dim, &pf);
+  FrameBuffer scaled;
+  scaled.setProperties(&m_scaledDim, &pf);
+
+  Rect srcRect = dim.getRect();
+  Rect dstRect = m_scaledDim.getRect();
+  FrameBufferScaler scaler;
+  scaler.enableSimd(isSimd);
+  scaler.setGeometry(filter, &srcRect, &dstRect, &pf);
+
+  Region damage;
+  std::vector<Rect> damageRects;
+  Rect changed;
+  while (m_source->getNextFrame(&frameBuffer, &damage)) {
+    UINT64 startTime = PreciseTimer::getMicroseconds();
+    scaler.scale(&frameBuffer, &srcRect, &scaled, &changed);
+    UINT64 fullTime = PreciseTimer::getMicroseconds();
+
+    damageRects.clear();
+    damage.getRectVector(&damageRects);
+    std::vector<Rect>::iterator it;
+    for (it = damageRects.begin(); it < damageRects.end(); it++) {
+      scaler.scale(&frameBuffer, &*it, &scaled, &changed);
+      result->numUpdatedPixels += it->area();
+    }
+    UINT64 updateTime = PreciseTimer::getMicroseconds();
+
+    result->numFrames++;
+    result->fullTime += fullTime - startTime;
+    result->updateTime += updateTime - fullTime;
+  }
+}
+
+void ScalerBenchmark::printResult(FrameBufferScaler::Filter filter,
+                                  bool isSimd, const Result *result)
+{
+  Dimension dim = m_source->getDimension();
+  double numFrames = result->numFrames != 0 ? (double)result->numFrames : 1.0;
+  // Pixels per microsecond are megapixels per second.
+  double fullMpixPerSecond = 0.0;
+  if (result->fullTime != 0) {
+    fullMpixPerSecond = (double)dim.area() * result->numFrames /
+                        (double)result->fullTime;
+  }
+  double updateMpixPerSecond = 0.0;
+  if (result->updateTime != 0) {
+    updateMpixPerSecond = (double)result->numUpdatedPixels /
+                          (double)result->updateTime;
+  }
+  _ftprintf(m_report, _T("%-10s %5s %9.3f %11.2f %9.3f %11.2f\n"),
+            getFilterName(filter), isSimd ? _T("yes") : _T("no"),
+            (double)result->fullTime / 1000.0 / numFrames, fullMpixPerSecond,
+            (double)result->updateTime / 1000.0 / numFrames,
+            updateMpixPerSecond);
+  fflush(m_report);
+}
+
+const TCHAR *ScalerBenchmark::getFilterName(FrameBufferScaler::Filter filter)
+{
+  switch (filter) {
+  case FrameBufferScaler::FILTER_BOX:
+    return _T("Box");
+  case FrameBufferScaler::FILTER_BILINEAR:
+    return _T("Bilinear");
+  case FrameBufferScaler::FILTER_AREA:
+    return _T("Area");
+  }
+  return _T("Unknown");
+}
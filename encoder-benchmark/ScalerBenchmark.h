@@ -0,0 +1,69 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef __SCALERBENCHMARK_H__
+#define __SCALERBENCHMARK_H__
+
+#include <stdio.h>
+
+#include "FrameSource.h"
+#include "rfb/FrameBufferScaler.h"
+
+// Scales a sequence of frames to the given size with each filter of
+// FrameBufferScaler, with and without SIMD kernels. Every frame is scaled
+// entirely, as on a change of the scale, and then again only in its
+// damaged area, as the viewer does on framebuffer updates.
+class ScalerBenchmark
+{
+public:
+  // The source must remain valid during the life of this object.
+  ScalerBenchmark(FrameSource *source, FILE *report,
+                  const Dimension *scaledDim);
+  virtual ~ScalerBenchmark();
+
+  // Run all the filters one by one, printing a line for each.
+  void run();
+
+protected:
+  struct Result
+  {
+    int numFrames;
+    UINT64 numUpdatedPixels;
+    // Times in microseconds.
+    UINT64 fullTime;
+    UINT64 updateTime;
+  };
+
+  void runFilter(FrameBufferScaler::Filter filter, bool isSimd,
+                 Result *result);
+  void printResult(FrameBufferScaler::Filter filter, bool isSimd,
+                   const Result *result);
+
+  static const TCHAR *getFilterName(FrameBufferScaler::Filter filter);
+
+  FrameSource *m_source;
+  FILE *m_report;
+  Dimension m_scaledDim;
+};
+
+#endif // __SCALERBENCHMARK_H__
@@ -0,0 +1,229 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "SyntheticFrameSource.h"
+
+SyntheticFrameSource::SyntheticFrameSource(Workload workload,
+                                           int width, int height,
+                                           int numFrames)
+: m_workload(workload),
+  m_dim(width, height),
+  m_numFrames(numFrames),
+  m_frameNumber(0),
+  m_seed(1)
+{
+  const TCHAR *names[] = { _T("text"), _T("scroll"), _T("video"),
+                           _T("photo") };
+  m_name.format(_T("synthetic %s %dx%d"), names[workload], width, height);
+}
+
+SyntheticFrameSource::~SyntheticFrameSource()
+{
+}
+
+bool SyntheticFrameSource::parseWorkload(const TCHAR *name,
+                                         Workload *workload)
+{
+  StringStorage str(name);
+  if (str.isEqualTo(_T("text"))) {
+    *workload = TEXT;
+  } else if (str.isEqualTo(_T("scroll"))) {
+    *workload = SCROLL;
+  } else if (str.isEqualTo(_T("video"))) {
+    *workload = VIDEO;
+  } else if (str.isEqualTo(_T("photo"))) {
+    *workload = PHOTO;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+Dimension SyntheticFrameSource::getDimension() const
+{
+  return m_dim;
+}
+
+PixelFormat SyntheticFrameSource::getPixelFormat() const
+{
+  PixelFormat pf;
+  pf.initBigEndianByNative();
+  pf.bitsPerPixel = 32;
+  pf.colorDepth = 24;
+  pf.redMax = pf.greenMax = pf.blueMax = 255;
+  pf.redShift = 16;
+  pf.greenShift = 8;
+  pf.blueShift = 0;
+  return pf;
+}
+
+const TCHAR *SyntheticFrameSource::getName() const
+{
+  return m_name.getString();
+}
+
+void SyntheticFrameSource::rewind()
+{
+  m_frameNumber = 0;
+  m_seed = 1;
+}
+
+bool SyntheticFrameSource::getNextFrame(FrameBuffer *fb, Region *damage)
+{
+  if (m_frameNumber >= m_numFrames) {
+    return false;
+  }
+  damage->clear();
+  Rect screen = m_dim.getRect();
+
+  // The first frame is always the full screen.
+  if (m_frameNumber == 0) {
+    drawBackground(fb);
+    damage->addRect(&screen);
+    m_frameNumber++;
+    return true;
+  }
+
+  int numLines = m_dim.height / GLYPH_HEIGHT;
+  switch (m_workload) {
+  case TEXT:
+    {
+      // Type a few characters at the end of the current line.
+      int line = (m_frameNumber / 16) % numLines;
+      int column = (m_frameNumber % 16) * 4;
+      Rect r(column * GLYPH_WIDTH, line * GLYPH_HEIGHT,
+             (column + 4) * GLYPH_WIDTH, (line + 1) * GLYPH_HEIGHT);
+      r = r.intersection(&screen);
+      drawTextLine(fb, &r);
+      damage->addRect(&r);
+    }
+    break;
+  case SCROLL:
+    {
+      // Scroll up by one line and draw a new line at the bottom.
+      Rect moved(0, 0, m_dim.width, (numLines - 1) * GLYPH_HEIGHT);
+      fb->move(&moved, 0, GLYPH_HEIGHT);
+      Rect newLine(0, (numLines - 1) * GLYPH_HEIGHT,
+                   m_dim.width, numLines * GLYPH_HEIGHT);
+      fb->fillRect(&newLine, 0xffffff);
+      Rect text(newLine);
+      text.right = (int)(random() % m_dim.width);
+      drawTextLine(fb, &text);
+      damage->addRect(&screen);
+    }
+    break;
+  case VIDEO:
+    {
+      Rect area(0, 0, 640, 360);
+      area.move((m_dim.width - 640) / 2, (m_dim.height - 360) / 2);
+      area = area.intersection(&screen);
+      drawVideoFrame(fb, &area);
+      damage->addRect(&area);
+    }
+    break;
+  case PHOTO:
+    {
+      for (int i = 0; i < 4; i++) {
+        int w = 64 + random() % 192;
+        int h = 64 + random() % 192;
+        Rect tile(0, 0, w, h);
+        tile.move(random() % m_dim.width, random() % m_dim.height);
+        tile = tile.intersection(&screen);
+        drawPhotoTile(fb, &tile);
+        damage->addRect(&tile);
+      }
+    }
+    break;
+  }
+  m_frameNumber++;
+  return true;
+}
+
+UINT32 SyntheticFrameSource::random()
+{
+  m_seed = m_seed * 1103515245 + 12345;
+  return (m_seed >> 16) & 0x7fff;
+}
+
+void SyntheticFrameSource::drawBackground(FrameBuffer *fb)
+{
+  Rect full = m_dim.getRect();
+  if (m_workload == PHOTO) {
+    drawPhotoTile(fb, &full);
+    return;
+  }
+  fb->fillRect(&full, 0xffffff);
+  if (m_workload == TEXT || m_workload == SCROLL) {
+    // Fill the upper half of the screen with text.
+    for (int y = 0; y + GLYPH_HEIGHT <= m_dim.height / 2; y += GLYPH_HEIGHT) {
+      Rect line(0, y, random() % m_dim.width, y + GLYPH_HEIGHT);
+      drawTextLine(fb, &line);
+    }
+  }
+}
+
+void SyntheticFrameSource::drawTextLine(FrameBuffer *fb, const Rect *line)
+{
+  // Each glyph is a random pattern of dark pixels on a light background,
+  // which gives about the same color statistics as anti-aliased text.
+  for (int x0 = line->left; x0 + GLYPH_WIDTH <= line->right;
+       x0 += GLYPH_WIDTH) {
+    UINT32 pattern = random() | (random() << 15);
+    for (int y = line->top + 3; y < line->bottom - 3; y++) {
+      UINT32 *row = (UINT32 *)fb->getBufferPtr(x0, y);
+      for (int x = 1; x < GLYPH_WIDTH - 1; x++) {
+        bool on = ((pattern >> ((y * 3 + x) % 30)) & 1) != 0;
+        row[x] = on ? 0x202020 : 0xffffff;
+      }
+    }
+  }
+}
+
+void SyntheticFrameSource::drawVideoFrame(FrameBuffer *fb, const Rect *area)
+{
+  int t = m_frameNumber * 3;
+  for (int y = area->top; y < area->bottom; y++) {
+    UINT32 *row = (UINT32 *)fb->getBufferPtr(area->left, y);
+    for (int x = 0; x < area->getWidth(); x++) {
+      UINT32 r = (x + t) & 0xff;
+      UINT32 g = (y * 2 + t) & 0xff;
+      UINT32 b = ((x ^ y) + random() % 8) & 0xff;
+      row[x] = (r << 16) | (g << 8) | b;
+    }
+  }
+}
+
+void SyntheticFrameSource::drawPhotoTile(FrameBuffer *fb, const Rect *tile)
+{
+  for (int y = tile->top; y < tile->bottom; y++) {
+    UINT32 *row = (UINT32 *)fb->getBufferPtr(tile->left, y);
+    for (int x = 0; x < tile->getWidth(); x++) {
+      UINT32 noise = random() % 24;
+      UINT32 r = ((tile->left + x) / 4 + noise) & 0xff;
+      UINT32 g = (y / 3 + noise) & 0xff;
+      UINT32 b = ((tile->left + x + y) / 6 + noise) & 0xff;
+      row[x] = (r << 16) | (g << 8) | b;
+    }
+  }
+}
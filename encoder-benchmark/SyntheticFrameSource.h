@@ -0,0 +1,81 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __SYNTHETICFRAMESOURCE_H__
+#define __SYNTHETICFRAMESOURCE_H__
+
+#include "util/StringStorage.h"
+#include "FrameSource.h"
+
+// Generates a deterministic sequence of frames in 32-bit true color.
+class SyntheticFrameSource : public FrameSource
+{
+public:
+  enum Workload {
+    // Lines of small dark "glyphs" typed on a light background.
+    TEXT,
+    // The whole screen scrolls up by a few rows, new lines appear below.
+    SCROLL,
+    // A 640x360 area with smooth but constantly changing content.
+    VIDEO,
+    // Noisy photo-like content changed in medium-sized tiles.
+    PHOTO
+  };
+
+  SyntheticFrameSource(Workload workload, int width, int height,
+                       int numFrames);
+  virtual ~SyntheticFrameSource();
+
+  // Find the workload by its name ("text", "scroll", "video" or "photo").
+  // Return false if the name is unknown.
+  static bool parseWorkload(const TCHAR *name, Workload *workload);
+
+  virtual Dimension getDimension() const;
+  virtual PixelFormat getPixelFormat() const;
+  virtual const TCHAR *getName() const;
+  virtual void rewind();
+  virtual bool getNextFrame(FrameBuffer *fb, Region *damage);
+
+protected:
+  // Simple linear congruential generator, so that the sequence would be
+  // the same on every run.
+  UINT32 random();
+
+  void drawBackground(FrameBuffer *fb);
+  void drawTextLine(FrameBuffer *fb, const Rect *line);
+  void drawVideoFrame(FrameBuffer *fb, const Rect *area);
+  void drawPhotoTile(FrameBuffer *fb, const Rect *tile);
+
+  static const int GLYPH_WIDTH = 8;
+  static const int GLYPH_HEIGHT = 16;
+
+  Workload m_workload;
+  Dimension m_dim;
+  int m_numFrames;
+  int m_frameNumber;
+  UINT32 m_seed;
+  StringStorage m_name;
+};
+
+#endif // __SYNTHETICFRAMESOURCE_H__
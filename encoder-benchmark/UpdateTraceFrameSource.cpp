@@ -0,0 +1,118 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "UpdateTraceFrameSource.h"
+
+#include "io-lib/DataInputStream.h"
+#include "util/Exception.h"
+
+UpdateTraceFrameSource::UpdateTraceFrameSource(const TCHAR *fileName)
+: m_fileName(fileName),
+  m_file(0),
+  m_reader(0)
+{
+  open();
+}
+
+UpdateTraceFrameSource::~UpdateTraceFrameSource()
+{
+  close();
+}
+
+bool UpdateTraceFrameSource::isUpdateTrace(const TCHAR *fileName)
+{
+  try {
+    WinFileChannel file(fileName, F_READ, FM_OPEN);
+    DataInputStream input(&file);
+    char signature[UpdateTraceDefs::SIGNATURE_LENGTH];
+    input.readFully(signature, sizeof(signature));
+    return memcmp(signature, UpdateTraceDefs::SIGNATURE,
+                  sizeof(signature)) == 0;
+  } catch (Exception &) {
+    return false;
+  }
+}
+
+Dimension UpdateTraceFrameSource::getDimension() const
+{
+  return m_reader->getDimension();
+}
+
+PixelFormat UpdateTraceFrameSource::getPixelFormat() const
+{
+  return m_reader->getPixelFormat();
+}
+
+const TCHAR *UpdateTraceFrameSource::getName() const
+{
+  return m_fileName.getString();
+}
+
+void UpdateTraceFrameSource::rewind()
+{
+  close();
+  open();
+}
+
+bool UpdateTraceFrameSource::getNextFrame(FrameBuffer *fb, Region *damage)
+{
+  Dimension dim = m_reader->getDimension();
+  PixelFormat pf = m_reader->getPixelFormat();
+  if (!m_reader->readUpdate(&m_record, fb)) {
+    return false;
+  }
+  // The first update always follows a format chunk, the later ones must
+  // keep the properties reported to the benchmark.
+  Dimension newDim = m_reader->getDimension();
+  PixelFormat newPf = m_reader->getPixelFormat();
+  if (!newDim.isEqualTo(&dim) || !newPf.isEqualTo(&pf)) {
+    return false;
+  }
+  damage->set(&m_record.changedRegion);
+  damage->add(&m_record.copiedRegion);
+  return true;
+}
+
+void UpdateTraceFrameSource::open()
+{
+  m_file = new WinFileChannel(m_fileName.getString(), F_READ, FM_OPEN);
+  try {
+    m_reader = new UpdateTraceReader(m_file);
+  } catch (...) {
+    close();
+    throw;
+  }
+}
+
+void UpdateTraceFrameSource::close()
+{
+  if (m_reader != 0) {
+    delete m_reader;
+    m_reader = 0;
+  }
+  if (m_file != 0) {
+    delete m_file;
+    m_file = 0;
+  }
+}
@@ -0,0 +1,64 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __UPDATETRACEFRAMESOURCE_H__
+#define __UPDATETRACEFRAMESOURCE_H__
+
+#include "file-lib/WinFileChannel.h"
+#include "rfb/UpdateTraceReader.h"
+#include "util/StringStorage.h"
+#include "FrameSource.h"
+
+// Replays an update trace recorded by the server (see
+// rfb/UpdateTraceDefs.h). The damage of each frame is the changed region
+// together with the copied region, since the benchmark does not use
+// CopyRect. The sequence ends at the first change of the frame buffer
+// properties.
+class UpdateTraceFrameSource : public FrameSource
+{
+public:
+  // Opens the file and reads its header. Throws Exception on errors.
+  UpdateTraceFrameSource(const TCHAR *fileName);
+  virtual ~UpdateTraceFrameSource();
+
+  // Return true if the file starts with the update trace signature.
+  static bool isUpdateTrace(const TCHAR *fileName);
+
+  virtual Dimension getDimension() const;
+  virtual PixelFormat getPixelFormat() const;
+  virtual const TCHAR *getName() const;
+  virtual void rewind();
+  virtual bool getNextFrame(FrameBuffer *fb, Region *damage);
+
+protected:
+  void open();
+  void close();
+
+  StringStorage m_fileName;
+  WinFileChannel *m_file;
+  UpdateTraceReader *m_reader;
+  UpdateTraceRecord m_record;
+};
+
+#endif // __UPDATETRACEFRAMESOURCE_H__
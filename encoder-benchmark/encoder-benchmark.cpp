@@ -0,0 +1,321 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "EncoderBenchmark.h"
+#include "FullUpdateBenchmark.h"
+#include "IpcBenchmark.h"
+#include "JpegBenchmark.h"
+#include "LogBenchmark.h"
+#include "LoopbackBenchmark.h"
+#include "ScalerBenchmark.h"
+#include "SyntheticFrameSource.h"
+#include "FrameSequenceFile.h"
+#include "UpdateTraceFrameSource.h"
+#include "rfb/EncodingDefs.h"
+#include "util/Exception.h"
+#include "util/StringParser.h"
+#include "util/StringStorage.h"
+#include <stdio.h>
+
+static const int DEFAULT_WIDTH = 1920;
+static const int DEFAULT_HEIGHT = 1080;
+static const int DEFAULT_NUM_FRAMES = 100;
+static const int DEFAULT_NUM_LOG_LINES = 100000;
+static const int DEFAULT_NUM_IPC_MESSAGES = 100000;
+
+static void printUsage()
+{
+  _ftprintf(stderr,
+            _T("Usage: encoder-benchmark <workload> [frames]")
+            _T(" [-loopback [kbps [latency]]] [-pipelined]\n")
+            _T("       [-readahead] [-jpegthreads n] [-fps n] [-autotune]\n")
+            _T("       encoder-benchmark <workload> [frames] -solid\n")
+            _T("       encoder-benchmark <workload> [frames] -paralleltight\n")
+            _T("       encoder-benchmark <workload> [frames] -videothreads n\n")
+            _T("       encoder-benchmark <workload> [frames] -jpeg\n")
+            _T("       encoder-benchmark -log [lines]\n")
+            _T("       encoder-benchmark -ipc [messages]\n")
+            _T("       encoder-benchmark <workload> [frames]")
+            _T(" -scale <width>x<height>\n")
+            _T("  <workload> is one of the synthetic workloads (text, scroll,")
+            _T(" video, photo)\n")
+            _T("  with an optional frame size (e.g. video@3840x2160, default")
+            _T(" %dx%d)\n")
+            _T("  or a path to a frame sequence file or an update trace.\n")
+            _T("  [frames] is the number of synthetic frames (default %d).\n")
+            _T("  -loopback sends the frames to an in-process viewer and")
+            _T(" checks the result,\n")
+            _T("  optionally over a link with the given bandwidth in kbit/s")
+            _T(" (0 = unlimited)\n")
+            _T("  and one-way latency in milliseconds.\n")
+            _T("  -pipelined makes the viewer request the next update as")
+            _T(" soon as an update starts.\n")
+            _T("  -readahead makes the viewer read the connection in a")
+            _T(" separate thread.\n")
+            _T("  -jpegthreads makes the viewer decompress JPEG rectangles")
+            _T(" in n threads.\n")
+            _T("  -fps limits the rate of the viewer update notifications")
+            _T(" to n per second.\n")
+            _T("  -autotune makes the viewer choose the encoding from the")
+            _T(" measured updates,\n")
+            _T("  starting from Tight.\n")
+            _T("  -solid compares Tight without and with the extraction of")
+            _T(" solid-color areas.\n")
+            _T("  -paralleltight sends every frame as a full-screen Tight")
+            _T(" update without and\n")
+            _T("  with the parallel mode and checks the decoded frames.\n")
+            _T("  -videothreads sends every frame as a full-screen video")
+            _T(" update compressed\n")
+            _T("  by JPEG in 1, 2, 4 and so on up to n threads, reporting")
+            _T(" updates per second\n")
+            _T("  (e.g. video and video@3840x2160 for 1080p and 4K).\n")
+            _T("  -jpeg compares the direct and the converting input of the")
+            _T(" JPEG compressor\n")
+            _T("  at each chroma subsampling.\n")
+            _T("  -scale measures the viewer scaling filters instead of")
+            _T(" the encoders.\n")
+            _T("  The options may be given in any order, the viewer options")
+            _T(" need -loopback.\n")
+            _T("  -log measures the file loggers with the given number of")
+            _T(" lines per thread\n")
+            _T("  (default %d).\n")
+            _T("  -ipc measures the desktop IPC messages per second and")
+            _T(" latency with\n")
+            _T("  the given number of messages per test (default %d).\n"),
+            DEFAULT_WIDTH, DEFAULT_HEIGHT, DEFAULT_NUM_FRAMES,
+            DEFAULT_NUM_LOG_LINES, DEFAULT_NUM_IPC_MESSAGES);
+}
+
+// Parses "<workload>[@<width>x<height>]" naming a synthetic workload.
+static bool parseSyntheticWorkload(const TCHAR *arg,
+                                   SyntheticFrameSource::Workload *workload,
+                                   int *width, int *height)
+{
+  StringStorage name(arg);
+  *width = DEFAULT_WIDTH;
+  *height = DEFAULT_HEIGHT;
+  const TCHAR *size = _tcsrchr(arg, _T('@'));
+  if (size != 0) {
+    TCHAR c;
+    if (_stscanf(size + 1, _T("%dx%d%c"), width, height, &c) != 2 ||
+        *width <= 0 || *height <= 0) {
+      return false;
+    }
+    name.truncate(_tcslen(size));
+  }
+  return SyntheticFrameSource::parseWorkload(name.getString(), workload);
+}
+
+// Parses the value of the option at argv[*index] and moves the index to it.
+static bool parseOptionValue(int argc, TCHAR *argv[], int *index, int *value)
+{
+  if (*index + 1 >= argc ||
+      !StringParser::parseInt(argv[*index + 1], value) || *value < 0) {
+    return false;
+  }
+  (*index)++;
+  return true;
+}
+
+// Returns true if the argument following argv[index] is not an option.
+static bool hasPlainArgument(int argc, TCHAR *argv[], int index)
+{
+  return index + 1 < argc && argv[index + 1][0] != _T('-');
+}
+
+int _tmain(int argc, TCHAR *argv[])
+{
+  if (argc < 2) {
+    printUsage();
+    return 1;
+  }
+  // The benchmarks which don't need a workload.
+  bool isLogTest = _tcscmp(argv[1], _T("-log")) == 0;
+  bool isIpcTest = _tcscmp(argv[1], _T("-ipc")) == 0;
+  if (isLogTest || isIpcTest) {
+    int count = isLogTest ? DEFAULT_NUM_LOG_LINES : DEFAULT_NUM_IPC_MESSAGES;
+    bool isValid = argc <= 3;
+    if (isValid && argc == 3) {
+      isValid = StringParser::parseInt(argv[2], &count) && count > 0;
+    }
+    if (!isValid) {
+      printUsage();
+      return 1;
+    }
+    try {
+      if (isLogTest) {
+        LogBenchmark logBenchmark(stdout, count);
+        logBenchmark.run();
+      } else {
+        IpcBenchmark ipcBenchmark(stdout, count);
+        ipcBenchmark.run();
+      }
+    } catch (Exception &e) {
+      _ftprintf(stderr, _T("Error: %s\n"), e.getMessage());
+      return 1;
+    }
+    return 0;
+  }
+  int numFrames = DEFAULT_NUM_FRAMES;
+  bool isLoopback = false;
+  int bandwidth = 0;
+  int latency = 0;
+  bool isPipelined = false;
+  bool isReadingAhead = false;
+  int numDecodingThreads = 0;
+  int frameRate = 0;
+  bool isAutoTuning = false;
+  bool hasViewerOptions = false;
+  bool isSolidAreaTest = false;
+  bool isParallelTightTest = false;
+  int numVideoThreads = 0;
+  bool isJpegTest = false;
+  bool isScaling = false;
+  Dimension scaledDim;
+  for (int i = 2; i < argc; i++) {
+    const TCHAR *arg = argv[i];
+    bool isValid = true;
+    if (i == 2 && arg[0] != _T('-')) {
+      isValid = StringParser::parseInt(arg, &numFrames) && numFrames > 0;
+    } else if (_tcscmp(arg, _T("-loopback")) == 0) {
+      isLoopback = true;
+      // The link parameters are optional.
+      if (hasPlainArgument(argc, argv, i)) {
+        isValid = parseOptionValue(argc, argv, &i, &bandwidth);
+        if (isValid && hasPlainArgument(argc, argv, i)) {
+          isValid = parseOptionValue(argc, argv, &i, &latency);
+        }
+      }
+    } else if (_tcscmp(arg, _T("-pipelined")) == 0) {
+      isPipelined = hasViewerOptions = true;
+    } else if (_tcscmp(arg, _T("-readahead")) == 0) {
+      isReadingAhead = hasViewerOptions = true;
+    } else if (_tcscmp(arg, _T("-autotune")) == 0) {
+      isAutoTuning = hasViewerOptions = true;
+    } else if (_tcscmp(arg, _T("-jpegthreads")) == 0) {
+      isValid = parseOptionValue(argc, argv, &i, &numDecodingThreads);
+      hasViewerOptions = true;
+    } else if (_tcscmp(arg, _T("-fps")) == 0) {
+      isValid = parseOptionValue(argc, argv, &i, &frameRate);
+      hasViewerOptions = true;
+    } else if (_tcscmp(arg, _T("-solid")) == 0) {
+      isSolidAreaTest = true;
+    } else if (_tcscmp(arg, _T("-paralleltight")) == 0) {
+      isParallelTightTest = true;
+    } else if (_tcscmp(arg, _T("-videothreads")) == 0) {
+      isValid = parseOptionValue(argc, argv, &i, &numVideoThreads) &&
+                numVideoThreads > 0;
+    } else if (_tcscmp(arg, _T("-jpeg")) == 0) {
+      isJpegTest = true;
+    } else if (_tcscmp(arg, _T("-scale")) == 0 && i + 1 < argc) {
+      TCHAR c;
+      isScaling = true;
+      i++;
+      isValid = _stscanf(argv[i], _T("%dx%d%c"),
+                         &scaledDim.width, &scaledDim.height, &c) == 2 &&
+                scaledDim.width > 0 && scaledDim.height > 0;
+    } else {
+      isValid = false;
+    }
+    if (!isValid) {
+      printUsage();
+      return 1;
+    }
+  }
+  // The viewer options make sense only for the loopback mode, which can't
+  // be combined with the other ones.
+  int numModes = (isLoopback ? 1 : 0) + (isSolidAreaTest ? 1 : 0) +
+                 (isParallelTightTest ? 1 : 0) +
+                 (numVideoThreads != 0 ? 1 : 0) + (isJpegTest ? 1 : 0) +
+                 (isScaling ? 1 : 0);
+  if ((hasViewerOptions && !isLoopback) || numModes > 1) {
+    printUsage();
+    return 1;
+  }
+  FrameSource *source = 0;
+  EncoderBenchmark *benchmark = 0;
+  try {
+    SyntheticFrameSource::Workload workload;
+    int width, height;
+    if (parseSyntheticWorkload(argv[1], &workload, &width, &height)) {
+      source = new SyntheticFrameSource(workload, width, height, numFrames);
+    } else if (UpdateTraceFrameSource::isUpdateTrace(argv[1])) {
+      source = new UpdateTraceFrameSource(argv[1]);
+    } else {
+      source = new FrameSequenceFile(argv[1]);
+    }
+    if (isScaling) {
+      ScalerBenchmark scalerBenchmark(source, stdout, &scaledDim);
+      scalerBenchmark.run();
+      delete source;
+      return 0;
+    }
+    if (isJpegTest) {
+      JpegBenchmark jpegBenchmark(source, stdout);
+      jpegBenchmark.run();
+      delete source;
+      return 0;
+    }
+    if (isParallelTightTest || numVideoThreads != 0) {
+      FullUpdateBenchmark fullUpdateBenchmark(source, stdout);
+      if (isParallelTightTest) {
+        fullUpdateBenchmark.runTightParallel();
+      } else {
+        fullUpdateBenchmark.runVideo(numVideoThreads);
+      }
+      delete source;
+      return 0;
+    }
+    if (isLoopback) {
+      LoopbackBenchmark::Options options;
+      options.bandwidth = (UINT64)bandwidth * 1000 / 8;
+      options.latency = (UINT64)latency * 1000;
+      options.viewer.isPipelined = isPipelined;
+      options.viewer.isReadingAhead = isReadingAhead;
+      options.viewer.numDecodingThreads = numDecodingThreads;
+      options.viewer.frameRate = frameRate;
+      options.viewer.isAutoTuning = isAutoTuning;
+      benchmark = new LoopbackBenchmark(source, stdout, &options);
+    } else {
+      benchmark = new EncoderBenchmark(source, stdout);
+    }
+    if (isAutoTuning) {
+      // The viewer overrides the configuration, so one run is enough.
+      benchmark->addConfig(EncodingDefs::TIGHT);
+    } else if (isSolidAreaTest) {
+      benchmark->addSolidAreaConfigs();
+    } else {
+      benchmark->addDefaultConfigs();
+    }
+    benchmark->run();
+  } catch (Exception &e) {
+    _ftprintf(stderr, _T("Error: %s\n"), e.getMessage());
+    delete benchmark;
+    delete source;
+    return 1;
+  }
+  delete benchmark;
+  delete source;
+  return 0;
+}
@@ -0,0 +1,178 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "RefinementScheduler.h"
+
+#include <vector>
+
+#include "thread/AutoLock.h"
+
+RefinementScheduler::RefinementScheduler()
+: m_delay(0),
+  m_refinementBytes(0)
+{
+}
+
+RefinementScheduler::~RefinementScheduler()
+{
+}
+
+void RefinementScheduler::setDelay(unsigned int delay)
+{
+  AutoLock al(&m_lock);
+  m_delay = delay;
+  if (m_delay == 0) {
+    m_pendingRegion.clear();
+  }
+}
+
+void RefinementScheduler::reset()
+{
+  AutoLock al(&m_lock);
+  m_pendingRegion.clear();
+}
+
+void RefinementScheduler::onCopyRect(const Region *dstRegion,
+                                     const Point *srcPoint)
+{
+  AutoLock al(&m_lock);
+  if (m_pendingRegion.isEmpty() || dstRegion->isEmpty()) {
+    return;
+  }
+
+  Rect dstBounds = dstRegion->getBounds();
+  int dx = srcPoint->x - dstBounds.left;
+  int dy = srcPoint->y - dstBounds.top;
+
+  // Find lossy pixels in the source and move them to the destination.
+  Region lossyCopy = *dstRegion;
+  lossyCopy.translate(dx, dy);
+  lossyCopy.intersect(&m_pendingRegion);
+  lossyCopy.translate(-dx, -dy);
+
+  m_pendingRegion.subtract(dstRegion);
+  m_pendingRegion.add(&lossyCopy);
+}
+
+void RefinementScheduler::onUpdateSent(const Region *sentRegion,
+                                       const Region *lossyRegion)
+{
+  AutoLock al(&m_lock);
+  m_pendingRegion.subtract(sentRegion);
+  if (!lossyRegion->isEmpty()) {
+    m_lastLossyTime = DateTime::now();
+    if (m_delay != 0) {
+      m_pendingRegion.add(lossyRegion);
+    }
+  }
+}
+
+bool RefinementScheduler::getNextBatch(const Region *allowedRegion,
+                                       Region *batch)
+{
+  AutoLock al(&m_lock);
+  batch->clear();
+  if (m_delay == 0 || m_pendingRegion.isEmpty() ||
+      (DateTime::now() - m_lastLossyTime).getTime() < m_delay) {
+    return false;
+  }
+
+  Region candidates = m_pendingRegion;
+  candidates.intersect(allowedRegion);
+  std::vector<Rect> rects;
+  candidates.getRectVector(&rects);
+
+  int areaLeft = MAX_BATCH_AREA;
+  std::vector<Rect>::iterator it;
+  for (it = rects.begin(); it != rects.end() && areaLeft > 0; it++) {
+    Rect r = *it;
+    if (r.area() > areaLeft) {
+      // Take only the upper part of the rectangle which fits the batch.
+      int rows = areaLeft / r.getWidth();
+      if (rows < 1) {
+        rows = 1;
+      }
+      r.setHeight(rows);
+    }
+    batch->addRect(&r);
+    areaLeft -= r.area();
+  }
+
+  if (batch->isEmpty()) {
+    // Nothing can be refined within the allowed region at the moment, try
+    // again after one more quiet period.
+    m_lastLossyTime = DateTime::now();
+    return false;
+  }
+  m_pendingRegion.subtract(batch);
+  return true;
+}
+
+bool RefinementScheduler::hasPendingRegion()
+{
+  AutoLock al(&m_lock);
+  return !m_pendingRegion.isEmpty();
+}
+
+DWORD RefinementScheduler::getWaitTime()
+{
+  AutoLock al(&m_lock);
+  if (m_delay == 0 || m_pendingRegion.isEmpty()) {
+    return INFINITE;
+  }
+  UINT64 elapsed = (DateTime::now() - m_lastLossyTime).getTime();
+  if (elapsed >= m_delay) {
+    return 0;
+  }
+  return (DWORD)(m_delay - elapsed);
+}
+
+void RefinementScheduler::addRefinementBytes(UINT64 bytes)
+{
+  AutoLock al(&m_lock);
+  m_refinementBytes += bytes;
+}
+
+UINT64 RefinementScheduler::getPendingArea()
+{
+  AutoLock al(&m_lock);
+  return getRegionArea(&m_pendingRegion);
+}
+
+UINT64 RefinementScheduler::getRefinementBytes()
+{
+  AutoLock al(&m_lock);
+  return m_refinementBytes;
+}
+
+UINT64 RefinementScheduler::getRegionArea(const Region *region)
+{
+  std::vector<Rect> rects;
+  region->getRectVector(&rects);
+  UINT64 area = 0;
+  for (size_t i = 0; i < rects.size(); i++) {
+    area += rects[i].area();
+  }
+  return area;
+}
@@ -0,0 +1,111 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __REFINEMENTSCHEDULER_H__
+#define __REFINEMENTSCHEDULER_H__
+
+#include "region/Point.h"
+#include "region/Region.h"
+#include "thread/LocalMutex.h"
+#include "util/DateTime.h"
+
+// RefinementScheduler remembers which parts of the client's framebuffer were
+// last sent with lossy (JPEG) compression and decides when to resend them
+// losslessly. Refinement starts after a quiet period without lossy updates
+// and is done in small batches, each one sent only when there is nothing
+// else to send, so it uses idle time only.
+//
+// onCopyRect(), onUpdateSent() and getNextBatch() should be called from the
+// sender thread, other functions may be called from any thread.
+class RefinementScheduler
+{
+public:
+  RefinementScheduler();
+  virtual ~RefinementScheduler();
+
+  // Set the quiet period in milliseconds. Zero disables refinement.
+  void setDelay(unsigned int delay);
+
+  // Forget all lossy areas, e.g. because the whole framebuffer will be
+  // sent again.
+  void reset();
+
+  // Register a CopyRect operation to the dstRegion from the source point
+  // srcPoint (top left corner of the source rectangle). Lossy areas move
+  // together with the copied pixels.
+  void onCopyRect(const Region *dstRegion, const Point *srcPoint);
+
+  // Register a sent framebuffer update. The sentRegion no longer needs
+  // refinement unless it's inside lossyRegion (the part sent with lossy
+  // compression).
+  void onUpdateSent(const Region *sentRegion, const Region *lossyRegion);
+
+  // If the quiet period has passed, take the next batch of lossy areas
+  // inside allowedRegion, store it in *batch, remove it from the pending
+  // region and return true. Otherwise, return false.
+  bool getNextBatch(const Region *allowedRegion, Region *batch);
+
+  // Return true if there are lossy areas waiting for refinement.
+  bool hasPendingRegion();
+
+  // Return the number of milliseconds until the refinement may start, zero
+  // if it may start now, or INFINITE if there is nothing to refine.
+  DWORD getWaitTime();
+
+  // Account bytes sent for refinement.
+  void addRefinementBytes(UINT64 bytes);
+
+  //
+  // Metrics.
+  //
+
+  // Area of the regions waiting for refinement, in pixels.
+  UINT64 getPendingArea();
+  // Total number of bytes sent for refinement.
+  UINT64 getRefinementBytes();
+
+protected:
+  static UINT64 getRegionArea(const Region *region);
+
+  // Maximum number of pixels in one refinement batch.
+  static const int MAX_BATCH_AREA = 65536;
+
+  unsigned int m_delay;
+
+  // Areas sent with lossy compression and not refined yet.
+  Region m_pendingRegion;
+  // The moment when something was sent with lossy compression most recently.
+  DateTime m_lastLossyTime;
+
+  UINT64 m_refinementBytes;
+
+  LocalMutex m_lock;
+
+private:
+  // Do not allow copying objects.
+  RefinementScheduler(const RefinementScheduler &other);
+  RefinementScheduler &operator=(const RefinementScheduler &other);
+};
+
+#endif // __REFINEMENTSCHEDULER_H__
@@ -25,3 +25,4 @@
 #include "UpdSenderMsgDefs.h"
 
 const char UpdSenderClientMsgDefs::RFB_VIDEO_FREEZE_SIG[] = "VD_FREEZ";
+const char UpdSenderClientMsgDefs::RFB_SET_SCALE_SIG[] = "SETSCALE";
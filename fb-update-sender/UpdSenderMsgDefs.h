@@ -32,6 +32,11 @@ class UpdSenderClientMsgDefs
 public:
   static const UINT32 RFB_VIDEO_FREEZE = 152;
   const static char RFB_VIDEO_FREEZE_SIG[];
+  // Sets the scale (in percent, from 1 to 100) at which the server sends
+  // the desktop to the client. Message body: padding (1 byte), scale
+  // (2 bytes).
+  static const UINT32 RFB_SET_SCALE = 153;
+  const static char RFB_SET_SCALE_SIG[];
 };
 
 #endif // __UPDSENDERMSGDEFS_H__
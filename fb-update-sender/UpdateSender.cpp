@@ -29,6 +29,9 @@
 #include <vector>
 #include "util/inttypes.h"
 #include "util/Exception.h"
+#include "util/PreciseTimer.h"
+#include "log-writer/Tracer.h"
+#include "server-config-lib/Configurator.h"
 #include "UpdSenderMsgDefs.h"
 
 UpdateSender::UpdateSender(RfbCodeRegistrator *codeRegtor,
@@ -43,14 +46,18 @@ UpdateSender::UpdateSender(RfbCodeRegistrator *codeRegtor,
   m_busy(false),
   m_incrUpdIsReq(false),
   m_fullUpdIsReq(false),
+  m_requestTime(0),
   m_setColorMapEntr(false),
   m_output(output),
   m_enbox(&m_pixelConverter, m_output),
   m_id(id),
   m_videoFrozen(false),
   m_shareOnlyApp(false),
+  m_newScale(FULL_SCALE),
+  m_scale(FULL_SCALE),
   m_log(log),
-  m_cursorUpdates(log)
+  m_cursorUpdates(log),
+  m_statisticsStartTime(PreciseTimer::getMicroseconds())
 {
   // FIXME: argument must be defined
   m_updateKeeper = new UpdateKeeper(&Rect());
@@ -76,9 +83,13 @@ UpdateSender::UpdateSender(RfbCodeRegistrator *codeRegtor,
   codeRegtor->addClToSrvCap(UpdSenderClientMsgDefs::RFB_VIDEO_FREEZE,
                             VendorDefs::TIGHTVNC,
                             UpdSenderClientMsgDefs::RFB_VIDEO_FREEZE_SIG);
+  codeRegtor->addClToSrvCap(UpdSenderClientMsgDefs::RFB_SET_SCALE,
+                            VendorDefs::TIGHTVNC,
+                            UpdSenderClientMsgDefs::RFB_SET_SCALE_SIG);
 
   // Request codes
   codeRegtor->regCode(UpdSenderClientMsgDefs::RFB_VIDEO_FREEZE, this);
+  codeRegtor->regCode(UpdSenderClientMsgDefs::RFB_SET_SCALE, this);
   codeRegtor->regCode(ClientMsgDefs::FB_UPDATE_REQUEST, this);
   codeRegtor->regCode(ClientMsgDefs::SET_PIXEL_FORMAT, this);
   codeRegtor->regCode(ClientMsgDefs::SET_ENCODINGS, this);
@@ -113,6 +124,9 @@ void UpdateSender::onRequest(UINT32 reqCode, RfbInputGate *input)
   case UpdSenderClientMsgDefs::RFB_VIDEO_FREEZE:
     readVideoFreeze(input);
     break;
+  case UpdSenderClientMsgDefs::RFB_SET_SCALE:
+    readSetScale(input);
+    break;
   default:
     StringStorage errMess;
     errMess.format(_T("Unknown %d protocol code received"), (int)reqCode);
@@ -178,6 +192,30 @@ bool UpdateSender::clientIsReady()
   return (m_incrUpdIsReq || m_fullUpdIsReq) && !m_busy;
 }
 
+void UpdateSender::getStatistics(UpdateStatistics *statistics)
+{
+  {
+    AutoLock al(&m_statisticsLock);
+    *statistics = m_publishedStatistics;
+  }
+  statistics->duration = PreciseTimer::getMicroseconds() -
+                         m_statisticsStartTime;
+}
+
+void UpdateSender::unscalePointerPos(UINT16 *x, UINT16 *y)
+{
+  int scale;
+  {
+    AutoLock al(&m_viewPortMut);
+    scale = m_scale;
+  }
+  if (scale != FULL_SCALE) {
+    // Take the center of the pixel the client points to.
+    *x = (UINT16)min((*x * 2 + 1) * FULL_SCALE / (2 * scale), 0xffff);
+    *y = (UINT16)min((*y * 2 + 1) * FULL_SCALE / (2 * scale), 0xffff);
+  }
+}
+
 void UpdateSender::sendRectHeader(const Rect *rect, INT32 encodingType)
 {
   // FIXME: Why no warnings on passing bigger integer types?
@@ -209,7 +247,7 @@ void UpdateSender::sendNewFBSize(Dimension *dim)
   sendRectHeader(&r, PseudoEncDefs::DESKTOP_SIZE);
 }
 
-void UpdateSender::sendFbInClientDim(const EncodeOptions *encodeOptions,
+size_t UpdateSender::sendFbInClientDim(const EncodeOptions *encodeOptions,
                                      const FrameBuffer *fb,
                                      const Dimension *dim,
                                      const PixelFormat *pf)
@@ -233,6 +271,7 @@ void UpdateSender::sendFbInClientDim(const EncodeOptions *encodeOptions,
   _ASSERT(numRects == rects.size());
   m_output->writeUInt16(numRects);
   sendRectangles(m_enbox.getEncoder(), &rects, &blankFrameBuffer, encodeOptions);
+  return rects.size();
 }
 
 void UpdateSender::sendCursorShapeUpdate(const PixelFormat *fmt,
@@ -260,6 +299,8 @@ void UpdateSender::sendCursorShapeUpdate(const PixelFormat *fmt,
 void UpdateSender::sendCursorPosUpdate()
 {
   Point pos = m_cursorUpdates.getCurPos();
+  pos.x = pos.x * m_scale / FULL_SCALE;
+  pos.y = pos.y * m_scale / FULL_SCALE;
   sendRectHeader(pos.x, pos.y, 0, 0, PseudoEncDefs::POINTER_POS);
 }
 
@@ -277,6 +318,14 @@ void UpdateSender::sendCopyRect(const std::vector<Rect> *rects, const Point *sou
     m_output->writeUInt16(source->x);
     m_output->writeUInt16(source->y);
   }
+
+  UINT64 numPixels = 0;
+  for (iRect = rects->begin(); iRect != rects->end(); iRect++) {
+    numPixels += iRect->area();
+  }
+  // Header and source position of each rectangle.
+  m_statistics.addRectangles(UpdateStatistics::COPY_RECT, rects->size(),
+                             numPixels, rects->size() * 16, 0);
 }
 
 void UpdateSender::sendPalette(PixelFormat *pf)
@@ -301,13 +350,15 @@ void UpdateSender::sendUpdate()
   Region requestedFullReg, requestedIncrReg;
   bool incrUpdIsReq, fullUpdIsReq;
   DateTime reqTimePoint;
+  UINT64 requestTime;
   if (!extractReqRegions(&requestedIncrReg, &requestedFullReg,
                          &incrUpdIsReq, &fullUpdIsReq,
-                         &reqTimePoint)) {
+                         &reqTimePoint, &requestTime)) {
     m_log->debug(_T("No request, exiting from the sendUpdate()"));
     return;
   }
   m_log->debug(_T("A request has been made, continuing"));
+  TRACE_SPAN_ARGS(updateSpan, "UpdateSender::sendUpdate", "rects", "bytes");
   m_log->debug(_T("The incremental region has %d rectangles"),
              (int)requestedIncrReg.getCount());
   m_log->debug(_T("The full region has %d rectangles"),
@@ -331,12 +382,23 @@ void UpdateSender::sendUpdate()
   FrameBuffer *frameBuffer = &m_frameBuffer;
 
   AutoLock l(m_output);
+  UINT64 bytesBeforeUpdate = m_output->getBytesWritten();
+  size_t numSentRects = 0;
 
   Dimension clientDim, lastViewPortDim;
+  int scale;
   {
     AutoLock al(&m_viewPortMut);
     clientDim = m_clientDim;
     lastViewPortDim = m_lastViewPortDim;
+    scale = m_newScale;
+  }
+  // The client must be able to change its frame buffer size to get the
+  // desktop scaled.
+  PixelFormat frameBufferFormat = frameBuffer->getPixelFormat();
+  if (!encodeOptions.desktopSizeEnabled() ||
+      !FrameBufferScaler::isSupportedFormat(&frameBufferFormat)) {
+    scale = FULL_SCALE;
   }
 
   // If client does not support the desktop resizing then view port dimension
@@ -348,7 +410,8 @@ void UpdateSender::sendUpdate()
   }
 
   // Checking for screen size changing
-  bool dimensionChanged = lastViewPortDim != Dimension(&viewPort) || updCont.screenSizeChanged;
+  bool dimensionChanged = lastViewPortDim != Dimension(&viewPort) ||
+                          updCont.screenSizeChanged || scale != m_scale;
   if (dimensionChanged) {
     updCont.screenSizeChanged = true;
   }
@@ -358,13 +421,19 @@ void UpdateSender::sendUpdate()
     AutoLock al(&m_viewPortMut);
     m_lastViewPortDim.setDim(&viewPort);
     lastViewPortDim = m_lastViewPortDim;
+    m_scale = scale;
+    if (m_scale == FULL_SCALE) {
+      // Release the scaled picture, it will be made anew if needed.
+      Dimension emptyDim;
+      m_scaledFrameBuffer.setDimension(&emptyDim);
+    }
     if (encodeOptions.desktopSizeEnabled()) {
-      m_clientDim.setDim(&viewPort);
+      m_clientDim = getScaledDimension(&lastViewPortDim, m_scale);
       clientDim = m_clientDim;
-      m_updateKeeper->setBorderRect(&clientDim.getRect());
-      updCont.changedRegion.crop(&clientDim.getRect());
+      m_updateKeeper->setBorderRect(&lastViewPortDim.getRect());
+      updCont.changedRegion.crop(&lastViewPortDim.getRect());
       // Dazzle changedRegion
-      updCont.changedRegion.addRect(&clientDim.getRect());
+      updCont.changedRegion.addRect(&lastViewPortDim.getRect());
     } else {
       m_updateKeeper->setBorderRect(&lastViewPortDim.getRect());
       updCont.changedRegion.crop(&lastViewPortDim.getRect());
@@ -395,18 +464,23 @@ void UpdateSender::sendUpdate()
     m_log->debug(_T("Screen size changed or full region requested"));
     if (encodeOptions.desktopSizeEnabled()) {
       m_log->debug(_T("Desktop resize is enabled, sending NewFBSize %dx%d"),
-                 lastViewPortDim.width, lastViewPortDim.height);
-      sendNewFBSize(&lastViewPortDim);
+                 clientDim.width, clientDim.height);
+      sendNewFBSize(&clientDim);
+      numSentRects = 1;
       // FIXME: "Dazzle" does not seem like a good word here.
       m_log->debug(_T("Dazzle changed region"));
       m_updateKeeper->dazzleChangedReg();
     } else {
       m_log->debug(_T("Desktop resize is disabled, sending blank screen"));
-      sendFbInClientDim(&encodeOptions, frameBuffer, &clientDim,
-                        &frameBuffer->getPixelFormat());
+      numSentRects = sendFbInClientDim(&encodeOptions, frameBuffer, &clientDim,
+                                       &frameBuffer->getPixelFormat());
       m_log->debug(_T("Dazzle changed region"));
       m_updateKeeper->dazzleChangedReg();
     }
+    // Everything will be sent again, so forget about lossy areas.
+    Region lossyRegion;
+    m_enbox.extractLossyRegion(&lossyRegion);
+    m_refinement.reset();
   } else {
     m_log->debug(_T("Processing normal updates"));
     CursorShape cursorShape;
@@ -419,7 +493,10 @@ void UpdateSender::sendUpdate()
                            frameBuffer,
                            &cursorShape);
 
-    if (!encodeOptions.copyRectEnabled() || getVideoFrozen()) {
+    // CopyRect is not used for the scaled desktop, since the scaled pixels
+    // at the destination depend on the pixels around it.
+    if (!encodeOptions.copyRectEnabled() || getVideoFrozen() ||
+        m_scale != FULL_SCALE) {
       m_log->debug(_T("CopyRect is disabled, converting to normal updates"));
       updCont.changedRegion.add(&updCont.copiedRegion);
       updCont.copiedRegion.clear();
@@ -469,6 +546,17 @@ void UpdateSender::sendUpdate()
       paintBlack(frameBuffer, &blackRegion);
     }
 
+    // If the client gets the desktop scaled, encode the scaled frame buffer
+    // and map the regions to its coordinates.
+    Region requestedRegion = requestedIncrReg;
+    requestedRegion.add(&requestedFullReg);
+    FrameBuffer *encodedFrameBuffer = frameBuffer;
+    if (m_scale != FULL_SCALE) {
+      scaleFrameBuffer(frameBuffer, &clientDim, &changedRegion, &videoRegion);
+      scaleRegion(frameBuffer, &requestedRegion, false);
+      encodedFrameBuffer = &m_scaledFrameBuffer;
+    }
+
     //
     // At this point, we've got final regions in changedRegion and videoRegion.
     //
@@ -478,7 +566,7 @@ void UpdateSender::sendUpdate()
                changedRegion.getCount());
     std::vector<Rect> normalRects;
     splitRegion(m_enbox.getEncoder(), &changedRegion, &normalRects,
-                frameBuffer, &encodeOptions);
+                encodedFrameBuffer, &encodeOptions);
 
     // Do the same for the videoRegion.
     std::vector<Rect> videoRects;
@@ -486,19 +574,36 @@ void UpdateSender::sendUpdate()
       m_log->debug(_T("Video region is not empty"));
       m_enbox.validateJpegEncoder(); // make sure JpegEncoder is allocated
       splitRegion(m_enbox.getJpegEncoder(), &videoRegion, &videoRects,
-                  frameBuffer, &encodeOptions);
+                  encodedFrameBuffer, &encodeOptions);
     }
 
     // Get the final list of CopyRect rectangles.
     std::vector<Rect> copyRects;
     updCont.copiedRegion.getRectVector(&copyRects);
 
+    // If there is nothing else to send, use the idle time to resend a part
+    // of the areas previously sent with lossy compression.
+    EncodeOptions losslessOptions = encodeOptions;
+    losslessOptions.disableJpeg();
+    std::vector<Rect> refinementRects;
+    if (normalRects.empty() && videoRects.empty() && copyRects.empty() &&
+        !updCont.cursorPosChanged && !updCont.cursorShapeChanged) {
+      Region refinementRegion;
+      if (m_refinement.getNextBatch(&requestedRegion, &refinementRegion)) {
+        splitRegion(m_enbox.getEncoder(), &refinementRegion, &refinementRects,
+                    encodedFrameBuffer, &losslessOptions);
+      }
+    }
+
     // Calculate the total number of rectangles and pseudo-rectangles.
     m_log->debug(_T("Number of normal rectangles: %d"), normalRects.size());
     m_log->debug(_T("Number of video rectangles: %d"), videoRects.size());
     m_log->debug(_T("Number of CopyRect rectangles: %d"), copyRects.size());
+    m_log->debug(_T("Number of refinement rectangles: %d"),
+                 refinementRects.size());
     size_t numTotalRects =
-      normalRects.size() + videoRects.size() + copyRects.size();
+      normalRects.size() + videoRects.size() + copyRects.size() +
+      refinementRects.size();
 
     if (updCont.cursorPosChanged) {
       numTotalRects++;
@@ -520,6 +625,7 @@ void UpdateSender::sendUpdate()
       m_output->writeUInt8(0); // message type
       m_output->writeUInt8(0); // padding
       m_output->writeUInt16((UINT16)numTotalRects);
+      numSentRects = numTotalRects;
 
       if (updCont.cursorPosChanged) {
         m_log->debug(_T("Sending cursor position update"));
@@ -538,9 +644,27 @@ void UpdateSender::sendUpdate()
       m_log->debug(_T("Time between request and a point before send and coding (in milliseconds): %u"),
                  (unsigned int)(DateTime::now() - reqTimePoint).getTime());
       m_log->debug(_T("Sending video rectangles"));
-      sendRectangles(m_enbox.getJpegEncoder(), &videoRects, frameBuffer, &encodeOptions);
+      sendRectangles(m_enbox.getJpegEncoder(), &videoRects, encodedFrameBuffer,
+                     &encodeOptions);
       m_log->debug(_T("Sending normal rectangles"));
-      sendRectangles(m_enbox.getEncoder(), &normalRects, frameBuffer, &encodeOptions);
+      sendRectangles(m_enbox.getEncoder(), &normalRects, encodedFrameBuffer,
+                     &encodeOptions);
+      if (!refinementRects.empty()) {
+        UINT64 bytesBefore = m_output->getBytesWritten();
+        sendRectangles(m_enbox.getEncoder(), &refinementRects,
+                       encodedFrameBuffer, &losslessOptions);
+        m_refinement.addRefinementBytes(m_output->getBytesWritten() -
+                                        bytesBefore);
+        m_statistics.numRefinementRects += refinementRects.size();
+      }
+
+      // Remember which areas the client got with lossy compression.
+      Region sentRegion = changedRegion;
+      sentRegion.add(&videoRegion);
+      Region lossyRegion;
+      m_enbox.extractLossyRegion(&lossyRegion);
+      m_refinement.onCopyRect(&updCont.copiedRegion, &updCont.copySrc);
+      m_refinement.onUpdateSent(&sentRegion, &lossyRegion);
       m_log->debug(_T("Time between request and answer is (in milliseconds): %u"),
                  (unsigned int)(DateTime::now() - reqTimePoint).getTime());
     } else {
@@ -556,7 +680,86 @@ void UpdateSender::sendUpdate()
   }
 
   m_log->debug(_T("Flushing output"));
-  m_output->flush();
+  UINT64 flushStartTime = PreciseTimer::getMicroseconds();
+  {
+    TRACE_SPAN(flushSpan, "UpdateSender::flush");
+    m_output->flush();
+  }
+  UINT64 flushEndTime = PreciseTimer::getMicroseconds();
+
+  updateSpan.setArgs(numSentRects,
+                     m_output->getBytesWritten() - bytesBeforeUpdate);
+  if (numSentRects != 0) {
+    m_statistics.pendingLossyArea = m_refinement.getPendingArea();
+    m_statistics.refinementBytes = m_refinement.getRefinementBytes();
+    m_statistics.addUpdate(numSentRects,
+                           m_output->getBytesWritten() - bytesBeforeUpdate,
+                           flushEndTime - requestTime,
+                           flushEndTime - flushStartTime);
+    AutoLock al(&m_statisticsLock);
+    m_publishedStatistics = m_statistics;
+  }
+}
+
+void UpdateSender::scaleFrameBuffer(const FrameBuffer *frameBuffer,
+                                    const Dimension *clientDim,
+                                    Region *changedRegion,
+                                    Region *videoRegion)
+{
+  TRACE_SPAN(span, "UpdateSender::scaleFrameBuffer");
+  PixelFormat pf = frameBuffer->getPixelFormat();
+  Rect srcRect = frameBuffer->getDimension().getRect();
+  Rect dstRect = clientDim->getRect();
+  // The area filter gives the most readable picture when scaling down.
+  bool geometryChanged = m_scaler.setGeometry(FrameBufferScaler::FILTER_AREA,
+                                              &srcRect, &dstRect, &pf);
+  bool isWholeScaled = false;
+  if (geometryChanged || m_scaledFrameBuffer.getDimension() != *clientDim) {
+    // Nothing of the previous scaled picture can be reused.
+    m_scaledFrameBuffer.setProperties(clientDim, &pf);
+    Rect dstChanged;
+    m_scaler.scale(frameBuffer, &srcRect, &m_scaledFrameBuffer, &dstChanged);
+    isWholeScaled = true;
+  }
+  scaleRegion(frameBuffer, videoRegion, !isWholeScaled);
+  scaleRegion(frameBuffer, changedRegion, !isWholeScaled);
+  // A scaled pixel may depend on both regions, send it once.
+  changedRegion->subtract(videoRegion);
+}
+
+void UpdateSender::scaleRegion(const FrameBuffer *frameBuffer, Region *region,
+                               bool scalePixels)
+{
+  std::vector<Rect> rects;
+  region->getRectVector(&rects);
+  region->clear();
+  for (size_t i = 0; i < rects.size(); i++) {
+    Rect dstChanged;
+    if (scalePixels) {
+      m_scaler.scale(frameBuffer, &rects[i], &m_scaledFrameBuffer,
+                     &dstChanged);
+    } else {
+      m_scaler.getDependentRect(&rects[i], &dstChanged);
+    }
+    region->addRect(&dstChanged);
+  }
+}
+
+Dimension UpdateSender::getScaledDimension(const Dimension *viewPortDim,
+                                           int scale)
+{
+  // Round up so that no pixel of the view port is lost.
+  return Dimension((viewPortDim->width * scale + FULL_SCALE - 1) / FULL_SCALE,
+                   (viewPortDim->height * scale + FULL_SCALE - 1) /
+                   FULL_SCALE);
+}
+
+Rect UpdateSender::unscaleRect(const Rect *rect, int scale)
+{
+  return Rect(rect->left * FULL_SCALE / scale,
+              rect->top * FULL_SCALE / scale,
+              (rect->right * FULL_SCALE + scale - 1) / scale,
+              (rect->bottom * FULL_SCALE + scale - 1) / scale);
 }
 
 void UpdateSender::paintBlack(FrameBuffer *frameBuffer, const Region *blackRegion)
@@ -587,10 +790,31 @@ void UpdateSender::sendRectangles(Encoder *encoder,
                                   const FrameBuffer *frameBuffer,
                                   const EncodeOptions *encodeOptions)
 {
-  std::vector<Rect>::const_iterator i;
-  for (i = rects->begin(); i != rects->end(); i++) {
-    sendRectHeader(&*i, encoder->getCode());
-    encoder->sendRectangle(&*i, frameBuffer, encodeOptions);
+  // Note that the encoder may be not allocated if there is nothing to send
+  // (e.g. JpegEncoder when there is no video).
+  if (!rects->empty()) {
+    TRACE_SPAN_ARGS(encodeSpan, "Encoder::sendRectangles", "rects", "bytes");
+    UINT64 bytesBefore = m_output->getBytesWritten();
+    UINT64 startTime = PreciseTimer::getMicroseconds();
+    encoder->sendRectangles(rects, frameBuffer, encodeOptions);
+    UINT64 encodeTime = PreciseTimer::getMicroseconds() - startTime;
+    encodeSpan.setArgs(rects->size(),
+                       m_output->getBytesWritten() - bytesBefore);
+
+    UINT64 numPixels = 0;
+    std::vector<Rect>::const_iterator i;
+    for (i = rects->begin(); i != rects->end(); i++) {
+      numPixels += i->area();
+    }
+    UpdateStatistics::RectType type;
+    if (encoder == m_enbox.getJpegEncoder()) {
+      type = UpdateStatistics::JPEG_RECT;
+    } else {
+      type = UpdateStatistics::getRectType(encoder->getCode());
+    }
+    m_statistics.addRectangles(type, rects->size(), numPixels,
+                               m_output->getBytesWritten() - bytesBefore,
+                               encodeTime);
   }
 }
 
@@ -599,7 +823,16 @@ void UpdateSender::execute()
   m_log->info(_T("Starting update sender thread for client #%d"), m_id);
 
   while(!isTerminating()) {
-    m_newUpdatesEvent.waitForEvent();
+    // If the client waits for an update, wake up when it's time to refine
+    // lossy areas even if there are no new updates.
+    DWORD timeout = INFINITE;
+    {
+      AutoLock al(&m_reqRectLocMut);
+      if (m_incrUpdIsReq || m_fullUpdIsReq) {
+        timeout = m_refinement.getWaitTime();
+      }
+    }
+    m_newUpdatesEvent.waitForEvent(timeout);
     m_busy = true;
     m_log->debug(_T("Update sender thread of client #%d is awake"), m_id);
     if (!isTerminating()) {
@@ -627,6 +860,16 @@ void UpdateSender::readUpdateRequest(RfbInputGate *io)
   reqRect.setWidth(io->readUInt16());
   reqRect.setHeight(io->readUInt16());
 
+  // The client requests the desktop in its own coordinates.
+  int scale;
+  {
+    AutoLock al(&m_viewPortMut);
+    scale = m_scale;
+  }
+  if (scale != FULL_SCALE) {
+    reqRect = unscaleRect(&reqRect, scale);
+  }
+
   Region combinedReqRegions;
   {
     AutoLock al(&m_reqRectLocMut);
@@ -638,6 +881,7 @@ void UpdateSender::readUpdateRequest(RfbInputGate *io)
       m_fullUpdIsReq = true;
     }
     m_requestTimePoint = DateTime::now();
+    m_requestTime = PreciseTimer::getMicroseconds();
     combinedReqRegions.add(&m_requestedIncrReg);
     combinedReqRegions.add(&m_requestedFullReg);
   }
@@ -651,7 +895,8 @@ void UpdateSender::readUpdateRequest(RfbInputGate *io)
   _ASSERT(m_updReqListener != 0);
 
   bool alreadyHasUpdates = m_updateKeeper->checkForUpdates(&combinedReqRegions);
-  if (alreadyHasUpdates) {
+  // Lossy areas waiting for refinement may have to be sent as well.
+  if (alreadyHasUpdates || m_refinement.hasPendingRegion()) {
     // We should initiaite send update to avoid it skipping on no updates from a desktop
     // FIXME: Code duplication, see the newUpdates() function.
     m_newUpdatesEvent.notify();
@@ -746,11 +991,29 @@ void UpdateSender::readVideoFreeze(RfbInputGate *io)
   setVideoFrozen(io->readUInt8() != 0);
 }
 
+void UpdateSender::readSetScale(RfbInputGate *io)
+{
+  io->readUInt8(); // padding
+  int scale = io->readUInt16();
+  if (scale < 1 || scale > FULL_SCALE) {
+    throw Exception(_T("Scale must be from 1 to 100 percent"));
+  }
+  m_log->detail(_T("Scale %d%% requested by client #%d"), scale, m_id);
+  {
+    AutoLock al(&m_viewPortMut);
+    m_newScale = scale;
+  }
+  // The new scale takes effect on sending next update, do not wait for
+  // changes on the desktop.
+  m_newUpdatesEvent.notify();
+}
+
 bool UpdateSender::extractReqRegions(Region *incrReqReg,
                                      Region *fullReqReg,
                                      bool *incrUpdIsReq,
                                      bool *fullUpdIsReq,
-                                     DateTime *reqTimePoint)
+                                     DateTime *reqTimePoint,
+                                     UINT64 *requestTime)
 {
   AutoLock al(&m_reqRectLocMut);
 
@@ -765,12 +1028,14 @@ bool UpdateSender::extractReqRegions(Region *incrReqReg,
   m_fullUpdIsReq = false;
 
   *reqTimePoint = m_requestTimePoint;
+  *requestTime = m_requestTime;
 
   return *incrUpdIsReq || *fullUpdIsReq;
 }
 
 void UpdateSender::extractUpdates(UpdateContainer *updCont)
 {
+  TRACE_SPAN(span, "UpdateSender::extractUpdates");
   m_updateKeeper->extract(updCont);
 }
 
@@ -834,6 +1099,12 @@ void UpdateSender::selectEncoder(EncodeOptions *encodeOptions)
   // Make sure the encoder object corresponds to the preferred encoding
   // requested in the most recent SetEncodings client message.
   m_enbox.selectEncoder(encodeOptions->getPreferredEncoding());
+
+  // Server-side encoder settings may be changed at any time as well.
+  ServerConfig *srvConf = Configurator::getInstance()->getServerConfig();
+  m_enbox.setTightParallelMode(srvConf->isParallelTightCompressionEnabled());
+  m_enbox.setJpegThreadCount((int)srvConf->getJpegEncoderThreadCount());
+  m_refinement.setDelay(srvConf->getLosslessRefinementDelay());
 }
 
 void UpdateSender::updateFrameBuffer(UpdateContainer *updCont,
@@ -30,6 +30,7 @@
 #include "desktop/UpdateKeeper.h"
 #include "UpdateRequestListener.h"
 #include "rfb/FrameBuffer.h"
+#include "rfb/FrameBufferScaler.h"
 #include "ViewPort.h"
 #include "network/RfbOutputGate.h"
 #include "network/RfbInputGate.h"
@@ -40,6 +41,8 @@
 #include "rfb-sconn/RfbCodeRegistrator.h"
 #include "util/DateTime.h"
 #include "CursorUpdates.h"
+#include "RefinementScheduler.h"
+#include "UpdateStatistics.h"
 #include "SenderControlInformationInterface.h"
 
 class UpdateSender : public Thread, public RfbDispatcherListener
@@ -78,6 +81,15 @@ public:
   // Return true if the client is ready, false otherwise.
   bool clientIsReady();
 
+  // Returns a snapshot of the performance counters of this connection.
+  // This function may be called from any thread.
+  void getStatistics(UpdateStatistics *statistics);
+
+  // Maps a pointer position received from the client to the view port
+  // coordinates if the client gets the desktop scaled down.
+  // This function may be called from any thread.
+  void unscalePointerPos(UINT16 *x, UINT16 *y);
+
 protected:
   // Listener function which implements RfbDispatcherListener. It will be
   // called on receiving client messages if we registered as a handler for
@@ -89,6 +101,7 @@ protected:
   void readSetPixelFormat(RfbInputGate *io);
   void readSetEncodings(RfbInputGate *io);
   void readVideoFreeze(RfbInputGate *io);
+  void readSetScale(RfbInputGate *io);
 
   // The addUpdateContainer() function adds all updates from the first
   // updateContainer parameter to the own UpdateContainer object.
@@ -119,7 +132,8 @@ protected:
                          Region *fullReqReg,
                          bool *incrUpdIsReq,
                          bool *fullUpdIsReq,
-                         DateTime *reqTimePoint);
+                         DateTime *reqTimePoint,
+                         UINT64 *requestTime);
   void extractUpdates(UpdateContainer *updCont);
   void cropUpdContForReqRegions(UpdateContainer *updCont,
                                 const Region *incrReqReg,
@@ -138,6 +152,24 @@ protected:
   bool updateViewPort(Rect *outNewViewPort, bool *shareApp, Region *prevShareAppRegion,
                       Region *newShareAppRegion);
 
+  // Scales the parts of the frame buffer covered by the changed and video
+  // regions to m_scaledFrameBuffer and maps the regions to the coordinates
+  // of the client.
+  void scaleFrameBuffer(const FrameBuffer *frameBuffer,
+                        const Dimension *clientDim,
+                        Region *changedRegion, Region *videoRegion);
+  // Maps the region to the coordinates of the client, scaling the pixels
+  // if scalePixels is true.
+  void scaleRegion(const FrameBuffer *frameBuffer, Region *region,
+                   bool scalePixels);
+  // Returns the dimension of the view port as the client gets it at the
+  // scale.
+  static Dimension getScaledDimension(const Dimension *viewPortDim,
+                                      int scale);
+  // Maps the rectangle in the coordinates of the client to the view port
+  // coordinates.
+  static Rect unscaleRect(const Rect *rect, int scale);
+
   // The sendPalette() function sends pallete after a set color map request
   // by a client.
   void sendPalette(PixelFormat *pf);
@@ -151,7 +183,8 @@ protected:
   void sendRectHeader(UINT16 x, UINT16 y, UINT16 w, UINT16 h,
                       INT32 encodingType);
   void sendNewFBSize(Dimension *dim);
-  void sendFbInClientDim(const EncodeOptions *encodeOptions,
+  // Returns the number of rectangles sent.
+  size_t sendFbInClientDim(const EncodeOptions *encodeOptions,
                          const FrameBuffer *fb,
                          const Dimension *dim,
                          const PixelFormat *pf);
@@ -191,6 +224,8 @@ protected:
   bool m_busy;
   // Property for perfomance measurements. It uses with the regions mutex.
   DateTime m_requestTimePoint;
+  // The same in microseconds, for the statistics.
+  UINT64 m_requestTime;
   LocalMutex m_reqRectLocMut;
 
   SenderControlInformationInterface *m_senderControlInformation;
@@ -198,6 +233,10 @@ protected:
   Rect m_viewPort;
   Dimension m_clientDim;
   Dimension m_lastViewPortDim;
+  // Scale in percent requested by the client and the scale of the updates
+  // being sent to it now. The latter is changed only by the sender thread.
+  int m_newScale;
+  int m_scale;
   bool m_shareOnlyApp;
   Region m_appRegion;
   Region m_prevAppRegion;
@@ -208,6 +247,13 @@ protected:
   FrameBuffer m_frameBuffer;
   Desktop *m_desktop;
 
+  // Frame buffer scaled to the client dimension when m_scale is less than
+  // FULL_SCALE. Updates are encoded from it instead of m_frameBuffer. Both
+  // objects are used only by the sender thread.
+  FrameBuffer m_scaledFrameBuffer;
+  FrameBufferScaler m_scaler;
+  static const int FULL_SCALE = 100;
+
   CursorUpdates m_cursorUpdates;
 
   // EncodeOptions class maintain the configuration of encoders and
@@ -253,6 +299,18 @@ protected:
   // should be used only by the sender thread.
   EncoderStore m_enbox;
 
+  // Keeps track of areas sent with lossy compression and schedules their
+  // lossless refinement.
+  RefinementScheduler m_refinement;
+
+  // Performance counters. m_statistics is updated by the sender thread
+  // only, so it needs no locking; m_publishedStatistics is its copy made
+  // after each update for other threads.
+  UpdateStatistics m_statistics;
+  UpdateStatistics m_publishedStatistics;
+  UINT64 m_statisticsStartTime;
+  LocalMutex m_statisticsLock;
+
   // Information
   // FIXME: Document this properly.
   int m_id;
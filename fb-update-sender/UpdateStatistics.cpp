@@ -0,0 +1,201 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "UpdateStatistics.h"
+
+#include "rfb/EncodingDefs.h"
+
+UpdateStatistics::UpdateStatistics()
+: duration(0),
+  numUpdates(0),
+  numRects(0),
+  numBytes(0),
+  pendingLossyArea(0),
+  numRefinementRects(0),
+  refinementBytes(0)
+{
+  memset(encodings, 0, sizeof(encodings));
+}
+
+UpdateStatistics::RectType UpdateStatistics::getRectType(int encoding)
+{
+  switch (encoding) {
+  case EncodingDefs::RRE:
+    return RRE_RECT;
+  case EncodingDefs::HEXTILE:
+    return HEXTILE_RECT;
+  case EncodingDefs::ZRLE:
+    return ZRLE_RECT;
+  case EncodingDefs::TIGHT:
+    return TIGHT_RECT;
+  case EncodingDefs::COPYRECT:
+    return COPY_RECT;
+  default:
+    return RAW_RECT;
+  }
+}
+
+const TCHAR *UpdateStatistics::getRectTypeName(int rectType)
+{
+  switch (rectType) {
+  case RAW_RECT:
+    return _T("Raw");
+  case RRE_RECT:
+    return _T("RRE");
+  case HEXTILE_RECT:
+    return _T("Hextile");
+  case ZRLE_RECT:
+    return _T("ZRLE");
+  case TIGHT_RECT:
+    return _T("Tight");
+  case JPEG_RECT:
+    return _T("JPEG");
+  case COPY_RECT:
+    return _T("CopyRect");
+  default:
+    return _T("Unknown");
+  }
+}
+
+void UpdateStatistics::addRectangles(RectType type, size_t rects,
+                                     UINT64 pixels, UINT64 bytes,
+                                     UINT64 encodeTime)
+{
+  EncodingStatistics *stats = &encodings[type];
+  stats->numRects += rects;
+  stats->numPixels += pixels;
+  stats->numBytes += bytes;
+  stats->encodeTime += encodeTime;
+}
+
+void UpdateStatistics::addUpdate(size_t rects, UINT64 bytes,
+                                 UINT64 requestLatency, UINT64 flushDuration)
+{
+  numUpdates++;
+  numRects += rects;
+  numBytes += bytes;
+  updateRects.add(rects);
+  updateBytes.add(bytes);
+  latency.add(requestLatency);
+  flushTime.add(flushDuration);
+}
+
+double UpdateStatistics::getUpdatesPerSecond() const
+{
+  if (duration == 0) {
+    return 0.0;
+  }
+  return (double)numUpdates * 1000000.0 / (double)duration;
+}
+
+double UpdateStatistics::getBytesPerSecond() const
+{
+  if (duration == 0) {
+    return 0.0;
+  }
+  return (double)numBytes * 1000000.0 / (double)duration;
+}
+
+void UpdateStatistics::serialize(DataOutputStream *output) const
+{
+  output->writeUInt64(duration);
+  output->writeUInt64(numUpdates);
+  output->writeUInt64(numRects);
+  output->writeUInt64(numBytes);
+
+  output->writeUInt32(NUM_RECT_TYPES);
+  for (int i = 0; i < NUM_RECT_TYPES; i++) {
+    output->writeUInt64(encodings[i].numRects);
+    output->writeUInt64(encodings[i].numPixels);
+    output->writeUInt64(encodings[i].numBytes);
+    output->writeUInt64(encodings[i].encodeTime);
+  }
+
+  serializeHistogram(&updateBytes, output);
+  serializeHistogram(&updateRects, output);
+  serializeHistogram(&latency, output);
+  serializeHistogram(&flushTime, output);
+
+  output->writeUInt64(pendingLossyArea);
+  output->writeUInt64(numRefinementRects);
+  output->writeUInt64(refinementBytes);
+}
+
+void UpdateStatistics::deserialize(DataInputStream *input)
+{
+  duration = input->readUInt64();
+  numUpdates = input->readUInt64();
+  numRects = input->readUInt64();
+  numBytes = input->readUInt64();
+
+  // Rectangle types unknown to this side are skipped.
+  memset(encodings, 0, sizeof(encodings));
+  UINT32 numTypes = input->readUInt32();
+  for (UINT32 i = 0; i < numTypes; i++) {
+    EncodingStatistics stats;
+    stats.numRects = input->readUInt64();
+    stats.numPixels = input->readUInt64();
+    stats.numBytes = input->readUInt64();
+    stats.encodeTime = input->readUInt64();
+    if (i < NUM_RECT_TYPES) {
+      encodings[i] = stats;
+    }
+  }
+
+  deserializeHistogram(&updateBytes, input);
+  deserializeHistogram(&updateRects, input);
+  deserializeHistogram(&latency, input);
+  deserializeHistogram(&flushTime, input);
+
+  pendingLossyArea = input->readUInt64();
+  numRefinementRects = input->readUInt64();
+  refinementBytes = input->readUInt64();
+}
+
+void UpdateStatistics::serializeHistogram(const Histogram *histogram,
+                                          DataOutputStream *output)
+{
+  output->writeUInt64(histogram->getSum());
+  output->writeUInt64(histogram->getMax());
+  output->writeUInt32(Histogram::NUM_BUCKETS);
+  for (int i = 0; i < Histogram::NUM_BUCKETS; i++) {
+    output->writeUInt64(histogram->getBucketCount(i));
+  }
+}
+
+void UpdateStatistics::deserializeHistogram(Histogram *histogram,
+                                            DataInputStream *input)
+{
+  UINT64 sum = input->readUInt64();
+  UINT64 maxValue = input->readUInt64();
+  UINT64 buckets[Histogram::NUM_BUCKETS];
+  memset(buckets, 0, sizeof(buckets));
+  UINT32 numBuckets = input->readUInt32();
+  for (UINT32 i = 0; i < numBuckets; i++) {
+    UINT64 count = input->readUInt64();
+    // Values beyond our range go to the last bucket.
+    buckets[min(i, (UINT32)Histogram::NUM_BUCKETS - 1)] += count;
+  }
+  histogram->set(buckets, sum, maxValue);
+}
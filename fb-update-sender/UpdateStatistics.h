@@ -0,0 +1,111 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __UPDATESTATISTICS_H__
+#define __UPDATESTATISTICS_H__
+
+#include "util/Histogram.h"
+#include "io-lib/DataInputStream.h"
+#include "io-lib/DataOutputStream.h"
+
+// Performance counters of framebuffer updates sent to one client. The
+// sender thread accumulates them in its own copy without locking and
+// publishes a snapshot after each update; the snapshot can be passed to
+// the control client via serialize() and deserialize().
+//
+// Times are in microseconds.
+class UpdateStatistics
+{
+public:
+  // Kinds of rectangles the encoding statistics are collected for.
+  enum RectType
+  {
+    RAW_RECT,
+    RRE_RECT,
+    HEXTILE_RECT,
+    ZRLE_RECT,
+    TIGHT_RECT,
+    // Video rectangles sent by JpegEncoder.
+    JPEG_RECT,
+    COPY_RECT,
+    NUM_RECT_TYPES
+  };
+
+  struct EncodingStatistics
+  {
+    UINT64 numRects;
+    UINT64 numPixels;
+    UINT64 numBytes;
+    UINT64 encodeTime;
+  };
+
+  UpdateStatistics();
+
+  // Maps an RFB encoding code to the rectangle type.
+  static RectType getRectType(int encoding);
+  static const TCHAR *getRectTypeName(int rectType);
+
+  void addRectangles(RectType type, size_t rects, UINT64 pixels,
+                     UINT64 bytes, UINT64 encodeTime);
+  // The request latency is the time from the update request to the end of
+  // flushing the update.
+  void addUpdate(size_t rects, UINT64 bytes, UINT64 requestLatency,
+                 UINT64 flushDuration);
+
+  // Average rates since the start of the collection.
+  double getUpdatesPerSecond() const;
+  double getBytesPerSecond() const;
+
+  void serialize(DataOutputStream *output) const throw(IOException);
+  void deserialize(DataInputStream *input) throw(IOException);
+
+  // Time since the collection start.
+  UINT64 duration;
+
+  UINT64 numUpdates;
+  UINT64 numRects;
+  UINT64 numBytes;
+
+  EncodingStatistics encodings[NUM_RECT_TYPES];
+
+  // Lossless refinement of the areas sent with lossy compression: the area
+  // still waiting for it (at the last update) and what has been sent.
+  UINT64 pendingLossyArea;
+  UINT64 numRefinementRects;
+  UINT64 refinementBytes;
+
+  // Distributions of per-update values.
+  Histogram updateBytes;
+  Histogram updateRects;
+  Histogram latency;
+  Histogram flushTime;
+
+private:
+  static void serializeHistogram(const Histogram *histogram,
+                                 DataOutputStream *output);
+  static void deserializeHistogram(Histogram *histogram,
+                                   DataInputStream *input);
+};
+
+#endif // __UPDATESTATISTICS_H__
@@ -0,0 +1,59 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "BufferedInputStream.h"
+#include "util/CommonHeader.h"
+
+BufferedInputStream::BufferedInputStream(InputStream *input)
+: m_input(input),
+  m_dataOffset(0),
+  m_dataLength(0)
+{
+}
+
+BufferedInputStream::~BufferedInputStream()
+{
+}
+
+size_t BufferedInputStream::read(void *buffer, size_t len)
+{
+  if (m_dataLength == 0) {
+    if (len >= sizeof(m_buffer)) {
+      return m_input->read(buffer, len);
+    }
+    m_dataLength = m_input->read(m_buffer, sizeof(m_buffer));
+    m_dataOffset = 0;
+  }
+
+  size_t toCopy = min(len, m_dataLength);
+  memcpy(buffer, &m_buffer[m_dataOffset], toCopy);
+  m_dataOffset += toCopy;
+  m_dataLength -= toCopy;
+
+  return toCopy;
+}
+
+size_t BufferedInputStream::available() const
+{
+  return m_dataLength;
+}
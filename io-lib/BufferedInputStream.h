@@ -0,0 +1,70 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef _BUFFERED_INPUT_STREAM_H_
+#define _BUFFERED_INPUT_STREAM_H_
+
+#include "InputStream.h"
+
+/**
+ * Buffered input stream class (decorator pattern).
+ * Adds read-ahead bufferization feature to input stream, so many small
+ * reads cost a single read from real input stream.
+ * @remark real input stream must return data that is already available
+ * instead of waiting until all requested data arrives.
+ */
+class BufferedInputStream : public InputStream
+{
+public:
+  /**
+   * Creates new buffered input stream.
+   * @param input real input stream.
+   */
+  BufferedInputStream(InputStream *input);
+  virtual ~BufferedInputStream();
+
+  /**
+   * Reads data from inner buffer. If inner buffer is empty, then it's
+   * refilled by one read from real input stream. Big reads go directly
+   * to real input stream.
+   * @throw IOException on error.
+   * @fixme really it can throw any kind of exception.
+   */
+  virtual size_t read(void *buffer, size_t len) throw(IOException);
+
+  /**
+   * Returns count of bytes that can be read without accessing real
+   * input stream.
+   */
+  size_t available() const;
+
+protected:
+  InputStream *m_input;
+
+  char m_buffer[4096];
+
+  size_t m_dataOffset;
+  size_t m_dataLength;
+};
+
+#endif
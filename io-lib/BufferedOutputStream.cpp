@@ -25,7 +25,8 @@
 #include "BufferedOutputStream.h"
 
 BufferedOutputStream::BufferedOutputStream(OutputStream *output)
-: m_dataLength(0)
+: m_dataLength(0),
+  m_totalWritten(0)
 {
   m_output = new DataOutputStream(output);
 }
@@ -42,6 +43,8 @@ BufferedOutputStream::~BufferedOutputStream()
 
 size_t BufferedOutputStream::write(const void *buffer, size_t len)
 {
+  m_totalWritten += len;
+
   if (m_dataLength + len >= sizeof(m_buffer)) {
     flush();
 
@@ -57,7 +60,15 @@ size_t BufferedOutputStream::write(const void *buffer, size_t len)
 
 void BufferedOutputStream::flush()
 {
-  m_output->writeFully(&m_buffer[0], m_dataLength);
-
+  // The buffer is emptied before the writing so that the data of a failed
+  // write is never written again.
+  size_t dataLength = m_dataLength;
   m_dataLength = 0;
+
+  m_output->writeFully(&m_buffer[0], dataLength);
+}
+
+UINT64 BufferedOutputStream::getTotalWritten() const
+{
+  return m_totalWritten;
 }
@@ -59,12 +59,19 @@ public:
    */
   void flush() throw(IOException);
 
+  /**
+   * Returns total count of bytes passed to write() since object creation.
+   */
+  UINT64 getTotalWritten() const;
+
 protected:
   DataOutputStream *m_output;
 
   char m_buffer[1400];
 
   size_t m_dataLength;
+
+  UINT64 m_totalWritten;
 };
 
 #endif
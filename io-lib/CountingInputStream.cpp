@@ -0,0 +1,52 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "CountingInputStream.h"
+
+CountingInputStream::CountingInputStream(InputStream *input)
+: m_input(input),
+  m_bytesRead(0)
+{
+}
+
+CountingInputStream::~CountingInputStream()
+{
+}
+
+void CountingInputStream::setInput(InputStream *input)
+{
+  m_input = input;
+}
+
+size_t CountingInputStream::read(void *buffer, size_t len)
+{
+  size_t result = m_input->read(buffer, len);
+  m_bytesRead += result;
+  return result;
+}
+
+UINT64 CountingInputStream::getBytesRead() const
+{
+  return m_bytesRead;
+}
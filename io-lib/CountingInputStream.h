@@ -0,0 +1,67 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef _COUNTING_INPUT_STREAM_H_
+#define _COUNTING_INPUT_STREAM_H_
+
+#include "InputStream.h"
+
+/**
+ * Counting input stream class (decorator pattern).
+ * Passes reads to real input stream and counts bytes read.
+ * @remark the counter is not synchronized, it should be read by the thread
+ * which reads the stream.
+ */
+class CountingInputStream : public InputStream
+{
+public:
+  /**
+   * Creates new counting input stream.
+   * @param input real input stream, it may be set later by setInput().
+   */
+  CountingInputStream(InputStream *input = 0);
+  virtual ~CountingInputStream();
+
+  /**
+   * Sets real input stream.
+   */
+  void setInput(InputStream *input);
+
+  /**
+   * Reads data from real input stream.
+   * @throw IOException on error.
+   */
+  virtual size_t read(void *buffer, size_t len) throw(IOException);
+
+  /**
+   * Returns total count of bytes read from the stream.
+   */
+  UINT64 getBytesRead() const;
+
+protected:
+  InputStream *m_input;
+  UINT64 m_bytesRead;
+};
+
+#endif
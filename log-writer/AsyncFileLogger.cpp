@@ -0,0 +1,409 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "AsyncFileLogger.h"
+
+#include <malloc.h>
+#include <vector>
+
+AsyncFileLogger::AsyncFileLogger(const TCHAR *logDir, const TCHAR *fileName,
+                                 unsigned char logLevel, bool logHeadEnabled,
+                                 OverflowPolicy overflowPolicy)
+: FileLogger(logDir, fileName, logLevel, logHeadEnabled),
+  m_queuedCount(0),
+  m_droppedCount(0),
+  m_overflowPolicy(overflowPolicy),
+  m_isLazyFormattingEnabled(true)
+{
+  InitializeSListHead(&m_queue);
+  resume();
+}
+
+AsyncFileLogger::AsyncFileLogger(bool logHeadEnabled,
+                                 OverflowPolicy overflowPolicy)
+: FileLogger(logHeadEnabled),
+  m_queuedCount(0),
+  m_droppedCount(0),
+  m_overflowPolicy(overflowPolicy),
+  m_isLazyFormattingEnabled(true)
+{
+  InitializeSListHead(&m_queue);
+  resume();
+}
+
+AsyncFileLogger::~AsyncFileLogger()
+{
+  terminate();
+  wait();
+  // Lines that were printed after the thread had exited.
+  writeQueuedLines();
+}
+
+void AsyncFileLogger::print(int logLevel, const TCHAR *line)
+{
+  size_t numChars = _tcslen(line) + 1;
+  LogRecord *record = allocateRecord(logLevel, 0, numChars);
+  if (record == 0) {
+    return;
+  }
+  memcpy(getText(record), line, numChars * sizeof(TCHAR));
+  queueRecord(record);
+}
+
+bool AsyncFileLogger::printFormat(int logLevel, const TCHAR *fmt,
+                                  va_list argList)
+{
+  if (!m_isLazyFormattingEnabled) {
+    return false;
+  }
+
+  // Find the types of the arguments before taking any of them.
+  PackedArg args[MAX_PACKED_ARGS];
+  size_t numArgs = 0;
+  for (const TCHAR *p = fmt; *p != 0; p++) {
+    if (*p != _T('%')) {
+      continue;
+    }
+    if (p[1] == _T('%')) {
+      p++;
+      continue;
+    }
+    if (numArgs == MAX_PACKED_ARGS) {
+      return false;
+    }
+    size_t length = parseConversion(p, &args[numArgs].type);
+    if (length == 0) {
+      return false;
+    }
+    numArgs++;
+    p += length - 1;
+  }
+
+  size_t formatLength = _tcslen(fmt) + 1;
+  size_t numChars = formatLength;
+  size_t stringLengths[MAX_PACKED_ARGS];
+  for (size_t i = 0; i < numArgs; i++) {
+    switch (args[i].type) {
+    case ARG_INT:
+      args[i].intValue = va_arg(argList, int);
+      break;
+    case ARG_INT64:
+      args[i].int64Value = va_arg(argList, INT64);
+      break;
+    case ARG_SIZE:
+      args[i].sizeValue = va_arg(argList, size_t);
+      break;
+    case ARG_POINTER:
+      args[i].pointerValue = va_arg(argList, const void *);
+      break;
+    case ARG_DOUBLE:
+      args[i].doubleValue = va_arg(argList, double);
+      break;
+    case ARG_STRING:
+      args[i].stringValue = va_arg(argList, const TCHAR *);
+      stringLengths[i] = 0;
+      if (args[i].stringValue != 0) {
+        stringLengths[i] = _tcslen(args[i].stringValue) + 1;
+        numChars += stringLengths[i];
+      }
+      break;
+    }
+  }
+
+  LogRecord *record = allocateRecord(logLevel, numArgs, numChars);
+  if (record == 0) {
+    return true;
+  }
+  record->isFormat = true;
+  TCHAR *text = getText(record);
+  memcpy(text, fmt, formatLength * sizeof(TCHAR));
+  TCHAR *strings = text + formatLength;
+  for (size_t i = 0; i < numArgs; i++) {
+    record->args[i] = args[i];
+    if (args[i].type == ARG_STRING && args[i].stringValue != 0) {
+      memcpy(strings, args[i].stringValue, stringLengths[i] * sizeof(TCHAR));
+      record->args[i].stringValue = strings;
+      strings += stringLengths[i];
+    }
+  }
+  queueRecord(record);
+  return true;
+}
+
+void AsyncFileLogger::enableLazyFormatting(bool enabled)
+{
+  m_isLazyFormattingEnabled = enabled;
+}
+
+AsyncFileLogger::LogRecord *
+AsyncFileLogger::allocateRecord(int logLevel, size_t numArgs, size_t numChars)
+{
+  if (!reserveQueuePlace(logLevel)) {
+    return 0;
+  }
+
+  // The record has a place for one argument anyway.
+  size_t numExtraArgs = numArgs > 1 ? numArgs - 1 : 0;
+  size_t size = sizeof(LogRecord) + numExtraArgs * sizeof(PackedArg) +
+                numChars * sizeof(TCHAR);
+  LogRecord *record =
+    (LogRecord *)_aligned_malloc(size, MEMORY_ALLOCATION_ALIGNMENT);
+  if (record == 0) {
+    InterlockedDecrement(&m_queuedCount);
+    InterlockedIncrement(&m_droppedCount);
+    return 0;
+  }
+  record->threadId = GetCurrentThreadId();
+  record->level = logLevel;
+  record->time = DateTime::now().getTime();
+  record->isFormat = false;
+  record->numArgs = numArgs;
+  return record;
+}
+
+void AsyncFileLogger::queueRecord(LogRecord *record)
+{
+  // Wake up the writing thread only when the queue was empty, it will take
+  // the following lines with the same batch.
+  if (InterlockedPushEntrySList(&m_queue, &record->entry) == 0) {
+    m_linesQueued.notify();
+  }
+}
+
+TCHAR *AsyncFileLogger::getText(LogRecord *record)
+{
+  return (TCHAR *)(record->args + (record->numArgs > 1 ? record->numArgs : 1));
+}
+
+size_t AsyncFileLogger::parseConversion(const TCHAR *spec, ArgType *type)
+{
+  const TCHAR *p = spec + 1;
+  // Flags, width and precision. The '*' width or precision would take one
+  // more argument, it's not supported.
+  while (*p != 0 && _tcschr(_T("-+ #0"), *p) != 0) {
+    p++;
+  }
+  while (*p >= _T('0') && *p <= _T('9')) {
+    p++;
+  }
+  if (*p == _T('.')) {
+    p++;
+    while (*p >= _T('0') && *p <= _T('9')) {
+      p++;
+    }
+  }
+
+  // Size prefix.
+  bool is64 = false;
+  bool isSize = false;
+  bool hasOtherSize = false;
+  if (_tcsncmp(p, _T("I64"), 3) == 0 || _tcsncmp(p, _T("ll"), 2) == 0) {
+    is64 = true;
+    p += *p == _T('I') ? 3 : 2;
+  } else if (_tcsncmp(p, _T("I32"), 3) == 0) {
+    p += 3;
+  } else if (*p == _T('I')) {
+    isSize = true;
+    p++;
+  } else if (*p != 0 && _tcschr(_T("hlwL"), *p) != 0) {
+    hasOtherSize = true;
+    p++;
+  }
+
+  switch (*p) {
+  case _T('d'):
+  case _T('i'):
+  case _T('o'):
+  case _T('u'):
+  case _T('x'):
+  case _T('X'):
+    *type = is64 ? ARG_INT64 : (isSize ? ARG_SIZE : ARG_INT);
+    break;
+  case _T('c'):
+    if (is64 || isSize) {
+      return 0;
+    }
+    *type = ARG_INT;
+    break;
+  case _T('e'):
+  case _T('E'):
+  case _T('f'):
+  case _T('g'):
+  case _T('G'):
+  case _T('a'):
+  case _T('A'):
+    if (is64 || isSize) {
+      return 0;
+    }
+    *type = ARG_DOUBLE;
+    break;
+  case _T('p'):
+    if (is64 || isSize || hasOtherSize) {
+      return 0;
+    }
+    *type = ARG_POINTER;
+    break;
+  case _T('s'):
+    // Only the strings of TCHAR are supported.
+    if (is64 || isSize || hasOtherSize) {
+      return 0;
+    }
+    *type = ARG_STRING;
+    break;
+  default:
+    return 0;
+  }
+  size_t length = p + 1 - spec;
+  return length <= MAX_CONVERSION_LENGTH ? length : 0;
+}
+
+void AsyncFileLogger::formatRecord(LogRecord *record,
+                                   std::vector<TCHAR> *line)
+{
+  line->clear();
+  const TCHAR *p = getText(record);
+  size_t argIndex = 0;
+  TCHAR conversion[MAX_CONVERSION_LENGTH + 1];
+  StringStorage formatted;
+  while (*p != 0) {
+    if (*p != _T('%')) {
+      line->push_back(*p++);
+      continue;
+    }
+    if (p[1] == _T('%')) {
+      line->push_back(_T('%'));
+      p += 2;
+      continue;
+    }
+    // printFormat() has checked the format already.
+    ArgType type;
+    size_t length = parseConversion(p, &type);
+    _ASSERT(length != 0 && argIndex < record->numArgs);
+    memcpy(conversion, p, length * sizeof(TCHAR));
+    conversion[length] = 0;
+    p += length;
+
+    const PackedArg *arg = &record->args[argIndex++];
+    switch (arg->type) {
+    case ARG_INT:
+      formatted.format(conversion, arg->intValue);
+      break;
+    case ARG_INT64:
+      formatted.format(conversion, arg->int64Value);
+      break;
+    case ARG_SIZE:
+      formatted.format(conversion, arg->sizeValue);
+      break;
+    case ARG_POINTER:
+      formatted.format(conversion, arg->pointerValue);
+      break;
+    case ARG_DOUBLE:
+      formatted.format(conversion, arg->doubleValue);
+      break;
+    case ARG_STRING:
+      formatted.format(conversion, arg->stringValue);
+      break;
+    }
+    const TCHAR *text = formatted.getString();
+    line->insert(line->end(), text, text + formatted.getLength());
+  }
+  line->push_back(0);
+}
+
+bool AsyncFileLogger::reserveQueuePlace(int logLevel)
+{
+  while (InterlockedIncrement(&m_queuedCount) > MAX_QUEUED_LINES) {
+    if (m_overflowPolicy == DROP_VERBOSE_LINES) {
+      if (logLevel <= MAX_UNDROPPABLE_LEVEL) {
+        return true;
+      }
+      InterlockedDecrement(&m_queuedCount);
+      InterlockedIncrement(&m_droppedCount);
+      return false;
+    }
+    InterlockedDecrement(&m_queuedCount);
+    m_linesQueued.notify();
+    m_queueEmptied.waitForEvent(WRITE_INTERVAL);
+  }
+  return true;
+}
+
+void AsyncFileLogger::execute()
+{
+  while (!isTerminating()) {
+    m_linesQueued.waitForEvent(WRITE_INTERVAL);
+    writeQueuedLines();
+  }
+}
+
+void AsyncFileLogger::onTerminate()
+{
+  m_linesQueued.notify();
+}
+
+void AsyncFileLogger::writeQueuedLines()
+{
+  PSLIST_ENTRY entry = InterlockedFlushSList(&m_queue);
+  if (entry == 0) {
+    return;
+  }
+
+  // The queue is a stack, restore the order of the lines.
+  std::vector<LogRecord *> records;
+  for (; entry != 0; entry = entry->Next) {
+    records.push_back((LogRecord *)entry);
+  }
+
+  unsigned int processId = GetCurrentProcessId();
+  try {
+    LONG droppedCount = InterlockedExchange(&m_droppedCount, 0);
+    if (droppedCount != 0) {
+      StringStorage message;
+      message.format(_T("%d log lines have been dropped because of the")
+                     _T(" log queue overflow"), (int)droppedCount);
+      DateTime now = DateTime::now();
+      m_fileAccount.printToBuffer(processId, GetCurrentThreadId(), &now,
+                                  2, message.getString());
+    }
+    std::vector<TCHAR> line;
+    for (size_t i = records.size(); i > 0; i--) {
+      LogRecord *record = records[i - 1];
+      DateTime time(record->time);
+      const TCHAR *text = getText(record);
+      if (record->isFormat) {
+        formatRecord(record, &line);
+        text = &line.front();
+      }
+      m_fileAccount.printToBuffer(processId, record->threadId, &time,
+                                  record->level, text);
+    }
+    m_fileAccount.writeBuffer();
+  } catch (...) {
+  }
+
+  for (size_t i = 0; i < records.size(); i++) {
+    _aligned_free(records[i]);
+  }
+  InterlockedExchangeAdd(&m_queuedCount, -(LONG)records.size());
+  m_queueEmptied.notify();
+}
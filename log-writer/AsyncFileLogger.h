@@ -0,0 +1,176 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef __ASYNCFILELOGGER_H__
+#define __ASYNCFILELOGGER_H__
+
+#include "FileLogger.h"
+#include "thread/Thread.h"
+#include "win-system/WindowsEvent.h"
+
+#include <vector>
+
+// This class is a FileLogger that does not write to the file in the caller
+// thread. The print() function only copies the line to a record with the
+// caller thread id and time and pushes it to a lock-free queue; a separate
+// thread adds the line prefixes and writes the queued lines in batches.
+//
+// Messages logged via LogWriter are not even formatted in the caller
+// thread: printFormat() copies the format string and packs the arguments
+// into the record (strings are copied, as they may be freed by the caller
+// right after the call), and the writing thread formats them. Formats with
+// conversions which can't be packed (see parseConversion()) are formatted
+// by LogWriter as usual.
+//
+// Lines that are still queued when the process crashes are lost, so
+// synchronous FileLogger remains the choice where that matters more than
+// the caller latency.
+class AsyncFileLogger : public FileLogger, private Thread
+{
+public:
+  // What to do when the queue has MAX_QUEUED_LINES lines.
+  enum OverflowPolicy
+  {
+    // Drop the lines of the info and more detailed levels, queue the more
+    // important ones anyway. The number of dropped lines is logged.
+    DROP_VERBOSE_LINES,
+    // Wait in the caller thread until the queue has a free place.
+    BLOCK_CALLER
+  };
+
+  static const LONG MAX_QUEUED_LINES = 16384;
+
+  AsyncFileLogger(const TCHAR *logDir, const TCHAR *fileName,
+                  unsigned char logLevel, bool logHeadEnabled,
+                  OverflowPolicy overflowPolicy = DROP_VERBOSE_LINES);
+
+  // Postponed initialization, see FileLogger.
+  AsyncFileLogger(bool logHeadEnabled,
+                  OverflowPolicy overflowPolicy = DROP_VERBOSE_LINES);
+
+  // Writes the queued lines and stops the writing thread.
+  virtual ~AsyncFileLogger();
+
+  // Queues a log line.
+  virtual void print(int logLevel, const TCHAR *line);
+
+  // Queues the format and the packed arguments of a log line if the format
+  // allows that.
+  virtual bool printFormat(int logLevel, const TCHAR *fmt, va_list argList);
+
+  // Enable or disable packing of the arguments by printFormat(). It's
+  // enabled by default; disabling it makes LogWriter format the lines in
+  // the caller thread, which is useful only to measure the difference.
+  void enableLazyFormatting(bool enabled);
+
+private:
+  enum ArgType
+  {
+    ARG_INT,
+    ARG_INT64,
+    ARG_SIZE,
+    ARG_POINTER,
+    ARG_DOUBLE,
+    ARG_STRING
+  };
+
+  struct PackedArg
+  {
+    ArgType type;
+    union
+    {
+      int intValue;
+      INT64 int64Value;
+      size_t sizeValue;
+      const void *pointerValue;
+      double doubleValue;
+      // Points to a copy of the string in the record.
+      const TCHAR *stringValue;
+    };
+  };
+
+  struct LogRecord
+  {
+    // Must be the first member (see InterlockedPushEntrySList()).
+    SLIST_ENTRY entry;
+    UINT32 threadId;
+    int level;
+    UINT64 time;
+    // If true, the text is a format string for the arguments, otherwise it
+    // is a formatted line.
+    bool isFormat;
+    size_t numArgs;
+    // The record is allocated to fit all the arguments, followed by the
+    // text and the copies of the string arguments.
+    PackedArg args[1];
+  };
+
+  virtual void execute();
+  virtual void onTerminate();
+
+  // Allocates a record for numArgs arguments and numChars characters of
+  // text, fills in its header. Returns 0 if the line must be dropped.
+  LogRecord *allocateRecord(int logLevel, size_t numArgs, size_t numChars);
+  // Pushes the record to the queue.
+  void queueRecord(LogRecord *record);
+  static TCHAR *getText(LogRecord *record);
+
+  // Parses the conversion specification at the start of spec (which starts
+  // with '%', but is not "%%"). Returns its length and the type of its
+  // argument, or zero if the conversion is not supported for packing.
+  static size_t parseConversion(const TCHAR *spec, ArgType *type);
+
+  // Formats the line of a record made by printFormat().
+  static void formatRecord(LogRecord *record, std::vector<TCHAR> *line);
+
+  // Writes all queued lines to the file.
+  void writeQueuedLines();
+
+  // Waits for a free place in the queue if needed. Returns false if the
+  // line must be dropped.
+  bool reserveQueuePlace(int logLevel);
+
+  // Interval of writing the queued lines in milliseconds.
+  static const DWORD WRITE_INTERVAL = 100;
+
+  // Levels of the lines that are never dropped.
+  static const int MAX_UNDROPPABLE_LEVEL = 3;
+
+  // Limits of the formats printFormat() packs.
+  static const size_t MAX_PACKED_ARGS = 16;
+  static const size_t MAX_CONVERSION_LENGTH = 31;
+
+  SLIST_HEADER m_queue;
+  volatile LONG m_queuedCount;
+  volatile LONG m_droppedCount;
+
+  OverflowPolicy m_overflowPolicy;
+  volatile bool m_isLazyFormattingEnabled;
+
+  // Signaled when the queue gets the first line.
+  WindowsEvent m_linesQueued;
+  // Signaled when the writing thread has emptied the queue.
+  WindowsEvent m_queueEmptied;
+};
+
+#endif // __ASYNCFILELOGGER_H__
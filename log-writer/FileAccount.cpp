@@ -91,9 +91,41 @@ void FileAccount::print(unsigned int processId,
 {
   AutoLock al(&m_logMut);
 
+  printToBuffer(processId, threadId, dt, level, message);
+  writeBuffer();
+}
+
+void FileAccount::printToBuffer(unsigned int processId,
+                                unsigned int threadId,
+                                const DateTime *dt,
+                                int level,
+                                const TCHAR *message)
+{
+  AutoLock al(&m_logMut);
+
   updateLogHeaderLines(processId, threadId, dt, level, message);
   updateLogDumpLines(processId, threadId, dt, level, message);
   flush(processId, threadId, dt, level, message);
+  if (m_buffer.size() >= MAX_BUFFER_SIZE) {
+    writeBuffer();
+  }
+}
+
+void FileAccount::writeBuffer()
+{
+  AutoLock al(&m_logMut);
+
+  if (m_file != 0 && !m_buffer.empty()) {
+    // Drop the lines on a write error as well, so that a failing file does
+    // not make the buffer grow.
+    try {
+      m_file->write(&m_buffer.front(), m_buffer.size());
+    } catch (...) {
+      m_buffer.clear();
+      throw;
+    }
+  }
+  m_buffer.clear();
 }
 
 bool FileAccount::acceptsLevel(int logLevel)
@@ -138,12 +170,8 @@ void FileAccount::format(unsigned int processId,
   StringStorage timeString(_T("[Temporary unavaliable]"));
   SYSTEMTIME st;
   dt->toUtcSystemTime(&st);
-  unsigned char logBarrier;
-  {
-    AutoLock al(&m_logMut);
-    logBarrier = m_level;
-  }
-  if (logBarrier < 9) {
+  // The caller holds m_logMut.
+  if (m_level < 9) {
     timeString.format(_T("%.4d-%.2d-%.2d %.2d:%.2d:%.2d"),
                       st.wYear, st.wMonth, st.wDay,
                       st.wHour, st.wMinute, st.wSecond);
@@ -170,10 +198,13 @@ void FileAccount::format(unsigned int processId,
 
   const TCHAR endLine[] = { 13, 10 };
 
-  // Writing string without null-termination symbol.
+  // Buffering string without null-termination symbol.
   if (m_file != 0) {
-    m_file->write(resultLine.getString(), resultLine.getSize() - sizeof(TCHAR));
-    m_file->write(endLine, sizeof(endLine));
+    const char *line = (const char *)resultLine.getString();
+    m_buffer.insert(m_buffer.end(), line,
+                    line + resultLine.getSize() - sizeof(TCHAR));
+    m_buffer.insert(m_buffer.end(), (const char *)endLine,
+                    (const char *)endLine + sizeof(endLine));
   }
 }
 
@@ -263,6 +294,7 @@ void FileAccount::openFile()
       } else {
         writeLogHeader();
       }
+      writeBuffer();
     } catch (...) {
       closeFile();
     }
@@ -272,6 +304,10 @@ void FileAccount::openFile()
 void FileAccount::closeFile()
 {
   if (m_file != 0) {
+    try {
+      writeBuffer();
+    } catch (...) {
+    }
     delete m_file;
     m_file = 0;
   }
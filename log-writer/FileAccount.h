@@ -31,6 +31,8 @@
 #include "file-lib/WinFile.h"
 #include "LogDump.h"
 
+#include <vector>
+
 class FileAccount : public LogDump
 {
 public:
@@ -89,6 +91,18 @@ public:
                      int level,
                      const TCHAR *message);
 
+  // The same as print() but the formatted line can stay in memory until
+  // the writeBuffer() call or until the buffer gets full. Used to write
+  // a batch of lines with a few file writes.
+  void printToBuffer(unsigned int processId,
+                     unsigned int threadId,
+                     const DateTime *dt,
+                     int level,
+                     const TCHAR *message);
+
+  // Writes the buffered lines to the file.
+  void writeBuffer();
+
   virtual bool acceptsLevel(int logLevel);
 
 protected:
@@ -120,7 +134,7 @@ private:
   // Creates backup files
   void createBackup(unsigned int backupLimit);
 
-  // Formates the message and stores it to the file.
+  // Formates the message and stores it to the write buffer.
   void format(unsigned int processId,
               unsigned int threadId,
               const DateTime *dt,
@@ -140,6 +154,10 @@ private:
   bool m_asFirstOpen;
   WinFile *m_file;
 
+  // Formatted lines that are not written to the file yet.
+  std::vector<char> m_buffer;
+  static const size_t MAX_BUFFER_SIZE = 64 * 1024;
+
   LocalMutex m_logMut;
 };
 
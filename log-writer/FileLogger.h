@@ -73,7 +73,7 @@ public:
 
   virtual bool acceptsLevel(int logLevel);
 
-private:
+protected:
   FileAccount m_fileAccount;
 };
 
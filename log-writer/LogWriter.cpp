@@ -118,6 +118,9 @@ void LogWriter::debug(const TCHAR *fmt, ...)
 void LogWriter::vprintLog(int logLevel, const TCHAR *fmt, va_list argList)
 {
   if (m_logger != 0) {
+    if (m_logger->printFormat(logLevel, fmt, argList)) {
+      return;
+    }
     // Format the original string.
     int count = _vsctprintf(fmt, argList);
     std::vector<TCHAR> formattedString(count + 1);
@@ -27,6 +27,8 @@
 
 #include "util/CharDefs.h"
 
+#include <stdarg.h>
+
 //
 // The Logger class defines abstract low-level interface for logging
 // (recording various types of events in software components or applications).
@@ -64,6 +66,20 @@ public:
   //
   virtual void print(int logLevel, const TCHAR *line) = 0;
 
+  //
+  // LogWriter calls this function before formatting a message. A Logger
+  // implementation may override it to take the format string and the
+  // arguments as they are, and format the line later (e.g. in another
+  // thread). If it returns false, LogWriter formats the line and passes it
+  // to print(), so the arguments must not be taken in that case.
+  //
+  // The default implementation returns false.
+  //
+  virtual bool printFormat(int logLevel, const TCHAR *fmt, va_list argList)
+  {
+    return false;
+  }
+
   //
   // Implementations of this abstract function should return true if they ready
   // to process a message with this logLevel. That is you can test messages for
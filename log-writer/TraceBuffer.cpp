@@ -0,0 +1,83 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "TraceBuffer.h"
+
+TraceBuffer::TraceBuffer(DWORD threadId, size_t capacity)
+: m_threadId(threadId),
+  m_writeCount(0),
+  m_isFull(false)
+{
+  size_t size = 2;
+  while (size < capacity) {
+    size <<= 1;
+  }
+  m_events.resize(size);
+  m_mask = (UINT32)size - 1;
+}
+
+TraceBuffer::~TraceBuffer()
+{
+}
+
+void TraceBuffer::add(const TraceEvent *event)
+{
+  UINT32 count = (UINT32)m_writeCount;
+  m_events[count & m_mask] = *event;
+  if ((count & m_mask) == m_mask) {
+    m_isFull = true;
+  }
+  // Publish the event only after it has been written completely.
+  InterlockedExchange(&m_writeCount, (LONG)(count + 1));
+}
+
+void TraceBuffer::getEvents(UINT64 since,
+                            std::vector<TraceEvent> *events) const
+{
+  UINT32 capacity = m_mask + 1;
+  UINT32 endCount = (UINT32)m_writeCount;
+  UINT32 available = m_isFull ? capacity : endCount;
+
+  std::vector<TraceEvent> copy(available);
+  UINT32 firstCount = endCount - available;
+  for (UINT32 i = 0; i < available; i++) {
+    copy[i] = m_events[(firstCount + i) & m_mask];
+  }
+
+  // The writer could overwrite the oldest events during the copying, the
+  // slot of the next event may be half-written as well.
+  UINT32 firstValidCount = (UINT32)m_writeCount + 1 - capacity;
+  INT32 overwritten = (INT32)(firstValidCount - firstCount);
+  UINT32 skip = overwritten > 0 ? min((UINT32)overwritten, available) : 0;
+
+  for (UINT32 i = skip; i < available; i++) {
+    if (copy[i].end >= since) {
+      events->push_back(copy[i]);
+    }
+  }
+}
+
+DWORD TraceBuffer::getThreadId() const
+{
+  return m_threadId;
+}
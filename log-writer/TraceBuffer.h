@@ -0,0 +1,83 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef __TRACEBUFFER_H__
+#define __TRACEBUFFER_H__
+
+#include "util/CommonHeader.h"
+
+#include <vector>
+
+// Static description of a traced code span. Instances are created by the
+// TRACE_SPAN macros and live for the whole process lifetime, so events keep
+// only a pointer to them.
+struct TracePoint
+{
+  const char *name;
+  // Names of the span arguments or zero if an argument is not used.
+  const char *arg0Name;
+  const char *arg1Name;
+};
+
+// One finished span, times are in nanoseconds of PreciseTimer.
+struct TraceEvent
+{
+  const TracePoint *point;
+  UINT64 start;
+  UINT64 end;
+  UINT64 arg0;
+  UINT64 arg1;
+};
+
+// Ring of the last events of one thread. Only the owner thread adds events,
+// and it never waits for readers; any thread can take a copy of the ring at
+// any time. Events overwritten while they are being copied are dropped from
+// the copy.
+class TraceBuffer
+{
+public:
+  // The capacity is rounded up to a power of two.
+  TraceBuffer(DWORD threadId, size_t capacity);
+  virtual ~TraceBuffer();
+
+  // Must be called by the owner thread only.
+  void add(const TraceEvent *event);
+
+  // Appends events that ended at or after the since time to the events
+  // vector, from the oldest to the newest.
+  void getEvents(UINT64 since, std::vector<TraceEvent> *events) const;
+
+  DWORD getThreadId() const;
+
+private:
+  std::vector<TraceEvent> m_events;
+  UINT32 m_mask;
+  DWORD m_threadId;
+
+  // Total number of added events, modulo 2^32.
+  volatile LONG m_writeCount;
+  // Becomes true when the ring is filled for the first time.
+  volatile bool m_isFull;
+};
+
+#endif // __TRACEBUFFER_H__
@@ -0,0 +1,82 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "TraceExporter.h"
+
+#include "util/AnsiStringStorage.h"
+
+void TraceExporter::exportChromeJson(unsigned int seconds,
+                                     std::vector<char> *output)
+{
+  UINT64 now = PreciseTimer::getNanoseconds();
+  UINT64 period = (UINT64)seconds * 1000000000;
+  UINT64 since = now > period ? now - period : 0;
+
+  std::vector<TraceEvent> events;
+  std::vector<DWORD> threadIds;
+  Tracer::getEvents(since, &events, &threadIds);
+
+  DWORD processId = GetCurrentProcessId();
+  AnsiStringStorage line;
+
+  append(output, "{\"traceEvents\":[");
+  for (size_t i = 0; i < events.size(); i++) {
+    const TraceEvent *event = &events[i];
+    // The names are string literals of the source code, so they need no
+    // escaping.
+    line.format("%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%u,\"tid\":%u,"
+                "\"ts\":",
+                i == 0 ? "" : ",", event->point->name,
+                (unsigned int)processId, (unsigned int)threadIds[i]);
+    append(output, line.getString());
+    appendTime(output, event->start);
+    append(output, ",\"dur\":");
+    appendTime(output, event->end - event->start);
+
+    if (event->point->arg0Name != 0) {
+      line.format(",\"args\":{\"%s\":%I64u", event->point->arg0Name,
+                  event->arg0);
+      append(output, line.getString());
+      if (event->point->arg1Name != 0) {
+        line.format(",\"%s\":%I64u", event->point->arg1Name, event->arg1);
+        append(output, line.getString());
+      }
+      append(output, "}");
+    }
+    append(output, "}");
+  }
+  append(output, "\n],\"displayTimeUnit\":\"ns\"}\n");
+}
+
+void TraceExporter::append(std::vector<char> *output, const char *string)
+{
+  output->insert(output->end(), string, string + strlen(string));
+}
+
+void TraceExporter::appendTime(std::vector<char> *output, UINT64 nanoseconds)
+{
+  AnsiStringStorage time;
+  time.format("%I64u.%03u", nanoseconds / 1000,
+              (unsigned int)(nanoseconds % 1000));
+  append(output, time.getString());
+}
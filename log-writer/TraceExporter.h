@@ -0,0 +1,44 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef __TRACEEXPORTER_H__
+#define __TRACEEXPORTER_H__
+
+#include "Tracer.h"
+
+// Converts the events collected by Tracer to the Chrome trace event JSON
+// format that chrome://tracing and Perfetto can open.
+class TraceExporter
+{
+public:
+  // Stores the events of the last given number of seconds to the output
+  // vector as an UTF-8 JSON document.
+  static void exportChromeJson(unsigned int seconds, std::vector<char> *output);
+
+private:
+  static void append(std::vector<char> *output, const char *string);
+  // Writes nanoseconds as microseconds with the fractional part.
+  static void appendTime(std::vector<char> *output, UINT64 nanoseconds);
+};
+
+#endif // __TRACEEXPORTER_H__
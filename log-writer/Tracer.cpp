@@ -0,0 +1,117 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "Tracer.h"
+
+#include "thread/AutoLock.h"
+
+volatile LONG Tracer::s_isEnabled = 0;
+DWORD Tracer::s_tlsIndex = TlsAlloc();
+std::list<Tracer::ThreadBuffer> Tracer::s_buffers;
+LocalMutex Tracer::s_buffersLock;
+
+void Tracer::setEnabled(bool enabled)
+{
+  InterlockedExchange(&s_isEnabled, enabled ? 1 : 0);
+}
+
+void Tracer::addSpan(const TracePoint *point, UINT64 start, UINT64 end,
+                     UINT64 arg0, UINT64 arg1)
+{
+  if (s_tlsIndex == TLS_OUT_OF_INDEXES) {
+    return;
+  }
+  TraceBuffer *buffer = (TraceBuffer *)TlsGetValue(s_tlsIndex);
+  if (buffer == 0) {
+    buffer = createThreadBuffer();
+    if (buffer == 0) {
+      return;
+    }
+  }
+
+  TraceEvent event;
+  event.point = point;
+  event.start = start;
+  event.end = end;
+  event.arg0 = arg0;
+  event.arg1 = arg1;
+  buffer->add(&event);
+}
+
+void Tracer::getEvents(UINT64 since, std::vector<TraceEvent> *events,
+                       std::vector<DWORD> *threadIds)
+{
+  AutoLock al(&s_buffersLock);
+
+  for (std::list<ThreadBuffer>::iterator iter = s_buffers.begin();
+       iter != s_buffers.end(); iter++) {
+    iter->buffer->getEvents(since, events);
+    threadIds->resize(events->size(), iter->buffer->getThreadId());
+  }
+}
+
+TraceBuffer *Tracer::createThreadBuffer()
+{
+  ThreadBuffer threadBuffer;
+  if (!DuplicateHandle(GetCurrentProcess(), GetCurrentThread(),
+                       GetCurrentProcess(), &threadBuffer.thread,
+                       SYNCHRONIZE, FALSE, 0)) {
+    return 0;
+  }
+  threadBuffer.buffer = new TraceBuffer(GetCurrentThreadId(),
+                                        EVENTS_PER_THREAD);
+
+  {
+    AutoLock al(&s_buffersLock);
+    removeFinishedBuffers();
+    s_buffers.push_back(threadBuffer);
+  }
+
+  TlsSetValue(s_tlsIndex, threadBuffer.buffer);
+  return threadBuffer.buffer;
+}
+
+void Tracer::removeFinishedBuffers()
+{
+  size_t finishedCount = 0;
+  std::list<ThreadBuffer>::iterator iter;
+  for (iter = s_buffers.begin(); iter != s_buffers.end(); iter++) {
+    if (WaitForSingleObject(iter->thread, 0) == WAIT_OBJECT_0) {
+      finishedCount++;
+    }
+  }
+
+  // The list is ordered by the creation time, so the oldest buffers go
+  // first.
+  iter = s_buffers.begin();
+  while (finishedCount > MAX_FINISHED_THREADS && iter != s_buffers.end()) {
+    if (WaitForSingleObject(iter->thread, 0) == WAIT_OBJECT_0) {
+      CloseHandle(iter->thread);
+      delete iter->buffer;
+      iter = s_buffers.erase(iter);
+      finishedCount--;
+    } else {
+      iter++;
+    }
+  }
+}
@@ -0,0 +1,135 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef __TRACER_H__
+#define __TRACER_H__
+
+#include "TraceBuffer.h"
+#include "util/PreciseTimer.h"
+#include "thread/LocalMutex.h"
+
+#include <list>
+
+// Process-wide collector of trace spans. Every thread writes to its own
+// TraceBuffer that is created on the first event of the thread, so adding
+// an event takes no locks. Tracing is off until setEnabled(true) is called;
+// the TRACE_SPAN macros compile to nothing if TVN_NO_TRACE is defined.
+class Tracer
+{
+public:
+  // Number of events kept for each thread.
+  static const size_t EVENTS_PER_THREAD = 8192;
+  // Number of buffers of finished threads kept for the export.
+  static const size_t MAX_FINISHED_THREADS = 16;
+
+  static void setEnabled(bool enabled);
+  static bool isEnabled() { return s_isEnabled != 0; }
+
+  // Adds the span to the buffer of the calling thread.
+  static void addSpan(const TracePoint *point, UINT64 start, UINT64 end,
+                      UINT64 arg0, UINT64 arg1);
+
+  // Appends events of all threads that ended at or after the since time.
+  // The thread ids are stored in the threadIds vector, one per event.
+  static void getEvents(UINT64 since, std::vector<TraceEvent> *events,
+                        std::vector<DWORD> *threadIds);
+
+private:
+  struct ThreadBuffer
+  {
+    TraceBuffer *buffer;
+    // Handle of the owner thread to find out when it has finished.
+    HANDLE thread;
+  };
+
+  static TraceBuffer *createThreadBuffer();
+  // Deletes the oldest buffers of finished threads over the limit.
+  static void removeFinishedBuffers();
+
+  static volatile LONG s_isEnabled;
+  static DWORD s_tlsIndex;
+
+  static std::list<ThreadBuffer> s_buffers;
+  static LocalMutex s_buffersLock;
+};
+
+// Measures the time from its construction to its destruction and passes it
+// to Tracer if tracing was enabled at the construction time.
+class TraceSpan
+{
+public:
+  TraceSpan(const TracePoint *point)
+  : m_point(point),
+    m_start(0),
+    m_arg0(0),
+    m_arg1(0)
+  {
+    if (Tracer::isEnabled()) {
+      m_start = PreciseTimer::getNanoseconds();
+    }
+  }
+
+  ~TraceSpan()
+  {
+    if (m_start != 0) {
+      Tracer::addSpan(m_point, m_start, PreciseTimer::getNanoseconds(),
+                      m_arg0, m_arg1);
+    }
+  }
+
+  void setArgs(UINT64 arg0, UINT64 arg1 = 0)
+  {
+    m_arg0 = arg0;
+    m_arg1 = arg1;
+  }
+
+private:
+  const TracePoint *m_point;
+  UINT64 m_start;
+  UINT64 m_arg0;
+  UINT64 m_arg1;
+};
+
+// Stands for TraceSpan when tracing is compiled out.
+class NullTraceSpan
+{
+public:
+  void setArgs(UINT64 arg0, UINT64 arg1 = 0) {}
+};
+
+// Usage:
+//   TRACE_SPAN(span, "UpdateSender::sendUpdate");
+//   TRACE_SPAN_ARGS(span, "encode", "rects", "bytes");
+//   ...
+//   span.setArgs(numRects, numBytes);
+#ifndef TVN_NO_TRACE
+#define TRACE_SPAN_ARGS(var, name, arg0Name, arg1Name)                     \
+  static const TracePoint var##Point = { name, arg0Name, arg1Name };       \
+  TraceSpan var(&var##Point)
+#else
+#define TRACE_SPAN_ARGS(var, name, arg0Name, arg1Name) NullTraceSpan var
+#endif
+
+#define TRACE_SPAN(var, name) TRACE_SPAN_ARGS(var, name, 0, 0)
+
+#endif // __TRACER_H__
@@ -0,0 +1,57 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __LOOPBACKCHANNEL_H__
+#define __LOOPBACKCHANNEL_H__
+
+#include "io-lib/Channel.h"
+#include "LoopbackPipe.h"
+
+// One end of an in-process connection: reads from one pipe and writes to
+// another. The pipes are not owned by the channel, LoopbackConnection
+// creates channels in pairs.
+class LoopbackChannel : public Channel
+{
+public:
+  LoopbackChannel(LoopbackPipe *input, LoopbackPipe *output);
+  virtual ~LoopbackChannel();
+
+  //
+  // Inherited from Channel.
+  //
+
+  virtual size_t read(void *buffer, size_t len) throw(IOException);
+
+  virtual size_t write(const void *buffer, size_t len) throw(IOException);
+
+  // Closes both directions, so blocked operations on both ends of the
+  // connection are broken.
+  virtual void close();
+
+protected:
+  LoopbackPipe *m_input;
+  LoopbackPipe *m_output;
+};
+
+#endif // __LOOPBACKCHANNEL_H__
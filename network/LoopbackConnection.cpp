@@ -0,0 +1,53 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "LoopbackConnection.h"
+
+LoopbackConnection::LoopbackConnection(size_t capacity,
+                                       UINT64 bandwidth, UINT64 latency)
+: m_toClient(capacity, bandwidth, latency),
+  m_toServer(capacity, bandwidth, latency),
+  m_serverChannel(&m_toServer, &m_toClient),
+  m_clientChannel(&m_toClient, &m_toServer)
+{
+}
+
+LoopbackConnection::~LoopbackConnection()
+{
+}
+
+Channel *LoopbackConnection::getServerChannel()
+{
+  return &m_serverChannel;
+}
+
+Channel *LoopbackConnection::getClientChannel()
+{
+  return &m_clientChannel;
+}
+
+void LoopbackConnection::close()
+{
+  m_serverChannel.close();
+}
@@ -0,0 +1,61 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __LOOPBACKCONNECTION_H__
+#define __LOOPBACKCONNECTION_H__
+
+#include "LoopbackChannel.h"
+
+// A pair of connected channels for running a server and a client in the
+// same process without sockets, e.g. in benchmarks. Each end must be used
+// by one reading and one writing thread at a time.
+//
+// Both directions use the same capacity and link emulation parameters
+// (see LoopbackPipe).
+class LoopbackConnection
+{
+public:
+  static const size_t DEFAULT_CAPACITY = 1024 * 1024;
+
+  // Zero bandwidth (bytes per second) means unlimited, latency is the
+  // one-way delay in microseconds.
+  LoopbackConnection(size_t capacity = DEFAULT_CAPACITY,
+                     UINT64 bandwidth = 0, UINT64 latency = 0);
+  virtual ~LoopbackConnection();
+
+  // The channels remain owned by this object.
+  Channel *getServerChannel();
+  Channel *getClientChannel();
+
+  // Breaks the connection in both directions.
+  void close();
+
+private:
+  LoopbackPipe m_toClient;
+  LoopbackPipe m_toServer;
+  LoopbackChannel m_serverChannel;
+  LoopbackChannel m_clientChannel;
+};
+
+#endif // __LOOPBACKCONNECTION_H__
@@ -0,0 +1,175 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "LoopbackPipe.h"
+#include "util/PreciseTimer.h"
+
+LoopbackPipe::LoopbackPipe(size_t capacity, UINT64 bandwidth, UINT64 latency)
+: m_buffer(0),
+  m_capacity(1),
+  m_writePos(0),
+  m_readPos(0),
+  m_isShaped(bandwidth != 0 || latency != 0),
+  m_bandwidth(bandwidth),
+  m_latency(latency),
+  m_linkFreeTime(0),
+  m_marks(0),
+  m_writeMark(0),
+  m_readMark(0),
+  m_isClosed(0)
+{
+  if (capacity > (size_t)MAX_CAPACITY) {
+    throw IOException(_T("Loopback pipe capacity is too big."));
+  }
+  while ((size_t)m_capacity < capacity) {
+    m_capacity <<= 1;
+  }
+  m_buffer = new UINT8[m_capacity];
+  if (m_isShaped) {
+    m_marks = new DeliveryMark[NUM_MARKS];
+  }
+}
+
+LoopbackPipe::~LoopbackPipe()
+{
+  delete[] m_buffer;
+  delete[] m_marks;
+}
+
+size_t LoopbackPipe::write(const void *buffer, size_t len)
+{
+  if (len == 0) {
+    return 0;
+  }
+  size_t length = min(len, waitForSpace());
+
+  ULONG writePos = (ULONG)m_writePos;
+  size_t offset = writePos & (m_capacity - 1);
+  size_t firstPart = min(length, (size_t)m_capacity - offset);
+  memcpy(m_buffer + offset, buffer, firstPart);
+  memcpy(m_buffer, (const UINT8 *)buffer + firstPart, length - firstPart);
+  writePos += (ULONG)length;
+  InterlockedExchange(&m_writePos, (LONG)writePos);
+
+  if (m_isShaped) {
+    UINT64 now = PreciseTimer::getMicroseconds();
+    UINT64 startTime = max(now, m_linkFreeTime);
+    m_linkFreeTime = startTime;
+    if (m_bandwidth != 0) {
+      m_linkFreeTime += (UINT64)length * 1000000 / m_bandwidth;
+    }
+    ULONG writeMark = (ULONG)m_writeMark;
+    DeliveryMark *mark = &m_marks[writeMark % (ULONG)NUM_MARKS];
+    mark->position = (LONG)writePos;
+    mark->releaseTime = m_linkFreeTime + m_latency;
+    InterlockedExchange(&m_writeMark, (LONG)(writeMark + 1));
+  }
+
+  m_dataEvent.notify();
+  return length;
+}
+
+size_t LoopbackPipe::read(void *buffer, size_t len)
+{
+  if (len == 0) {
+    return 0;
+  }
+  size_t length = min(len, waitForData());
+
+  ULONG readPos = (ULONG)m_readPos;
+  size_t offset = readPos & (m_capacity - 1);
+  size_t firstPart = min(length, (size_t)m_capacity - offset);
+  memcpy(buffer, m_buffer + offset, firstPart);
+  memcpy((UINT8 *)buffer + firstPart, m_buffer, length - firstPart);
+  readPos += (ULONG)length;
+
+  if (m_isShaped) {
+    ULONG readMark = (ULONG)m_readMark;
+    if (m_marks[readMark % (ULONG)NUM_MARKS].position == (LONG)readPos) {
+      InterlockedExchange(&m_readMark, (LONG)(readMark + 1));
+    }
+  }
+  InterlockedExchange(&m_readPos, (LONG)readPos);
+
+  m_spaceEvent.notify();
+  return length;
+}
+
+void LoopbackPipe::close()
+{
+  InterlockedExchange(&m_isClosed, 1);
+  m_dataEvent.notify();
+  m_spaceEvent.notify();
+}
+
+size_t LoopbackPipe::waitForSpace()
+{
+  while (true) {
+    if (m_isClosed) {
+      throw IOException(_T("The loopback pipe is closed."));
+    }
+    size_t used = (ULONG)m_writePos - (ULONG)m_readPos;
+    ULONG usedMarks = (ULONG)m_writeMark - (ULONG)m_readMark;
+    bool hasFreeMark = !m_isShaped || usedMarks < (ULONG)NUM_MARKS;
+    if (used < (size_t)m_capacity && hasFreeMark) {
+      return m_capacity - used;
+    }
+    m_spaceEvent.waitForEvent();
+  }
+}
+
+size_t LoopbackPipe::waitForData()
+{
+  while (true) {
+    ULONG readPos = (ULONG)m_readPos;
+    DWORD timeout = INFINITE;
+    if (!m_isShaped) {
+      size_t available = (ULONG)m_writePos - readPos;
+      if (available != 0) {
+        return available;
+      }
+    } else {
+      ULONG readMark = (ULONG)m_readMark;
+      if (readMark != (ULONG)m_writeMark) {
+        const DeliveryMark *mark = &m_marks[readMark % (ULONG)NUM_MARKS];
+        UINT64 now = PreciseTimer::getMicroseconds();
+        if (now >= mark->releaseTime) {
+          return (ULONG)mark->position - readPos;
+        }
+        UINT64 delay = mark->releaseTime - now;
+        if (delay < 2000) {
+          // Waiting for an event is not precise enough for such short
+          // delays, so just give the rest of the time slice away.
+          Sleep(0);
+          continue;
+        }
+        timeout = (DWORD)(delay / 1000);
+      }
+    }
+    if (m_isClosed) {
+      throw IOException(_T("The loopback pipe is closed."));
+    }
+    m_dataEvent.waitForEvent(timeout);
+  }
+}
@@ -0,0 +1,108 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __LOOPBACKPIPE_H__
+#define __LOOPBACKPIPE_H__
+
+#include "util/CommonHeader.h"
+#include "win-system/WindowsEvent.h"
+#include "io-lib/IOException.h"
+
+// A one-way in-process byte pipe with one writer thread and one reader
+// thread. Data goes through a lock-free ring buffer: the writer only moves
+// the write position and the reader only moves the read position, so the
+// threads never wait for each other unless the buffer is full or empty.
+//
+// Optionally the pipe emulates a network link. Each written block becomes
+// readable after the time needed to transmit it at the given bandwidth
+// (blocks are transmitted one after another) plus the given latency. Data
+// which is "in flight" occupies the ring buffer, so the capacity works as
+// a send window and should exceed the bandwidth-delay product unless that
+// limitation is desired.
+class LoopbackPipe
+{
+public:
+  // The capacity is rounded up to a power of two. Zero bandwidth (bytes
+  // per second) means unlimited, latency is in microseconds.
+  LoopbackPipe(size_t capacity, UINT64 bandwidth = 0, UINT64 latency = 0);
+  virtual ~LoopbackPipe();
+
+  // Copies up to len bytes into the pipe, blocking while it is full.
+  // Returns the number of bytes written.
+  // @throw IOException if the pipe is closed.
+  size_t write(const void *buffer, size_t len) throw(IOException);
+
+  // Copies up to len bytes out of the pipe, blocking until some data is
+  // available. Returns the number of bytes read.
+  // @throw IOException if the pipe is closed and there is nothing to read.
+  size_t read(void *buffer, size_t len) throw(IOException);
+
+  // Wakes up blocked readers and writers and makes all subsequent write
+  // calls fail. This method may be called from any thread.
+  void close();
+
+private:
+  // Waits until the data can be written and returns the free space.
+  size_t waitForSpace() throw(IOException);
+  // Waits until the data can be read and returns its size.
+  size_t waitForData() throw(IOException);
+
+  // Position in the ring buffer after which the data is not readable yet
+  // and the time when it becomes readable.
+  struct DeliveryMark
+  {
+    LONG position;
+    UINT64 releaseTime;
+  };
+
+  static const LONG MAX_CAPACITY = 1 << 30;
+  static const LONG NUM_MARKS = 1024;
+
+  UINT8 *m_buffer;
+  LONG m_capacity;
+
+  // Positions only grow (wrapping around) and are stored with interlocked
+  // operations, so the other side sees the data before the position.
+  // Each position is modified by one thread only.
+  volatile LONG m_writePos;
+  volatile LONG m_readPos;
+
+  bool m_isShaped;
+  UINT64 m_bandwidth;
+  UINT64 m_latency;
+  // Time when the emulated link finishes transmitting the last block.
+  // Used by the writer only.
+  UINT64 m_linkFreeTime;
+  // Ring of delivery marks, another single-producer single-consumer queue.
+  DeliveryMark *m_marks;
+  volatile LONG m_writeMark;
+  volatile LONG m_readMark;
+
+  volatile LONG m_isClosed;
+
+  WindowsEvent m_dataEvent;
+  WindowsEvent m_spaceEvent;
+};
+
+#endif // __LOOPBACKPIPE_H__
@@ -0,0 +1,90 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "ReadAheadInputStream.h"
+#include "thread/AutoLock.h"
+
+#include <vector>
+
+ReadAheadInputStream::ReadAheadInputStream(size_t capacity)
+: m_source(0),
+  m_pipe(capacity)
+{
+}
+
+ReadAheadInputStream::~ReadAheadInputStream()
+{
+  terminate();
+  wait();
+}
+
+void ReadAheadInputStream::start(InputStream *source)
+{
+  m_source = source;
+  resume();
+}
+
+size_t ReadAheadInputStream::read(void *buffer, size_t len)
+{
+  try {
+    return m_pipe.read(buffer, len);
+  } catch (IOException &) {
+    // The pipe is closed, report the reason.
+    AutoLock al(&m_errorLock);
+    if (m_error.isEmpty()) {
+      throw IOException(_T("Reading ahead is stopped."));
+    }
+    throw IOException(m_error.getString());
+  }
+}
+
+void ReadAheadInputStream::execute()
+{
+  std::vector<char> buffer(READ_SIZE);
+  try {
+    while (!isTerminating()) {
+      size_t length = m_source->read(&buffer.front(), buffer.size());
+      if (length == 0) {
+        throw IOException(_T("Connection has been closed."));
+      }
+      for (size_t written = 0; written < length;) {
+        written += m_pipe.write(&buffer.front() + written, length - written);
+      }
+    }
+  } catch (Exception &e) {
+    AutoLock al(&m_errorLock);
+    // The pipe fails on termination only, then the reader doesn't need
+    // the reason.
+    if (m_error.isEmpty()) {
+      m_error.setString(e.getMessage());
+    }
+  }
+  // The reader gets the rest of the data and then the error.
+  m_pipe.close();
+}
+
+void ReadAheadInputStream::onTerminate()
+{
+  m_pipe.close();
+}
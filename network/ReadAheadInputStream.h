@@ -0,0 +1,73 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __READAHEADINPUTSTREAM_H__
+#define __READAHEADINPUTSTREAM_H__
+
+#include "io-lib/InputStream.h"
+#include "thread/Thread.h"
+#include "thread/LocalMutex.h"
+#include "util/StringStorage.h"
+#include "LoopbackPipe.h"
+
+// Input stream which reads another stream ahead of its reader, in its own
+// thread. The data goes through a pipe of bounded capacity, so a reader
+// which spends time on processing the data (e.g. on decoding) doesn't stop
+// receiving from the network while the pipe has free space.
+//
+// The stream has one reader thread.
+class ReadAheadInputStream : public InputStream, public Thread
+{
+public:
+  ReadAheadInputStream(size_t capacity);
+  // Stops the thread and waits for it, so reading from the source stream
+  // must be broken (e.g. by closing the connection) before.
+  virtual ~ReadAheadInputStream();
+
+  // Starts reading from the source stream. May be called only once.
+  void start(InputStream *source);
+
+  // Reads the data which has been read from the source stream, blocking
+  // until some data is available.
+  // @throw IOException if the source stream has failed or the thread is
+  // terminated and there is no more data.
+  virtual size_t read(void *buffer, size_t len) throw(IOException);
+
+protected:
+  virtual void execute();
+  // Wakes up the reader and the thread if they are waiting for the pipe.
+  virtual void onTerminate();
+
+private:
+  static const size_t READ_SIZE = 64 * 1024;
+
+  InputStream *m_source;
+  LoopbackPipe m_pipe;
+
+  // The error which has stopped reading from the source stream.
+  StringStorage m_error;
+  LocalMutex m_errorLock;
+};
+
+#endif // __READAHEADINPUTSTREAM_H__
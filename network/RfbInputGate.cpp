@@ -24,7 +24,7 @@
 
 #include "RfbInputGate.h"
 
-RfbInputGate::RfbInputGate(Channel *stream)
+RfbInputGate::RfbInputGate(InputStream *stream)
 : DataInputStream(stream)
 {
 }
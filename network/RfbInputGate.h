@@ -25,14 +25,14 @@
 #ifndef _RFB_INPUT_GATE_H_
 #define _RFB_INPUT_GATE_H_
 
-#include "io-lib/Channel.h"
+#include "io-lib/InputStream.h"
 
 #include "io-lib/DataInputStream.h"
 
 class RfbInputGate : public DataInputStream
 {
 public:
-  RfbInputGate(Channel *stream);
+  RfbInputGate(InputStream *stream);
   virtual ~RfbInputGate();
 };
 
@@ -44,3 +44,8 @@ void RfbOutputGate::flush()
 {
   m_tunnel->flush();
 }
+
+UINT64 RfbOutputGate::getBytesWritten() const
+{
+  return m_tunnel->getTotalWritten();
+}
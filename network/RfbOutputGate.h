@@ -59,6 +59,12 @@ public:
    */
   virtual void flush() throw(IOException);
 
+  /**
+   * Returns total count of bytes written to the gate (including buffered
+   * data which was not flushed yet).
+   */
+  UINT64 getBytesWritten() const;
+
 private:
   /**
    * Tunnel that adds buffering.
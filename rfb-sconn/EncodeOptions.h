@@ -70,6 +70,10 @@ public:
   // false otherwise.
   bool jpegEnabled() const;
 
+  // Forget the JPEG quality level so that jpegEnabled() would return false,
+  // as if the client did not request JPEG compression.
+  void disableJpeg();
+
   //
   // Accessor functions to boolean values.
   //
@@ -67,3 +67,23 @@ void Encoder::sendRectangle(const Rect *rect,
     m_output->writeFully((char *)lineP, lineSizeInBytes);
   }
 }
+
+void Encoder::sendRectangles(const std::vector<Rect> *rects,
+                             const FrameBuffer *serverFb,
+                             const EncodeOptions *options)
+{
+  std::vector<Rect>::const_iterator i;
+  for (i = rects->begin(); i != rects->end(); i++) {
+    sendRectHeader(&*i);
+    sendRectangle(&*i, serverFb, options);
+  }
+}
+
+void Encoder::sendRectHeader(const Rect *rect)
+{
+  m_output->writeUInt16((UINT16)rect->left);
+  m_output->writeUInt16((UINT16)rect->top);
+  m_output->writeUInt16((UINT16)rect->getWidth());
+  m_output->writeUInt16((UINT16)rect->getHeight());
+  m_output->writeInt32(getCode());
+}
@@ -96,7 +96,21 @@ public:
                              const FrameBuffer *serverFb,
                              const EncodeOptions *options) throw(IOException);
 
+  // Encode and send a list of rectangles, each one preceded by its rectangle
+  // header (as used in the FramebufferUpdate message). The default
+  // implementation sends the rectangles one by one via sendRectangle().
+  // Encoders which can overlap encoding of several rectangles may implement
+  // their own version, but the order of rectangles in the output must be
+  // preserved.
+  virtual void sendRectangles(const std::vector<Rect> *rects,
+                              const FrameBuffer *serverFb,
+                              const EncodeOptions *options) throw(IOException);
+
 protected:
+  // Write the rectangle header: the coordinates and the size of the
+  // rectangle followed by the encoding type code returned by getCode().
+  void sendRectHeader(const Rect *rect) throw(IOException);
+
 
   // PixelConverter is used for converting pixels from the given framebuffer
   // to some other pixel format (typically, the pixel format using by an RFB
@@ -33,7 +33,10 @@ EncoderStore::EncoderStore(PixelConverter *pixelConverter, DataOutputStream *out
 : m_encoder(0),
   m_jpegEncoder(0),
   m_pixelConverter(pixelConverter),
-  m_output(output)
+  m_output(output),
+  m_tightParallelMode(false),
+  m_tightSolidAreaExtraction(true),
+  m_jpegThreadCount(1)
 {
 }
 
@@ -69,7 +72,53 @@ void EncoderStore::validateJpegEncoder()
 {
   if (m_jpegEncoder == 0) {
     TightEncoder *tight = (TightEncoder *)validateEncoder(EncodingDefs::TIGHT);
-    m_jpegEncoder = new JpegEncoder(tight);
+    JpegEncoder *jpeg = new JpegEncoder(tight);
+    try {
+      jpeg->setThreadCount(m_jpegThreadCount);
+    } catch (...) {
+      delete jpeg;
+      throw;
+    }
+    m_jpegEncoder = jpeg;
+  }
+}
+
+void EncoderStore::setTightParallelMode(bool enabled)
+{
+  m_tightParallelMode = enabled;
+
+  std::map<int, Encoder *>::iterator it = m_map.find(EncodingDefs::TIGHT);
+  if (it != m_map.end()) {
+    ((TightEncoder *)it->second)->setParallelMode(enabled);
+  }
+}
+
+void EncoderStore::setTightSolidAreaExtraction(bool enabled)
+{
+  m_tightSolidAreaExtraction = enabled;
+
+  std::map<int, Encoder *>::iterator it = m_map.find(EncodingDefs::TIGHT);
+  if (it != m_map.end()) {
+    ((TightEncoder *)it->second)->setSolidAreaExtraction(enabled);
+  }
+}
+
+void EncoderStore::setJpegThreadCount(int numThreads)
+{
+  m_jpegThreadCount = numThreads;
+
+  if (m_jpegEncoder != 0) {
+    m_jpegEncoder->setThreadCount(numThreads);
+  }
+}
+
+void EncoderStore::extractLossyRegion(Region *lossyRegion)
+{
+  std::map<int, Encoder *>::iterator it = m_map.find(EncodingDefs::TIGHT);
+  if (it != m_map.end()) {
+    ((TightEncoder *)it->second)->extractLossyRegion(lossyRegion);
+  } else {
+    lossyRegion->clear();
   }
 }
 
@@ -115,7 +164,17 @@ Encoder *EncoderStore::allocateEncoder(int encType) const
 {
   switch (encType) {
   case EncodingDefs::TIGHT:
-    return new TightEncoder(m_pixelConverter, m_output);
+    {
+      TightEncoder *tight = new TightEncoder(m_pixelConverter, m_output);
+      try {
+        tight->setParallelMode(m_tightParallelMode);
+        tight->setSolidAreaExtraction(m_tightSolidAreaExtraction);
+      } catch (...) {
+        delete tight;
+        throw;
+      }
+      return tight;
+    }
   case EncodingDefs::ZRLE:
     return new ZrleEncoder(m_pixelConverter, m_output);
   case EncodingDefs::HEXTILE:
@@ -63,6 +63,26 @@ public:
   void selectEncoder(int encType);
   void validateJpegEncoder();
 
+  // Enable or disable the parallel mode of the Tight encoder (see
+  // TightEncoder::setParallelMode()). The setting is applied to the Tight
+  // encoder immediately if it's allocated already, or on its allocation.
+  void setTightParallelMode(bool enabled);
+
+  // Enable or disable the extraction of solid-color areas by the Tight
+  // encoder (see TightEncoder::setSolidAreaExtraction()). It's applied the
+  // same way as the parallel mode.
+  void setTightSolidAreaExtraction(bool enabled);
+
+  // Set the number of threads used by JpegEncoder (see
+  // JpegEncoder::setThreadCount()). Like the parallel mode above, the
+  // setting is applied immediately or on JpegEncoder allocation.
+  void setJpegThreadCount(int numThreads);
+
+  // Get the region sent with lossy compression since the previous call (see
+  // TightEncoder::extractLossyRegion()). Only Tight encoder (used by
+  // JpegEncoder as well) can produce lossy data.
+  void extractLossyRegion(Region *lossyRegion);
+
 protected:
   // This function makes sure the specified encoder is allocated and stored in
   // m_map. If it's already there, this function returns a pointer to the
@@ -102,6 +122,13 @@ protected:
   // This pointer to DataOutputStream will be used to construct encoders.
   DataOutputStream *m_output;
 
+  // Parallel mode flag to be passed to the Tight encoder.
+  bool m_tightParallelMode;
+  // Solid-color area extraction flag to be passed to the Tight encoder.
+  bool m_tightSolidAreaExtraction;
+  // Number of JPEG compression threads to be passed to JpegEncoder.
+  int m_jpegThreadCount;
+
 private:
   // Do not allow copying objects.
   EncoderStore(const EncoderStore &other);
@@ -73,6 +73,9 @@ term_destination (j_compress_ptr cinfo)
 StandardJpegCompressor::StandardJpegCompressor()
   : m_quality(-1), // make sure (m_quality != n_newQuality)
     m_newQuality(DEFAULT_JPEG_QUALITY),
+    m_subsampling(-1),
+    m_newSubsampling(getDefaultSubsampling(DEFAULT_JPEG_QUALITY)),
+    m_isDirectInputEnabled(true),
     m_outputBuffer(0),
     m_numBytesAllocated(0),
     m_numBytesReady(0)
@@ -193,6 +196,7 @@ StandardJpegCompressor::setQuality(int level)
     level = 100;
   }
   m_newQuality = level;
+  m_newSubsampling = getDefaultSubsampling(level);
 }
 
 //
@@ -203,6 +207,26 @@ void
 StandardJpegCompressor::resetQuality()
 {
   m_newQuality = DEFAULT_JPEG_QUALITY;
+  m_newSubsampling = getDefaultSubsampling(DEFAULT_JPEG_QUALITY);
+}
+
+void
+StandardJpegCompressor::setSubsampling(ChromaSubsampling subsampling)
+{
+  m_newSubsampling = subsampling;
+}
+
+void
+StandardJpegCompressor::enableDirectInput(bool enabled)
+{
+  m_isDirectInputEnabled = enabled;
+}
+
+bool
+StandardJpegCompressor::isDirectInputSupported(const PixelFormat *fmt)
+{
+  J_COLOR_SPACE colorSpace;
+  return getDirectColorSpace(fmt, &colorSpace);
 }
 
 void
@@ -210,20 +234,110 @@ StandardJpegCompressor::compress(const void *buf,
                                  const PixelFormat *fmt,
                                  int w, int h, int stride)
 {
-  bool useQuickConversion =
-    (fmt->bitsPerPixel == 32 && fmt->colorDepth == 24 &&
-     fmt->redMax == 255 && fmt->greenMax == 255 && fmt->blueMax == 255);
+  J_COLOR_SPACE directColorSpace;
+  bool directInput = m_isDirectInputEnabled &&
+                     getDirectColorSpace(fmt, &directColorSpace);
 
   m_jpeg.cinfo.image_width = w;
   m_jpeg.cinfo.image_height = h;
 
+  if (directInput) {
+    m_jpeg.cinfo.input_components = 4;
+    m_jpeg.cinfo.in_color_space = directColorSpace;
+  } else {
+    m_jpeg.cinfo.input_components = 3;
+    m_jpeg.cinfo.in_color_space = JCS_RGB;
+  }
+
   if (m_newQuality != m_quality) {
     jpeg_set_quality(&m_jpeg.cinfo, m_newQuality, true);
     m_quality = m_newQuality;
   }
+  if (m_newSubsampling != m_subsampling) {
+    applySubsampling(m_newSubsampling);
+    m_subsampling = m_newSubsampling;
+  }
 
   jpeg_start_compress(&m_jpeg.cinfo, TRUE);
 
+  if (directInput) {
+    writeDirectRows(buf, stride);
+  } else {
+    writeConvertedRows(buf, fmt, w, stride);
+  }
+
+  jpeg_finish_compress(&m_jpeg.cinfo);
+}
+
+void
+StandardJpegCompressor::applySubsampling(ChromaSubsampling subsampling)
+{
+  // Sampling factors of the luminance component, chrominance components
+  // always use 1x1.
+  int hSampFactor = 2;
+  int vSampFactor = 2;
+  if (subsampling == SUBSAMPLING_444) {
+    hSampFactor = 1;
+    vSampFactor = 1;
+  } else if (subsampling == SUBSAMPLING_422) {
+    vSampFactor = 1;
+  }
+
+  jpeg_component_info *compInfo = m_jpeg.cinfo.comp_info;
+  compInfo[0].h_samp_factor = hSampFactor;
+  compInfo[0].v_samp_factor = vSampFactor;
+  for (int i = 1; i < m_jpeg.cinfo.num_components; i++) {
+    compInfo[i].h_samp_factor = 1;
+    compInfo[i].v_samp_factor = 1;
+  }
+}
+
+bool
+StandardJpegCompressor::getDirectColorSpace(const PixelFormat *fmt,
+                                            J_COLOR_SPACE *colorSpace)
+{
+#ifdef JCS_EXTENSIONS
+  if (fmt->bitsPerPixel != 32 || fmt->colorDepth != 24 || fmt->bigEndian ||
+      fmt->redMax != 255 || fmt->greenMax != 255 || fmt->blueMax != 255) {
+    return false;
+  }
+  // Each color component should occupy a whole byte. The pixel format uses
+  // native (little-endian) byte order, so a shift of N bits means the
+  // component is stored in byte N / 8.
+  if (fmt->redShift % 8 != 0 || fmt->greenShift % 8 != 0 ||
+      fmt->blueShift % 8 != 0) {
+    return false;
+  }
+  int r = fmt->redShift / 8;
+  int g = fmt->greenShift / 8;
+  int b = fmt->blueShift / 8;
+
+  if (r == 0 && g == 1 && b == 2) {
+    *colorSpace = JCS_EXT_RGBX;
+  } else if (r == 2 && g == 1 && b == 0) {
+    *colorSpace = JCS_EXT_BGRX;
+  } else if (r == 1 && g == 2 && b == 3) {
+    *colorSpace = JCS_EXT_XRGB;
+  } else if (r == 3 && g == 2 && b == 1) {
+    *colorSpace = JCS_EXT_XBGR;
+  } else {
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+void
+StandardJpegCompressor::writeConvertedRows(const void *buf,
+                                           const PixelFormat *fmt,
+                                           int w, int stride)
+{
+  bool useQuickConversion =
+    (fmt->bitsPerPixel == 32 && fmt->colorDepth == 24 &&
+     fmt->redMax == 255 && fmt->greenMax == 255 && fmt->blueMax == 255);
+
   const char *src = (const char *)buf;
 
   // We'll pass up to 8 rows to jpeg_write_scanlines().
@@ -250,8 +364,27 @@ StandardJpegCompressor::compress(const void *buf,
   }
 
   delete[] rgb;
+}
 
-  jpeg_finish_compress(&m_jpeg.cinfo);
+void
+StandardJpegCompressor::writeDirectRows(const void *buf, int stride)
+{
+  // The JPEG library does not modify the input rows, so it's safe to pass
+  // pointers into the pixel buffer.
+  JSAMPLE *src = (JSAMPLE *)buf;
+  JSAMPROW rowPointer[16];
+
+  while (m_jpeg.cinfo.next_scanline < m_jpeg.cinfo.image_height) {
+    int firstRow = m_jpeg.cinfo.next_scanline;
+    int maxRows = m_jpeg.cinfo.image_height - firstRow;
+    if (maxRows > 16) {
+      maxRows = 16;
+    }
+    for (int dy = 0; dy < maxRows; dy++) {
+      rowPointer[dy] = src + (size_t)(firstRow + dy) * stride;
+    }
+    jpeg_write_scanlines(&m_jpeg.cinfo, rowPointer, maxRows);
+  }
 }
 
 size_t StandardJpegCompressor::getOutputLength()
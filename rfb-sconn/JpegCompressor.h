@@ -50,12 +50,35 @@
 class JpegCompressor
 {
 public:
+  // Chroma subsampling modes, in the order of decreasing quality.
+  enum ChromaSubsampling {
+    SUBSAMPLING_444, // no subsampling
+    SUBSAMPLING_422, // half horizontal chroma resolution
+    SUBSAMPLING_420  // half horizontal and vertical chroma resolution
+  };
+
   virtual ~JpegCompressor() {}
 
-  // Set JPEG quality level (0..100)
+  // Set JPEG quality level (0..100). This also selects the chroma
+  // subsampling mode returned by getDefaultSubsampling() for this level.
   virtual void setQuality(int level) = 0;
   virtual void resetQuality() = 0;
 
+  // Override the chroma subsampling mode chosen by setQuality().
+  virtual void setSubsampling(ChromaSubsampling subsampling) = 0;
+
+  // Get the chroma subsampling mode suitable for the specified JPEG quality
+  // level (0..100). Higher quality levels use less subsampling.
+  static ChromaSubsampling getDefaultSubsampling(int quality)
+  {
+    if (quality >= 90) {
+      return SUBSAMPLING_444;
+    } else if (quality >= 70) {
+      return SUBSAMPLING_422;
+    }
+    return SUBSAMPLING_420;
+  }
+
   // Actually compress a rectangle of a given pixel buffer referenced by buf.
   // The pixel format as specified by fmt must meet the following
   // requirements: bitsPerPixel must be either 32 or 16, and the bigEndian
@@ -89,6 +112,18 @@ public:
   virtual void setQuality(int level);
   virtual void resetQuality();
 
+  virtual void setSubsampling(ChromaSubsampling subsampling);
+
+  // Allow or forbid passing the pixels to the JPEG library as is, when
+  // their format permits (see isDirectInputSupported()). It's allowed by
+  // default; forbidding it makes every rectangle go through the conversion
+  // to RGB, which is useful only to compare the two paths.
+  void enableDirectInput(bool enabled);
+
+  // Check if pixels in the specified format can be passed to the JPEG
+  // library without conversion.
+  static bool isDirectInputSupported(const PixelFormat *fmt);
+
   virtual void compress(const void *buf, const PixelFormat *fmt,
                         int w, int h, int stride);
 
@@ -111,10 +146,34 @@ protected:
   int m_quality;
   int m_newQuality;
 
+  // Subsampling mode in the compression structure, -1 if not set yet.
+  int m_subsampling;
+  ChromaSubsampling m_newSubsampling;
+
+  bool m_isDirectInputEnabled;
+
   unsigned char *m_outputBuffer;
   size_t m_numBytesAllocated;
   size_t m_numBytesReady;
 
+  // Set sampling factors in the compression structure according to the
+  // subsampling mode.
+  void applySubsampling(ChromaSubsampling subsampling);
+
+  // Check if pixels in the specified format can be passed to libjpeg-turbo
+  // as is, via one of its extended color spaces. If so, return true and
+  // store the color space in *colorSpace. Always returns false if the JPEG
+  // library does not support extended color spaces.
+  static bool getDirectColorSpace(const PixelFormat *fmt,
+                                  J_COLOR_SPACE *colorSpace);
+
+  // Feed the pixels to the JPEG library after converting them to RGB.
+  void writeConvertedRows(const void *buf, const PixelFormat *fmt,
+                          int w, int stride);
+
+  // Feed the pixels to the JPEG library directly from the pixel buffer.
+  void writeDirectRows(const void *buf, int stride);
+
   // Convert one row (scanline) from the specified pixel format to the format
   // supported by the IJG JPEG library (one byte per one color component).
   void convertRow(JSAMPLE *dst, const void *src,
@@ -0,0 +1,149 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "JpegCompressorPool.h"
+
+#include "thread/AutoLock.h"
+
+JpegCompressorWorker::JpegCompressorWorker(JpegCompressorPool *owner)
+: m_owner(owner)
+{
+  resume();
+}
+
+JpegCompressorWorker::~JpegCompressorWorker()
+{
+  terminate();
+  wait();
+}
+
+void JpegCompressorWorker::execute()
+{
+  while (!isTerminating()) {
+    JpegCompressionJob *job = m_owner->takeJob();
+    if (job != 0) {
+      compressJob(job);
+    } else {
+      m_owner->m_newJob.waitForEvent();
+    }
+  }
+  // Pass the wake-up signal to other workers being terminated.
+  m_owner->m_newJob.notify();
+}
+
+void JpegCompressorWorker::onTerminate()
+{
+  m_owner->m_newJob.notify();
+}
+
+void JpegCompressorWorker::compressJob(JpegCompressionJob *job)
+{
+  bool failed = false;
+  StringStorage errorMessage;
+  try {
+    m_compressor.setQuality(job->quality);
+    m_compressor.compress(job->pixels, &job->format,
+                          job->rect.getWidth(), job->rect.getHeight(),
+                          job->stride);
+    const char *data = m_compressor.getOutputData();
+    job->output.assign(data, data + m_compressor.getOutputLength());
+  } catch (Exception &e) {
+    failed = true;
+    errorMessage.setString(e.getMessage());
+  }
+  m_owner->onJobDone(job, failed, &errorMessage);
+}
+
+//--------------------------------------------------------------------------//
+
+JpegCompressorPool::JpegCompressorPool(int numThreads)
+{
+  for (int i = 0; i < numThreads; i++) {
+    m_workers.push_back(new JpegCompressorWorker(this));
+  }
+}
+
+JpegCompressorPool::~JpegCompressorPool()
+{
+  // Request termination of all the workers first, then wait for each one.
+  for (size_t i = 0; i < m_workers.size(); i++) {
+    m_workers[i]->terminate();
+  }
+  for (size_t i = 0; i < m_workers.size(); i++) {
+    delete m_workers[i];
+  }
+}
+
+int JpegCompressorPool::getNumThreads() const
+{
+  return (int)m_workers.size();
+}
+
+void JpegCompressorPool::submit(JpegCompressionJob *job)
+{
+  {
+    AutoLock al(&m_queueLock);
+    m_queue.push_back(job);
+  }
+  m_newJob.notify();
+}
+
+bool JpegCompressorPool::isDone(JpegCompressionJob *job)
+{
+  AutoLock al(&m_doneLock);
+  return job->done;
+}
+
+void JpegCompressorPool::waitForJob(JpegCompressionJob *job)
+{
+  while (!isDone(job)) {
+    m_jobDone.waitForEvent();
+  }
+}
+
+JpegCompressionJob *JpegCompressorPool::takeJob()
+{
+  AutoLock al(&m_queueLock);
+  if (m_queue.empty()) {
+    return 0;
+  }
+  JpegCompressionJob *job = m_queue.front();
+  m_queue.pop_front();
+  if (!m_queue.empty()) {
+    m_newJob.notify();
+  }
+  return job;
+}
+
+void JpegCompressorPool::onJobDone(JpegCompressionJob *job, bool failed,
+                                   const StringStorage *errorMessage)
+{
+  {
+    AutoLock al(&m_doneLock);
+    job->failed = failed;
+    job->errorMessage = *errorMessage;
+    job->done = true;
+  }
+  m_jobDone.notify();
+}
@@ -0,0 +1,146 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __RFB_JPEG_COMPRESSOR_POOL_H_INCLUDED__
+#define __RFB_JPEG_COMPRESSOR_POOL_H_INCLUDED__
+
+#include <deque>
+#include <vector>
+
+#include "region/Rect.h"
+#include "rfb/PixelFormat.h"
+#include "thread/Thread.h"
+#include "thread/LocalMutex.h"
+#include "win-system/WindowsEvent.h"
+#include "JpegCompressor.h"
+
+class JpegCompressorPool;
+
+// One rectangle to be compressed with JPEG by a JpegCompressorPool worker.
+// The pixel data is referenced, not copied, so it must not change until the
+// job is finished.
+struct JpegCompressionJob
+{
+  JpegCompressionJob(const Rect *r, const void *pixelData,
+                     const PixelFormat *pixelFormat, int bytesPerRow,
+                     int jpegQuality)
+  : rect(r), pixels(pixelData), format(*pixelFormat), stride(bytesPerRow),
+    quality(jpegQuality), done(false), failed(false) {}
+
+  Rect rect;
+  const void *pixels;
+  PixelFormat format;
+  int stride;
+  // JPEG quality level (0..100).
+  int quality;
+
+  // Compressed data, filled in by the worker thread.
+  std::vector<char> output;
+
+  // The fields below are changed by the worker thread, access to them must
+  // be synchronized via JpegCompressorPool.
+  bool done;
+  bool failed;
+  StringStorage errorMessage;
+};
+
+// A worker thread with its own JPEG compressor.
+class JpegCompressorWorker : public Thread
+{
+public:
+  JpegCompressorWorker(JpegCompressorPool *owner);
+  virtual ~JpegCompressorWorker();
+
+protected:
+  virtual void execute();
+  virtual void onTerminate();
+
+  void compressJob(JpegCompressionJob *job);
+
+  JpegCompressorPool *m_owner;
+  StandardJpegCompressor m_compressor;
+
+private:
+  // Do not allow copying objects.
+  JpegCompressorWorker(const JpegCompressorWorker &other);
+  JpegCompressorWorker &operator=(const JpegCompressorWorker &other);
+};
+
+// JpegCompressorPool compresses JPEG rectangles in a number of worker
+// threads, each one using its own JpegCompressor. JPEG rectangles do not
+// depend on each other, so they can be compressed in any order. Keeping the
+// order of the output is up to the caller, typically it submits a number of
+// jobs and then waits for them in the order of submission.
+//
+// submit(), isDone() and waitForJob() should be called from one thread.
+class JpegCompressorPool
+{
+  friend class JpegCompressorWorker;
+
+public:
+  JpegCompressorPool(int numThreads);
+  virtual ~JpegCompressorPool();
+
+  int getNumThreads() const;
+
+  // Queue the job for compression. The caller keeps ownership of the job
+  // but may not delete it until it's finished.
+  void submit(JpegCompressionJob *job);
+
+  // Check if the job is finished (successfully or not).
+  bool isDone(JpegCompressionJob *job);
+
+  // Wait until the job is finished (successfully or not).
+  void waitForJob(JpegCompressionJob *job);
+
+protected:
+  // Called by worker threads. Return the next job from the queue or 0 if
+  // the queue is empty.
+  JpegCompressionJob *takeJob();
+  // Called by worker threads when a job is finished.
+  void onJobDone(JpegCompressionJob *job, bool failed,
+                 const StringStorage *errorMessage);
+
+  std::vector<JpegCompressorWorker *> m_workers;
+
+  // Jobs waiting for a free worker.
+  std::deque<JpegCompressionJob *> m_queue;
+  LocalMutex m_queueLock;
+  // Notified when new jobs are queued. The worker which gets a job notifies
+  // it again if there are more jobs in the queue, so that other workers
+  // would wake up too.
+  WindowsEvent m_newJob;
+
+  // Synchronizes access to the done, failed and errorMessage fields of jobs.
+  LocalMutex m_doneLock;
+  // Notified by worker threads each time a job is finished.
+  WindowsEvent m_jobDone;
+
+private:
+  // Do not allow copying objects.
+  JpegCompressorPool(const JpegCompressorPool &other);
+  JpegCompressorPool &operator=(const JpegCompressorPool &other);
+};
+
+#endif // __RFB_JPEG_COMPRESSOR_POOL_H_INCLUDED__
@@ -26,12 +26,16 @@
 
 JpegEncoder::JpegEncoder(TightEncoder *tightEncoder)
 : Encoder(tightEncoder->m_pixelConverter, tightEncoder->m_output),
-  m_tightEncoder(tightEncoder)
+  m_tightEncoder(tightEncoder),
+  m_compressorPool(0)
 {
 }
 
 JpegEncoder::~JpegEncoder()
 {
+  if (m_compressorPool != 0) {
+    delete m_compressorPool;
+  }
 }
 
 int JpegEncoder::getCode() const
@@ -45,9 +49,16 @@ void JpegEncoder::splitRectangle(const Rect *rect,
                                  const EncodeOptions *options)
 {
   int maxWidth = 2048;
-  for (int x0 = rect->left; x0 < rect->right; x0 += maxWidth) {
-    int x1 = (x0 + maxWidth <= rect->right) ? x0 + maxWidth : rect->right;
-    rectList->push_back(Rect(x0, rect->top, x1, rect->bottom));
+  int maxHeight = rect->getHeight();
+  if (m_compressorPool != 0) {
+    maxHeight = MAX_BAND_HEIGHT;
+  }
+  for (int y0 = rect->top; y0 < rect->bottom; y0 += maxHeight) {
+    int y1 = (y0 + maxHeight <= rect->bottom) ? y0 + maxHeight : rect->bottom;
+    for (int x0 = rect->left; x0 < rect->right; x0 += maxWidth) {
+      int x1 = (x0 + maxWidth <= rect->right) ? x0 + maxWidth : rect->right;
+      rectList->push_back(Rect(x0, y0, x1, y1));
+    }
   }
 }
 
@@ -65,3 +76,114 @@ void JpegEncoder::sendRectangle(const Rect *rect,
     m_tightEncoder->sendRectangle(rect, serverFb, options);
   }
 }
+
+void JpegEncoder::sendRectangles(const std::vector<Rect> *rects,
+                                 const FrameBuffer *serverFb,
+                                 const EncodeOptions *options)
+                                 throw(IOException)
+{
+  size_t bppServer = m_pixelConverter->getSrcBitsPerPixel();
+  size_t bppClient = m_pixelConverter->getDstBitsPerPixel();
+  bool goodColorResolution = (bppServer >= 16 && bppClient >= 16);
+
+  if (m_compressorPool == 0 || !options->jpegEnabled() ||
+      !goodColorResolution) {
+    Encoder::sendRectangles(rects, serverFb, options);
+    return;
+  }
+
+  // See TightEncoder::sendJpegRect() for the meaning of the default value.
+  int quality = options->getJpegQualityLevel(6) * 10 + 5;
+  PixelFormat fmt = serverFb->getPixelFormat();
+  int stride = serverFb->getBytesPerRow();
+
+  // Limit the number of jobs in progress so that we would not keep
+  // compressed data of the whole update in memory.
+  size_t maxPendingJobs = m_compressorPool->getNumThreads() * 2;
+
+  std::deque<JpegCompressionJob *> pending;
+  try {
+    std::vector<Rect>::const_iterator it;
+    for (it = rects->begin(); it != rects->end(); it++) {
+      const Rect *rect = &(*it);
+      JpegCompressionJob *job =
+        new JpegCompressionJob(rect, serverFb->getBufferPtr(rect->left,
+                                                            rect->top),
+                               &fmt, stride, quality);
+      try {
+        pending.push_back(job);
+      } catch (...) {
+        delete job;
+        throw;
+      }
+      m_compressorPool->submit(job);
+
+      while (pending.size() >= maxPendingJobs ||
+             (!pending.empty() && m_compressorPool->isDone(pending.front()))) {
+        sendOldestJob(&pending);
+      }
+    }
+    while (!pending.empty()) {
+      sendOldestJob(&pending);
+    }
+  } catch (...) {
+    // Worker threads may still use the remaining jobs.
+    while (!pending.empty()) {
+      m_compressorPool->waitForJob(pending.front());
+      delete pending.front();
+      pending.pop_front();
+    }
+    throw;
+  }
+}
+
+void JpegEncoder::setThreadCount(int numThreads)
+{
+  if (numThreads > MAX_THREAD_COUNT) {
+    numThreads = MAX_THREAD_COUNT;
+  }
+  if (numThreads < 2) {
+    numThreads = 0;
+  }
+  int currentCount = 0;
+  if (m_compressorPool != 0) {
+    currentCount = m_compressorPool->getNumThreads();
+  }
+  if (numThreads == currentCount) {
+    return;
+  }
+
+  if (m_compressorPool != 0) {
+    delete m_compressorPool;
+    m_compressorPool = 0;
+  }
+  if (numThreads != 0) {
+    m_compressorPool = new JpegCompressorPool(numThreads);
+  }
+}
+
+void JpegEncoder::sendOldestJob(std::deque<JpegCompressionJob *> *pending)
+{
+  JpegCompressionJob *job = pending->front();
+  m_compressorPool->waitForJob(job);
+  pending->pop_front();
+
+  try {
+    if (job->failed) {
+      throw IOException(job->errorMessage.getString());
+    }
+    size_t dataLen = job->output.size();
+
+    sendRectHeader(&job->rect);
+    m_output->writeUInt8(TightEncoder::SUBENCODING_JPEG);
+    TightEncoder::writeCompactLength(m_output, dataLen);
+    if (dataLen != 0) {
+      m_output->writeFully(&job->output.front(), dataLen);
+    }
+    m_tightEncoder->m_lossyRegion.addRect(&job->rect);
+  } catch (...) {
+    delete job;
+    throw;
+  }
+  delete job;
+}
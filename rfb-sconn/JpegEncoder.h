@@ -25,7 +25,10 @@
 #ifndef __RFB_JPEG_ENCODER_H_INCLUDED__
 #define __RFB_JPEG_ENCODER_H_INCLUDED__
 
+#include <deque>
+
 #include "TightEncoder.h"
+#include "JpegCompressorPool.h"
 
 class JpegEncoder : public Encoder
 {
@@ -39,7 +42,9 @@ public:
   virtual int getCode() const;
 
   // JpegEncoder implements its own splitRectangle() which just makes sure all
-  // rectangles are no wider than 2048 pixels.
+  // rectangles are no wider than 2048 pixels. If JPEG compression is done in
+  // multiple threads, tall rectangles are split into horizontal bands as
+  // well, to let more rectangles be compressed in parallel.
   virtual void splitRectangle(const Rect *rect,
                               std::vector<Rect> *rectList,
                               const FrameBuffer *serverFb,
@@ -53,8 +58,34 @@ public:
                              const FrameBuffer *serverFb,
                              const EncodeOptions *options);
 
+  // If JPEG sub-encoding should be used (see sendRectangle()) and more than
+  // one thread is allowed, compress the rectangles in parallel threads and
+  // send them in their original order. Otherwise, send them one by one.
+  virtual void sendRectangles(const std::vector<Rect> *rects,
+                              const FrameBuffer *serverFb,
+                              const EncodeOptions *options)
+                              throw(IOException);
+
+  // Set the number of threads used to compress JPEG rectangles. Values less
+  // than 2 disable parallel compression.
+  void setThreadCount(int numThreads);
+
 protected:
+  // Wait for the oldest pending job to finish, send its data and remove it
+  // from the queue.
+  void sendOldestJob(std::deque<JpegCompressionJob *> *pending);
+
   TightEncoder *m_tightEncoder;
+
+  // Worker threads compressing JPEG rectangles, null if parallel compression
+  // is disabled.
+  JpegCompressorPool *m_compressorPool;
+
+  // Maximum height of horizontal bands used in parallel mode. It's a
+  // multiple of 16 so that band boundaries match JPEG MCU boundaries.
+  static const int MAX_BAND_HEIGHT = 128;
+  // Maximum number of threads to use for JPEG compression.
+  static const int MAX_THREAD_COUNT = 16;
 };
 
 #endif // __RFB_JPEG_ENCODER_H_INCLUDED__
@@ -303,6 +303,9 @@ void RfbClient::onKeyboardEvent(UINT32 keySym, bool down)
 
 void RfbClient::onMouseEvent(UINT16 x, UINT16 y, UINT8 buttonMask)
 {
+  // The client may get the desktop scaled down.
+  m_updateSender->unscalePointerPos(&x, &y);
+
   PixelFormat pfStub;
   Dimension fbDim;
   m_desktop->getFrameBufferProperties(&fbDim, &pfStub);
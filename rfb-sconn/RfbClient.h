@@ -88,6 +88,11 @@ public:
   void changeDynViewPort(const ViewPortState *dynViewPort);
 
   bool clientIsReady() const { return m_updateSender->clientIsReady(); }
+  // Must be called in the normal phase only, see getClientState().
+  void getStatistics(UpdateStatistics *statistics)
+  {
+    m_updateSender->getStatistics(statistics);
+  }
   void sendUpdate(const UpdateContainer *updateContainer,
                   const CursorShape *cursorShape);
   void sendClipboard(const StringStorage *newClipboard);
@@ -27,7 +27,10 @@
 #include "io-lib/ByteArrayOutputStream.h"
 
 TightEncoder::TightEncoder(PixelConverter *conv, DataOutputStream *output)
-: Encoder(conv, output)
+: Encoder(conv, output),
+  m_compressorPool(0),
+  m_currentJob(0),
+  m_isSolidAreaExtractionEnabled(true)
 {
   for (int i = 0; i < NUM_ZLIB_STREAMS; i++) {
     m_zsActive[i] = false;
@@ -36,6 +39,10 @@ TightEncoder::TightEncoder(PixelConverter *conv, DataOutputStream *output)
 
 TightEncoder::~TightEncoder()
 {
+  // Stop worker threads before releasing zlib streams.
+  if (m_compressorPool != 0) {
+    delete m_compressorPool;
+  }
   for (int i = 0; i < NUM_ZLIB_STREAMS; i++) {
     if (m_zsActive[i]) {
       deflateEnd(&m_zsStruct[i]);
@@ -52,6 +59,35 @@ void TightEncoder::splitRectangle(const Rect *rect,
                                   std::vector<Rect> *rectList,
                                   const FrameBuffer *serverFb,
                                   const EncodeOptions *options)
+{
+  // Small rectangles are not worth looking for solid-color areas.
+  if (rect->area() < MIN_SPLIT_RECT_SIZE || !m_isSolidAreaExtractionEnabled) {
+    splitByConf(rect, rectList, options);
+    return;
+  }
+
+  // Solid-color areas are detected in the server pixel format. If an area is
+  // solid in the server format, it will be solid in the client format too.
+  size_t bpp = serverFb->getBitsPerPixel();
+  switch (bpp) {
+  case 8:
+    splitBySolidAreas<UINT8>(rect, rectList, serverFb, options);
+    break;
+  case 16:
+    splitBySolidAreas<UINT16>(rect, rectList, serverFb, options);
+    break;
+  case 32:
+    splitBySolidAreas<UINT32>(rect, rectList, serverFb, options);
+    break;
+  default:
+    _ASSERT(0);
+    splitByConf(rect, rectList, options);
+  }
+}
+
+void TightEncoder::splitByConf(const Rect *rect,
+                               std::vector<Rect> *rectList,
+                               const EncodeOptions *options)
 {
   int maxSize = getConf(options).maxRectSize;
   int rectWidth = rect->getWidth();
@@ -103,8 +139,260 @@ void TightEncoder::sendRectangle(const Rect *rect,
   }
 }
 
+void TightEncoder::sendRectangles(const std::vector<Rect> *rects,
+                                  const FrameBuffer *serverFb,
+                                  const EncodeOptions *options)
+{
+  if (m_compressorPool == 0) {
+    Encoder::sendRectangles(rects, serverFb, options);
+    return;
+  }
+
+  // Each rectangle is encoded into a separate job. Everything except zlib
+  // compression is done right here, in the calling thread; compression is
+  // left to the worker thread of the corresponding zlib stream. To reuse
+  // the normal encoding functions, m_output is temporarily redirected to the
+  // job's prefix buffer. The compressor pool writes finished jobs to the
+  // real output in the original order.
+  DataOutputStream *output = m_output;
+  try {
+    std::vector<Rect>::const_iterator i;
+    for (i = rects->begin(); i != rects->end(); i++) {
+      TightCompressionJob *job = new TightCompressionJob;
+      try {
+        ByteArrayOutputStream prefix;
+        DataOutputStream prefixData(&prefix);
+        m_output = &prefixData;
+        m_currentJob = job;
+
+        sendRectHeader(&*i);
+        sendRectangle(&*i, serverFb, options);
+
+        m_output = output;
+        m_currentJob = 0;
+        job->prefix.assign(prefix.toByteArray(),
+                           prefix.toByteArray() + prefix.size());
+      } catch (...) {
+        delete job;
+        throw;
+      }
+      m_compressorPool->submit(job, output);
+    }
+    m_compressorPool->flush(output);
+  } catch (...) {
+    m_output = output;
+    m_currentJob = 0;
+    m_compressorPool->discard();
+    throw;
+  }
+}
+
+void TightEncoder::setParallelMode(bool enabled)
+{
+  if (enabled && m_compressorPool == 0) {
+    m_compressorPool = new TightParallelCompressor(this, NUM_ZLIB_STREAMS);
+  } else if (!enabled && m_compressorPool != 0) {
+    delete m_compressorPool;
+    m_compressorPool = 0;
+  }
+}
+
+void TightEncoder::setSolidAreaExtraction(bool enabled)
+{
+  m_isSolidAreaExtractionEnabled = enabled;
+}
+
+void TightEncoder::extractLossyRegion(Region *lossyRegion)
+{
+  *lossyRegion = m_lossyRegion;
+  m_lossyRegion.clear();
+}
+
 //--------------------------------------------------------------------------//
 
+template <class PIXEL_T>
+void TightEncoder::splitBySolidAreas(const Rect *rect,
+                                     std::vector<Rect> *rectList,
+                                     const FrameBuffer *serverFb,
+                                     const EncodeOptions *options)
+{
+  Rect r(rect);
+
+  // Calculate maximum number of rows in one non-solid rectangle.
+  int maxWidth = min(getConf(options).maxRectWidth, r.getWidth());
+  int maxRows = getConf(options).maxRectSize / maxWidth;
+
+  for (int dy = r.top; dy < r.bottom; dy += MAX_SPLIT_TILE_SIZE) {
+    // If the rectangle becomes too large, split its upper part now.
+    if (dy - r.top >= maxRows) {
+      Rect upper(r.left, r.top, r.right, r.top + maxRows);
+      splitByConf(&upper, rectList, options);
+      r.top += maxRows;
+    }
+
+    int dh = min(MAX_SPLIT_TILE_SIZE, r.bottom - dy);
+    for (int dx = r.left; dx < r.right; dx += MAX_SPLIT_TILE_SIZE) {
+      int dw = min(MAX_SPLIT_TILE_SIZE, r.right - dx);
+      Rect tile(dx, dy, dx + dw, dy + dh);
+      UINT32 color;
+      if (!checkSolidTile<PIXEL_T>(&tile, serverFb, &color, false)) {
+        continue;
+      }
+
+      // Get dimensions of the solid-color area.
+      Rect searchArea(dx, dy, r.right, r.bottom);
+      int bestWidth, bestHeight;
+      findBestSolidArea<PIXEL_T>(&searchArea, serverFb, color,
+                                 &bestWidth, &bestHeight);
+
+      // Make sure the solid-color area is large enough (or the whole
+      // rectangle is of the same color).
+      int bestArea = bestWidth * bestHeight;
+      if (bestArea != r.area() && bestArea < MIN_SOLID_SUBRECT_SIZE) {
+        continue;
+      }
+
+      // Try to extend the solid-color area to its maximum size.
+      Rect best(dx, dy, dx + bestWidth, dy + bestHeight);
+      extendSolidArea<PIXEL_T>(&r, serverFb, color, &best);
+
+      // The part above the solid-color area has been scanned already, just
+      // split it. The part at the left may still contain solid areas.
+      if (best.top != r.top) {
+        Rect above(r.left, r.top, r.right, best.top);
+        splitByConf(&above, rectList, options);
+      }
+      if (best.left != r.left) {
+        Rect atLeft(r.left, best.top, best.left, best.bottom);
+        splitRectangle(&atLeft, rectList, serverFb, options);
+      }
+
+      // The solid-color area itself, it will be sent as SUBENCODING_FILL.
+      rectList->push_back(best);
+
+      // Remaining parts at the right and below the solid-color area.
+      if (best.right != r.right) {
+        Rect atRight(best.right, best.top, r.right, best.bottom);
+        splitRectangle(&atRight, rectList, serverFb, options);
+      }
+      if (best.bottom != r.bottom) {
+        Rect below(r.left, best.bottom, r.right, r.bottom);
+        splitRectangle(&below, rectList, serverFb, options);
+      }
+      return;
+    }
+  }
+
+  // No suitable solid-color areas found.
+  splitByConf(&r, rectList, options);
+}
+
+template <class PIXEL_T>
+bool TightEncoder::checkSolidTile(const Rect *r, const FrameBuffer *fb,
+                                  UINT32 *color, bool needSameColor)
+{
+  const PIXEL_T *row = (const PIXEL_T *)fb->getBufferPtr(r->left, r->top);
+  const int stride = fb->getDimension().width;
+  const int w = r->getWidth();
+  const int h = r->getHeight();
+
+  const PIXEL_T colorValue = *row;
+  if (needSameColor && (UINT32)colorValue != *color) {
+    return false;
+  }
+
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      if (row[x] != colorValue) {
+        return false;
+      }
+    }
+    row += stride;
+  }
+
+  *color = colorValue;
+  return true;
+}
+
+template <class PIXEL_T>
+void TightEncoder::findBestSolidArea(const Rect *r, const FrameBuffer *fb,
+                                     UINT32 color,
+                                     int *bestWidth, int *bestHeight)
+{
+  int prevWidth = r->getWidth();
+  *bestWidth = 0;
+  *bestHeight = 0;
+
+  for (int dy = r->top; dy < r->bottom; dy += MAX_SPLIT_TILE_SIZE) {
+    int dh = min(MAX_SPLIT_TILE_SIZE, r->bottom - dy);
+    int dw = min(MAX_SPLIT_TILE_SIZE, prevWidth);
+    Rect tile(r->left, dy, r->left + dw, dy + dh);
+    if (!checkSolidTile<PIXEL_T>(&tile, fb, &color, true)) {
+      break;
+    }
+
+    int dx;
+    for (dx = r->left + dw; dx < r->left + prevWidth; dx += dw) {
+      dw = min(MAX_SPLIT_TILE_SIZE, r->left + prevWidth - dx);
+      tile.setRect(dx, dy, dx + dw, dy + dh);
+      if (!checkSolidTile<PIXEL_T>(&tile, fb, &color, true)) {
+        break;
+      }
+    }
+
+    prevWidth = dx - r->left;
+    int height = dy + dh - r->top;
+    if (prevWidth * height > *bestWidth * *bestHeight) {
+      *bestWidth = prevWidth;
+      *bestHeight = height;
+    }
+  }
+}
+
+template <class PIXEL_T>
+void TightEncoder::extendSolidArea(const Rect *bounds, const FrameBuffer *fb,
+                                   UINT32 color, Rect *area)
+{
+  Rect line;
+  int cx, cy;
+
+  // Try to extend the area upwards.
+  for (cy = area->top - 1; cy >= bounds->top; cy--) {
+    line.setRect(area->left, cy, area->right, cy + 1);
+    if (!checkSolidTile<PIXEL_T>(&line, fb, &color, true)) {
+      break;
+    }
+  }
+  area->top = cy + 1;
+
+  // Downwards.
+  for (cy = area->bottom; cy < bounds->bottom; cy++) {
+    line.setRect(area->left, cy, area->right, cy + 1);
+    if (!checkSolidTile<PIXEL_T>(&line, fb, &color, true)) {
+      break;
+    }
+  }
+  area->bottom = cy;
+
+  // To the left.
+  for (cx = area->left - 1; cx >= bounds->left; cx--) {
+    line.setRect(cx, area->top, cx + 1, area->bottom);
+    if (!checkSolidTile<PIXEL_T>(&line, fb, &color, true)) {
+      break;
+    }
+  }
+  area->left = cx + 1;
+
+  // To the right.
+  for (cx = area->right; cx < bounds->right; cx++) {
+    line.setRect(cx, area->top, cx + 1, area->bottom);
+    if (!checkSolidTile<PIXEL_T>(&line, fb, &color, true)) {
+      break;
+    }
+  }
+  area->right = cx;
+}
+
 // FIXME: Is it really necessary to pass both frame buffers in arguments?
 // FIXME: Make a special version for the case when PIXEL_T is UINT8.
 template <class PIXEL_T>
@@ -304,6 +592,8 @@ void TightEncoder::sendJpegRect(const Rect *rect,
   m_output->writeUInt8(SUBENCODING_JPEG);
   sendCompactLength(dataLength);
   m_output->writeFully(m_compressor.getOutputData(), dataLength);
+
+  m_lossyRegion.addRect(rect);
 }
 
 //--------------------------------------------------------------------------//
@@ -474,6 +764,27 @@ void TightEncoder::sendCompressed(const char *data, size_t dataLen,
     return;
   }
 
+  // In the parallel mode, leave compression to the worker thread of this
+  // zlib stream.
+  if (m_currentJob != 0) {
+    _ASSERT(m_currentJob->input.empty());
+    m_currentJob->input.assign(data, data + dataLen);
+    m_currentJob->streamId = streamId;
+    m_currentJob->zlibLevel = zlibLevel;
+    return;
+  }
+
+  std::vector<char> compressed;
+  compressData(data, dataLen, streamId, zlibLevel, &compressed);
+
+  sendCompactLength(compressed.size());
+  m_output->writeFully(&compressed.front(), compressed.size());
+}
+
+void TightEncoder::compressData(const char *data, size_t dataLen,
+                                int streamId, int zlibLevel,
+                                std::vector<char> *compressed)
+{
   z_streamp pz = &m_zsStruct[streamId];
 
   // Initialize compression stream if needed.
@@ -495,8 +806,8 @@ void TightEncoder::sendCompressed(const char *data, size_t dataLen,
   // Prepare buffers.
   size_t compressedBufferSize = dataLen + dataLen / 100 + 16;
 
-  std::vector<char> charBuff(compressedBufferSize);
-  char *compressedData = &charBuff.front();
+  compressed->resize(compressedBufferSize);
+  char *compressedData = &compressed->front();
 
   _ASSERT((unsigned int)dataLen == dataLen);
   _ASSERT((unsigned int)compressedBufferSize == compressedBufferSize);
@@ -520,16 +831,16 @@ void TightEncoder::sendCompressed(const char *data, size_t dataLen,
       throw IOException(_T("Zlib compression failed in Tight encoder"));
   }
 
-  try {
-    size_t compressedLength = compressedBufferSize - pz->avail_out;
-    sendCompactLength(compressedLength);
-    m_output->writeFully(compressedData, compressedLength);
-  } catch (...) {
-    throw;
-  }
+  compressed->resize(compressedBufferSize - pz->avail_out);
 }
 
 void TightEncoder::sendCompactLength(size_t dataLen)
+{
+  writeCompactLength(m_output, dataLen);
+}
+
+void TightEncoder::writeCompactLength(DataOutputStream *output,
+                                      size_t dataLen)
 {
   _ASSERT(dataLen <= 0x3FFFFF);
 
@@ -546,7 +857,7 @@ void TightEncoder::sendCompactLength(size_t dataLen)
     }
   }
 
-  m_output->writeFully(buffer, numBytes);
+  output->writeFully(buffer, numBytes);
 }
 
 // FIXME: Values for maxRectSize and maxRectWidth should be determined after
@@ -28,13 +28,16 @@
 // FIXME: Use some object-oriented wrapper instead of the pure zlib.
 #include "zlib/zlib.h"
 
+#include "region/Region.h"
 #include "Encoder.h"
 #include "TightPalette.h"
 #include "JpegCompressor.h"
+#include "TightParallelCompressor.h"
 
 class TightEncoder : public Encoder
 {
   friend class JpegEncoder;
+  friend class TightParallelCompressor;
 
 public:
   TightEncoder(PixelConverter *conv, DataOutputStream *output);
@@ -43,7 +46,10 @@ public:
   virtual int getCode() const;
 
   // Splits big rectangles according to the configuration setings (m_conf)
-  // corresponding to the compression level set in EncodeOptions.
+  // corresponding to the compression level set in EncodeOptions. Before
+  // splitting, big rectangles are scanned for large solid-color areas, each
+  // such area is extracted as one separate rectangle so that it would be sent
+  // with a single SUBENCODING_FILL record.
   virtual void splitRectangle(const Rect *rect,
                               std::vector<Rect> *rectList,
                               const FrameBuffer *serverFb,
@@ -53,7 +59,64 @@ public:
                              const FrameBuffer *serverFb,
                              const EncodeOptions *options) throw(IOException);
 
+  // In the parallel mode, this function compresses data of different zlib
+  // streams concurrently, in separate threads (see TightParallelCompressor).
+  // Otherwise, it works just like the default implementation.
+  virtual void sendRectangles(const std::vector<Rect> *rects,
+                              const FrameBuffer *serverFb,
+                              const EncodeOptions *options) throw(IOException);
+
+  // Enable or disable the parallel mode. The parallel mode is disabled by
+  // default. This function may not be called while sending rectangles.
+  void setParallelMode(bool enabled);
+
+  // Enable or disable the extraction of solid-color areas in
+  // splitRectangle(). It's enabled by default, disabling it is useful only
+  // to measure its effect.
+  void setSolidAreaExtraction(bool enabled);
+
+  // Move the region covered by rectangles sent with lossy (JPEG) compression
+  // since the previous call into *lossyRegion, replacing its contents.
+  void extractLossyRegion(Region *lossyRegion);
+
 protected:
+  // Split the rectangle according to the m_conf limits only, without looking
+  // for solid-color areas.
+  void splitByConf(const Rect *rect,
+                   std::vector<Rect> *rectList,
+                   const EncodeOptions *options);
+
+  // An implementation of splitRectangle() for the given pixel size of the
+  // server frame buffer. If a large solid-color area is found, it's added to
+  // rectList as one rectangle, and the parts around it are split
+  // recursively. Otherwise, the rectangle is split with splitByConf().
+  template <class PIXEL_T>
+    void splitBySolidAreas(const Rect *rect,
+                           std::vector<Rect> *rectList,
+                           const FrameBuffer *serverFb,
+                           const EncodeOptions *options);
+
+  // Check if all pixels of the rectangle r have the same color. If
+  // needSameColor is true, that color should also be equal to *color,
+  // otherwise the color found is stored in *color.
+  template <class PIXEL_T>
+    bool checkSolidTile(const Rect *r, const FrameBuffer *fb,
+                        UINT32 *color, bool needSameColor);
+
+  // Find the biggest solid-color area of the given color starting from the
+  // upper-left corner of the rectangle r, walking by tiles of
+  // MAX_SPLIT_TILE_SIZE pixels. The size of the area found is stored in
+  // *bestWidth and *bestHeight.
+  template <class PIXEL_T>
+    void findBestSolidArea(const Rect *r, const FrameBuffer *fb, UINT32 color,
+                           int *bestWidth, int *bestHeight);
+
+  // Try to extend the solid-color area *area in all four directions, pixel
+  // by pixel, not going out of the boundaries specified by bounds.
+  template <class PIXEL_T>
+    void extendSolidArea(const Rect *bounds, const FrameBuffer *fb,
+                         UINT32 color, Rect *area);
+
   // An implementation of sendRectangle() for the given pixel size.
   template <class PIXEL_T>
     void sendAnyRect(const Rect *rect,
@@ -126,10 +189,22 @@ protected:
   void sendCompressed(const char *data, size_t dataLen,
                       int streamId, int zlibLevel) throw(IOException);
 
+  // Compress the data via the specified zlib stream, put the result into
+  // *compressed. Different streams may be used from different threads
+  // concurrently, but each one should be used by one thread at a time.
+  // FIXME: Throw ZlibException instead.
+  void compressData(const char *data, size_t dataLen,
+                    int streamId, int zlibLevel,
+                    std::vector<char> *compressed) throw(IOException);
+
   // Send the number of the compressed bytes following. The number (dataLen)
   // is represented by a variable-length code (1..3 bytes).
   void sendCompactLength(size_t dataLen) throw(IOException);
 
+  // The same as sendCompactLength() but writes to the specified stream.
+  static void writeCompactLength(DataOutputStream *output,
+                                 size_t dataLen) throw(IOException);
+
   // Configuration table of the Tight encoder. Do not access this table
   // directly, use getConf() method instead.
   static const struct Conf {
@@ -161,6 +236,15 @@ protected:
   static const int JPEG_MIN_RECT_WIDTH = 8;
   static const int JPEG_MIN_RECT_HEIGHT = 8;
 
+  // Parameters of the solid-color area extraction. Rectangles smaller than
+  // MIN_SPLIT_RECT_SIZE are never scanned for solid-color areas, the areas
+  // are looked for in tiles of MAX_SPLIT_TILE_SIZE x MAX_SPLIT_TILE_SIZE
+  // pixels, and solid-color areas smaller than MIN_SOLID_SUBRECT_SIZE are
+  // not extracted.
+  static const int MIN_SPLIT_RECT_SIZE = 4096;
+  static const int MIN_SOLID_SUBRECT_SIZE = 2048;
+  static const int MAX_SPLIT_TILE_SIZE = 16;
+
   // The number of zlib streams used by TightEncoder (it cannot exceed 4).
   static const int NUM_ZLIB_STREAMS = 3;
 
@@ -183,6 +267,21 @@ protected:
 
   // JPEG compressor working via the IJG JPEG library.
   StandardJpegCompressor m_compressor;
+
+  // Worker threads compressing zlib streams in the parallel mode, 0 if the
+  // parallel mode is disabled.
+  TightParallelCompressor *m_compressorPool;
+
+  // In the parallel mode, the job for the rectangle being encoded at the
+  // moment. sendCompressed() stores its data in this job instead of
+  // compressing it. Zero when not encoding rectangles in the parallel mode.
+  TightCompressionJob *m_currentJob;
+
+  // Rectangles sent with JPEG since the last extractLossyRegion() call.
+  Region m_lossyRegion;
+
+  // If false, splitRectangle() splits rectangles by m_conf only.
+  bool m_isSolidAreaExtractionEnabled;
 };
 
 #endif // __RFB_TIGHT_ENCODER_H_INCLUDED__
@@ -0,0 +1,198 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "TightParallelCompressor.h"
+
+#include "thread/AutoLock.h"
+#include "TightEncoder.h"
+
+TightStreamWorker::TightStreamWorker(TightParallelCompressor *owner)
+: m_owner(owner)
+{
+  resume();
+}
+
+TightStreamWorker::~TightStreamWorker()
+{
+  terminate();
+  wait();
+}
+
+void TightStreamWorker::addJob(TightCompressionJob *job)
+{
+  {
+    AutoLock al(&m_queueLock);
+    m_queue.push_back(job);
+  }
+  m_newJob.notify();
+}
+
+void TightStreamWorker::execute()
+{
+  while (!isTerminating()) {
+    TightCompressionJob *job = 0;
+    {
+      AutoLock al(&m_queueLock);
+      if (!m_queue.empty()) {
+        job = m_queue.front();
+        m_queue.pop_front();
+      }
+    }
+    if (job != 0) {
+      m_owner->compressJob(job);
+    } else {
+      m_newJob.waitForEvent();
+    }
+  }
+}
+
+void TightStreamWorker::onTerminate()
+{
+  m_newJob.notify();
+}
+
+//--------------------------------------------------------------------------//
+
+TightParallelCompressor::TightParallelCompressor(TightEncoder *encoder,
+                                                 int numStreams)
+: m_encoder(encoder),
+  m_pendingSize(0)
+{
+  for (int i = 0; i < numStreams; i++) {
+    m_workers.push_back(new TightStreamWorker(this));
+  }
+}
+
+TightParallelCompressor::~TightParallelCompressor()
+{
+  discard();
+  for (size_t i = 0; i < m_workers.size(); i++) {
+    delete m_workers[i];
+  }
+}
+
+void TightParallelCompressor::submit(TightCompressionJob *job,
+                                     DataOutputStream *output)
+{
+  _ASSERT(job->streamId >= 0 && (size_t)job->streamId < m_workers.size());
+
+  try {
+    m_pending.push_back(job);
+  } catch (...) {
+    delete job;
+    throw;
+  }
+  m_pendingSize += job->prefix.size() + job->input.size();
+
+  if (job->input.empty()) {
+    AutoLock al(&m_doneLock);
+    job->done = true;
+  } else {
+    m_workers[job->streamId]->addJob(job);
+  }
+
+  // Write out everything finished so far, keeping the order. If there is
+  // too much data pending, wait for the oldest jobs.
+  while (!m_pending.empty() &&
+         (isDone(m_pending.front()) || m_pendingSize > MAX_PENDING_SIZE)) {
+    writeOldestJob(output);
+  }
+}
+
+void TightParallelCompressor::flush(DataOutputStream *output)
+{
+  while (!m_pending.empty()) {
+    writeOldestJob(output);
+  }
+}
+
+void TightParallelCompressor::discard()
+{
+  while (!m_pending.empty()) {
+    TightCompressionJob *job = m_pending.front();
+    waitForJob(job);
+    m_pending.pop_front();
+    delete job;
+  }
+  m_pendingSize = 0;
+}
+
+void TightParallelCompressor::compressJob(TightCompressionJob *job)
+{
+  bool failed = false;
+  StringStorage errorMessage;
+  try {
+    m_encoder->compressData(&job->input.front(), job->input.size(),
+                            job->streamId, job->zlibLevel, &job->output);
+  } catch (Exception &e) {
+    failed = true;
+    errorMessage.setString(e.getMessage());
+  }
+
+  {
+    AutoLock al(&m_doneLock);
+    job->failed = failed;
+    job->errorMessage = errorMessage;
+    job->done = true;
+  }
+  m_jobDone.notify();
+}
+
+bool TightParallelCompressor::isDone(TightCompressionJob *job)
+{
+  AutoLock al(&m_doneLock);
+  return job->done;
+}
+
+void TightParallelCompressor::waitForJob(TightCompressionJob *job)
+{
+  while (!isDone(job)) {
+    m_jobDone.waitForEvent();
+  }
+}
+
+void TightParallelCompressor::writeOldestJob(DataOutputStream *output)
+{
+  TightCompressionJob *job = m_pending.front();
+  waitForJob(job);
+  m_pending.pop_front();
+  m_pendingSize -= job->prefix.size() + job->input.size();
+
+  try {
+    if (job->failed) {
+      throw IOException(job->errorMessage.getString());
+    }
+    if (!job->prefix.empty()) {
+      output->writeFully(&job->prefix.front(), job->prefix.size());
+    }
+    if (!job->input.empty()) {
+      TightEncoder::writeCompactLength(output, job->output.size());
+      output->writeFully(&job->output.front(), job->output.size());
+    }
+  } catch (...) {
+    delete job;
+    throw;
+  }
+  delete job;
+}
@@ -0,0 +1,165 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __RFB_TIGHT_PARALLEL_COMPRESSOR_H_INCLUDED__
+#define __RFB_TIGHT_PARALLEL_COMPRESSOR_H_INCLUDED__
+
+#include <deque>
+#include <vector>
+
+#include "io-lib/DataOutputStream.h"
+#include "thread/Thread.h"
+#include "thread/LocalMutex.h"
+#include "win-system/WindowsEvent.h"
+
+class TightEncoder;
+class TightParallelCompressor;
+
+// Encoded data of one rectangle produced by TightEncoder in the parallel
+// mode. Everything except the zlib-compressed part is stored in the prefix,
+// the data to be compressed is stored in the input and will be compressed by
+// the worker thread serving the corresponding zlib stream.
+struct TightCompressionJob
+{
+  TightCompressionJob()
+  : streamId(0), zlibLevel(0), done(false), failed(false) {}
+
+  // Bytes to be written as is: the rectangle header, Tight control bytes,
+  // palette, or the whole rectangle data if it does not need compression.
+  std::vector<char> prefix;
+
+  // Data to be compressed via the zlib stream streamId, with the specified
+  // compression level. Empty if nothing should be compressed.
+  std::vector<char> input;
+  int streamId;
+  int zlibLevel;
+
+  // Compressed data, filled in by the worker thread.
+  std::vector<char> output;
+
+  // The fields below are changed by the worker thread, access to them must
+  // be synchronized via TightParallelCompressor.
+  bool done;
+  bool failed;
+  StringStorage errorMessage;
+};
+
+// A thread compressing jobs of one zlib stream in the order of their
+// arrival.
+class TightStreamWorker : public Thread
+{
+public:
+  TightStreamWorker(TightParallelCompressor *owner);
+  virtual ~TightStreamWorker();
+
+  // Add a job to the queue of this worker.
+  void addJob(TightCompressionJob *job);
+
+protected:
+  virtual void execute();
+  virtual void onTerminate();
+
+  TightParallelCompressor *m_owner;
+
+  std::deque<TightCompressionJob *> m_queue;
+  LocalMutex m_queueLock;
+  WindowsEvent m_newJob;
+
+private:
+  // Do not allow copying objects.
+  TightStreamWorker(const TightStreamWorker &other);
+  TightStreamWorker &operator=(const TightStreamWorker &other);
+};
+
+// TightParallelCompressor lets TightEncoder compress data of different zlib
+// streams at the same time, each zlib stream in its own worker thread.
+// Within one stream, jobs are compressed in the order of submission, which
+// is all the Tight decoder needs. Finished jobs are written to the output
+// in the order of submission too, so the result is identical to what the
+// encoder would produce in the normal (sequential) mode.
+//
+// The amount of data kept in pending jobs is limited by MAX_PENDING_SIZE.
+// When it's exceeded, submit() waits for the oldest jobs and writes them out
+// before returning.
+//
+// All the functions except the constructor and the destructor should be
+// called only from the thread that uses the TightEncoder.
+class TightParallelCompressor
+{
+  friend class TightStreamWorker;
+
+public:
+  // Creates one worker thread per each of numStreams zlib streams. The
+  // encoder will be used to perform actual compression.
+  TightParallelCompressor(TightEncoder *encoder, int numStreams);
+  virtual ~TightParallelCompressor();
+
+  // Takes ownership of the job and passes it to the worker of its zlib
+  // stream (if the job has anything to compress). Then writes all the jobs
+  // already finished to the output, in order.
+  void submit(TightCompressionJob *job,
+              DataOutputStream *output) throw(IOException);
+
+  // Waits for all pending jobs and writes them to the output.
+  void flush(DataOutputStream *output) throw(IOException);
+
+  // Waits for all pending jobs and drops them without writing. This should
+  // be called on errors, before abandoning the current update.
+  void discard();
+
+  // Maximum total size of prefixes and inputs of pending jobs.
+  static const size_t MAX_PENDING_SIZE = 8 * 1024 * 1024;
+
+protected:
+  // Called by a worker thread to compress the job.
+  void compressJob(TightCompressionJob *job);
+
+  bool isDone(TightCompressionJob *job);
+  void waitForJob(TightCompressionJob *job);
+
+  // Wait for the oldest pending job, remove it from the queue and write it
+  // to the output.
+  void writeOldestJob(DataOutputStream *output) throw(IOException);
+
+  TightEncoder *m_encoder;
+
+  // Worker threads, one per zlib stream.
+  std::vector<TightStreamWorker *> m_workers;
+
+  // Submitted jobs not written yet, in the order of submission.
+  std::deque<TightCompressionJob *> m_pending;
+  size_t m_pendingSize;
+
+  // Synchronizes access to the done, failed and errorMessage fields of jobs.
+  LocalMutex m_doneLock;
+  // Notified by worker threads each time a job is finished.
+  WindowsEvent m_jobDone;
+
+private:
+  // Do not allow copying objects.
+  TightParallelCompressor(const TightParallelCompressor &other);
+  TightParallelCompressor &operator=(const TightParallelCompressor &other);
+};
+
+#endif // __RFB_TIGHT_PARALLEL_COMPRESSOR_H_INCLUDED__
@@ -0,0 +1,497 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "FrameBufferScaler.h"
+
+#include <math.h>
+#include <emmintrin.h>
+
+const bool FrameBufferScaler::m_hasSse2 = FrameBufferScaler::detectSse2();
+
+FrameBufferScaler::FrameBufferScaler()
+: m_isSimdEnabled(true),
+  m_filter(FILTER_AREA),
+  m_isDirect(false)
+{
+}
+
+FrameBufferScaler::~FrameBufferScaler()
+{
+}
+
+bool FrameBufferScaler::detectSse2()
+{
+  return IsProcessorFeaturePresent(PF_XMMI64_INSTRUCTIONS_AVAILABLE) != 0;
+}
+
+bool FrameBufferScaler::isSupportedFormat(const PixelFormat *pf)
+{
+  if (pf->bitsPerPixel != 8 && pf->bitsPerPixel != 16 &&
+      pf->bitsPerPixel != 32) {
+    return false;
+  }
+  // Each channel must fit a byte.
+  return pf->redMax <= 255 && pf->greenMax <= 255 && pf->blueMax <= 255 &&
+         pf->redShift < pf->bitsPerPixel &&
+         pf->greenShift < pf->bitsPerPixel &&
+         pf->blueShift < pf->bitsPerPixel;
+}
+
+void FrameBufferScaler::enableSimd(bool enabled)
+{
+  m_isSimdEnabled = enabled;
+}
+
+bool FrameBufferScaler::setGeometry(Filter filter, const Rect *srcRect,
+                                    const Rect *dstRect,
+                                    const PixelFormat *pf)
+{
+  if (filter == m_filter && srcRect->isEqualTo(&m_srcRect) &&
+      dstRect->isEqualTo(&m_dstRect) && pf->isEqualTo(&m_pf)) {
+    return false;
+  }
+  _ASSERT(isSupportedFormat(pf));
+
+  m_filter = filter;
+  m_srcRect = *srcRect;
+  m_dstRect = *dstRect;
+  m_pf = *pf;
+  m_isDirect = pf->bitsPerPixel == 32 &&
+               pf->redMax == 255 && pf->greenMax == 255 &&
+               pf->blueMax == 255 &&
+               pf->redShift % 8 == 0 && pf->greenShift % 8 == 0 &&
+               pf->blueShift % 8 == 0;
+
+  if (!srcRect->isEmpty() && !dstRect->isEmpty()) {
+    m_xAxis.build(filter, srcRect->getWidth(), dstRect->getWidth());
+    m_yAxis.build(filter, srcRect->getHeight(), dstRect->getHeight());
+  }
+  return true;
+}
+
+void FrameBufferScaler::scale(const FrameBuffer *src, const Rect *srcChanged,
+                              FrameBuffer *dst, Rect *dstChanged)
+{
+  getDependentRect(srcChanged, dstChanged);
+  if (dstChanged->isEmpty()) {
+    return;
+  }
+  scaleRect(src, dst,
+            dstChanged->left - m_dstRect.left,
+            dstChanged->right - m_dstRect.left,
+            dstChanged->top - m_dstRect.top,
+            dstChanged->bottom - m_dstRect.top);
+}
+
+void FrameBufferScaler::getDependentRect(const Rect *srcChanged,
+                                         Rect *dstChanged) const
+{
+  dstChanged->clear();
+  Rect changed = srcChanged->intersection(&m_srcRect);
+  if (changed.isEmpty() || m_dstRect.isEmpty()) {
+    return;
+  }
+  int dstX0, dstX1, dstY0, dstY1;
+  m_xAxis.getDependentRange(changed.left - m_srcRect.left,
+                            changed.right - m_srcRect.left,
+                            &dstX0, &dstX1);
+  m_yAxis.getDependentRange(changed.top - m_srcRect.top,
+                            changed.bottom - m_srcRect.top,
+                            &dstY0, &dstY1);
+  if (dstX0 >= dstX1 || dstY0 >= dstY1) {
+    return;
+  }
+  dstChanged->setRect(m_dstRect.left + dstX0, m_dstRect.top + dstY0,
+                      m_dstRect.left + dstX1, m_dstRect.top + dstY1);
+}
+
+void FrameBufferScaler::Axis::build(Filter filter, int srcLength,
+                                    int dstLength)
+{
+  first.resize(dstLength);
+  count.resize(dstLength);
+  offset.resize(dstLength);
+  weights.clear();
+
+  double ratio = (double)srcLength / dstLength;
+  std::vector<double> w;
+  for (int d = 0; d < dstLength; d++) {
+    // The destination pixel covers [start, end) of the source.
+    double start = d * ratio;
+    double end = (d + 1) * ratio;
+    int i0, i1;
+    w.clear();
+    switch (filter) {
+    case FILTER_AREA:
+      i0 = (int)floor(start);
+      i1 = min((int)ceil(end), srcLength);
+      for (int i = i0; i < i1; i++) {
+        w.push_back(min(end, (double)(i + 1)) - max(start, (double)i));
+      }
+      break;
+    case FILTER_BILINEAR:
+      {
+        double center = (start + end) / 2.0 - 0.5;
+        center = max(0.0, min(center, (double)(srcLength - 1)));
+        i0 = (int)floor(center);
+        double fraction = center - i0;
+        w.push_back(1.0 - fraction);
+        if (i0 + 1 < srcLength) {
+          w.push_back(fraction);
+        }
+      }
+      break;
+    default:
+      // Pixels with centers in [start, end), the nearest one if there are
+      // no such pixels.
+      i0 = (int)ceil(start - 0.5);
+      i1 = min((int)ceil(end - 0.5), srcLength);
+      if (i1 <= i0) {
+        i0 = min((int)((start + end) / 2.0), srcLength - 1);
+        i1 = i0 + 1;
+      }
+      w.assign(i1 - i0, 1.0);
+      break;
+    }
+
+    // The fixed point weights must add up to WEIGHT_ONE exactly, the
+    // rounding error goes to the largest weight.
+    double sum = 0.0;
+    size_t largest = 0;
+    for (size_t k = 0; k < w.size(); k++) {
+      sum += w[k];
+      if (w[k] > w[largest]) {
+        largest = k;
+      }
+    }
+    size_t base = weights.size();
+    int total = 0;
+    for (size_t k = 0; k < w.size(); k++) {
+      int weight = (int)(w[k] / sum * WEIGHT_ONE + 0.5);
+      weights.push_back((INT16)weight);
+      total += weight;
+    }
+    weights[base + largest] = (INT16)(weights[base + largest] +
+                                      WEIGHT_ONE - total);
+
+    // Zero weights at the ends would only add dependencies.
+    size_t begin = base;
+    size_t stop = weights.size();
+    while (stop - begin > 1 && weights[begin] == 0) {
+      begin++;
+    }
+    while (stop - begin > 1 && weights[stop - 1] == 0) {
+      stop--;
+    }
+    weights.erase(weights.begin() + stop, weights.end());
+    weights.erase(weights.begin() + base, weights.begin() + begin);
+
+    first[d] = i0 + (int)(begin - base);
+    count[d] = (int)(stop - begin);
+    offset[d] = base;
+  }
+}
+
+void FrameBufferScaler::Axis::getDependentRange(int srcFirst, int srcEnd,
+                                                int *dstFirst,
+                                                int *dstEnd) const
+{
+  // The source ranges of the destination pixels grow monotonically.
+  int length = (int)first.size();
+  int d = 0;
+  while (d < length && first[d] + count[d] <= srcFirst) {
+    d++;
+  }
+  *dstFirst = d;
+  while (d < length && first[d] < srcEnd) {
+    d++;
+  }
+  *dstEnd = d;
+}
+
+void FrameBufferScaler::scaleRect(const FrameBuffer *src, FrameBuffer *dst,
+                                  int dstX0, int dstX1, int dstY0, int dstY1)
+{
+  int width = dstX1 - dstX0;
+  int srcX0 = m_xAxis.first[dstX0];
+  int srcX1 = srcX0;
+  for (int x = dstX0; x < dstX1; x++) {
+    srcX1 = max(srcX1, m_xAxis.first[x] + m_xAxis.count[x]);
+  }
+  m_dstRow.resize(width);
+
+  for (int bandY = dstY0; bandY < dstY1; bandY += BAND_ROWS) {
+    int bandEnd = min(bandY + BAND_ROWS, dstY1);
+    int srcY0 = m_yAxis.first[bandY];
+    int srcY1 = srcY0;
+    for (int y = bandY; y < bandEnd; y++) {
+      srcY1 = max(srcY1, m_yAxis.first[y] + m_yAxis.count[y]);
+    }
+
+    m_rows.resize((size_t)(srcY1 - srcY0) * width);
+    for (int y = srcY0; y < srcY1; y++) {
+      const UINT32 *srcRow = getSourceRow(src, srcX0, y, srcX1 - srcX0);
+      filterRow(&m_rows[(size_t)(y - srcY0) * width], srcRow, srcX0,
+                dstX0, dstX1);
+    }
+
+    for (int y = bandY; y < bandEnd; y++) {
+      int count = m_yAxis.count[y];
+      m_rowPointers.resize(count);
+      for (int k = 0; k < count; k++) {
+        m_rowPointers[k] =
+          &m_rows[(size_t)(m_yAxis.first[y] + k - srcY0) * width];
+      }
+      const INT16 *weights = &m_yAxis.weights[m_yAxis.offset[y]];
+      if (m_isDirect) {
+        UINT32 *dstRow = (UINT32 *)dst->getBufferPtr(m_dstRect.left + dstX0,
+                                                     m_dstRect.top + y);
+        filterColumn(dstRow, &m_rowPointers.front(), weights, count, width);
+      } else {
+        filterColumn(&m_dstRow.front(), &m_rowPointers.front(), weights,
+                     count, width);
+        putDestinationRow(dst, dstX0, y, &m_dstRow.front(), width);
+      }
+    }
+  }
+}
+
+const UINT32 *FrameBufferScaler::getSourceRow(const FrameBuffer *src,
+                                              int srcX, int srcY, int count)
+{
+  const void *row = src->getBufferPtr(m_srcRect.left + srcX,
+                                      m_srcRect.top + srcY);
+  if (m_isDirect) {
+    return (const UINT32 *)row;
+  }
+  m_srcRow.resize(count);
+  switch (m_pf.bitsPerPixel) {
+  case 8:
+    expandRowT(&m_srcRow.front(), (const UINT8 *)row, count);
+    break;
+  case 16:
+    expandRowT(&m_srcRow.front(), (const UINT16 *)row, count);
+    break;
+  default:
+    expandRowT(&m_srcRow.front(), (const UINT32 *)row, count);
+    break;
+  }
+  return &m_srcRow.front();
+}
+
+void FrameBufferScaler::putDestinationRow(FrameBuffer *dst, int dstX,
+                                          int dstY, const UINT32 *pixels,
+                                          int count)
+{
+  void *row = dst->getBufferPtr(m_dstRect.left + dstX, m_dstRect.top + dstY);
+  switch (m_pf.bitsPerPixel) {
+  case 8:
+    packRowT((UINT8 *)row, pixels, count);
+    break;
+  case 16:
+    packRowT((UINT16 *)row, pixels, count);
+    break;
+  default:
+    packRowT((UINT32 *)row, pixels, count);
+    break;
+  }
+}
+
+template<class PIXEL_T>
+void FrameBufferScaler::expandRowT(UINT32 *dst, const PIXEL_T *src,
+                                   int count) const
+{
+  for (int i = 0; i < count; i++) {
+    UINT32 pixel = src[i];
+    dst[i] = (pixel >> m_pf.redShift & m_pf.redMax) |
+             (pixel >> m_pf.greenShift & m_pf.greenMax) << 8 |
+             (pixel >> m_pf.blueShift & m_pf.blueMax) << 16;
+  }
+}
+
+template<class PIXEL_T>
+void FrameBufferScaler::packRowT(PIXEL_T *dst, const UINT32 *src,
+                                 int count) const
+{
+  // Averages never exceed the maximums, so the channels don't overflow.
+  for (int i = 0; i < count; i++) {
+    UINT32 pixel = src[i];
+    dst[i] = (PIXEL_T)((pixel & 0xff) << m_pf.redShift |
+                       (pixel >> 8 & 0xff) << m_pf.greenShift |
+                       (pixel >> 16 & 0xff) << m_pf.blueShift);
+  }
+}
+
+void FrameBufferScaler::filterRow(UINT32 *dst, const UINT32 *src,
+                                  int srcBase, int dstX0, int dstX1) const
+{
+  if (m_hasSse2 && m_isSimdEnabled) {
+    filterRowSse2(dst, src, srcBase, &m_xAxis, dstX0, dstX1);
+  } else {
+    filterRowC(dst, src, srcBase, &m_xAxis, dstX0, dstX1);
+  }
+}
+
+void FrameBufferScaler::filterColumn(UINT32 *dst, const UINT32 *const *rows,
+                                     const INT16 *weights, int count,
+                                     int width) const
+{
+  if (m_hasSse2 && m_isSimdEnabled) {
+    filterColumnSse2(dst, rows, weights, count, width);
+  } else {
+    filterColumnC(dst, rows, weights, count, 0, width);
+  }
+}
+
+void FrameBufferScaler::filterRowC(UINT32 *dst, const UINT32 *src,
+                                   int srcBase, const Axis *axis,
+                                   int dstX0, int dstX1)
+{
+  for (int x = dstX0; x < dstX1; x++) {
+    const UINT32 *pixels = src + axis->first[x] - srcBase;
+    const INT16 *weights = &axis->weights[axis->offset[x]];
+    int count = axis->count[x];
+    UINT32 result = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+      int sum = WEIGHT_ONE / 2;
+      for (int k = 0; k < count; k++) {
+        sum += (int)(pixels[k] >> shift & 0xff) * weights[k];
+      }
+      result |= (UINT32)(sum >> WEIGHT_BITS) << shift;
+    }
+    *dst++ = result;
+  }
+}
+
+void FrameBufferScaler::filterColumnC(UINT32 *dst, const UINT32 *const *rows,
+                                      const INT16 *weights, int count,
+                                      int startX, int width)
+{
+  for (int x = startX; x < width; x++) {
+    UINT32 result = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+      int sum = WEIGHT_ONE / 2;
+      for (int k = 0; k < count; k++) {
+        sum += (int)(rows[k][x] >> shift & 0xff) * weights[k];
+      }
+      result |= (UINT32)(sum >> WEIGHT_BITS) << shift;
+    }
+    dst[x] = result;
+  }
+}
+
+//
+// The SSE2 kernels multiply pairs of 16-bit channel values by pairs of
+// weights with _mm_madd_epi16(), so each step accounts two taps for all
+// four channels of a pixel. An odd tap is paired with zero.
+//
+
+void FrameBufferScaler::filterRowSse2(UINT32 *dst, const UINT32 *src,
+                                      int srcBase, const Axis *axis,
+                                      int dstX0, int dstX1)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i rounding = _mm_set1_epi32(WEIGHT_ONE / 2);
+  for (int x = dstX0; x < dstX1; x++) {
+    const UINT32 *pixels = src + axis->first[x] - srcBase;
+    const INT16 *weights = &axis->weights[axis->offset[x]];
+    int count = axis->count[x];
+    __m128i sum = rounding;
+    int k = 0;
+    for (; k + 1 < count; k += 2) {
+      // Channels of the two pixels interleaved: a0 b0 a1 b1 a2 b2 a3 b3.
+      __m128i pair = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)pixels[k]),
+                                       _mm_cvtsi32_si128((int)pixels[k + 1]));
+      pair = _mm_unpacklo_epi8(pair, zero);
+      __m128i w = _mm_set1_epi32((UINT16)weights[k] |
+                                 (int)weights[k + 1] << 16);
+      sum = _mm_add_epi32(sum, _mm_madd_epi16(pair, w));
+    }
+    if (k < count) {
+      __m128i single = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)pixels[k]),
+                                         zero);
+      single = _mm_unpacklo_epi16(single, zero);
+      __m128i w = _mm_set1_epi32((UINT16)weights[k]);
+      sum = _mm_add_epi32(sum, _mm_madd_epi16(single, w));
+    }
+    sum = _mm_srai_epi32(sum, WEIGHT_BITS);
+    sum = _mm_packs_epi32(sum, sum);
+    sum = _mm_packus_epi16(sum, sum);
+    *dst++ = (UINT32)_mm_cvtsi128_si32(sum);
+  }
+}
+
+void FrameBufferScaler::filterColumnSse2(UINT32 *dst,
+                                         const UINT32 *const *rows,
+                                         const INT16 *weights, int count,
+                                         int width)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i rounding = _mm_set1_epi32(WEIGHT_ONE / 2);
+  int x = 0;
+  for (; x + 4 <= width; x += 4) {
+    // One sum of four channels per pixel.
+    __m128i sum0 = rounding;
+    __m128i sum1 = rounding;
+    __m128i sum2 = rounding;
+    __m128i sum3 = rounding;
+    int k = 0;
+    for (; k + 1 < count; k += 2) {
+      __m128i a = _mm_loadu_si128((const __m128i *)(rows[k] + x));
+      __m128i b = _mm_loadu_si128((const __m128i *)(rows[k + 1] + x));
+      __m128i w = _mm_set1_epi32((UINT16)weights[k] |
+                                 (int)weights[k + 1] << 16);
+      __m128i lo = _mm_unpacklo_epi8(a, b);
+      __m128i hi = _mm_unpackhi_epi8(a, b);
+      sum0 = _mm_add_epi32(sum0,
+                           _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), w));
+      sum1 = _mm_add_epi32(sum1,
+                           _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), w));
+      sum2 = _mm_add_epi32(sum2,
+                           _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), w));
+      sum3 = _mm_add_epi32(sum3,
+                           _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), w));
+    }
+    if (k < count) {
+      __m128i a = _mm_loadu_si128((const __m128i *)(rows[k] + x));
+      __m128i w = _mm_set1_epi32((UINT16)weights[k]);
+      __m128i lo = _mm_unpacklo_epi8(a, zero);
+      __m128i hi = _mm_unpackhi_epi8(a, zero);
+      sum0 = _mm_add_epi32(sum0,
+                           _mm_madd_epi16(_mm_unpacklo_epi16(lo, zero), w));
+      sum1 = _mm_add_epi32(sum1,
+                           _mm_madd_epi16(_mm_unpackhi_epi16(lo, zero), w));
+      sum2 = _mm_add_epi32(sum2,
+                           _mm_madd_epi16(_mm_unpacklo_epi16(hi, zero), w));
+      sum3 = _mm_add_epi32(sum3,
+                           _mm_madd_epi16(_mm_unpackhi_epi16(hi, zero), w));
+    }
+    __m128i pixels01 = _mm_packs_epi32(_mm_srai_epi32(sum0, WEIGHT_BITS),
+                                       _mm_srai_epi32(sum1, WEIGHT_BITS));
+    __m128i pixels23 = _mm_packs_epi32(_mm_srai_epi32(sum2, WEIGHT_BITS),
+                                       _mm_srai_epi32(sum3, WEIGHT_BITS));
+    _mm_storeu_si128((__m128i *)(dst + x),
+                     _mm_packus_epi16(pixels01, pixels23));
+  }
+  filterColumnC(dst, rows, weights, count, x, width);
+}
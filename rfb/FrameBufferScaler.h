@@ -0,0 +1,185 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef _FRAME_BUFFER_SCALER_H_
+#define _FRAME_BUFFER_SCALER_H_
+
+#include "util/CommonHeader.h"
+#include "util/inttypes.h"
+#include "FrameBuffer.h"
+#include "region/Rect.h"
+
+#include <vector>
+
+//
+// FrameBufferScaler resamples a rectangle of one frame buffer to a rectangle
+// of another size in a second frame buffer, which works as a cache of the
+// scaled picture. After the whole picture has been scaled once, only the
+// parts of the source which have changed are scaled again.
+//
+// The filters are separable: each row of the source is filtered
+// horizontally, then the filtered rows are combined vertically. Weights are
+// 14-bit fixed point numbers computed once for a geometry. Pixels are
+// processed as four 8-bit channels, so 32-bit frame buffers with 8-bit
+// channels are scaled in place with SSE2 where the processor supports it;
+// other formats are expanded to this form row by row.
+//
+// This class isn't thread-safe.
+//
+class FrameBufferScaler
+{
+public:
+  enum Filter {
+    // Plain average of the source pixels whose centers are covered by the
+    // destination pixel. Cheap, but aliases at fractional scales.
+    FILTER_BOX,
+    // Interpolation between two nearest source pixels in each direction.
+    // Suitable for scaling up, aliases when scaling down more than twice.
+    FILTER_BILINEAR,
+    // Average of the source area covered by the destination pixel, with
+    // the pixels on the edges weighted by their coverage. The best choice
+    // for scaling down.
+    FILTER_AREA
+  };
+
+  FrameBufferScaler();
+  virtual ~FrameBufferScaler();
+
+  //
+  // Returns true if frame buffers of the pixel format can be scaled.
+  //
+  static bool isSupportedFormat(const PixelFormat *pf);
+
+  //
+  // Sets the filter, the source rectangle, the destination rectangle it is
+  // scaled to and the pixel format of both frame buffers, which must be
+  // supported. Returns true if the geometry has been changed, in this case
+  // the caller must scale the whole source rectangle again.
+  //
+  bool setGeometry(Filter filter, const Rect *srcRect, const Rect *dstRect,
+                   const PixelFormat *pf);
+
+  //
+  // Scales the changed part of src to dst. The part of the destination
+  // rectangle which has been changed is stored to dstChanged, it is empty
+  // if srcChanged is out of the source rectangle.
+  //
+  void scale(const FrameBuffer *src, const Rect *srcChanged,
+             FrameBuffer *dst, Rect *dstChanged);
+
+  //
+  // Stores to dstChanged the part of the destination rectangle which
+  // scale() would change for srcChanged, without scaling anything.
+  //
+  void getDependentRect(const Rect *srcChanged, Rect *dstChanged) const;
+
+  //
+  // Allows or forbids the use of SIMD instructions (allowed by default).
+  // Used to compare the speed of the kernels.
+  //
+  void enableSimd(bool enabled);
+
+private:
+  // Weights of the source pixels for each destination pixel along one axis.
+  // Coordinates are relative to the source and destination rectangles.
+  struct Axis
+  {
+    void build(Filter filter, int srcLength, int dstLength);
+
+    // Finds the range of destination pixels [*dstFirst, *dstEnd) which
+    // depend on the source pixels [srcFirst, srcEnd).
+    void getDependentRange(int srcFirst, int srcEnd,
+                           int *dstFirst, int *dstEnd) const;
+
+    std::vector<int> first;
+    std::vector<int> count;
+    std::vector<size_t> offset;
+    std::vector<INT16> weights;
+  };
+
+  // Scales the destination pixels [dstX0, dstX1) x [dstY0, dstY1).
+  void scaleRect(const FrameBuffer *src, FrameBuffer *dst,
+                 int dstX0, int dstX1, int dstY0, int dstY1);
+
+  // Returns count pixels of the source row starting at srcX (relative to
+  // the source rectangle) as four 8-bit channels.
+  const UINT32 *getSourceRow(const FrameBuffer *src, int srcX, int srcY,
+                             int count);
+  // Stores count pixels of four 8-bit channels to the destination row.
+  void putDestinationRow(FrameBuffer *dst, int dstX, int dstY,
+                         const UINT32 *pixels, int count);
+
+  template<class PIXEL_T>
+  void expandRowT(UINT32 *dst, const PIXEL_T *src, int count) const;
+  template<class PIXEL_T>
+  void packRowT(PIXEL_T *dst, const UINT32 *src, int count) const;
+
+  // Filter kernels. src of filterRow() points to the source pixel srcBase.
+  void filterRow(UINT32 *dst, const UINT32 *src, int srcBase,
+                 int dstX0, int dstX1) const;
+  void filterColumn(UINT32 *dst, const UINT32 *const *rows,
+                    const INT16 *weights, int count, int width) const;
+  static void filterRowC(UINT32 *dst, const UINT32 *src, int srcBase,
+                         const Axis *axis, int dstX0, int dstX1);
+  // Processes the pixels [startX, width), so it also finishes rows for
+  // the SIMD kernel.
+  static void filterColumnC(UINT32 *dst, const UINT32 *const *rows,
+                            const INT16 *weights, int count,
+                            int startX, int width);
+  static void filterRowSse2(UINT32 *dst, const UINT32 *src, int srcBase,
+                            const Axis *axis, int dstX0, int dstX1);
+  static void filterColumnSse2(UINT32 *dst, const UINT32 *const *rows,
+                               const INT16 *weights, int count, int width);
+
+  static bool detectSse2();
+
+  static const bool m_hasSse2;
+
+  static const int WEIGHT_BITS = 14;
+  static const int WEIGHT_ONE = 1 << WEIGHT_BITS;
+  // Number of destination rows scaled together. Limits the size of the
+  // buffer of horizontally filtered rows.
+  static const int BAND_ROWS = 32;
+
+  bool m_isSimdEnabled;
+
+  Filter m_filter;
+  Rect m_srcRect;
+  Rect m_dstRect;
+  PixelFormat m_pf;
+  // True if the frame buffers keep four 8-bit channels in 32-bit pixels,
+  // so no expanding and packing of rows is needed.
+  bool m_isDirect;
+
+  Axis m_xAxis;
+  Axis m_yAxis;
+
+  // Horizontally filtered source rows of the current band.
+  std::vector<UINT32> m_rows;
+  std::vector<const UINT32 *> m_rowPointers;
+  // Expanded source row and the destination row before packing.
+  std::vector<UINT32> m_srcRow;
+  std::vector<UINT32> m_dstRow;
+};
+
+#endif
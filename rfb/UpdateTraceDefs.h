@@ -0,0 +1,79 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __RFB_UPDATE_TRACE_DEFS_H_INCLUDED__
+#define __RFB_UPDATE_TRACE_DEFS_H_INCLUDED__
+
+//
+// Definitions for update trace files written by the server-side update
+// recorder (see UpdateRecorder in the desktop library) and read by
+// UpdateTraceReader.
+//
+// A trace file starts with an 8-byte signature and a UINT32 version number.
+// The rest of the file is a sequence of chunks, each one is a UINT8 chunk
+// type followed by UINT32 payload length and the payload itself. Readers
+// must skip chunks of unknown types. All integers are in network byte order.
+//
+// CHUNK_FORMAT payload:
+//   UINT16  frame buffer width and height
+//   UINT8   bits per pixel, color depth, big endian flag
+//   UINT16  red max, green max, blue max
+//   UINT8   red shift, green shift, blue shift
+//
+// CHUNK_UPDATE payload:
+//   UINT32  milliseconds since the start of the recording
+//   UINT8   flags (FLAG_* below)
+//   INT32   cursor position x, y
+//   INT32   copy source x, y
+//   region  changed region, copied region, video region; each one is
+//           a UINT32 number of rectangles followed by UINT16 x, y, width
+//           and height for each rectangle
+//   pixels  for each rectangle of the changed region, its pixels in the
+//           frame buffer pixel format, row by row
+//
+// Every update chunk applies to the frame buffer with the dimension and the
+// pixel format from the most recent format chunk. The copied region should
+// be moved from the copy source first, then the changed pixels overwrite
+// the frame buffer.
+//
+
+class UpdateTraceDefs
+{
+public:
+  static const char *const SIGNATURE;
+  static const int SIGNATURE_LENGTH = 8;
+  static const int VERSION = 1;
+
+  static const int CHUNK_FORMAT = 1;
+  static const int CHUNK_UPDATE = 2;
+
+  static const int FLAG_SCREEN_SIZE_CHANGED = 0x01;
+  static const int FLAG_CURSOR_POS_CHANGED = 0x02;
+  static const int FLAG_CURSOR_SHAPE_CHANGED = 0x04;
+  // The changed region covers the whole frame buffer because some updates
+  // were dropped by the recorder before this one.
+  static const int FLAG_KEY_FRAME = 0x08;
+};
+
+#endif // __RFB_UPDATE_TRACE_DEFS_H_INCLUDED__
@@ -0,0 +1,184 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "UpdateTraceReader.h"
+
+#include "file-lib/EOFException.h"
+#include "util/Exception.h"
+
+UpdateTraceReader::UpdateTraceReader(InputStream *input)
+: m_input(input),
+  m_formatChanged(false)
+{
+  char signature[UpdateTraceDefs::SIGNATURE_LENGTH];
+  m_input.readFully(signature, sizeof(signature));
+  if (memcmp(signature, UpdateTraceDefs::SIGNATURE, sizeof(signature)) != 0) {
+    throw Exception(_T("Not an update trace file"));
+  }
+  UINT32 version = m_input.readUInt32();
+  if (version != UpdateTraceDefs::VERSION) {
+    StringStorage errMess;
+    errMess.format(_T("Unsupported update trace version: %u"), version);
+    throw Exception(errMess.getString());
+  }
+
+  int type;
+  UINT32 length;
+  if (!readChunkHeader(&type, &length) ||
+      type != UpdateTraceDefs::CHUNK_FORMAT) {
+    throw Exception(_T("The update trace does not start with a format chunk"));
+  }
+  readFormat();
+}
+
+UpdateTraceReader::~UpdateTraceReader()
+{
+}
+
+Dimension UpdateTraceReader::getDimension() const
+{
+  return m_dim;
+}
+
+PixelFormat UpdateTraceReader::getPixelFormat() const
+{
+  return m_pf;
+}
+
+bool UpdateTraceReader::readUpdate(UpdateTraceRecord *record, FrameBuffer *fb)
+{
+  int type;
+  UINT32 length;
+  while (true) {
+    if (!readChunkHeader(&type, &length)) {
+      return false;
+    }
+    if (type == UpdateTraceDefs::CHUNK_UPDATE) {
+      break;
+    } else if (type == UpdateTraceDefs::CHUNK_FORMAT) {
+      readFormat();
+    } else {
+      skip(length);
+    }
+  }
+
+  record->timestamp = m_input.readUInt32();
+  record->flags = m_input.readUInt8();
+  record->cursorPos.x = m_input.readInt32();
+  record->cursorPos.y = m_input.readInt32();
+  record->copySrc.x = m_input.readInt32();
+  record->copySrc.y = m_input.readInt32();
+  readRegion(&record->changedRegion, &m_changedRects);
+  readRegion(&record->copiedRegion, &m_copiedRects);
+  readRegion(&record->videoRegion, &m_videoRects);
+  record->formatChanged = m_formatChanged;
+  m_formatChanged = false;
+
+  PixelFormat fbPf = fb->getPixelFormat();
+  if (!fb->getDimension().isEqualTo(&m_dim) || !fbPf.isEqualTo(&m_pf)) {
+    fb->setProperties(&m_dim, &m_pf);
+  }
+
+  // Reproduce CopyRect operations the same way UpdateFilter does.
+  Rect fbRect = m_dim.getRect();
+  std::vector<Rect>::iterator it;
+  for (it = m_copiedRects.begin(); it < m_copiedRects.end(); it++) {
+    if (!fbRect.isFullyContainRect(&*it)) {
+      throw Exception(_T("A copied rectangle is out of the frame buffer"));
+    }
+    fb->move(&*it, record->copySrc.x, record->copySrc.y);
+  }
+
+  size_t pixelSize = m_pf.bitsPerPixel / 8;
+  for (it = m_changedRects.begin(); it < m_changedRects.end(); it++) {
+    if (!fbRect.isFullyContainRect(&*it)) {
+      throw Exception(_T("A changed rectangle is out of the frame buffer"));
+    }
+    size_t rowSize = it->getWidth() * pixelSize;
+    for (int y = it->top; y < it->bottom; y++) {
+      m_input.readFully(fb->getBufferPtr(it->left, y), rowSize);
+    }
+  }
+  return true;
+}
+
+bool UpdateTraceReader::readChunkHeader(int *type, UINT32 *length)
+{
+  try {
+    *type = m_input.readUInt8();
+  } catch (EOFException &) {
+    return false;
+  }
+  *length = m_input.readUInt32();
+  return true;
+}
+
+void UpdateTraceReader::readFormat()
+{
+  int width = m_input.readUInt16();
+  int height = m_input.readUInt16();
+  m_dim.setDim(width, height);
+
+  m_pf.bitsPerPixel = m_input.readUInt8();
+  m_pf.colorDepth = m_input.readUInt8();
+  m_pf.bigEndian = m_input.readUInt8() != 0;
+  m_pf.redMax = m_input.readUInt16();
+  m_pf.greenMax = m_input.readUInt16();
+  m_pf.blueMax = m_input.readUInt16();
+  m_pf.redShift = m_input.readUInt8();
+  m_pf.greenShift = m_input.readUInt8();
+  m_pf.blueShift = m_input.readUInt8();
+
+  if (m_pf.bitsPerPixel != 8 && m_pf.bitsPerPixel != 16 &&
+      m_pf.bitsPerPixel != 32) {
+    throw Exception(_T("Unsupported pixel format in the update trace"));
+  }
+  m_formatChanged = true;
+}
+
+void UpdateTraceReader::readRegion(Region *region, std::vector<Rect> *rects)
+{
+  region->clear();
+  rects->clear();
+  UINT32 numRects = m_input.readUInt32();
+  for (UINT32 i = 0; i < numRects; i++) {
+    Rect r;
+    r.left = m_input.readUInt16();
+    r.top = m_input.readUInt16();
+    r.setWidth(m_input.readUInt16());
+    r.setHeight(m_input.readUInt16());
+    region->addRect(&r);
+    rects->push_back(r);
+  }
+}
+
+void UpdateTraceReader::skip(UINT32 length)
+{
+  char buffer[1024];
+  while (length != 0) {
+    size_t portion = min(length, (UINT32)sizeof(buffer));
+    m_input.readFully(buffer, portion);
+    length -= (UINT32)portion;
+  }
+}
@@ -0,0 +1,89 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __RFB_UPDATE_TRACE_READER_H_INCLUDED__
+#define __RFB_UPDATE_TRACE_READER_H_INCLUDED__
+
+#include <vector>
+
+#include "io-lib/DataInputStream.h"
+#include "region/Region.h"
+#include "region/Point.h"
+#include "FrameBuffer.h"
+#include "UpdateTraceDefs.h"
+
+// One update read from a trace file, see UpdateTraceDefs.h.
+struct UpdateTraceRecord
+{
+  UINT32 timestamp;
+  Region changedRegion;
+  Region copiedRegion;
+  Region videoRegion;
+  Point copySrc;
+  Point cursorPos;
+  int flags;
+  // True if the frame buffer properties have changed before this update.
+  bool formatChanged;
+};
+
+// Reads update trace files and replays them into a frame buffer.
+class UpdateTraceReader
+{
+public:
+  // Reads the file header and the first format chunk from the input
+  // stream. Throws Exception if that's not a trace file of a known version.
+  UpdateTraceReader(InputStream *input);
+  virtual ~UpdateTraceReader();
+
+  // Return the current frame buffer properties.
+  Dimension getDimension() const;
+  PixelFormat getPixelFormat() const;
+
+  // Read the next update and apply it to the frame buffer. The frame buffer
+  // is resized to the current properties if needed, so the same frame
+  // buffer must be passed on each call to get a correct picture. Return
+  // false at the end of the trace.
+  bool readUpdate(UpdateTraceRecord *record, FrameBuffer *fb);
+
+protected:
+  // Read the type and the length of the next chunk. Return false at the
+  // end of the file.
+  bool readChunkHeader(int *type, UINT32 *length);
+  void readFormat();
+  // Read a region into both *region and *rects, the latter keeps the order
+  // of rectangles as they were written.
+  void readRegion(Region *region, std::vector<Rect> *rects);
+  void skip(UINT32 length);
+
+  DataInputStream m_input;
+  Dimension m_dim;
+  PixelFormat m_pf;
+  // Set by readFormat(), cleared when the next update is returned.
+  bool m_formatChanged;
+  std::vector<Rect> m_changedRects;
+  std::vector<Rect> m_copiedRects;
+  std::vector<Rect> m_videoRects;
+};
+
+#endif // __RFB_UPDATE_TRACE_READER_H_INCLUDED__
@@ -582,6 +582,24 @@ bool Configurator::saveServerConfig(SettingsManager *sm)
   if (!sm->setBoolean(_T("RunControlInterface"), m_serverConfig.getShowTrayIconFlag())) {
     saveResult = false;
   }
+  if (!sm->setBoolean(_T("ParallelTightCompression"), m_serverConfig.isParallelTightCompressionEnabled())) {
+    saveResult = false;
+  }
+  if (!sm->setUINT(_T("JpegEncoderThreads"), m_serverConfig.getJpegEncoderThreadCount())) {
+    saveResult = false;
+  }
+  if (!sm->setUINT(_T("LosslessRefinementDelay"), m_serverConfig.getLosslessRefinementDelay())) {
+    saveResult = false;
+  }
+  if (!sm->setBoolean(_T("RecordUpdates"), m_serverConfig.isUpdateRecordingEnabled())) {
+    saveResult = false;
+  }
+  if (!sm->setUINT(_T("SyntheticScreenWorkload"), m_serverConfig.getSyntheticScreenWorkload())) {
+    saveResult = false;
+  }
+  if (!sm->setBoolean(_T("TraceEvents"), m_serverConfig.isTracingEnabled())) {
+    saveResult = false;
+  }
   return saveResult;
 }
 
@@ -761,6 +779,42 @@ bool Configurator::loadServerConfig(SettingsManager *sm, ServerConfig *config)
     m_isConfigLoadedPartly = true;
     m_serverConfig.setShowTrayIconFlag(boolVal);
   }
+  if (!sm->getBoolean(_T("ParallelTightCompression"), &boolVal)) {
+    loadResult = false;
+  } else {
+    m_isConfigLoadedPartly = true;
+    m_serverConfig.enableParallelTightCompression(boolVal);
+  }
+  if (!sm->getUINT(_T("JpegEncoderThreads"), &uintVal)) {
+    loadResult = false;
+  } else {
+    m_isConfigLoadedPartly = true;
+    m_serverConfig.setJpegEncoderThreadCount(uintVal);
+  }
+  if (!sm->getUINT(_T("LosslessRefinementDelay"), &uintVal)) {
+    loadResult = false;
+  } else {
+    m_isConfigLoadedPartly = true;
+    m_serverConfig.setLosslessRefinementDelay(uintVal);
+  }
+  if (!sm->getBoolean(_T("RecordUpdates"), &boolVal)) {
+    loadResult = false;
+  } else {
+    m_isConfigLoadedPartly = true;
+    m_serverConfig.setUpdateRecordingEnabled(boolVal);
+  }
+  if (!sm->getUINT(_T("SyntheticScreenWorkload"), &uintVal)) {
+    loadResult = false;
+  } else {
+    m_isConfigLoadedPartly = true;
+    m_serverConfig.setSyntheticScreenWorkload(uintVal);
+  }
+  if (!sm->getBoolean(_T("TraceEvents"), &boolVal)) {
+    loadResult = false;
+  } else {
+    m_isConfigLoadedPartly = true;
+    m_serverConfig.setTracingEnabled(boolVal);
+  }
   updateLogDirPath();
   return loadResult;
 }
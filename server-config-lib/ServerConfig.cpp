@@ -44,7 +44,13 @@ ServerConfig::ServerConfig()
   m_allowLoopbackConnections(false),
   m_videoRecognitionInterval(3000), m_grabTransparentWindows(true),
   m_saveLogToAllUsersPath(false), m_hasControlPassword(false),
-  m_showTrayIcon(true)
+  m_showTrayIcon(true),
+  m_parallelTightCompression(false),
+  m_jpegEncoderThreads(1),
+  m_losslessRefinementDelay(0),
+  m_recordUpdates(false),
+  m_syntheticScreenWorkload(0),
+  m_traceEvents(false)
 {
   memset(m_primaryPassword,  0, sizeof(m_primaryPassword));
   memset(m_readonlyPassword, 0, sizeof(m_readonlyPassword));
@@ -109,6 +115,12 @@ void ServerConfig::serialize(DataOutputStream *output)
   output->writeInt8(m_showTrayIcon ? 1 : 0);
 
   output->writeUTF8(m_logFilePath.getString());
+  output->writeInt8(m_parallelTightCompression ? 1 : 0);
+  output->writeUInt32(m_jpegEncoderThreads);
+  output->writeUInt32(m_losslessRefinementDelay);
+  output->writeInt8(m_recordUpdates ? 1 : 0);
+  output->writeUInt32(m_syntheticScreenWorkload);
+  output->writeInt8(m_traceEvents ? 1 : 0);
 }
 
 void ServerConfig::deserialize(DataInputStream *input)
@@ -167,6 +179,12 @@ void ServerConfig::deserialize(DataInputStream *input)
   m_showTrayIcon = input->readInt8() == 1;
 
   input->readUTF8(&m_logFilePath);
+  m_parallelTightCompression = input->readInt8() == 1;
+  m_jpegEncoderThreads = input->readUInt32();
+  m_losslessRefinementDelay = input->readUInt32();
+  m_recordUpdates = input->readInt8() == 1;
+  m_syntheticScreenWorkload = input->readUInt32();
+  m_traceEvents = input->readInt8() == 1;
 }
 
 bool ServerConfig::getShowTrayIconFlag()
@@ -697,3 +715,75 @@ bool ServerConfig::getGrabTransparentWindowsFlag()
   AutoLock lock(&m_objectCS);
   return m_grabTransparentWindows;
 }
+
+bool ServerConfig::isParallelTightCompressionEnabled()
+{
+  AutoLock lock(&m_objectCS);
+  return m_parallelTightCompression;
+}
+
+void ServerConfig::enableParallelTightCompression(bool value)
+{
+  AutoLock lock(&m_objectCS);
+  m_parallelTightCompression = value;
+}
+
+unsigned int ServerConfig::getJpegEncoderThreadCount()
+{
+  AutoLock lock(&m_objectCS);
+  return m_jpegEncoderThreads;
+}
+
+void ServerConfig::setJpegEncoderThreadCount(unsigned int value)
+{
+  AutoLock lock(&m_objectCS);
+  m_jpegEncoderThreads = value;
+}
+
+unsigned int ServerConfig::getLosslessRefinementDelay()
+{
+  AutoLock lock(&m_objectCS);
+  return m_losslessRefinementDelay;
+}
+
+void ServerConfig::setLosslessRefinementDelay(unsigned int value)
+{
+  AutoLock lock(&m_objectCS);
+  m_losslessRefinementDelay = value;
+}
+
+bool ServerConfig::isUpdateRecordingEnabled()
+{
+  AutoLock lock(&m_objectCS);
+  return m_recordUpdates;
+}
+
+void ServerConfig::setUpdateRecordingEnabled(bool value)
+{
+  AutoLock lock(&m_objectCS);
+  m_recordUpdates = value;
+}
+
+unsigned int ServerConfig::getSyntheticScreenWorkload()
+{
+  AutoLock lock(&m_objectCS);
+  return m_syntheticScreenWorkload;
+}
+
+void ServerConfig::setSyntheticScreenWorkload(unsigned int value)
+{
+  AutoLock lock(&m_objectCS);
+  m_syntheticScreenWorkload = value;
+}
+
+bool ServerConfig::isTracingEnabled()
+{
+  AutoLock lock(&m_objectCS);
+  return m_traceEvents;
+}
+
+void ServerConfig::setTracingEnabled(bool value)
+{
+  AutoLock lock(&m_objectCS);
+  m_traceEvents = value;
+}
@@ -271,6 +271,28 @@ public:
 
   void getLogFileDir(StringStorage *logFileDir);
   void setLogFileDir(const TCHAR *logFileDir);
+
+  //
+  // Performance tuning options
+  //
+
+  bool isParallelTightCompressionEnabled();
+  void enableParallelTightCompression(bool value);
+
+  unsigned int getJpegEncoderThreadCount();
+  void setJpegEncoderThreadCount(unsigned int value);
+
+  unsigned int getLosslessRefinementDelay();
+  void setLosslessRefinementDelay(unsigned int value);
+
+  bool isUpdateRecordingEnabled();
+  void setUpdateRecordingEnabled(bool value);
+
+  unsigned int getSyntheticScreenWorkload();
+  void setSyntheticScreenWorkload(unsigned int value);
+
+  bool isTracingEnabled();
+  void setTracingEnabled(bool value);
 protected:
 
   //
@@ -395,6 +417,33 @@ protected:
   bool m_showTrayIcon;
 
   StringStorage m_logFilePath;
+
+  //
+  // Performance tuning options
+  //
+
+  // Compress different zlib streams of Tight encoder in parallel threads.
+  bool m_parallelTightCompression;
+
+  // Number of threads used to compress JPEG (video) rectangles, 1 means
+  // no additional threads.
+  unsigned int m_jpegEncoderThreads;
+
+  // Time in milliseconds after the last lossy (JPEG) update before areas sent
+  // with lossy compression are resent losslessly, 0 disables refinement.
+  unsigned int m_losslessRefinementDelay;
+
+  // Write all updates seen by the desktop server to a trace file in the log
+  // directory (for performance analysis).
+  bool m_recordUpdates;
+
+  // Use a synthetic 1920x1080 desktop with the given workload instead of the
+  // real screen (see SyntheticScreenDriver::Workload), 0 means the real screen.
+  unsigned int m_syntheticScreenWorkload;
+
+  // Collect timings of the update pipeline stages in memory so they can be
+  // exported with "tvnserver -controlapp -dumptrace" (for performance analysis).
+  bool m_traceEvents;
 private:
 
   //
@@ -0,0 +1,133 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "ClientStatisticsCommand.h"
+
+#include "util/AnsiStringStorage.h"
+#include "file-lib/WinFile.h"
+
+ClientStatisticsCommand::ClientStatisticsCommand(ControlProxy *serverControl,
+                                                 const TCHAR *reportFile)
+: m_proxy(serverControl),
+  m_reportFile(reportFile)
+{
+}
+
+ClientStatisticsCommand::~ClientStatisticsCommand()
+{
+}
+
+void ClientStatisticsCommand::execute()
+{
+  RfbClientStatisticsList clients;
+  m_proxy->getClientsStatistics(&clients);
+
+  StringStorage report;
+  report.format(_T("Clients: %u\r\n"), (unsigned int)clients.size());
+  for (RfbClientStatisticsList::const_iterator iter = clients.begin();
+       iter != clients.end(); iter++) {
+    formatClient(&(*iter), &report);
+  }
+
+  // Errors of the report file are reported the same way as the control
+  // transport errors: the command just fails.
+  try {
+    AnsiStringStorage ansiReport(&report);
+    WinFile file(m_reportFile.getString(), F_WRITE, FM_CREATE);
+    file.write(ansiReport.getString(), ansiReport.getLength());
+  } catch (Exception &e) {
+    throw IOException(e.getMessage());
+  }
+}
+
+void ClientStatisticsCommand::formatClient(const RfbClientStatistics *client,
+                                           StringStorage *out)
+{
+  const UpdateStatistics *stats = &client->m_statistics;
+
+  StringStorage line;
+  line.format(_T("\r\nClient %u (%s), %.1f s\r\n"),
+              (unsigned int)client->m_id,
+              client->m_peerAddr.getString(),
+              (double)stats->duration / 1000000.0);
+  out->appendString(line.getString());
+
+  line.format(_T("  updates: %I64u, %.2f per second\r\n")
+              _T("  bytes: %I64u, %.1f KB per second\r\n")
+              _T("  rects: %I64u\r\n"),
+              stats->numUpdates, stats->getUpdatesPerSecond(),
+              stats->numBytes, stats->getBytesPerSecond() / 1024.0,
+              stats->numRects);
+  out->appendString(line.getString());
+
+  line.format(_T("  update size (bytes): mean %.0f, p50 %I64u, p95 %I64u, ")
+              _T("max %I64u\r\n"),
+              stats->updateBytes.getMean(),
+              stats->updateBytes.getPercentile(50),
+              stats->updateBytes.getPercentile(95),
+              stats->updateBytes.getMax());
+  out->appendString(line.getString());
+
+  line.format(_T("  update rects: mean %.1f, p50 %I64u, p95 %I64u, ")
+              _T("max %I64u\r\n"),
+              stats->updateRects.getMean(),
+              stats->updateRects.getPercentile(50),
+              stats->updateRects.getPercentile(95),
+              stats->updateRects.getMax());
+  out->appendString(line.getString());
+
+  line.format(_T("  request latency (us): mean %.0f, p50 %I64u, p95 %I64u, ")
+              _T("max %I64u\r\n"),
+              stats->latency.getMean(),
+              stats->latency.getPercentile(50),
+              stats->latency.getPercentile(95),
+              stats->latency.getMax());
+  out->appendString(line.getString());
+
+  line.format(_T("  flush time (us): mean %.0f, p50 %I64u, p95 %I64u, ")
+              _T("max %I64u\r\n"),
+              stats->flushTime.getMean(),
+              stats->flushTime.getPercentile(50),
+              stats->flushTime.getPercentile(95),
+              stats->flushTime.getMax());
+  out->appendString(line.getString());
+
+  line.format(_T("  refinement: pending lossy area %I64u pixels, ")
+              _T("rects %I64u, bytes %I64u\r\n"),
+              stats->pendingLossyArea, stats->numRefinementRects,
+              stats->refinementBytes);
+  out->appendString(line.getString());
+
+  for (int i = 0; i < UpdateStatistics::NUM_RECT_TYPES; i++) {
+    const UpdateStatistics::EncodingStatistics *enc = &stats->encodings[i];
+    if (enc->numRects == 0) {
+      continue;
+    }
+    line.format(_T("  %-8s rects %I64u, pixels %I64u, bytes %I64u, ")
+                _T("encode %I64u us\r\n"),
+                UpdateStatistics::getRectTypeName(i),
+                enc->numRects, enc->numPixels, enc->numBytes,
+                enc->encodeTime);
+    out->appendString(line.getString());
+  }
+}
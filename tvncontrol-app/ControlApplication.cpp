@@ -29,6 +29,8 @@
 #include "ControlCommand.h"
 #include "ReloadConfigCommand.h"
 #include "DisconnectAllCommand.h"
+#include "ClientStatisticsCommand.h"
+#include "DumpTraceCommand.h"
 #include "SharePrimaryCommand.h"
 #include "ShareDisplayCommand.h"
 #include "ShareWindowCommand.h"
@@ -192,6 +194,20 @@ int ControlApplication::run()
       command = new ConnectCommand(m_serverControl, hostName.getString());
     } else if (cmdLineParser.hasShutdownFlag()) {
       command = new ShutdownCommand(m_serverControl);
+    } else if (cmdLineParser.hasClientStatisticsFlag()) {
+      StringStorage reportFile;
+      cmdLineParser.getClientStatisticsFile(&reportFile);
+      command = new ClientStatisticsCommand(m_serverControl,
+                                            reportFile.getString());
+    } else if (cmdLineParser.hasDumpTraceFlag()) {
+      StringStorage traceFile;
+      cmdLineParser.getDumpTraceFile(&traceFile);
+      unsigned int seconds = DumpTraceCommand::DEFAULT_TRACE_SECONDS;
+      if (cmdLineParser.hasTraceSecondsFlag()) {
+        seconds = cmdLineParser.getTraceSeconds();
+      }
+      command = new DumpTraceCommand(m_serverControl, traceFile.getString(),
+                                     seconds);
     } else if (cmdLineParser.hasSharePrimaryFlag()) {
       command = new SharePrimaryCommand(m_serverControl);
     } else if (cmdLineParser.hasShareDisplay()) {
@@ -42,6 +42,9 @@ const TCHAR ControlCommandLine::CONFIG_RELOAD[]  = _T("-reload");
 const TCHAR ControlCommandLine::DISCONNECT_ALL[] = _T("-disconnectall");
 const TCHAR ControlCommandLine::CONNECT[] = _T("-connect");
 const TCHAR ControlCommandLine::SHUTDOWN[] = _T("-shutdown");
+const TCHAR ControlCommandLine::CLIENT_STATISTICS[] = _T("-clientstats");
+const TCHAR ControlCommandLine::DUMP_TRACE[] = _T("-dumptrace");
+const TCHAR ControlCommandLine::TRACE_SECONDS[] = _T("-traceseconds");
 const TCHAR ControlCommandLine::SHARE_PRIMARY[] = _T("-shareprimary");
 const TCHAR ControlCommandLine::SHARE_RECT[] = _T("-sharerect");
 const TCHAR ControlCommandLine::SHARE_DISPLAY[] = _T("-sharedisplay");
@@ -57,7 +60,8 @@ const TCHAR ControlCommandLine::SLAVE_MODE[] = _T("-slave");
 const TCHAR ControlCommandLine::DONT_ELEVATE[] = _T("-dontelevate");
 
 ControlCommandLine::ControlCommandLine()
-: m_displayNumber(0),
+: m_traceSeconds(0),
+  m_displayNumber(0),
   m_sharedAppProcessId(0)
 {
 }
@@ -74,6 +78,9 @@ void ControlCommandLine::parse(const CommandLineArgs *cmdArgs)
     { DISCONNECT_ALL, NO_ARG },
     { CONNECT, NEEDS_ARG },
     { SHUTDOWN, NO_ARG },
+    { CLIENT_STATISTICS, NEEDS_ARG },
+    { DUMP_TRACE, NEEDS_ARG },
+    { TRACE_SECONDS, NEEDS_ARG },
     { SET_PRIMARY_VNC_PASSWORD, NEEDS_ARG },
     { SET_CONTROL_PASSWORD, NEEDS_ARG },
     { CHECK_SERVICE_PASSWORDS, NO_ARG },
@@ -138,6 +145,24 @@ void ControlCommandLine::parse(const CommandLineArgs *cmdArgs)
     optionSpecified(CONNECT, &m_connectHostName);
   }
 
+  if (hasClientStatisticsFlag()) {
+    optionSpecified(CLIENT_STATISTICS, &m_clientStatisticsFile);
+  }
+
+  if (hasDumpTraceFlag()) {
+    optionSpecified(DUMP_TRACE, &m_dumpTraceFile);
+  }
+
+  // The period of the trace makes sense only for -dumptrace.
+  if (hasTraceSecondsFlag()) {
+    if (!hasDumpTraceFlag()) {
+      throw CommandLineFormatException();
+    }
+    StringStorage strSeconds;
+    optionSpecified(TRACE_SECONDS, &strSeconds);
+    parseTraceSeconds(&strSeconds);
+  }
+
   if ((hasSetVncPasswordFlag() || hasSetControlPasswordFlag()) && m_foundKeys.size() > 1) {
     throw CommandLineFormatException();
   } else {
@@ -195,6 +220,36 @@ bool ControlCommandLine::hasShutdownFlag()
   return optionSpecified(SHUTDOWN);
 }
 
+bool ControlCommandLine::hasClientStatisticsFlag()
+{
+  return optionSpecified(CLIENT_STATISTICS);
+}
+
+void ControlCommandLine::getClientStatisticsFile(StringStorage *fileName) const
+{
+  *fileName = m_clientStatisticsFile;
+}
+
+bool ControlCommandLine::hasDumpTraceFlag()
+{
+  return optionSpecified(DUMP_TRACE);
+}
+
+void ControlCommandLine::getDumpTraceFile(StringStorage *fileName) const
+{
+  *fileName = m_dumpTraceFile;
+}
+
+bool ControlCommandLine::hasTraceSecondsFlag()
+{
+  return optionSpecified(TRACE_SECONDS);
+}
+
+unsigned int ControlCommandLine::getTraceSeconds() const
+{
+  return m_traceSeconds;
+}
+
 bool ControlCommandLine::hasSetVncPasswordFlag()
 {
   return optionSpecified(SET_PRIMARY_VNC_PASSWORD);
@@ -305,7 +360,8 @@ bool ControlCommandLine::isCommandSpecified()
   return hasKillAllFlag() || hasReloadFlag() || hasSetControlPasswordFlag() ||
          hasSetVncPasswordFlag() || hasConnectFlag() || hasShutdownFlag() ||
          hasSharePrimaryFlag() || hasShareDisplay() || hasShareWindow() ||
-         hasShareRect() || hasShareFull() || hasShareApp();
+         hasShareRect() || hasShareFull() || hasShareApp() ||
+         hasClientStatisticsFlag() || hasDumpTraceFlag();
 }
 
 void ControlCommandLine::parseRectCoordinates(const StringStorage *strCoord)
@@ -335,3 +391,14 @@ void ControlCommandLine::parseProcessId(const StringStorage *str)
     throw Exception(errMess.getString());
   }
 }
+
+void ControlCommandLine::parseTraceSeconds(const StringStorage *str)
+{
+  if (!StringParser::parseUInt(str->getString(), &m_traceSeconds) ||
+      m_traceSeconds == 0) {
+    StringStorage errMess;
+    errMess.format(_T("Can't parse the %s argument to a number of seconds"),
+                   str->getString());
+    throw Exception(errMess.getString());
+  }
+}
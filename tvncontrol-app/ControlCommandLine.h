@@ -43,6 +43,9 @@ public:
   static const TCHAR DISCONNECT_ALL[];
   static const TCHAR CONNECT[];
   static const TCHAR SHUTDOWN[];
+  static const TCHAR CLIENT_STATISTICS[];
+  static const TCHAR DUMP_TRACE[];
+  static const TCHAR TRACE_SECONDS[];
   static const TCHAR SHARE_PRIMARY[];
   static const TCHAR SHARE_RECT[];
   static const TCHAR SHARE_DISPLAY[];
@@ -70,6 +73,12 @@ public:
   bool hasConnectFlag();
   void getConnectHostName(StringStorage *hostName) const;
   bool hasShutdownFlag();
+  bool hasClientStatisticsFlag();
+  void getClientStatisticsFile(StringStorage *fileName) const;
+  bool hasDumpTraceFlag();
+  void getDumpTraceFile(StringStorage *fileName) const;
+  bool hasTraceSecondsFlag();
+  unsigned int getTraceSeconds() const;
   bool hasSetVncPasswordFlag();
   bool hasSetControlPasswordFlag();
   bool hasCheckServicePasswords();
@@ -100,12 +109,16 @@ private:
   void parseRectCoordinates(const StringStorage *strCoord);
   void parseDisplayNumber(const StringStorage *strDispNumber);
   void parseProcessId(const StringStorage *str);
+  void parseTraceSeconds(const StringStorage *str);
 
   StringStorage m_vncPassword;
   StringStorage m_controlPassword;
 
   StringStorage m_connectHostName;
   StringStorage m_passwordFile;
+  StringStorage m_clientStatisticsFile;
+  StringStorage m_dumpTraceFile;
+  unsigned int m_traceSeconds;
 
   Rect m_shareRect;
   unsigned char m_displayNumber;
@@ -179,6 +179,31 @@ public:
    */
   static const UINT32 UPDATE_TVNCONTROL_PROCESS_ID_MSG_ID = 0x15;
 
+  /**
+   * Get performance counters of rfb clients.
+   *
+   * Request body: [empty].
+   * Reply body:
+   *   UINT32 clientsCount.
+   *   struct {
+   *     UINT32 clientId.
+   *     StringUTF8 peerAddr.
+   *     serialized UpdateStatistics.
+   *   } clientsStatistics[clientsCount].
+   */
+  static const UINT32 GET_CLIENT_STATISTICS_MSG_ID = 0x16;
+
+  /**
+   * Get trace events collected by the server.
+   *
+   * Request body:
+   *   UINT32 seconds (period of time before the request to get events for).
+   * Reply body:
+   *   UINT32 length.
+   *   UINT8 traceJson[length] (Chrome trace event format, UTF-8).
+   */
+  static const UINT32 DUMP_TRACE_MSG_ID = 0x17;
+
   // Send to server a command that to share only a primary desktop.
   static const UINT32 SHARE_PRIMARY_MSG_ID = 0x20;
 
@@ -107,6 +107,43 @@ void ControlProxy::getClientsList(list<RfbClientInfo *> *clients)
   }
 }
 
+void ControlProxy::getClientsStatistics(RfbClientStatisticsList *clients)
+{
+  AutoLock l(m_gate);
+
+  createMessage(ControlProto::GET_CLIENT_STATISTICS_MSG_ID)->send();
+
+  UINT32 count = m_gate->readUInt32();
+
+  for (UINT32 i = 0; i < count; i++) {
+    StringStorage peerAddr;
+
+    UINT32 id = m_gate->readUInt32();
+
+    m_gate->readUTF8(&peerAddr);
+
+    clients->push_back(RfbClientStatistics(id, peerAddr.getString()));
+    clients->back().m_statistics.deserialize(m_gate);
+  }
+}
+
+void ControlProxy::dumpTrace(unsigned int seconds, std::vector<char> *trace)
+{
+  AutoLock l(m_gate);
+
+  ControlMessage *msg = createMessage(ControlProto::DUMP_TRACE_MSG_ID);
+
+  msg->writeUInt32(seconds);
+  msg->send();
+
+  UINT32 length = m_gate->readUInt32();
+
+  trace->resize(length);
+  if (length != 0) {
+    m_gate->readFully(&trace->front(), length);
+  }
+}
+
 void ControlProxy::makeOutgoingConnection(const TCHAR *connectString, bool viewOnly)
 {
   AutoLock l(m_gate);
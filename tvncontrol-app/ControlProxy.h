@@ -27,6 +27,7 @@
 
 #include "tvncontrol-app/ControlGate.h"
 #include "tvncontrol-app/RfbClientInfo.h"
+#include "tvncontrol-app/RfbClientStatistics.h"
 #include "tvncontrol-app/TvnServerInfo.h"
 
 #include "server-config-lib/ServerConfig.h"
@@ -35,6 +36,7 @@
 #include "RemoteException.h"
 
 #include <list>
+#include <vector>
 
 using namespace std;
 
@@ -80,6 +82,24 @@ public:
    */
   void getClientsList(list<RfbClientInfo *> *clients) throw(IOException, RemoteException);
 
+  /**
+   * Gets performance counters of rfb clients.
+   * @param [out] clients output parameter to store statistics.
+   * @throws RemoteException on error on server.
+   * @throws IOException on io error.
+   */
+  void getClientsStatistics(RfbClientStatisticsList *clients) throw(IOException, RemoteException);
+
+  /**
+   * Gets trace events collected by the server.
+   * @param seconds period of time to get events for.
+   * @param [out] trace output parameter to store trace in Chrome trace
+   * event JSON format.
+   * @throws RemoteException on error on server.
+   * @throws IOException on io error.
+   */
+  void dumpTrace(unsigned int seconds, std::vector<char> *trace) throw(IOException, RemoteException);
+
   /**
    * Reloads rfb server configuration.
    * @throws RemoteException on error on server.
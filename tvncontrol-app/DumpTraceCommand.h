@@ -0,0 +1,81 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef _DUMP_TRACE_COMMAND_H_
+#define _DUMP_TRACE_COMMAND_H_
+
+#include "util/Command.h"
+
+#include "ControlProxy.h"
+
+/**
+ * Command that gets the trace events of the last seconds from TightVNC
+ * server and writes them to a file in Chrome trace event format.
+ */
+class DumpTraceCommand : public Command
+{
+public:
+  /**
+   * Default period of time before the command execution to dump events for,
+   * used if the period is not given in the command line.
+   */
+  static const unsigned int DEFAULT_TRACE_SECONDS = 30;
+
+  /**
+   * Creates command.
+   * @param serverControl proxy.
+   * @param traceFile path to the file to write the trace to.
+   * @param seconds period of time before the command execution to dump
+   * events for.
+   */
+  DumpTraceCommand(ControlProxy *serverControl, const TCHAR *traceFile,
+                   unsigned int seconds);
+  /**
+   * Destroys command.
+   */
+  virtual ~DumpTraceCommand();
+
+  /**
+   * Executes command.
+   *
+   * Inhrited from Command abstract class.
+   *
+   * @throws IOException on io error, RemoteException on server side error.
+   */
+  virtual void execute() throw(IOException, RemoteException);
+private:
+  /**
+   * Proxy to some of TightVNC server control methods.
+   */
+  ControlProxy *m_proxy;
+  /**
+   * Path to the trace file.
+   */
+  StringStorage m_traceFile;
+  /**
+   * Period of time to dump events for, in seconds.
+   */
+  unsigned int m_seconds;
+};
+
+#endif
@@ -37,6 +37,8 @@
 
 #include "rfb/HostPath.h"
 
+#include "log-writer/TraceExporter.h"
+
 #include "win-system/WTS.h"
 
 #include "tvnserver/resource.h"
@@ -55,13 +57,15 @@ const UINT32 ControlClient::REQUIRES_AUTH[] = { ControlProto::ADD_CLIENT_MSG_ID,
                                                 ControlProto::SHARE_RECT_MSG_ID,
                                                 ControlProto::SHARE_APP_MSG_ID,
                                                 ControlProto::SHARE_FULL_MSG_ID,
-                                                ControlProto::CONNECT_TO_TCPDISP_MSG_ID };
+                                                ControlProto::CONNECT_TO_TCPDISP_MSG_ID,
+                                                ControlProto::DUMP_TRACE_MSG_ID };
 
 const UINT32 ControlClient::WITHOUT_AUTH[] = {
   ControlProto::AUTH_MSG_ID,
   ControlProto::RELOAD_CONFIG_MSG_ID,
   ControlProto::GET_SERVER_INFO_MSG_ID,
   ControlProto::GET_CLIENT_LIST_MSG_ID,
+  ControlProto::GET_CLIENT_STATISTICS_MSG_ID,
   ControlProto::GET_SHOW_TRAY_ICON_FLAG,
   ControlProto::UPDATE_TVNCONTROL_PROCESS_ID_MSG_ID
 };
@@ -174,6 +178,14 @@ void ControlClient::execute()
           m_log->detail(_T("Control client requests client list"));
           getClientsListMsgRcvd();
           break;
+        case ControlProto::GET_CLIENT_STATISTICS_MSG_ID:
+          m_log->detail(_T("Control client requests client statistics"));
+          getClientsStatisticsMsgRcvd();
+          break;
+        case ControlProto::DUMP_TRACE_MSG_ID:
+          m_log->detail(_T("Control client requests trace events"));
+          dumpTraceMsgRcvd();
+          break;
         case ControlProto::SET_CONFIG_MSG_ID:
           m_log->detail(_T("Control client sends new server config"));
           setServerConfigMsgRcvd();
@@ -298,6 +310,36 @@ void ControlClient::getClientsListMsgRcvd()
   }
 }
 
+void ControlClient::getClientsStatisticsMsgRcvd()
+{
+  RfbClientStatisticsList clients;
+
+  m_rfbClientManager->getClientsStatistics(&clients);
+
+  m_gate->writeUInt32(ControlProto::REPLY_OK);
+  m_gate->writeUInt32((unsigned int)clients.size());
+
+  for (RfbClientStatisticsList::iterator it = clients.begin(); it != clients.end(); it++) {
+    m_gate->writeUInt32((*it).m_id);
+    m_gate->writeUTF8((*it).m_peerAddr.getString());
+    (*it).m_statistics.serialize(m_gate);
+  }
+}
+
+void ControlClient::dumpTraceMsgRcvd()
+{
+  unsigned int seconds = m_gate->readUInt32();
+
+  std::vector<char> trace;
+  TraceExporter::exportChromeJson(seconds, &trace);
+
+  m_gate->writeUInt32(ControlProto::REPLY_OK);
+  m_gate->writeUInt32((unsigned int)trace.size());
+  if (!trace.empty()) {
+    m_gate->writeFully(&trace.front(), trace.size());
+  }
+}
+
 void ControlClient::getServerInfoMsgRcvd()
 {
   bool acceptFlag = false;
@@ -120,6 +120,16 @@ private:
    * @throws IOException on io error.
    */
   void getClientsListMsgRcvd() throw(IOException);
+  /**
+   * Called when get client statistics message recieved.
+   * @throws IOException on io error.
+   */
+  void getClientsStatisticsMsgRcvd() throw(IOException);
+  /**
+   * Called when dump trace message recieved.
+   * @throws IOException on io error.
+   */
+  void dumpTraceMsgRcvd() throw(IOException);
   /**
    * Called when get server info message reciveved.
    * @throws IOException on io error.
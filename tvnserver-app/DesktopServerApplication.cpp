@@ -26,6 +26,7 @@
 #include "DesktopServerCommandLine.h"
 #include "util/ResourceLoader.h"
 #include "desktop/WallpaperUtil.h"
+#include "log-writer/Tracer.h"
 #include "win-system/WTS.h"
 #include "win-system/Environment.h"
 #include "win-system/SharedMemory.h"
@@ -40,6 +41,8 @@ DesktopServerApplication::DesktopServerApplication(HINSTANCE appInstance,
   m_clToSrvGate(0),
   m_srvToClGate(0),
   m_dispatcher(0),
+  m_frameBufferMem(0),
+  m_sharedFrameBuffer(0),
   m_updHandlerSrv(0),
   m_uiSrv(0),
   m_cfgServer(0),
@@ -97,16 +100,35 @@ DesktopServerApplication::DesktopServerApplication(HINSTANCE appInstance,
     m_clToSrvGate = new BlockingGate(m_clToSrvChan);
     m_srvToClGate = new BlockingGate(m_srvToClChan);
 
+    HANDLE hFbMem = (HANDLE)mem[5];
+    if (hFbMem != 0) {
+      size_t fbMemSize = (size_t)mem[6];
+      // The pixels are passed by the pipes if the memory is not available.
+      try {
+        m_frameBufferMem = new UnnamedSharedMemory(hFbMem, fbMemSize);
+        m_sharedFrameBuffer = new SharedFrameBuffer(m_frameBufferMem);
+        m_log.info(_T("Frame buffer shared memory = %p; size = %u"), hFbMem,
+                   (unsigned int)fbMemSize);
+      } catch (Exception &e) {
+        m_log.error(_T("Cannot use frame buffer shared memory: %s"),
+                    e.getMessage());
+        if (m_frameBufferMem) delete m_frameBufferMem;
+        m_frameBufferMem = 0;
+      }
+    }
+
     // Server initializations
     m_dispatcher = new DesktopSrvDispatcher(m_clToSrvGate, this, &m_log);
 
-    m_updHandlerSrv = new UpdateHandlerServer(m_srvToClGate, m_dispatcher, this, &m_log);
+    m_updHandlerSrv = new UpdateHandlerServer(m_srvToClGate, m_dispatcher, this,
+                                              m_sharedFrameBuffer, &m_log);
     m_uiSrv = new UserInputServer(m_srvToClGate, m_dispatcher, this, &m_log);
     m_cfgServer = new ConfigServer(m_dispatcher, &m_log);
     m_gateKickHandler = new GateKickHandler(m_dispatcher);
 
     // Start servers
     m_dispatcher->resume();
+    m_updHandlerSrv->resume();
 
     // Spy for the session change.
     m_sessionChangesWatcher = new SessionChangesWatcher(this, &m_log);
@@ -154,6 +176,9 @@ void DesktopServerApplication::freeResources()
   if (m_clToSrvGate) delete m_clToSrvGate;
   if (m_srvToClChan) delete m_srvToClChan;
   if (m_clToSrvChan) delete m_clToSrvChan;
+
+  if (m_sharedFrameBuffer) delete m_sharedFrameBuffer;
+  if (m_frameBufferMem) delete m_frameBufferMem;
 }
 
 void DesktopServerApplication::onAnObjectEvent()
@@ -165,6 +190,7 @@ void DesktopServerApplication::onAnObjectEvent()
 
 void DesktopServerApplication::onConfigReload(ServerConfig *serverConfig)
 {
+  Tracer::setEnabled(serverConfig->isTracingEnabled());
 }
 
 int DesktopServerApplication::run()
@@ -31,6 +31,8 @@
 #include "desktop-ipc/BlockingGate.h"
 #include "desktop-ipc/DesktopSrvDispatcher.h"
 #include "desktop-ipc/UpdateHandlerServer.h"
+#include "desktop-ipc/SharedFrameBuffer.h"
+#include "win-system/UnnamedSharedMemory.h"
 #include "desktop-ipc/UserInputServer.h"
 #include "desktop-ipc/ConfigServer.h"
 #include "desktop-ipc/GateKickHandler.h"
@@ -85,6 +87,10 @@ private:
 
   DesktopSrvDispatcher *m_dispatcher;
 
+  // Frame buffer pixels shared with the service (can be zero).
+  UnnamedSharedMemory *m_frameBufferMem;
+  SharedFrameBuffer *m_sharedFrameBuffer;
+
   // Servers
   UpdateHandlerServer *m_updHandlerSrv;
   UserInputServer *m_uiSrv;
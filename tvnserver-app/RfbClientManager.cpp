@@ -397,6 +397,23 @@ void RfbClientManager::getClientsInfo(RfbClientInfoList *list)
   }
 }
 
+void RfbClientManager::getClientsStatistics(RfbClientStatisticsList *list)
+{
+  AutoLock al(&m_clientListLocker);
+
+  for (ClientListIter it = m_clientList.begin(); it != m_clientList.end(); it++) {
+    RfbClient *each = *it;
+    if (each->getClientState() == IN_NORMAL_PHASE) {
+      StringStorage peerHost;
+      each->getPeerHost(&peerHost);
+
+      RfbClientStatistics clientStats(each->getId(), peerHost.getString());
+      each->getStatistics(&clientStats.m_statistics);
+      list->push_back(clientStats);
+    }
+  }
+}
+
 void RfbClientManager::setDynViewPort(const ViewPortState *dynViewPort)
 {
   AutoLock al(&m_clientListLocker);
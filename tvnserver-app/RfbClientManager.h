@@ -44,6 +44,7 @@
 #include "desktop/UpdateSendingListener.h"
 #include "rfb-sconn/ClientAuthListener.h"
 #include "tvncontrol-app/RfbClientInfo.h"
+#include "tvncontrol-app/RfbClientStatistics.h"
 #include "NewConnectionEvents.h"
 
 typedef std::list<RfbClient *> ClientList;
@@ -80,6 +81,9 @@ public:
   // Adds rfb clients info to specified rfb client info list.
   // FIXME: This method needed only for control server.
   void getClientsInfo(RfbClientInfoList *list);
+  // Adds performance counters of the clients in the normal phase to the
+  // list.
+  void getClientsStatistics(RfbClientStatisticsList *list);
 
   // Disconnects all connected clients.
   virtual void disconnectAllClients();
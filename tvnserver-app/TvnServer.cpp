@@ -32,6 +32,8 @@
 
 #include "thread/GlobalMutex.h"
 
+#include "log-writer/Tracer.h"
+
 #include "tvnserver/resource.h"
 
 #include "wsconfig-lib/TvnLogFilename.h"
@@ -77,6 +79,8 @@ TvnServer::TvnServer(bool runsInServiceContext,
   configurator->load();
   m_srvConfig = Configurator::getInstance()->getServerConfig();
 
+  Tracer::setEnabled(m_srvConfig->isTracingEnabled());
+
   try {
     StringStorage logDir;
     m_srvConfig->getLogFileDir(&logDir);
@@ -201,6 +205,7 @@ void TvnServer::onConfigReload(ServerConfig *serverConfig)
     }
   }
   changeLogProps();
+  Tracer::setEnabled(m_srvConfig->isTracingEnabled());
 }
 
 void TvnServer::getServerInfo(TvnServerInfo *info)
@@ -33,7 +33,7 @@
 #include "TvnServer.h"
 #include "TvnServerListener.h"
 #include "WsConfigRunner.h"
-#include "log-writer/FileLogger.h"
+#include "log-writer/AsyncFileLogger.h"
 #include "LogInitListener.h"
 
 /**
@@ -86,7 +86,7 @@ private:
   // This is a callback function that calls when log properties have changed.
   virtual void onChangeLogProps(const TCHAR *newLogDir, unsigned char newLevel);
 
-  FileLogger m_fileLogger;
+  AsyncFileLogger m_fileLogger;
 
   /**
    * Command line string.
@@ -39,7 +39,9 @@ DesktopWindow::DesktopWindow(LogWriter *logWriter, ConnectionConfig *conConf)
   m_altDown(false),
   m_previousMousePos(-1, -1),
   m_previousMouseState(0),
-  m_isBackgroundDirty(false)
+  m_isBackgroundDirty(false),
+  m_isScaledValid(false),
+  m_paintDC(0)
 {
   m_rfbKeySym = std::auto_ptr<RfbKeySym>(new RfbKeySym(this, m_logWriter));
 }
@@ -73,6 +75,7 @@ void DesktopWindow::onPaint(DeviceContext *dc, PAINTSTRUCT *paintStruct)
     try {
       AutoLock al(&m_bufferLock);
       m_framebuffer.setTargetDC(paintStruct->hdc);
+      m_paintDC = paintStruct->hdc;
       if (!m_clientArea.isEmpty()) {
         doDraw(dc);
       }
@@ -465,11 +468,61 @@ void DesktopWindow::drawImage(const RECT *src, const RECT *dst)
      src->top == dst->top &&
      src->bottom == dst->bottom) {
     m_framebuffer.blitFromDibSection(&rc_dest);
-  } else {
+    // The scaled image isn't maintained at 100%.
+    m_isScaledValid = false;
+    AutoLock alDirty(&m_scaleDirtyLock);
+    m_scaleDirty.clear();
+  } else if (!drawScaledImage(&rc_src, &rc_dest)) {
     m_framebuffer.stretchFromDibSection(&rc_dest, &rc_src);
   }
 }
 
+bool DesktopWindow::drawScaledImage(const Rect *src, const Rect *dst)
+{
+  PixelFormat pf = m_framebuffer.getPixelFormat();
+  if (!FrameBufferScaler::isSupportedFormat(&pf)) {
+    return false;
+  }
+
+  // Averaging of the covered area is the best for scaling down, bilinear
+  // filter for scaling up.
+  FrameBufferScaler::Filter filter = FrameBufferScaler::FILTER_BILINEAR;
+  if (dst->getWidth() < src->getWidth() ||
+      dst->getHeight() < src->getHeight()) {
+    filter = FrameBufferScaler::FILTER_AREA;
+  }
+
+  Region dirty;
+  {
+    AutoLock al(&m_scaleDirtyLock);
+    dirty = m_scaleDirty;
+    m_scaleDirty.clear();
+  }
+  if (m_scaler.setGeometry(filter, src, dst, &pf) || !m_isScaledValid) {
+    // The scaled image is kept at the window coordinates.
+    Dimension dimension(dst->right, dst->bottom);
+    Dimension scaledDimension = m_scaledFramebuffer.getDimension();
+    PixelFormat scaledPf = m_scaledFramebuffer.getPixelFormat();
+    if (!dimension.isEqualTo(&scaledDimension) || !pf.isEqualTo(&scaledPf)) {
+      m_scaledFramebuffer.setProperties(&dimension, &pf, getHWnd());
+    }
+    dirty.clear();
+    dirty.addRect(src);
+    m_isScaledValid = true;
+  }
+  m_scaledFramebuffer.setTargetDC(m_paintDC);
+
+  // Only the changed parts are scaled again.
+  std::vector<Rect> rects;
+  dirty.getRectVector(&rects);
+  Rect changed;
+  for (std::vector<Rect>::iterator it = rects.begin(); it != rects.end(); it++) {
+    m_scaler.scale(&m_framebuffer, &*it, &m_scaledFramebuffer, &changed);
+  }
+  m_scaledFramebuffer.blitFromDibSection(dst);
+  return true;
+}
+
 bool DesktopWindow::onSize(WPARAM wParam, LPARAM lParam) 
 {
   calcClientArea();
@@ -499,6 +552,10 @@ void DesktopWindow::updateFramebuffer(const FrameBuffer *framebuffer,
                        dstRect->left, dstRect->top, dstRect->right, dstRect->bottom);
     m_logWriter->interror(_T("Error in updateFramebuffer (ViewerWindow)"));
   }
+  {
+    AutoLock al(&m_scaleDirtyLock);
+    m_scaleDirty.addRect(dstRect);
+  }
   repaint(dstRect);
 }
 
@@ -516,6 +573,7 @@ void DesktopWindow::setNewFramebuffer(const FrameBuffer *framebuffer)
     AutoLock al(&m_bufferLock);
 
     m_serverDimension = dimension;
+    m_isScaledValid = false;
     if (!dimension.isEmpty()) {
       // the width and height should be aligned to 4
       int alignWidth = (dimension.width + 3) / 4;
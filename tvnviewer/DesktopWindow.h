@@ -29,6 +29,7 @@
 #include "gui/DibFrameBuffer.h"
 #include "region/Rect.h"
 #include "region/Dimension.h"
+#include "region/Region.h"
 #include "ScaleManager.h"
 #include "client-config-lib/ConnectionConfig.h"
 #include "gui/PaintWindow.h"
@@ -37,6 +38,7 @@
 #include "gui/drawing/Graphics.h"
 #include "rfb/RfbKeySym.h"
 #include "viewer-core/RemoteViewerCore.h"
+#include "rfb/FrameBufferScaler.h"
 
 class DesktopWindow : public PaintWindow,
                       protected RfbKeySymListener
@@ -151,6 +153,18 @@ protected:
   // Dimension of m_framebuffer can be large m_serverDimension.
   Dimension m_serverDimension;
 
+  // scaled image (scale is not 100%)
+  // m_scaledFramebuffer keeps the visible part of m_framebuffer scaled by
+  // m_scaler at the window coordinates. Changes of m_framebuffer are
+  // collected in m_scaleDirty and scaled on the next paint.
+  FrameBufferScaler m_scaler;
+  DibFrameBuffer m_scaledFramebuffer;
+  bool m_isScaledValid;
+  LocalMutex m_scaleDirtyLock;
+  Region m_scaleDirty;
+  // DC of the window in onPaint().
+  HDC m_paintDC;
+
   // clipboard
   WinClipboard m_clipboard;
   StringStorage m_strClipboard;
@@ -167,6 +181,9 @@ private:
   void scrollProcessing(int fbWidth, int fbHeight);
   void drawBackground(DeviceContext *dc, const RECT *rcMain, const RECT *rcImage);
   void drawImage(const RECT *src, const RECT *dst);
+  // Draws the image scaled by m_scaler. Returns false if the pixel format
+  // isn't supported by it.
+  bool drawScaledImage(const Rect *src, const Rect *dst);
   void repaint(const Rect *repaintRect);
   void calcClientArea();
 };
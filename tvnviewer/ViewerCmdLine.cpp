@@ -50,6 +50,7 @@ const TCHAR ViewerCmdLine::MOUSE_LOCAL[] = _T("mouselocal");
 const TCHAR ViewerCmdLine::MOUSE_SWAP[] = _T("mouseswap");
 const TCHAR ViewerCmdLine::JPEG_IMAGE_QUALITY[] = _T("jpegimagequality");
 const TCHAR ViewerCmdLine::COMPRESSION_LEVEL[] = _T("compressionlevel");
+const TCHAR ViewerCmdLine::AUTO_TUNING[] = _T("autotuning");
 
 
 const TCHAR ViewerCmdLine::YES[] = _T("yes");
@@ -122,7 +123,8 @@ void ViewerCmdLine::parse()
     MOUSE_LOCAL,
     MOUSE_SWAP,
     JPEG_IMAGE_QUALITY,
-    COMPRESSION_LEVEL
+    COMPRESSION_LEVEL,
+    AUTO_TUNING
   };
 
   if (!processCmdLine(&options[0], sizeof(options) / sizeof(CmdLineOption))) {
@@ -166,6 +168,7 @@ void ViewerCmdLine::parse()
   parseCopyRect();
   parseViewOnly();
   parseJpegImageQuality();
+  parseAutoTuning();
 }
 
 void ViewerCmdLine::onHelp()
@@ -411,6 +414,18 @@ void ViewerCmdLine::parseJpegImageQuality()
   }
 }
 
+void ViewerCmdLine::parseAutoTuning()
+{
+  if (isPresent(AUTO_TUNING)) {
+    bool isAutoTuning = false;
+
+    if (m_options[AUTO_TUNING] == YES) {
+      isAutoTuning = true;
+    }
+    m_conConf->enableAutoTuning(isAutoTuning);
+  }
+}
+
 void ViewerCmdLine::parseCompressionLevel()
 {
   if (isPresent(COMPRESSION_LEVEL)) {
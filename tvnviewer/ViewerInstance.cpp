@@ -107,6 +107,8 @@ void ViewerInstance::start()
 
   m_fileTransfer.addCapabilities(&m_viewerCore);
 
+  m_viewerCore.enableAutoTuning(m_conConf.isAutoTuningEnabled());
+
   if (m_socket) {
     m_viewerCore.start(m_socket,
                        &m_viewerWnd, m_conConf.getSharedFlag());
@@ -0,0 +1,119 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "Histogram.h"
+
+Histogram::Histogram()
+{
+  clear();
+}
+
+void Histogram::add(UINT64 value)
+{
+  m_buckets[getBucket(value)]++;
+  m_count++;
+  m_sum += value;
+  if (value > m_max) {
+    m_max = value;
+  }
+}
+
+void Histogram::clear()
+{
+  memset(m_buckets, 0, sizeof(m_buckets));
+  m_count = 0;
+  m_sum = 0;
+  m_max = 0;
+}
+
+UINT64 Histogram::getCount() const
+{
+  return m_count;
+}
+
+UINT64 Histogram::getSum() const
+{
+  return m_sum;
+}
+
+UINT64 Histogram::getMax() const
+{
+  return m_max;
+}
+
+double Histogram::getMean() const
+{
+  return m_count != 0 ? (double)m_sum / (double)m_count : 0.0;
+}
+
+UINT64 Histogram::getBucketCount(int bucket) const
+{
+  return m_buckets[bucket];
+}
+
+UINT64 Histogram::getPercentile(int percent) const
+{
+  if (m_count == 0) {
+    return 0;
+  }
+  // The number of values which must be at or below the result, rounded up.
+  UINT64 rank = (m_count * percent + 99) / 100;
+  UINT64 counted = 0;
+  for (int i = 0; i < NUM_BUCKETS; i++) {
+    counted += m_buckets[i];
+    if (counted >= rank && counted != 0) {
+      return min(getBucketLimit(i), m_max);
+    }
+  }
+  return m_max;
+}
+
+UINT64 Histogram::getBucketLimit(int bucket)
+{
+  if (bucket >= NUM_BUCKETS - 1) {
+    return _UI64_MAX;
+  }
+  return ((UINT64)1 << bucket) - 1;
+}
+
+void Histogram::set(const UINT64 *bucketCounts, UINT64 sum, UINT64 maxValue)
+{
+  m_count = 0;
+  for (int i = 0; i < NUM_BUCKETS; i++) {
+    m_buckets[i] = bucketCounts[i];
+    m_count += bucketCounts[i];
+  }
+  m_sum = sum;
+  m_max = maxValue;
+}
+
+int Histogram::getBucket(UINT64 value)
+{
+  int bucket = 0;
+  while (value != 0 && bucket < NUM_BUCKETS - 1) {
+    value >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
@@ -0,0 +1,75 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __HISTOGRAM_H__
+#define __HISTOGRAM_H__
+
+#include "CommonHeader.h"
+
+// Distribution of non-negative values over power-of-two buckets. Bucket 0
+// counts zeros, bucket i > 0 counts values from 2^(i-1) to 2^i - 1, and
+// the last bucket also takes everything above. Adding a value is cheap
+// enough for hot paths, while the buckets still give a useful picture of
+// the tail (e.g. latency percentiles).
+class Histogram
+{
+public:
+  static const int NUM_BUCKETS = 40;
+
+  Histogram();
+
+  void add(UINT64 value);
+  void clear();
+
+  // Returns the number of values added, their sum and the maximum value.
+  UINT64 getCount() const;
+  UINT64 getSum() const;
+  UINT64 getMax() const;
+  // Returns the mean value or zero if there are no values.
+  double getMean() const;
+
+  UINT64 getBucketCount(int bucket) const;
+
+  // Returns the upper limit of the bucket which contains the given
+  // percentile, i.e. an estimate which is never less than the real value
+  // and less than twice as big. The result is limited by the maximum value.
+  UINT64 getPercentile(int percent) const;
+
+  // Returns the biggest value counted in the bucket.
+  static UINT64 getBucketLimit(int bucket);
+
+  // Replaces the contents, e.g. when restoring a histogram received
+  // from another process. The array must contain NUM_BUCKETS counts.
+  void set(const UINT64 *bucketCounts, UINT64 sum, UINT64 maxValue);
+
+private:
+  static int getBucket(UINT64 value);
+
+  UINT64 m_buckets[NUM_BUCKETS];
+  UINT64 m_count;
+  UINT64 m_sum;
+  UINT64 m_max;
+};
+
+#endif // __HISTOGRAM_H__
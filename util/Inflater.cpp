@@ -52,22 +52,26 @@ void Inflater::setUnpackedSize(size_t size)
 
 void Inflater::inflate()
 {
-  size_t avaliableOutput = m_unpackedSize + m_unpackedSize / 100 + 1024;
+  m_output.resize(getOutputCapacity(m_unpackedSize));
+
+  m_outputSize = (unsigned long)inflate(&m_output.front(), m_output.size());
+}
+
+size_t Inflater::inflate(char *output, size_t outputSize)
+{
   unsigned long prevTotalOut = m_zlibStream.total_out;
 
   // Check to overflow.
-  unsigned int constrainedValue = (unsigned int)avaliableOutput;
-  _ASSERT(avaliableOutput == constrainedValue);
+  unsigned int constrainedValue = (unsigned int)outputSize;
+  _ASSERT(outputSize == constrainedValue);
   constrainedValue = (unsigned int)m_inputSize;
   _ASSERT(m_inputSize == constrainedValue);
 
-  m_output.resize(avaliableOutput);
-
   m_zlibStream.next_in = (Bytef *)m_input;
   m_zlibStream.avail_in = (unsigned int)m_inputSize;
 
-  m_zlibStream.next_out = (Bytef *)&m_output.front();
-  m_zlibStream.avail_out = (unsigned int)avaliableOutput;
+  m_zlibStream.next_out = (Bytef *)output;
+  m_zlibStream.avail_out = (unsigned int)outputSize;
 
   int r = ::inflate(&m_zlibStream, Z_SYNC_FLUSH);
 
@@ -90,5 +94,12 @@ void Inflater::inflate()
     throw ZLibException(_T("Not enough buffer size for data decompression"));
   }
 
-  m_outputSize = m_zlibStream.total_out - prevTotalOut;
+  return m_zlibStream.total_out - prevTotalOut;
+}
+
+size_t Inflater::getOutputCapacity(size_t unpackedSize)
+{
+  // Leave some space for the zlib data which doesn't produce output
+  // (e.g. the empty block of sync flush).
+  return unpackedSize + unpackedSize / 100 + 1024;
 }
@@ -42,6 +42,21 @@ public:
 
   void inflate() throw(ZLibException);
 
+  //
+  // Inflates the input into the buffer of the caller instead of the internal
+  // output buffer and returns the number of inflated bytes.
+  //
+  // The buffer must have place for the whole inflated input, use
+  // getOutputCapacity() to get a safe size.
+  //
+  size_t inflate(char *output, size_t outputSize) throw(ZLibException);
+
+  //
+  // Returns the size of output buffer which is enough for inflating data
+  // with the given unpacked size.
+  //
+  static size_t getOutputCapacity(size_t unpackedSize);
+
 protected:
   z_stream m_zlibStream;
 
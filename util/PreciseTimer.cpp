@@ -0,0 +1,63 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "PreciseTimer.h"
+
+UINT64 PreciseTimer::getMicroseconds()
+{
+  static UINT64 frequency = getFrequency();
+  if (frequency == 0) {
+    // The counter is not available, fall back to the millisecond timer.
+    return (UINT64)GetTickCount() * 1000;
+  }
+
+  LARGE_INTEGER counter;
+  QueryPerformanceCounter(&counter);
+  UINT64 ticks = (UINT64)counter.QuadPart;
+  // Split the value to avoid overflow in the multiplication.
+  return ticks / frequency * 1000000 + ticks % frequency * 1000000 / frequency;
+}
+
+UINT64 PreciseTimer::getNanoseconds()
+{
+  static UINT64 frequency = getFrequency();
+  if (frequency == 0) {
+    return (UINT64)GetTickCount() * 1000000;
+  }
+
+  LARGE_INTEGER counter;
+  QueryPerformanceCounter(&counter);
+  UINT64 ticks = (UINT64)counter.QuadPart;
+  return ticks / frequency * 1000000000 +
+         ticks % frequency * 1000000000 / frequency;
+}
+
+UINT64 PreciseTimer::getFrequency()
+{
+  LARGE_INTEGER frequency;
+  if (!QueryPerformanceFrequency(&frequency)) {
+    return 0;
+  }
+  return (UINT64)frequency.QuadPart;
+}
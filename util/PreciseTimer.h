@@ -0,0 +1,48 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __PRECISETIMER_H__
+#define __PRECISETIMER_H__
+
+#include "CommonHeader.h"
+
+// Access to the high-resolution performance counter, for measuring short
+// time intervals. DateTime is not suitable for that because its resolution
+// is limited by the system timer tick.
+class PreciseTimer
+{
+public:
+  // Returns the current counter value in microseconds. The starting point
+  // is arbitrary, so only differences between the values make sense.
+  static UINT64 getMicroseconds();
+  // The same in nanoseconds. The real resolution is that of the counter.
+  static UINT64 getNanoseconds();
+
+private:
+  // Returns the counter frequency in ticks per second or zero if the
+  // counter is not available.
+  static UINT64 getFrequency();
+};
+
+#endif // __PRECISETIMER_H__
@@ -64,6 +64,26 @@ void CoreEventsAdapter::onFrameBufferUpdate(const FrameBuffer *fb,
 {
 }
 
+void CoreEventsAdapter::onFrameBufferUpdates(const FrameBuffer *fb,
+                                             const std::vector<Rect> *updates)
+{
+  std::vector<Rect>::const_iterator i;
+  for (i = updates->begin(); i != updates->end(); i++) {
+    onFrameBufferUpdate(fb, &*i);
+  }
+}
+
 void CoreEventsAdapter::onFrameBufferPropChange(const FrameBuffer *fb)
 {
 }
+
+void CoreEventsAdapter::onFrameBufferUpdateReceived(int numRects,
+                                                    UINT64 decodeTime,
+                                                    UINT64 latency)
+{
+}
+
+void CoreEventsAdapter::onEncodingTuned(const EncodingAutoTuner::Settings *settings,
+                                        const EncodingAutoTuner::Measurements *measurements)
+{
+}
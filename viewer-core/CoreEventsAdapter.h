@@ -34,6 +34,9 @@
 #include "util/Exception.h"
 
 #include "AuthHandler.h"
+#include "EncodingAutoTuner.h"
+
+#include <vector>
 
 //
 // CoreEventsAdapter interface is used to pass events from RemoteViewerCore to
@@ -104,6 +107,18 @@ public:
   //
   virtual void onFrameBufferUpdate(const FrameBuffer *fb, const Rect *update);
 
+  //
+  // Frame buffer contents has been changed in the given rectangles (they
+  // may overlap). The frame buffer is locked during this callback, as in
+  // onFrameBufferUpdate(). It's called once for all updates delivered
+  // together, e.g. for a frame if the notifications are paced (see
+  // RemoteViewerCore::setFrameRate()).
+  //
+  // Default implementation calls onFrameBufferUpdate() for each rectangle.
+  //
+  virtual void onFrameBufferUpdates(const FrameBuffer *fb,
+                                    const std::vector<Rect> *updates);
+
   // changed properties of frame buffer.
   // In this moment frame buffer area is dirty and may be contained incorrect data
   //
@@ -112,6 +127,27 @@ public:
   // notification will be called on initial frame buffer allocation as well.
   //
   virtual void onFrameBufferPropChange(const FrameBuffer *fb);
+
+  //
+  // A FramebufferUpdate message has been completely received and decoded.
+  // This function is called from the thread of RemoteViewerCore, it must
+  // return quickly. All times are in microseconds: decodeTime is the time
+  // spent reading and decoding the message after its type has been
+  // received, latency is the time from sending the corresponding update
+  // request to the end of decoding (zero if no request was sent).
+  //
+  virtual void onFrameBufferUpdateReceived(int numRects,
+                                           UINT64 decodeTime,
+                                           UINT64 latency);
+
+  //
+  // The encoding auto-tuner has finished a measurement window (see
+  // RemoteViewerCore::enableAutoTuning()). The settings are the ones used
+  // from now on, they may be the same as before. This function is called
+  // from the thread of RemoteViewerCore, it must return quickly.
+  //
+  virtual void onEncodingTuned(const EncodingAutoTuner::Settings *settings,
+                               const EncodingAutoTuner::Measurements *measurements);
 };
 
 #endif
@@ -26,8 +26,24 @@
 
 #include "FbUpdateNotifier.h"
 
+DecoderOfRectangle::DrawingLock::DrawingLock(DecoderOfRectangle *decoder)
+: m_lock(decoder->m_drawingLock)
+{
+  if (m_lock != 0) {
+    m_lock->lock();
+  }
+}
+
+DecoderOfRectangle::DrawingLock::~DrawingLock()
+{
+  if (m_lock != 0) {
+    m_lock->unlock();
+  }
+}
+
 DecoderOfRectangle::DecoderOfRectangle(LogWriter *logWriter)
-: Decoder(logWriter)
+: Decoder(logWriter),
+  m_drawingLock(0)
 {
 }
 
@@ -42,11 +58,31 @@ void DecoderOfRectangle::process(RfbInputGate *input,
                      LocalMutex *fbLock,
                      FbUpdateNotifier *fbNotifier)
 {
-  decode(input, secondFrameBuffer, rect);
-  copy(frameBuffer, secondFrameBuffer, rect, fbLock);
+  if (isDecodingInPlace()) {
+    m_drawingLock = fbLock;
+    try {
+      decode(input, frameBuffer, rect);
+    } catch (...) {
+      m_drawingLock = 0;
+      throw;
+    }
+    m_drawingLock = 0;
+  } else {
+    decode(input, secondFrameBuffer, rect);
+    copy(frameBuffer, secondFrameBuffer, rect, fbLock);
+  }
   notify(fbNotifier, rect);
 }
 
+void DecoderOfRectangle::flush()
+{
+}
+
+bool DecoderOfRectangle::isDecodingInPlace() const
+{
+  return false;
+}
+
 void DecoderOfRectangle::copy(FrameBuffer *dstFrameBuffer,
                    const FrameBuffer *srcFrameBuffer,
                    const Rect *rect,
@@ -27,6 +27,8 @@
 
 #include "Decoder.h"
 
+#include <vector>
+
 class FbUpdateNotifier;
 
 class DecoderOfRectangle : public Decoder
@@ -43,6 +45,10 @@ public:
   //   4. notify fbNotifier
   // His called decode(), copy() and notify() by order, defined in implementation.
   //
+  // If isDecodingInPlace() returns true, then steps 2 and 3 are replaced by
+  // decoding straight on "frameBuffer": the decoder locks fbLock (DrawingLock)
+  // only while it draws, not while it reads input.
+  //
   // This function is thread-safe for frameBuffer.
   //
   virtual void process(RfbInputGate *input,
@@ -52,12 +58,46 @@ public:
                        LocalMutex *fbLock,
                        FbUpdateNotifier *fbNotifier);
 
+  //
+  // Decoder may leave drawing of rectangles to other threads (and notify
+  // fbNotifier about them later). This method finishes drawing of all
+  // rectangles passed to process(). It's called before rectangles of other
+  // decoders are processed and before the end of update.
+  //
+  // Default implementation does nothing.
+  //
+  virtual void flush();
+
   //
   // This method inherited Decoder::isPseudo() and return true.
   //
   virtual bool isPseudo() const;
 
 protected:
+  //
+  // Locks the frame buffer passed to decode() while the decoder draws on it,
+  // if this frame buffer is shared with other threads. Otherwise does nothing.
+  //
+  class DrawingLock
+  {
+  public:
+    DrawingLock(DecoderOfRectangle *decoder);
+    ~DrawingLock();
+
+  private:
+    LocalMutex *m_lock;
+  };
+
+  //
+  // This method return true, if decoder reads all data of rectangle
+  // from input before drawing it and draws every pixel of rectangle
+  // without reading the previous content of frame buffer. Such decoder may
+  // decode on the general frame buffer, if it draws under DrawingLock.
+  //
+  // Default implementation return false.
+  //
+  virtual bool isDecodingInPlace() const;
+
   //
   // This method read rectangle-update from input and decode on frameBuffer.
   //
@@ -79,6 +119,22 @@ protected:
   //
   virtual void notify(FbUpdateNotifier *fbNotifier,
                       const Rect *rect);
+
+  //
+  // Grows the scratch buffer to at least "size" elements. The buffer is
+  // never shrunk, so the following rectangles reuse its memory and
+  // steady-state decoding doesn't allocate.
+  //
+  template<class T>
+  static void reserveScratch(std::vector<T> *buffer, size_t size)
+  {
+    if (buffer->size() < size) {
+      buffer->resize(size);
+    }
+  }
+
+  // Mutex of the frame buffer, which decode() draws on, or 0 if it isn't shared.
+  LocalMutex *m_drawingLock;
 };
 
 #endif
@@ -0,0 +1,181 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "EncodingAutoTuner.h"
+
+#include "rfb/EncodingDefs.h"
+
+const EncodingAutoTuner::Settings EncodingAutoTuner::LEVELS[] = {
+  { EncodingDefs::TIGHT, 9, 0 },
+  { EncodingDefs::TIGHT, 6, 2 },
+  { EncodingDefs::TIGHT, 6, 4 },
+  { EncodingDefs::TIGHT, 6, 6 },
+  { EncodingDefs::TIGHT, 6, 8 },
+  { EncodingDefs::TIGHT, 6, -1 },
+  { EncodingDefs::TIGHT, 1, -1 },
+  { EncodingDefs::ZRLE, -1, -1 },
+  { EncodingDefs::HEXTILE, -1, -1 }
+};
+
+const size_t EncodingAutoTuner::NUM_LEVELS =
+  sizeof(EncodingAutoTuner::LEVELS) / sizeof(EncodingAutoTuner::LEVELS[0]);
+
+const double EncodingAutoTuner::LINK_BOUND_RATIO = 0.75;
+const double EncodingAutoTuner::LINK_RATE_DECAY = 0.99;
+
+EncodingAutoTuner::EncodingAutoTuner()
+: m_levelMeasurements(NUM_LEVELS)
+{
+  reset();
+}
+
+EncodingAutoTuner::~EncodingAutoTuner()
+{
+}
+
+void EncodingAutoTuner::reset()
+{
+  m_level = DEFAULT_LEVEL;
+  memset(&m_measurements, 0, sizeof(m_measurements));
+  for (size_t i = 0; i < m_levelMeasurements.size(); i++) {
+    memset(&m_levelMeasurements[i], 0, sizeof(Measurements));
+  }
+  m_windowStart = 0;
+  m_windowUpdates = 0;
+  m_windowBytes = 0;
+  m_windowUpdateTime = 0;
+  m_windowLatency = 0;
+  m_linkRate = 0.0;
+  m_direction = 0;
+  m_directionWindows = 0;
+  m_upHoldWindows = HOLD_WINDOWS;
+}
+
+bool EncodingAutoTuner::addUpdate(UINT64 numBytes, UINT64 updateTime,
+                                  UINT64 latency, UINT64 time,
+                                  bool *settingsChanged)
+{
+  *settingsChanged = false;
+  if (m_windowUpdates == 0) {
+    m_windowStart = time;
+  }
+  m_windowUpdates++;
+  m_windowBytes += numBytes;
+  m_windowUpdateTime += updateTime;
+  m_windowLatency += latency;
+
+  UINT64 windowTime = time - m_windowStart;
+  if (windowTime < WINDOW_TIME || m_windowUpdates < WINDOW_UPDATES) {
+    return false;
+  }
+
+  m_measurements.numUpdates = m_windowUpdates;
+  m_measurements.bytesPerSecond = 0.0;
+  if (m_windowUpdateTime != 0) {
+    m_measurements.bytesPerSecond = (double)m_windowBytes * 1000000.0 /
+                                    (double)m_windowUpdateTime;
+  }
+  m_linkRate = max(m_measurements.bytesPerSecond,
+                   m_linkRate * LINK_RATE_DECAY);
+  m_measurements.linkBytesPerSecond = m_linkRate;
+  m_measurements.bytesPerUpdate = m_windowBytes / m_windowUpdates;
+  m_measurements.updateTime = m_windowUpdateTime / m_windowUpdates;
+  m_measurements.latency = m_windowLatency / m_windowUpdates;
+  m_levelMeasurements[m_level] = m_measurements;
+  m_windowUpdates = 0;
+  m_windowBytes = 0;
+  m_windowUpdateTime = 0;
+  m_windowLatency = 0;
+
+  int direction = getDirection(&m_measurements);
+  if (direction != m_direction) {
+    m_direction = direction;
+    m_directionWindows = 0;
+  }
+  m_directionWindows++;
+
+  if (m_direction < 0 && m_directionWindows >= HOLD_WINDOWS) {
+    m_level--;
+    m_upHoldWindows = min(m_upHoldWindows * 2, (int)MAX_UP_HOLD_WINDOWS);
+    *settingsChanged = true;
+  } else if (m_direction > 0 && m_directionWindows >= m_upHoldWindows) {
+    m_level++;
+    *settingsChanged = true;
+  }
+  if (*settingsChanged) {
+    // The next windows measure the new settings.
+    m_direction = 0;
+    m_directionWindows = 0;
+  }
+  return true;
+}
+
+int EncodingAutoTuner::getDirection(const Measurements *measurements) const
+{
+  if (measurements->updateTime > SLOW_UPDATE_TIME) {
+    // The link is busy all the time of the update, so it needs less data.
+    if (measurements->bytesPerSecond >=
+        measurements->linkBytesPerSecond * LINK_BOUND_RATIO) {
+      return m_level > 0 ? -1 : 0;
+    }
+    // The link waits for the decoding, which needs to be cheaper.
+    return m_level + 1 < NUM_LEVELS ? 1 : 0;
+  }
+  if (measurements->updateTime < FAST_UPDATE_TIME &&
+      m_level < LOSSLESS_LEVEL) {
+    return 1;
+  }
+  return 0;
+}
+
+const EncodingAutoTuner::Settings *EncodingAutoTuner::getSettings() const
+{
+  return &LEVELS[m_level];
+}
+
+size_t EncodingAutoTuner::getLevel() const
+{
+  return m_level;
+}
+
+size_t EncodingAutoTuner::getNumLevels()
+{
+  return NUM_LEVELS;
+}
+
+const EncodingAutoTuner::Settings *EncodingAutoTuner::getDefaultSettings()
+{
+  return &LEVELS[DEFAULT_LEVEL];
+}
+
+const EncodingAutoTuner::Measurements *EncodingAutoTuner::getMeasurements() const
+{
+  return &m_measurements;
+}
+
+const EncodingAutoTuner::Measurements *
+EncodingAutoTuner::getLevelMeasurements(size_t level) const
+{
+  return &m_levelMeasurements[level];
+}
@@ -0,0 +1,164 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef _ENCODING_AUTO_TUNER_H_
+#define _ENCODING_AUTO_TUNER_H_
+
+#include "util/CommonHeader.h"
+
+#include <vector>
+
+//
+// EncodingAutoTuner chooses the encoding, the compression level and the JPEG
+// quality level from the measured performance of frame buffer updates.
+//
+// The settings form a ladder of levels: Tight with JPEG from the lowest to
+// the highest quality, then lossless Tight, then ZRLE and Hextile, which
+// save CPU time of decoding but need more bandwidth. An update is measured
+// from its first byte to its end, so the time the server holds the update
+// request doesn't count. Slow updates received about as fast as the link
+// has shown it can transfer are limited by the link, and the tuner moves
+// one level down. Slow updates received slower than that are limited by
+// the decoding, and the tuner moves one level up, as it does if updates
+// are fast (but not beyond lossless Tight). A move needs several
+// measurement windows in a row agreeing on it, and after each move down the
+// tuner waits longer before moving up again, so it doesn't oscillate between
+// two levels.
+//
+// This class isn't thread-safe.
+//
+class EncodingAutoTuner
+{
+public:
+  struct Settings
+  {
+    int encoding;
+    // Compression level and JPEG quality level, -1 if not used.
+    int compressionLevel;
+    int jpegQualityLevel;
+  };
+
+  struct Measurements
+  {
+    int numUpdates;
+    // Bytes per second received while receiving the updates.
+    double bytesPerSecond;
+    // The highest rate of the recent windows, which the link has achieved.
+    double linkBytesPerSecond;
+    // Average values per update: received bytes, time from the first byte
+    // of the update to its end and latency in microseconds (see
+    // CoreEventsAdapter::onFrameBufferUpdateReceived()).
+    UINT64 bytesPerUpdate;
+    UINT64 updateTime;
+    UINT64 latency;
+  };
+
+  EncodingAutoTuner();
+  virtual ~EncodingAutoTuner();
+
+  //
+  // Forgets the measurements and returns to the default settings.
+  //
+  void reset();
+
+  //
+  // Accounts a received update of numBytes bytes, which took updateTime
+  // from its first byte. Time is the current time in microseconds.
+  // Returns true if a measurement window is finished. In this case
+  // settingsChanged is set to true if the settings have been changed.
+  //
+  bool addUpdate(UINT64 numBytes, UINT64 updateTime, UINT64 latency,
+                 UINT64 time, bool *settingsChanged);
+
+  //
+  // Returns the current settings and their level on the ladder.
+  //
+  const Settings *getSettings() const;
+  size_t getLevel() const;
+  static size_t getNumLevels();
+
+  //
+  // Returns the settings used after reset().
+  //
+  static const Settings *getDefaultSettings();
+
+  //
+  // Returns measurements of the last finished window.
+  //
+  const Measurements *getMeasurements() const;
+
+  //
+  // Returns the last measurements made with the settings of the level, the
+  // number of updates is zero if the level has not been used yet.
+  //
+  const Measurements *getLevelMeasurements(size_t level) const;
+
+private:
+  // Returns -1 to move down, 1 to move up or 0 to stay.
+  int getDirection(const Measurements *measurements) const;
+
+  static const Settings LEVELS[];
+  static const size_t NUM_LEVELS;
+  static const size_t DEFAULT_LEVEL = 3;
+  // The highest level to move to if the updates are fast.
+  static const size_t LOSSLESS_LEVEL = 5;
+
+  // Length of measurement window in microseconds and minimal number of
+  // updates in it.
+  static const UINT64 WINDOW_TIME = 1000000;
+  static const int WINDOW_UPDATES = 4;
+  // Average update time in microseconds which is considered slow or fast.
+  static const UINT64 SLOW_UPDATE_TIME = 200000;
+  static const UINT64 FAST_UPDATE_TIME = 60000;
+  // Updates received at this part of the link rate are limited by the link.
+  static const double LINK_BOUND_RATIO;
+  // The link rate falls by this factor in each window, so it follows a
+  // link which has become slower.
+  static const double LINK_RATE_DECAY;
+  // Number of windows in a row needed for a move, the number for a move up
+  // is doubled after each move down, up to the maximum.
+  static const int HOLD_WINDOWS = 3;
+  static const int MAX_UP_HOLD_WINDOWS = 48;
+
+  size_t m_level;
+  Measurements m_measurements;
+  std::vector<Measurements> m_levelMeasurements;
+
+  // Current window.
+  UINT64 m_windowStart;
+  int m_windowUpdates;
+  UINT64 m_windowBytes;
+  UINT64 m_windowUpdateTime;
+  UINT64 m_windowLatency;
+
+  // Bytes per second the link has achieved.
+  double m_linkRate;
+
+  // Direction wanted by the last windows and their number.
+  int m_direction;
+  int m_directionWindows;
+  int m_upHoldWindows;
+};
+
+#endif
@@ -25,6 +25,7 @@
 #include "FbupdateNotifier.h"
 
 #include "thread/AutoLock.h"
+#include "util/PreciseTimer.h"
 
 #include "CoreEventsAdapter.h"
 
@@ -35,6 +36,9 @@ FbUpdateNotifier::FbUpdateNotifier(FrameBuffer *fb, LocalMutex *fbLock, LogWrite
   m_cursorPainter(fb, logWriter),
   m_isNewSize(false),
   m_isCursorChange(false),
+  m_frameInterval(0),
+  m_lastFrameTime(0),
+  m_isWaitingForFrame(false),
   m_adapter(0)
 {
   m_oldPosition = m_cursorPainter.hideCursor();
@@ -84,6 +88,25 @@ void FbUpdateNotifier::execute()
     bool isNewSize;
     bool isCursorChange;
     Region update;
+    UINT64 frameInterval;
+    DWORD frameDelay = 0;
+    {
+      AutoLock al(&m_updateLock);
+      frameInterval = m_frameInterval;
+      // Updates wait for the next frame, a new size doesn't.
+      if (frameInterval != 0 && !m_isNewSize &&
+          (m_isCursorChange || !m_update.isEmpty())) {
+        UINT64 elapsed = PreciseTimer::getMicroseconds() - m_lastFrameTime;
+        if (elapsed < frameInterval) {
+          frameDelay = (DWORD)((frameInterval - elapsed + 999) / 1000);
+        }
+      }
+      m_isWaitingForFrame = frameDelay != 0;
+    }
+    if (frameDelay != 0) {
+      m_eventUpdate.waitForEvent(frameDelay);
+      continue;
+    }
     {
       AutoLock al(&m_updateLock);
       isNewSize = m_isNewSize;
@@ -123,16 +146,20 @@ void FbUpdateNotifier::execute()
 
       vector<Rect> updateList;
       update.getRectVector(&updateList);
+      if (frameInterval != 0) {
+        vector<Rect> rects;
+        rects.swap(updateList);
+        mergeRects(&rects, &updateList);
+      }
       m_logWriter->detail(_T("FbUpdateNotifier (event): %u updates"), updateList.size());
 
       try {
-        for (vector<Rect>::iterator i = updateList.begin(); i != updateList.end(); i++) {
-          m_adapter->onFrameBufferUpdate(m_frameBuffer, &*i);
-        }
+        m_adapter->onFrameBufferUpdates(m_frameBuffer, &updateList);
       } catch (...) {
         m_logWriter->error(_T("FbUpdateNotifier (event): error in update"));
       }
       m_oldPosition = m_cursorPainter.hideCursor();
+      m_lastFrameTime = PreciseTimer::getMicroseconds();
     }
 
     // Pause this thread, if there are no updates (cursor, frame buffer).
@@ -147,13 +174,52 @@ void FbUpdateNotifier::onTerminate()
   m_eventUpdate.notify();
 }
 
+void FbUpdateNotifier::mergeRects(const vector<Rect> *rects,
+                                  vector<Rect> *merged)
+{
+  merged->clear();
+  for (vector<Rect>::const_iterator i = rects->begin(); i != rects->end(); i++) {
+    // Find the rectangle which is the cheapest to merge with.
+    size_t best = 0;
+    int bestCost = 0;
+    for (size_t j = 0; j < merged->size(); j++) {
+      Rect bounds = getBounds(&(*merged)[j], &*i);
+      int cost = bounds.area() - (*merged)[j].area() - i->area();
+      if (j == 0 || cost < bestCost) {
+        best = j;
+        bestCost = cost;
+      }
+    }
+    if (!merged->empty() &&
+        (bestCost <= MERGE_COST || merged->size() >= MAX_MERGED_RECTS)) {
+      (*merged)[best] = getBounds(&(*merged)[best], &*i);
+    } else {
+      merged->push_back(*i);
+    }
+  }
+}
+
+Rect FbUpdateNotifier::getBounds(const Rect *first, const Rect *second)
+{
+  return Rect(min(first->left, second->left),
+              min(first->top, second->top),
+              max(first->right, second->right),
+              max(first->bottom, second->bottom));
+}
+
 void FbUpdateNotifier::onUpdate(const Rect *update)
 {
+  bool isWaitingForFrame;
   {
     AutoLock al(&m_updateLock);
     m_update.addRect(update);
+    isWaitingForFrame = m_isWaitingForFrame;
+  }
+  // The thread waiting for the next frame takes the update anyway, so it
+  // isn't woken up for each rectangle.
+  if (!isWaitingForFrame) {
+    m_eventUpdate.notify();
   }
-  m_eventUpdate.notify();
   m_logWriter->debug(_T("FbUpdateNotifier: added rectangle"));
 }
 
@@ -174,7 +240,9 @@ void FbUpdateNotifier::updatePointerPos(const Point *position)
 
   AutoLock al(&m_updateLock);
   m_isCursorChange = true;
-  m_eventUpdate.notify();
+  if (!m_isWaitingForFrame) {
+    m_eventUpdate.notify();
+  }
 }
 
 void FbUpdateNotifier::setNewCursor(const Point *hotSpot,
@@ -191,6 +259,13 @@ void FbUpdateNotifier::setNewCursor(const Point *hotSpot,
   m_eventUpdate.notify();
 }
 
+void FbUpdateNotifier::setFrameRate(int fps)
+{
+  AutoLock al(&m_updateLock);
+  m_frameInterval = fps > 0 ? 1000000 / fps : 0;
+  m_eventUpdate.notify();
+}
+
 void FbUpdateNotifier::setIgnoreShapeUpdates(bool ignore)
 {
   m_cursorPainter.setIgnoreShapeUpdates(ignore);
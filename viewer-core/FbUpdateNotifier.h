@@ -56,11 +56,24 @@ public:
                     const vector<UINT8> *bitmask);
 
   void setIgnoreShapeUpdates(bool ignore);
+
+  // Set the maximum rate of update notifications, in frames per second.
+  // The updates made between two notifications are delivered in one
+  // CoreEventsAdapter::onFrameBufferUpdates() call, merged into a few
+  // rectangles. Zero (default) means no limit, then the updates are not
+  // merged.
+  void setFrameRate(int fps);
 protected:
   // Inherited from Thread
   void execute();
   void onTerminate();
 
+  // Merges rects into at most MAX_MERGED_RECTS rectangles. Two rectangles
+  // are merged if their bounding rectangle has at most MERGE_COST pixels
+  // more than them, or if there are too many rectangles.
+  static void mergeRects(const vector<Rect> *rects, vector<Rect> *merged);
+  static Rect getBounds(const Rect *first, const Rect *second);
+
   LocalMutex *m_fbLock;
   FrameBuffer *m_frameBuffer;
   CursorPainter m_cursorPainter;
@@ -87,6 +100,18 @@ protected:
   // This flag is true after set new cursor or update position.
   bool m_isCursorChange;
 
+  // Minimal time between two notifications in microseconds, or 0.
+  UINT64 m_frameInterval;
+  // Time of the last notification, it's used only by the notifier thread.
+  UINT64 m_lastFrameTime;
+  // This flag is true while the thread sleeps until the next frame with
+  // updates pending. Then new updates and pointer moves don't wake it up.
+  bool m_isWaitingForFrame;
+
+  static const size_t MAX_MERGED_RECTS = 16;
+  // An extra callback costs about as much as drawing of this many pixels.
+  static const int MERGE_COST = 4096;
+
 private:
   // Do not allow copying objects.
   FbUpdateNotifier(const FbUpdateNotifier &);
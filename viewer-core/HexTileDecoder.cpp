@@ -24,6 +24,8 @@
 
 #include "HexTileDecoder.h"
 
+#include "RowBlitter.h"
+
 HexTileDecoder::HexTileDecoder(LogWriter *logWriter)
 : DecoderOfRectangle(logWriter)
 {
@@ -59,9 +61,20 @@ void HexTileDecoder::decode(RfbInputGate *input,
       UINT8 flags = input->readUInt8();
       // If tile-coding is RAW.
       if (flags & 0x1) {
-        for (int y = tileRect.top; y < tileRect.bottom; y++)
-          input->readFully(framebuffer->getBufferPtr(tileRect.left, y),
-                           tileRect.getWidth() * bytesPerPixel);
+        // Read the whole tile at once and spread it by rows.
+        UINT8 tilePixels[TILE_SIZE * TILE_SIZE * 4];
+        size_t srcStride = tileRect.getWidth() * bytesPerPixel;
+        input->readFully(tilePixels, srcStride * tileRect.getHeight());
+
+        size_t dstStride = framebuffer->getBytesPerRow();
+        UINT8 *dst = (UINT8 *)framebuffer->getBufferPtr(tileRect.left,
+                                                        tileRect.top);
+        const UINT8 *src = tilePixels;
+        for (int y = tileRect.top; y < tileRect.bottom; y++) {
+          RowBlitter::copyRow(dst, src, tileRect.getWidth(), bytesPerPixel);
+          dst += dstStride;
+          src += srcStride;
+        }
       } else {
         if (flags & 0x2) {
           input->readFully(&background, bytesPerPixel);
@@ -68,7 +68,8 @@ void JpegDecompressor::outputMessage(j_common_ptr cinfo)
 void JpegDecompressor::decompress(vector<UINT8> &buffer,
                                   size_t jpegBufLen,
                                   vector<UINT8> &pixels,
-                                  const Rect *dstRect)
+                                  const Rect *dstRect,
+                                  const PixelFormat *directFormat)
 {
   if (!dstRect->isValid())
     throw Exception(_T("invalid destination rectangle in jpeg-decompressor"));
@@ -78,9 +79,17 @@ void JpegDecompressor::decompress(vector<UINT8> &buffer,
   UINT8 *src_buf = &buffer.front();
   size_t src_buf_size = jpegBufLen;
 
+  J_COLOR_SPACE colorSpace = JCS_RGB;
+  size_t bytesPerPixel = BYTES_PER_PIXEL;
+  if (directFormat != 0) {
+    if (!getDirectColorSpace(directFormat, &colorSpace))
+      throw Exception(_T("unsupported output format in jpeg-decompressor"));
+    bytesPerPixel = DIRECT_BYTES_PER_PIXEL;
+  }
+
   size_t width = dstRect->getWidth();
   size_t height = dstRect->getHeight();
-  size_t pixelBufferCount =  width * height * BYTES_PER_PIXEL;
+  size_t pixelBufferCount =  width * height * bytesPerPixel;
   if (pixels.size() == 0 || pixels.size() < pixelBufferCount)
     throw Exception(_T("incorrect size of pixels-buffer in jpeg-decompressor"));
   UINT8 *dst_buf = &pixels.front();
@@ -101,7 +110,7 @@ void JpegDecompressor::decompress(vector<UINT8> &buffer,
     }
 
     /* Configure and start decompression. */
-    m_jpeg.cinfo.out_color_space = JCS_RGB;
+    m_jpeg.cinfo.out_color_space = colorSpace;
     jpeg_start_decompress(&m_jpeg.cinfo);
     if (m_jpeg.cinfo.output_width != jpegWidth ||
         m_jpeg.cinfo.output_height != jpegHeight ) {
@@ -112,7 +121,7 @@ void JpegDecompressor::decompress(vector<UINT8> &buffer,
     /* Consume decompressed data. */
     while (m_jpeg.cinfo.output_scanline < m_jpeg.cinfo.output_height) {
       size_t bufferIndex = m_jpeg.cinfo.output_scanline;
-      size_t bufferOffset = bufferIndex * width * BYTES_PER_PIXEL;
+      size_t bufferOffset = bufferIndex * width * bytesPerPixel;
 
       JSAMPROW row_ptr[1];
       row_ptr[0] = &dst_buf[bufferOffset];
@@ -130,6 +139,47 @@ void JpegDecompressor::decompress(vector<UINT8> &buffer,
   }
 }
 
+bool JpegDecompressor::isDirectFormat(const PixelFormat *pf)
+{
+  J_COLOR_SPACE colorSpace;
+  return getDirectColorSpace(pf, &colorSpace);
+}
+
+bool JpegDecompressor::getDirectColorSpace(const PixelFormat *pf,
+                                           J_COLOR_SPACE *colorSpace)
+{
+#ifdef JCS_EXTENSIONS
+  if (pf->bitsPerPixel != 32 || pf->colorDepth != 24 || pf->bigEndian ||
+      pf->redMax != 255 || pf->greenMax != 255 || pf->blueMax != 255) {
+    return false;
+  }
+  // Each color component should occupy a whole byte. The pixel format uses
+  // native (little-endian) byte order, so a shift of N bits means the
+  // component is stored in byte N / 8.
+  if (pf->redShift % 8 != 0 || pf->greenShift % 8 != 0 ||
+      pf->blueShift % 8 != 0) {
+    return false;
+  }
+  int r = pf->redShift / 8;
+  int g = pf->greenShift / 8;
+  int b = pf->blueShift / 8;
+
+  if (r == 0 && g == 1 && b == 2) {
+    *colorSpace = JCS_EXT_RGBX;
+  } else if (r == 2 && g == 1 && b == 0) {
+    *colorSpace = JCS_EXT_BGRX;
+  } else if (r == 1 && g == 2 && b == 3) {
+    *colorSpace = JCS_EXT_XRGB;
+  } else if (r == 3 && g == 2 && b == 1) {
+    *colorSpace = JCS_EXT_XBGR;
+  } else {
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
 
 void JpegDecompressor::init()
 {
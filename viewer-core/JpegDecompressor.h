@@ -28,6 +28,7 @@
 #include <cstdio>
 
 #include "region/Rect.h"
+#include "rfb/PixelFormat.h"
 
 // More help of jpeg-lib in /usr/share/doc/jpeg-8c-r1/example.c.bz2
 
@@ -48,6 +49,8 @@ class JpegDecompressor
 {
 public:
   static const size_t BYTES_PER_PIXEL = 3;
+  // Size of pixel in the direct output (see isDirectFormat()).
+  static const size_t DIRECT_BYTES_PER_PIXEL = 4;
 public:
   JpegDecompressor();
   virtual ~JpegDecompressor();
@@ -57,11 +60,23 @@ public:
    * advance, and dst_buf should have place for (w * h * 3) bytes. The output
    * format is an array of bytes where each pixel is represented by three bytes
    * for red, green and blue components, in that order.
+   *
+   * If directFormat is not 0, the output is in this pixel format instead,
+   * and dst_buf should have place for (w * h * 4) bytes. The format must
+   * be supported (see isDirectFormat()).
    */
   void decompress(vector<UINT8> &buffer,
                   size_t jpegBufLen,
                   vector<UINT8> &pixels,
-                  const Rect *dstRect);
+                  const Rect *dstRect,
+                  const PixelFormat *directFormat = 0);
+
+  /*
+   * Check if the data can be decompressed right in the given pixel format.
+   * It's possible with the extended color spaces of libjpeg-turbo, for
+   * 32-bit pixel formats where each color component takes a whole byte.
+   */
+  static bool isDirectFormat(const PixelFormat *pf);
 
 private:
   /*
@@ -78,6 +93,9 @@ private:
    */
   void cleanup();
 
+  static bool getDirectColorSpace(const PixelFormat *pf,
+                                  J_COLOR_SPACE *colorSpace);
+
 private:
   METHODDEF(StringStorage) getMessage(j_common_ptr cinfo);
   METHODDEF(void) errorExit(j_common_ptr cinfo);
@@ -0,0 +1,152 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "JpegDecompressorPool.h"
+
+#include "thread/AutoLock.h"
+
+JpegDecompressorWorker::JpegDecompressorWorker(JpegDecompressorPool *owner)
+: m_owner(owner)
+{
+  resume();
+}
+
+JpegDecompressorWorker::~JpegDecompressorWorker()
+{
+  terminate();
+  wait();
+}
+
+void JpegDecompressorWorker::execute()
+{
+  while (!isTerminating()) {
+    JpegDecompressionJob *job = m_owner->takeJob();
+    if (job != 0) {
+      decompressJob(job);
+    } else {
+      m_owner->m_newJob.waitForEvent();
+    }
+  }
+  // Pass the wake-up signal to other workers being terminated.
+  m_owner->m_newJob.notify();
+}
+
+void JpegDecompressorWorker::onTerminate()
+{
+  m_owner->m_newJob.notify();
+}
+
+void JpegDecompressorWorker::decompressJob(JpegDecompressionJob *job)
+{
+  bool failed = false;
+  StringStorage errorMessage;
+  try {
+    m_decompressor.decompress(job->jpegData, job->jpegLength, job->pixels,
+                              &job->rect,
+                              job->isDirect ? &job->directFormat : 0);
+  } catch (const Exception &e) {
+    failed = true;
+    errorMessage.setString(e.getMessage());
+  }
+  m_owner->onJobDone(job, failed, &errorMessage);
+}
+
+//--------------------------------------------------------------------------//
+
+JpegDecompressorPool::JpegDecompressorPool(int numThreads)
+{
+  for (int i = 0; i < numThreads; i++) {
+    m_workers.push_back(new JpegDecompressorWorker(this));
+  }
+}
+
+JpegDecompressorPool::~JpegDecompressorPool()
+{
+  // Request termination of all the workers first, then wait for each one.
+  for (size_t i = 0; i < m_workers.size(); i++) {
+    m_workers[i]->terminate();
+  }
+  for (size_t i = 0; i < m_workers.size(); i++) {
+    delete m_workers[i];
+  }
+}
+
+int JpegDecompressorPool::getNumThreads() const
+{
+  return (int)m_workers.size();
+}
+
+void JpegDecompressorPool::submit(JpegDecompressionJob *job)
+{
+  {
+    // The job may have been used before.
+    AutoLock al(&m_doneLock);
+    job->done = false;
+    job->failed = false;
+  }
+  {
+    AutoLock al(&m_queueLock);
+    m_queue.push_back(job);
+  }
+  m_newJob.notify();
+}
+
+bool JpegDecompressorPool::isDone(JpegDecompressionJob *job)
+{
+  AutoLock al(&m_doneLock);
+  return job->done;
+}
+
+void JpegDecompressorPool::waitForJob(JpegDecompressionJob *job)
+{
+  while (!isDone(job)) {
+    m_jobDone.waitForEvent();
+  }
+}
+
+JpegDecompressionJob *JpegDecompressorPool::takeJob()
+{
+  AutoLock al(&m_queueLock);
+  if (m_queue.empty()) {
+    return 0;
+  }
+  JpegDecompressionJob *job = m_queue.front();
+  m_queue.pop_front();
+  if (!m_queue.empty()) {
+    m_newJob.notify();
+  }
+  return job;
+}
+
+void JpegDecompressorPool::onJobDone(JpegDecompressionJob *job, bool failed,
+                                     const StringStorage *errorMessage)
+{
+  {
+    AutoLock al(&m_doneLock);
+    job->failed = failed;
+    job->errorMessage = *errorMessage;
+    job->done = true;
+  }
+  m_jobDone.notify();
+}
@@ -0,0 +1,145 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef _JPEG_DECOMPRESSOR_POOL_H_
+#define _JPEG_DECOMPRESSOR_POOL_H_
+
+#include <deque>
+#include <vector>
+
+#include "region/Rect.h"
+#include "rfb/PixelFormat.h"
+#include "thread/Thread.h"
+#include "thread/LocalMutex.h"
+#include "util/StringStorage.h"
+#include "win-system/WindowsEvent.h"
+#include "JpegDecompressor.h"
+
+class JpegDecompressorPool;
+
+// One JPEG rectangle to be decompressed by a JpegDecompressorPool worker.
+// Jobs are reused, so their buffers may be larger than the data in them.
+struct JpegDecompressionJob
+{
+  JpegDecompressionJob()
+  : jpegLength(0), isDirect(false), done(false), failed(false) {}
+
+  Rect rect;
+  // Compressed data, first jpegLength bytes of the buffer.
+  std::vector<UINT8> jpegData;
+  size_t jpegLength;
+  // If isDirect is true, the pixels are decompressed in directFormat.
+  // Otherwise, they are decompressed as RGB (see JpegDecompressor).
+  PixelFormat directFormat;
+  bool isDirect;
+
+  // Decompressed pixels, filled in by the worker thread.
+  std::vector<UINT8> pixels;
+
+  // The fields below are changed by the worker thread, access to them must
+  // be synchronized via JpegDecompressorPool.
+  bool done;
+  bool failed;
+  StringStorage errorMessage;
+};
+
+// A worker thread with its own JPEG decompressor.
+class JpegDecompressorWorker : public Thread
+{
+public:
+  JpegDecompressorWorker(JpegDecompressorPool *owner);
+  virtual ~JpegDecompressorWorker();
+
+protected:
+  virtual void execute();
+  virtual void onTerminate();
+
+  void decompressJob(JpegDecompressionJob *job);
+
+  JpegDecompressorPool *m_owner;
+  JpegDecompressor m_decompressor;
+
+private:
+  // Do not allow copying objects.
+  JpegDecompressorWorker(const JpegDecompressorWorker &other);
+  JpegDecompressorWorker &operator=(const JpegDecompressorWorker &other);
+};
+
+// JpegDecompressorPool decompresses JPEG rectangles in a number of worker
+// threads, each one using its own JpegDecompressor. JPEG rectangles carry
+// no state of zlib streams, so they can be decompressed in any order.
+// Drawing them in the order of the update is up to the caller: it submits
+// a number of jobs and then waits for them in the order of submission.
+//
+// submit(), isDone() and waitForJob() should be called from one thread.
+class JpegDecompressorPool
+{
+  friend class JpegDecompressorWorker;
+
+public:
+  JpegDecompressorPool(int numThreads);
+  virtual ~JpegDecompressorPool();
+
+  int getNumThreads() const;
+
+  // Queue the job for decompression. The caller keeps ownership of the job
+  // but may not delete or change it until it's finished.
+  void submit(JpegDecompressionJob *job);
+
+  // Check if the job is finished (successfully or not).
+  bool isDone(JpegDecompressionJob *job);
+
+  // Wait until the job is finished (successfully or not).
+  void waitForJob(JpegDecompressionJob *job);
+
+protected:
+  // Called by worker threads. Return the next job from the queue or 0 if
+  // the queue is empty.
+  JpegDecompressionJob *takeJob();
+  // Called by worker threads when a job is finished.
+  void onJobDone(JpegDecompressionJob *job, bool failed,
+                 const StringStorage *errorMessage);
+
+  std::vector<JpegDecompressorWorker *> m_workers;
+
+  // Jobs waiting for a free worker.
+  std::deque<JpegDecompressionJob *> m_queue;
+  LocalMutex m_queueLock;
+  // Notified when new jobs are queued. The worker which gets a job notifies
+  // it again if there are more jobs in the queue, so that other workers
+  // would wake up too.
+  WindowsEvent m_newJob;
+
+  // Synchronizes access to the done, failed and errorMessage fields of jobs.
+  LocalMutex m_doneLock;
+  // Notified by worker threads each time a job is finished.
+  WindowsEvent m_jobDone;
+
+private:
+  // Do not allow copying objects.
+  JpegDecompressorPool(const JpegDecompressorPool &other);
+  JpegDecompressorPool &operator=(const JpegDecompressorPool &other);
+};
+
+#endif
@@ -31,6 +31,7 @@
 #include "rfb/EncodingDefs.h"
 #include "rfb/VendorDefs.h"
 #include "util/AnsiStringStorage.h"
+#include "util/PreciseTimer.h"
 
 #include "AuthHandler.h"
 #include "RichCursorDecoder.h"
@@ -62,7 +63,8 @@ RemoteViewerCore::RemoteViewerCore(Logger *logger)
 : m_logWriter(logger),
   m_tcpConnection(&m_logWriter),
   m_fbUpdateNotifier(&m_frameBuffer, &m_fbLock, &m_logWriter),
-  m_decoderStore(&m_logWriter)
+  m_decoderStore(&m_logWriter),
+  m_countedInput(&m_countingInput)
 {
   init();
 }
@@ -74,7 +76,8 @@ RemoteViewerCore::RemoteViewerCore(const TCHAR *host, UINT16 port,
 : m_logWriter(logger),
   m_tcpConnection(&m_logWriter),
   m_fbUpdateNotifier(&m_frameBuffer, &m_fbLock, &m_logWriter),
-  m_decoderStore(&m_logWriter)
+  m_decoderStore(&m_logWriter),
+  m_countedInput(&m_countingInput)
 {
   init();
 
@@ -88,7 +91,8 @@ RemoteViewerCore::RemoteViewerCore(SocketIPv4 *socket,
 : m_logWriter(logger),
   m_tcpConnection(&m_logWriter),
   m_fbUpdateNotifier(&m_frameBuffer, &m_fbLock, &m_logWriter),
-  m_decoderStore(&m_logWriter)
+  m_decoderStore(&m_logWriter),
+  m_countedInput(&m_countingInput)
 {
   init();
 
@@ -102,7 +106,8 @@ RemoteViewerCore::RemoteViewerCore(RfbInputGate *input, RfbOutputGate *output,
 : m_logWriter(logger),
   m_tcpConnection(&m_logWriter),
   m_fbUpdateNotifier(&m_frameBuffer, &m_fbLock, &m_logWriter),
-  m_decoderStore(&m_logWriter)
+  m_decoderStore(&m_logWriter),
+  m_countedInput(&m_countingInput)
 {
   init();
 
@@ -131,6 +136,13 @@ void RemoteViewerCore::init()
   m_isNewPixelFormat = false;
   m_isFreeze = false;
   m_isNeedRequestUpdate = true;
+  m_isPipelining = false;
+  m_requestTime = 0;
+  m_isReadingAhead = false;
+  m_readAhead = 0;
+  m_readAheadInput = 0;
+  m_lastDecoder = 0;
+  m_isAutoTuning = false;
 }
 
 RemoteViewerCore::~RemoteViewerCore()
@@ -148,6 +160,8 @@ RemoteViewerCore::~RemoteViewerCore()
     }
   } catch (...) {
   }
+  delete m_readAheadInput;
+  delete m_readAhead;
 }
 
 void RemoteViewerCore::start(CoreEventsAdapter *adapter,
@@ -218,14 +232,31 @@ bool RemoteViewerCore::wasConnected() const
 void RemoteViewerCore::stop()
 {
   m_tcpConnection.close();
+  {
+    // The core thread is terminated under the lock, so it creates the
+    // read-ahead stream either before it or already terminated.
+    AutoLock al(&m_readAheadLock);
+    terminate();
+    if (m_readAhead != 0) {
+      m_readAhead->terminate();
+    }
+  }
   m_fbUpdateNotifier.terminate();
-  terminate();
 }
 
 void RemoteViewerCore::waitTermination()
 {
   m_fbUpdateNotifier.wait();
   wait();
+  // The core thread has finished, so the stream can't be created anymore.
+  ReadAheadInputStream *readAhead;
+  {
+    AutoLock al(&m_readAheadLock);
+    readAhead = m_readAhead;
+  }
+  if (readAhead != 0) {
+    readAhead->wait();
+  }
 }
 
 void RemoteViewerCore::setPixelFormat(const PixelFormat *pixelFormat)
@@ -277,19 +308,29 @@ void RemoteViewerCore::refreshFrameBuffer()
   m_isRefreshing = true;
 }
 
-void RemoteViewerCore::sendFbUpdateRequest(bool incremental)
+bool RemoteViewerCore::sendFbUpdateRequest(bool incremental,
+                                           bool canUpdatePixelFormat)
 {
   {
     AutoLock al(&m_requestUpdateLock);
     bool requestUpdate = m_isNeedRequestUpdate;
     m_isNeedRequestUpdate = false;
     if (!requestUpdate)
-      return;
+      return false;
+  }
+
+  if (!canUpdatePixelFormat) {
+    // The frame buffer is used by the update being decoded, so the new pixel
+    // format will be set by the request sent after this update.
+    AutoLock al(&m_pixelFormatLock);
+    if (m_isNewPixelFormat) {
+      return false;
+    }
   }
 
   bool isRefresh = false;
   bool isUpdateFbProperties = false;
-  if (updatePixelFormat()) {
+  if (canUpdatePixelFormat && updatePixelFormat()) {
     isUpdateFbProperties = true;
   }
 
@@ -316,9 +357,14 @@ void RemoteViewerCore::sendFbUpdateRequest(bool incremental)
                       updateRect.getWidth(), updateRect.getHeight());
   }
 
+  {
+    AutoLock al(&m_requestUpdateLock);
+    m_requestTime = PreciseTimer::getMicroseconds();
+  }
   RfbFramebufferUpdateRequestClientMessage fbUpdReq(isIncremental, updateRect);
   fbUpdReq.send(m_output);
   m_logWriter.debug(_T("Frame buffer update request is sent"));
+  return true;
 }
 
 void RemoteViewerCore::sendKeyboardEvent(bool downFlag, UINT32 key)
@@ -372,6 +418,10 @@ void RemoteViewerCore::sendCutTextEvent(const StringStorage *cutText)
 
 void RemoteViewerCore::setPreferredEncoding(INT32 encodingType)
 {
+  // The auto-tuner sets the encoding itself.
+  if (m_isAutoTuning) {
+    return;
+  }
   m_decoderStore.setPreferredEncoding(encodingType);
   sendEncodings();
 }
@@ -383,6 +433,16 @@ void RemoteViewerCore::allowCopyRect(bool allow)
 }
 
 void RemoteViewerCore::setCompressionLevel(int newLevel)
+{
+  if (m_isAutoTuning) {
+    return;
+  }
+  if (updateCompressionLevel(newLevel)) {
+    sendEncodings();
+  }
+}
+
+bool RemoteViewerCore::updateCompressionLevel(int newLevel)
 {
   bool needUpdate = false;
   for (int level = CompressionLevel::COMPRESSION_LEVEL_MIN;
@@ -394,15 +454,23 @@ void RemoteViewerCore::setCompressionLevel(int newLevel)
   // new compression level is valid?
   if (newLevel < CompressionLevel::COMPRESSION_LEVEL_MIN ||
       newLevel > CompressionLevel::COMPRESSION_LEVEL_MAX)
-    return;
+    return needUpdate;
 
   needUpdate |= m_decoderStore.addDecoder(new CompressionLevel(&m_logWriter, newLevel), -1);
-  if (needUpdate) {
+  return needUpdate;
+}
+
+void RemoteViewerCore::setJpegQualityLevel(int newLevel)
+{
+  if (m_isAutoTuning) {
+    return;
+  }
+  if (updateJpegQualityLevel(newLevel)) {
     sendEncodings();
   }
 }
 
-void RemoteViewerCore::setJpegQualityLevel(int newLevel)
+bool RemoteViewerCore::updateJpegQualityLevel(int newLevel)
 {
   bool needUpdate = false;
   for (int level = JpegQualityLevel::JPEG_QUALITY_LEVEL_MIN;
@@ -414,12 +482,10 @@ void RemoteViewerCore::setJpegQualityLevel(int newLevel)
   // new jpeg quality level is valid?
   if (newLevel < JpegQualityLevel::JPEG_QUALITY_LEVEL_MIN ||
       newLevel > JpegQualityLevel::JPEG_QUALITY_LEVEL_MAX)
-    return;
+    return needUpdate;
 
   needUpdate |= m_decoderStore.addDecoder(new JpegQualityLevel(&m_logWriter, newLevel), -1);
-  if (needUpdate) {
-    sendEncodings();
-  }
+  return needUpdate;
 }
 
 void RemoteViewerCore::enableCursorShapeUpdates(bool enabled)
@@ -438,6 +504,36 @@ void RemoteViewerCore::enableCursorShapeUpdates(bool enabled)
   }
 }
 
+void RemoteViewerCore::enableUpdatePipelining(bool enabled)
+{
+  AutoLock al(&m_requestUpdateLock);
+  m_isPipelining = enabled;
+}
+
+void RemoteViewerCore::enableReadAhead(bool enabled)
+{
+  m_isReadingAhead = enabled;
+}
+
+void RemoteViewerCore::setDecodingThreadCount(int numThreads)
+{
+  TightDecoder *tightDecoder =
+    dynamic_cast<TightDecoder *>(m_decoderStore.getDecoder(EncodingDefs::TIGHT));
+  if (tightDecoder != 0) {
+    tightDecoder->setThreadCount(numThreads);
+  }
+}
+
+void RemoteViewerCore::setFrameRate(int fps)
+{
+  m_fbUpdateNotifier.setFrameRate(fps);
+}
+
+void RemoteViewerCore::enableAutoTuning(bool enabled)
+{
+  m_isAutoTuning = enabled;
+}
+
 void RemoteViewerCore::ignoreCursorShapeUpdates(bool ignored)
 {
   m_fbUpdateNotifier.setIgnoreShapeUpdates(ignored);
@@ -789,6 +885,31 @@ void RemoteViewerCore::execute()
     // is connected
     m_logWriter.info(_T("Protocol stage is \"Is connected\"."));
 
+    // From now on, the connection is read in a separate thread, so the server
+    // isn't stalled while the decoders are busy.
+    if (m_isReadingAhead) {
+      m_logWriter.detail(_T("Starting reading ahead of the decoding"));
+      {
+        AutoLock al(&m_readAheadLock);
+        m_readAhead = new ReadAheadInputStream(READ_AHEAD_CAPACITY);
+        m_readAheadInput = new RfbInputGate(m_readAhead);
+        m_readAhead->start(m_input);
+        if (isTerminating()) {
+          m_readAhead->terminate();
+        }
+      }
+      m_input = m_readAheadInput;
+    }
+
+    // The auto-tuner needs the amount of received data. Its settings are
+    // sent as the first encodings.
+    if (m_isAutoTuning) {
+      m_countingInput.setInput(m_input);
+      m_input = &m_countedInput;
+      m_autoTuner.reset();
+      applyTunedSettings();
+    }
+
     try {
       m_adapter->onConnected(m_output);
     } catch (const Exception &ex) {
@@ -919,22 +1040,87 @@ void RemoteViewerCore::receiveFbUpdate()
 {
   // message type is already known: 0
 
+  // The message type has been read, so the update started with the byte
+  // before the current one.
+  UINT64 startTime = PreciseTimer::getMicroseconds();
+  UINT64 startBytes = 0;
+  if (m_isAutoTuning) {
+    startBytes = m_countingInput.getBytesRead() - 1;
+  }
+
   // read padding: one byte
   m_input->readUInt8();
 
   UINT16 numberOfRectangles = m_input->readUInt16();
   m_logWriter.debug(_T("number of rectangles: %d"), numberOfRectangles);
 
+  UINT64 requestTime;
+  bool isPipelining;
+  {
+    AutoLock al(&m_requestUpdateLock);
+    requestTime = m_requestTime;
+    m_requestTime = 0;
+    isPipelining = m_isPipelining;
+  }
+
+  // With pipelining, the next update is requested right now, so the server
+  // prepares it while this one is received and decoded.
+  bool isNextRequested = false;
+  if (isPipelining) {
+    bool isFreeze;
+    {
+      AutoLock al(&m_freezeLock);
+      isFreeze = m_isFreeze;
+    }
+    if (!isFreeze) {
+      {
+        AutoLock al(&m_requestUpdateLock);
+        m_isNeedRequestUpdate = true;
+      }
+      m_logWriter.detail(_T("Sending of pipelined frame buffer update request..."));
+      isNextRequested = sendFbUpdateRequest(true, false);
+    }
+  }
+
   bool isLastRect = false;
-  for (int rectangle = 0; rectangle < numberOfRectangles && !isLastRect; rectangle++) {
-    m_logWriter.debug(_T("Receiving rectangle #%d..."), rectangle);
-    isLastRect = receiveFbUpdateRectangle();
+  int rectangle;
+  try {
+    for (rectangle = 0; rectangle < numberOfRectangles && !isLastRect; rectangle++) {
+      m_logWriter.debug(_T("Receiving rectangle #%d..."), rectangle);
+      isLastRect = receiveFbUpdateRectangle();
+    }
+    // All rectangles must be in frame buffer before the update is reported.
+    flushDecoding();
+  } catch (...) {
+    try {
+      flushDecoding();
+    } catch (...) {
+    }
+    throw;
   }
 
-  {
+  UINT64 endTime = PreciseTimer::getMicroseconds();
+  if (!isNextRequested) {
     AutoLock al(&m_requestUpdateLock);
     m_isNeedRequestUpdate = true;
   }
+  UINT64 latency = requestTime != 0 ? endTime - requestTime : 0;
+  try {
+    m_adapter->onFrameBufferUpdateReceived(rectangle, endTime - startTime,
+                                           latency);
+  } catch (const Exception &ex) {
+    m_logWriter.error(_T("Error in CoreEventsAdapter::onFrameBufferUpdateReceived(): %s"),
+                      ex.getMessage());
+  } catch (...) {
+    m_logWriter.error(_T("Unknown error in CoreEventsAdapter::onFrameBufferUpdateReceived()"));
+  }
+  if (m_isAutoTuning) {
+    tuneEncoding(m_countingInput.getBytesRead() - startBytes,
+                 endTime - startTime, latency, endTime);
+  }
+  if (isNextRequested) {
+    return;
+  }
   {
     AutoLock al(&m_freezeLock);
     if (m_isFreeze)
@@ -969,6 +1155,10 @@ bool RemoteViewerCore::receiveFbUpdateRectangle()
       m_logWriter.debug(_T("Decoding..."));
 
       DecoderOfRectangle *rectangleDecoder = dynamic_cast<DecoderOfRectangle *>(decoder);
+      if (rectangleDecoder != m_lastDecoder) {
+        flushDecoding();
+      }
+      m_lastDecoder = rectangleDecoder;
       rectangleDecoder->process(m_input,
                                 &m_frameBuffer, &m_rectangleFb, &rect, &m_fbLock,
                                 &m_fbUpdateNotifier);
@@ -982,11 +1172,55 @@ bool RemoteViewerCore::receiveFbUpdateRectangle()
     } 
   } else { // it's pseudo encoding
     m_logWriter.debug(_T("It's pseudo encoding"));
+    flushDecoding();
     processPseudoEncoding(&rect, encodingType);
   }
   return false;
 }
 
+void RemoteViewerCore::tuneEncoding(UINT64 numBytes, UINT64 updateTime,
+                                    UINT64 latency, UINT64 time)
+{
+  bool isChanged;
+  if (!m_autoTuner.addUpdate(numBytes, updateTime, latency, time, &isChanged)) {
+    return;
+  }
+  const EncodingAutoTuner::Settings *settings = m_autoTuner.getSettings();
+  if (isChanged) {
+    m_logWriter.info(_T("Auto-tuning: encoding %d, compression level %d, ")
+                     _T("JPEG quality level %d"),
+                     settings->encoding, settings->compressionLevel,
+                     settings->jpegQualityLevel);
+    applyTunedSettings();
+    sendEncodings();
+  }
+  try {
+    m_adapter->onEncodingTuned(settings, m_autoTuner.getMeasurements());
+  } catch (const Exception &ex) {
+    m_logWriter.error(_T("Error in CoreEventsAdapter::onEncodingTuned(): %s"),
+                      ex.getMessage());
+  } catch (...) {
+    m_logWriter.error(_T("Unknown error in CoreEventsAdapter::onEncodingTuned()"));
+  }
+}
+
+void RemoteViewerCore::applyTunedSettings()
+{
+  const EncodingAutoTuner::Settings *settings = m_autoTuner.getSettings();
+  m_decoderStore.setPreferredEncoding(settings->encoding);
+  updateCompressionLevel(settings->compressionLevel);
+  updateJpegQualityLevel(settings->jpegQualityLevel);
+}
+
+void RemoteViewerCore::flushDecoding()
+{
+  if (m_lastDecoder != 0) {
+    DecoderOfRectangle *decoder = m_lastDecoder;
+    m_lastDecoder = 0;
+    decoder->flush();
+  }
+}
+
 void RemoteViewerCore::processPseudoEncoding(const Rect *rect,
                                              int encodingType)
 {
@@ -25,8 +25,10 @@
 #ifndef _REMOTE_VIEWER_CORE_H_
 #define _REMOTE_VIEWER_CORE_H_
 
+#include "io-lib/CountingInputStream.h"
 #include "log-writer/LogWriter.h"
 #include "network/RfbInputGate.h"
+#include "network/ReadAheadInputStream.h"
 #include "network/RfbOutputGate.h"
 #include "network/socket/SocketStream.h"
 #include "network/socket/SocketIPv4.h"
@@ -38,6 +40,8 @@
 #include "CapsContainer.h"
 #include "CoreEventsAdapter.h"
 #include "DecoderStore.h"
+#include "DecoderOfRectangle.h"
+#include "EncodingAutoTuner.h"
 #include "FbUpdateNotifier.h"
 #include "ServerMessageListener.h"
 #include "TcpConnection.h"
@@ -181,10 +185,11 @@ public:
   // the data, it also performs most notifications via the adapter interface,
   // except for two notifications which report changes in the frame buffer.
   //
-  // The notifications related to the frame buffer, onFrameBufferUpdate() and
+  // The notifications related to the frame buffer, onFrameBufferUpdates()
+  // (which calls onFrameBufferUpdate() by default) and
   // onFrameBufferPropChange(), will be called from a separate thread (let's
   // call it "frame buffer notifier"). The whole purpose of this thread is to
-  // perform these two callbacks. This architecture allows input thread to
+  // perform these callbacks. This architecture allows input thread to
   // continue reading network data while callbacks are executed. However, note
   // that the frame buffer is locked in these two callbacks, so it's still
   // possible to block the input thread by doing too much work in the
@@ -359,6 +364,55 @@ public:
   //
   void enableCursorShapeUpdates(bool enabled);
 
+  //
+  // Enable or disable pipelining of update requests (disabled by default).
+  // If enabled, the next incremental update request is sent as soon as the
+  // header of an update is received, so the server prepares the next update
+  // while the viewer receives and decodes the current one. Still, only one
+  // request is sent per received update, so requests don't pile up.
+  //
+  void enableUpdatePipelining(bool enabled);
+
+  //
+  // Enable or disable reading from the network in a separate thread
+  // (disabled by default). If enabled, data of the server is received into
+  // a buffer of bounded size while the core thread decodes, so the server
+  // isn't stalled by a full TCP receive window during long decoding.
+  //
+  // This function must be called before starting the core.
+  //
+  void enableReadAhead(bool enabled);
+
+  //
+  // Set the number of threads decompressing JPEG rectangles of Tight
+  // encoding in parallel. Values less than 2 disable parallel decompression
+  // (disabled by default).
+  //
+  // This function must be called before starting the core.
+  //
+  void setDecodingThreadCount(int numThreads);
+
+  //
+  // Limit the rate of frame buffer update notifications, in frames per
+  // second (not limited by default, if fps is 0). The updates between two
+  // notifications are merged into a few rectangles and delivered in one
+  // CoreEventsAdapter::onFrameBufferUpdates() call.
+  //
+  void setFrameRate(int fps);
+
+  //
+  // Enable or disable automatic choice of the encoding, the compression
+  // level and the JPEG quality level (disabled by default). If enabled, the
+  // core measures the updates and changes these settings (see
+  // EncodingAutoTuner), so calls of setPreferredEncoding(),
+  // setCompressionLevel() and setJpegQualityLevel() are ignored. The
+  // chosen settings and the measurements are reported to
+  // CoreEventsAdapter::onEncodingTuned().
+  //
+  // This function must be called before starting the core.
+  //
+  void enableAutoTuning(bool enabled);
+
   //
   // Ignore or show cursor shape updates (shown by default). If cursor shape
   // updates are enabled but ignored, remote cursor will not be shown. This
@@ -437,6 +491,9 @@ private:
   //   * then call receiveFrameBufferUpdRectangle() for each rectangle,
   //   * then send FramebufferUpdateRequest client message (code 3).
   //
+  // If pipelining is enabled, then the request is sent right after the number
+  // of rectangles, unless it has to change the pixel format of frame buffer.
+  //
   void receiveFbUpdate();
 
   //
@@ -448,6 +505,33 @@ private:
   //
   bool receiveFbUpdateRectangle();
 
+  //
+  // Finish drawing of rectangles, which the decoder of previous rectangle
+  // has left to other threads (see DecoderOfRectangle::flush()).
+  //
+  void flushDecoding();
+
+  //
+  // Pass measurements of the received update to m_autoTuner and apply the
+  // new settings, if they are changed. The update is numBytes long counting
+  // from its message type and took updateTime from its first byte.
+  //
+  void tuneEncoding(UINT64 numBytes, UINT64 updateTime, UINT64 latency,
+                    UINT64 time);
+
+  //
+  // Set the decoders for the settings chosen by m_autoTuner. The encodings
+  // are not sent.
+  //
+  void applyTunedSettings();
+
+  //
+  // Replace the pseudo-decoder of compression level or JPEG quality level.
+  // Return true if the list of encodings has been changed.
+  //
+  bool updateCompressionLevel(int newLevel);
+  bool updateJpegQualityLevel(int newLevel);
+
   //
   // Process a fake rectangle which represents a pseudo-encoding.
   //
@@ -455,9 +539,14 @@ private:
 
   //
   // Send FramebufferUpdateRequest client message (code 3).
-  // This method updates pixel format if needed.
+  // This method updates pixel format if needed and canUpdatePixelFormat is
+  // true. If a new pixel format is waiting and canUpdatePixelFormat is false,
+  // then the request isn't sent.
   //
-  void sendFbUpdateRequest(bool incremental = true);
+  // Returns true if the request is sent.
+  //
+  bool sendFbUpdateRequest(bool incremental = true,
+                           bool canUpdatePixelFormat = true);
 
   //
   // Receive Bell server message (code 2) and send event to the adapter.
@@ -545,11 +634,34 @@ private:
   // m_decoderStore depends on m_logWriter and must be defined after it.
   // See also: C++ standard 12.6.2 - Initializing bases and members.
   DecoderStore m_decoderStore;
+  // Decoder of the previous rectangle in the current update, or 0.
+  DecoderOfRectangle *m_lastDecoder;
 
   // m_fbUpdateNotifier depends on m_logWriter and must be defined after it.
   // See also: C++ standard 12.6.2 - Initializing bases and members.
   FbUpdateNotifier m_fbUpdateNotifier;
 
+  // Size of the buffer for data read ahead of the decoding.
+  static const size_t READ_AHEAD_CAPACITY = 4 * 1024 * 1024;
+
+  // If m_isReadingAhead is true, then in the working phase m_input reads
+  // from m_readAhead (m_readAheadInput), which reads the connection in its
+  // own thread. Both are created only then, so a core without reading ahead
+  // has neither the buffer nor the thread. m_readAheadLock protects the
+  // pointers for stop() and waitTermination().
+  bool m_isReadingAhead;
+  ReadAheadInputStream *m_readAhead;
+  RfbInputGate *m_readAheadInput;
+  LocalMutex m_readAheadLock;
+
+  // If m_isAutoTuning is true, then in the working phase m_input reads from
+  // m_countingInput (m_countedInput), which counts the received bytes for
+  // m_autoTuner.
+  bool m_isAutoTuning;
+  EncodingAutoTuner m_autoTuner;
+  CountingInputStream m_countingInput;
+  RfbInputGate m_countedInput;
+
   CapsContainer m_authCaps;
   map<UINT32, AuthHandler *> m_authHandlers;
 
@@ -584,6 +696,8 @@ private:
   //
   // After finish of decoding Decoder copy data to m_frameBuffer.
   // This buffer is not need to blocking: read information is one-thread.
+  // Decoders, which decode in place (Tight, ZRLE), don't use this buffer and
+  // draw on m_frameBuffer under m_fbLock.
   FrameBuffer m_rectangleFb;
 
   LocalMutex m_pixelFormatLock;
@@ -598,6 +712,13 @@ private:
 
   LocalMutex m_requestUpdateLock;
   bool m_isNeedRequestUpdate;
+  // Pipelining of update requests is enabled. Protected by
+  // m_requestUpdateLock.
+  bool m_isPipelining;
+  // Time of sending the last update request (see PreciseTimer), zero if no
+  // request has been sent since the last update. Protected by
+  // m_requestUpdateLock.
+  UINT64 m_requestTime;
 
   bool m_sharedFlag;
   int m_major;
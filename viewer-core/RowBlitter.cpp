@@ -0,0 +1,251 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "RowBlitter.h"
+
+#include <intrin.h>
+#include <emmintrin.h>
+#include <tmmintrin.h>
+
+const bool RowBlitter::m_hasSse2 = RowBlitter::detectSse2();
+const bool RowBlitter::m_hasSsse3 = RowBlitter::detectSsse3();
+
+bool RowBlitter::detectSse2()
+{
+  return IsProcessorFeaturePresent(PF_XMMI64_INSTRUCTIONS_AVAILABLE) != 0;
+}
+
+bool RowBlitter::detectSsse3()
+{
+  int cpuInfo[4];
+  __cpuid(cpuInfo, 0);
+  if (cpuInfo[0] < 1) {
+    return false;
+  }
+  __cpuid(cpuInfo, 1);
+  // ECX bit 9 is SSSE3.
+  return (cpuInfo[2] & (1 << 9)) != 0;
+}
+
+void RowBlitter::copyRow(void *dst, const void *src, size_t count,
+                         size_t bytesPerPixel)
+{
+  memcpy(dst, src, count * bytesPerPixel);
+}
+
+void RowBlitter::expandCPixelRow(UINT32 *dst, const UINT8 *src, size_t count,
+                                 CPixelOrder order)
+{
+  size_t done = 0;
+  if (m_hasSsse3) {
+    done = expandCPixelRowSsse3(dst, src, count, order);
+  }
+  src += done * 3;
+  if (order == FIRST_BYTE_HIGH) {
+    for (size_t i = done; i < count; i++, src += 3) {
+      dst[i] = (UINT32)src[0] << 16 | (UINT32)src[1] << 8 | src[2];
+    }
+  } else {
+    for (size_t i = done; i < count; i++, src += 3) {
+      dst[i] = src[0] | (UINT32)src[1] << 8 | (UINT32)src[2] << 16;
+    }
+  }
+}
+
+size_t RowBlitter::expandCPixelRowSsse3(UINT32 *dst, const UINT8 *src,
+                                        size_t count, CPixelOrder order)
+{
+  // -1 (high bit set) makes pshufb write a zero byte.
+  const __m128i shuffle = order == FIRST_BYTE_HIGH ?
+    _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1) :
+    _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+
+  // Four pixels take 12 bytes but 16 bytes are loaded, so the loop stops
+  // while at least 16 source bytes are left.
+  size_t i = 0;
+  for (; i + 6 <= count; i += 4, src += 12) {
+    __m128i in = _mm_loadu_si128((const __m128i *)src);
+    _mm_storeu_si128((__m128i *)(dst + i), _mm_shuffle_epi8(in, shuffle));
+  }
+  return i;
+}
+
+void RowBlitter::expandMonoRow(void *dst, const UINT8 *src, size_t count,
+                               UINT32 color0, UINT32 color1,
+                               size_t bytesPerPixel)
+{
+  switch (bytesPerPixel) {
+  case 1:
+    expandMonoRowT<UINT8>((UINT8 *)dst, src, count,
+                          (UINT8)color0, (UINT8)color1);
+    break;
+  case 2:
+    expandMonoRowT<UINT16>((UINT16 *)dst, src, count,
+                           (UINT16)color0, (UINT16)color1);
+    break;
+  case 4:
+    {
+      size_t done = 0;
+      if (m_hasSse2) {
+        done = expandMonoRowSse2((UINT32 *)dst, src, count, color0, color1);
+      }
+      expandMonoRowT<UINT32>((UINT32 *)dst + done, src + done / 8,
+                             count - done, color0, color1);
+    }
+    break;
+  default:
+    _ASSERT(false);
+  }
+}
+
+template<class PIXEL_T>
+void RowBlitter::expandMonoRowT(PIXEL_T *dst, const UINT8 *src, size_t count,
+                                PIXEL_T color0, PIXEL_T color1)
+{
+  for (size_t i = 0; i < count; i++) {
+    dst[i] = ((src[i >> 3] >> (7 - (i & 7))) & 1) != 0 ? color1 : color0;
+  }
+}
+
+size_t RowBlitter::expandMonoRowSse2(UINT32 *dst, const UINT8 *src,
+                                     size_t count,
+                                     UINT32 color0, UINT32 color1)
+{
+  const __m128i c0 = _mm_set1_epi32((int)color0);
+  const __m128i c1 = _mm_set1_epi32((int)color1);
+  const __m128i highBits = _mm_setr_epi32(0x80, 0x40, 0x20, 0x10);
+  const __m128i lowBits = _mm_setr_epi32(0x08, 0x04, 0x02, 0x01);
+
+  // Eight pixels of each source byte are selected by the compare masks.
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8, src++) {
+    __m128i bits = _mm_set1_epi32(*src);
+    __m128i mask = _mm_cmpeq_epi32(_mm_and_si128(bits, highBits), highBits);
+    _mm_storeu_si128((__m128i *)(dst + i),
+                     _mm_or_si128(_mm_and_si128(mask, c1),
+                                  _mm_andnot_si128(mask, c0)));
+    mask = _mm_cmpeq_epi32(_mm_and_si128(bits, lowBits), lowBits);
+    _mm_storeu_si128((__m128i *)(dst + i + 4),
+                     _mm_or_si128(_mm_and_si128(mask, c1),
+                                  _mm_andnot_si128(mask, c0)));
+  }
+  return i;
+}
+
+bool RowBlitter::lookupRow(void *dst, const UINT8 *indices, size_t count,
+                           const UINT32 *palette, size_t paletteSize,
+                           size_t bytesPerPixel)
+{
+  switch (bytesPerPixel) {
+  case 1:
+    return lookupRowT<UINT8>((UINT8 *)dst, indices, count,
+                             palette, paletteSize);
+  case 2:
+    return lookupRowT<UINT16>((UINT16 *)dst, indices, count,
+                              palette, paletteSize);
+  case 4:
+    return lookupRowT<UINT32>((UINT32 *)dst, indices, count,
+                              palette, paletteSize);
+  default:
+    _ASSERT(false);
+    return false;
+  }
+}
+
+template<class PIXEL_T>
+bool RowBlitter::lookupRowT(PIXEL_T *dst, const UINT8 *indices, size_t count,
+                            const UINT32 *palette, size_t paletteSize)
+{
+  // There is no gather instruction before AVX2, so it's plain scalar code.
+  // Palettes of Tight and ZRLE have at most 256 entries.
+  bool isValid = true;
+  if (paletteSize == 256) {
+    for (size_t i = 0; i < count; i++) {
+      dst[i] = (PIXEL_T)palette[indices[i]];
+    }
+  } else {
+    for (size_t i = 0; i < count; i++) {
+      UINT8 index = indices[i];
+      if (index < paletteSize) {
+        dst[i] = (PIXEL_T)palette[index];
+      } else {
+        isValid = false;
+      }
+    }
+  }
+  return isValid;
+}
+
+void RowBlitter::gradientRow(void *dst, const UINT8 *src, size_t count,
+                             size_t srcBytesPerPixel, const PixelFormat *pf,
+                             UINT16 *thisRow, const UINT16 *prevRow)
+{
+  switch (pf->bitsPerPixel) {
+  case 8:
+    gradientRowT<UINT8>((UINT8 *)dst, src, count, srcBytesPerPixel, pf,
+                        thisRow, prevRow);
+    break;
+  case 16:
+    gradientRowT<UINT16>((UINT16 *)dst, src, count, srcBytesPerPixel, pf,
+                         thisRow, prevRow);
+    break;
+  case 32:
+    gradientRowT<UINT32>((UINT32 *)dst, src, count, srcBytesPerPixel, pf,
+                         thisRow, prevRow);
+    break;
+  default:
+    _ASSERT(false);
+  }
+}
+
+template<class PIXEL_T>
+void RowBlitter::gradientRowT(PIXEL_T *dst, const UINT8 *src, size_t count,
+                              size_t srcBytesPerPixel, const PixelFormat *pf,
+                              UINT16 *thisRow, const UINT16 *prevRow)
+{
+  // Each pixel depends on the previous one, so the row can't be processed
+  // in parallel.
+  const UINT16 max[3] = {pf->redMax, pf->greenMax, pf->blueMax};
+  const UINT16 shift[3] = {pf->redShift, pf->greenShift, pf->blueShift};
+
+  for (size_t i = 0, j = 3; i < count; i++, j += 3, src += srcBytesPerPixel) {
+    UINT32 rawColor = 0;
+    if (srcBytesPerPixel == 3) {
+      rawColor = (UINT32)src[0] << 16 | (UINT32)src[1] << 8 | src[2];
+    } else {
+      memcpy(&rawColor, src, srcBytesPerPixel);
+    }
+
+    UINT32 color = 0;
+    for (int c = 0; c < 3; c++) {
+      UINT8 raw = (UINT8)(rawColor >> shift[c] & max[c]);
+      INT32 d = prevRow[j + c] +      // "upper" pixel (from prev row)
+                thisRow[j + c - 3] -  // prev pixel
+                prevRow[j + c - 3];   // "diagonal" prev pixel
+      UINT16 predicted = d < 0 ? 0 : d > max[c] ? max[c] : (UINT16)d;
+      thisRow[j + c] = (predicted + raw) & max[c];
+      color |= (UINT32)thisRow[j + c] << shift[c];
+    }
+    dst[i] = (PIXEL_T)color;
+  }
+}
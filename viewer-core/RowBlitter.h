@@ -0,0 +1,119 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef _ROW_BLITTER_H_
+#define _ROW_BLITTER_H_
+
+#include "util/CommonHeader.h"
+#include "util/inttypes.h"
+#include "rfb/PixelFormat.h"
+
+//
+// Row kernels shared by the rectangle decoders. Each function converts one
+// row of decoded data to frame buffer pixels, so a decoder gets the row
+// address once (getBufferPtr()) and steps to the next row by the frame
+// buffer stride (getBytesPerRow()) instead of addressing every pixel.
+//
+// Pixels of bytesPerPixel 1, 2 or 4 are supported; 32-bit rows have SSE2 or
+// SSSE3 fast paths where the processor supports them.
+//
+class RowBlitter
+{
+public:
+  // Byte order of 24-bit compressed pixels (CPIXEL).
+  enum CPixelOrder {
+    // The first byte is the most significant one (Tight).
+    FIRST_BYTE_HIGH,
+    // The first byte is the least significant one (ZRLE).
+    FIRST_BYTE_LOW
+  };
+
+  //
+  // Copies count pixels.
+  //
+  static void copyRow(void *dst, const void *src, size_t count,
+                      size_t bytesPerPixel);
+
+  //
+  // Expands count 3-byte pixels to 32-bit pixels with zero upper byte.
+  //
+  static void expandCPixelRow(UINT32 *dst, const UINT8 *src, size_t count,
+                              CPixelOrder order);
+
+  //
+  // Expands count bits of src (the most significant bit first) to color0
+  // for zero bits and color1 for one bits.
+  //
+  static void expandMonoRow(void *dst, const UINT8 *src, size_t count,
+                            UINT32 color0, UINT32 color1,
+                            size_t bytesPerPixel);
+
+  //
+  // Replaces count 8-bit indices by the colors of the palette. Pixels with
+  // indices out of the palette are left untouched; false is returned if
+  // there were such pixels.
+  //
+  static bool lookupRow(void *dst, const UINT8 *indices, size_t count,
+                        const UINT32 *palette, size_t paletteSize,
+                        size_t bytesPerPixel);
+
+  //
+  // Reconstructs count pixels filtered by the Tight "gradient" filter.
+  // Source pixels are srcBytesPerPixel wide, 3 means CPIXEL in the
+  // FIRST_BYTE_HIGH order. thisRow and prevRow keep color components of
+  // the current and of the previous row: each of them has (count + 1) * 3
+  // entries where the first three are zero. prevRow of the first row must
+  // be all zeros. The caller swaps the rows after each call.
+  //
+  static void gradientRow(void *dst, const UINT8 *src, size_t count,
+                          size_t srcBytesPerPixel, const PixelFormat *pf,
+                          UINT16 *thisRow, const UINT16 *prevRow);
+
+private:
+  template<class PIXEL_T>
+  static void expandMonoRowT(PIXEL_T *dst, const UINT8 *src, size_t count,
+                             PIXEL_T color0, PIXEL_T color1);
+  template<class PIXEL_T>
+  static bool lookupRowT(PIXEL_T *dst, const UINT8 *indices, size_t count,
+                         const UINT32 *palette, size_t paletteSize);
+  template<class PIXEL_T>
+  static void gradientRowT(PIXEL_T *dst, const UINT8 *src, size_t count,
+                           size_t srcBytesPerPixel, const PixelFormat *pf,
+                           UINT16 *thisRow, const UINT16 *prevRow);
+
+  // SIMD versions process the main part of the row and return the number
+  // of pixels they have processed.
+  static size_t expandCPixelRowSsse3(UINT32 *dst, const UINT8 *src,
+                                     size_t count, CPixelOrder order);
+  static size_t expandMonoRowSse2(UINT32 *dst, const UINT8 *src,
+                                  size_t count,
+                                  UINT32 color0, UINT32 color1);
+
+  static bool detectSse2();
+  static bool detectSsse3();
+
+  static const bool m_hasSse2;
+  static const bool m_hasSsse3;
+};
+
+#endif
@@ -25,9 +25,16 @@
 #include "TightDecoder.h"
 
 #include "rfb/StandardPixelFormatFactory.h"
+#include "FbUpdateNotifier.h"
+#include "RowBlitter.h"
 
 TightDecoder::TightDecoder(LogWriter *logWriter)
 : DecoderOfRectangle(logWriter),
+  m_decompressorPool(0),
+  m_pendingFb(0),
+  m_isRectPending(false),
+  m_fbLock(0),
+  m_fbNotifier(0),
   m_isCPixel(false)
 {
   m_encoding = EncodingDefs::TIGHT;
@@ -40,6 +47,17 @@ TightDecoder::TightDecoder(LogWriter *logWriter)
 
 TightDecoder::~TightDecoder()
 {
+  // Worker threads may still use the pending jobs.
+  while (!m_pendingJobs.empty()) {
+    m_decompressorPool->waitForJob(m_pendingJobs.front());
+    m_freeJobs.push_back(m_pendingJobs.front());
+    m_pendingJobs.pop_front();
+  }
+  delete m_decompressorPool;
+  for (size_t i = 0; i < m_freeJobs.size(); i++) {
+    delete m_freeJobs[i];
+  }
+
   for (int i = 0; i < DECODERS_NUM; i++) {
     try {
       delete m_inflater[i];
@@ -48,6 +66,67 @@ TightDecoder::~TightDecoder()
   }
 }
 
+void TightDecoder::process(RfbInputGate *input,
+                           FrameBuffer *frameBuffer,
+                           FrameBuffer *secondFrameBuffer,
+                           const Rect *rect,
+                           LocalMutex *fbLock,
+                           FbUpdateNotifier *fbNotifier)
+{
+  m_fbLock = fbLock;
+  m_fbNotifier = fbNotifier;
+  m_isRectPending = false;
+  DecoderOfRectangle::process(input, frameBuffer, secondFrameBuffer, rect,
+                              fbLock, fbNotifier);
+}
+
+void TightDecoder::flush()
+{
+  while (!m_pendingJobs.empty()) {
+    drawOldestJob();
+  }
+}
+
+void TightDecoder::setThreadCount(int numThreads)
+{
+  if (numThreads > MAX_THREAD_COUNT) {
+    numThreads = MAX_THREAD_COUNT;
+  }
+  if (numThreads < 2) {
+    numThreads = 0;
+  }
+  int currentCount = 0;
+  if (m_decompressorPool != 0) {
+    currentCount = m_decompressorPool->getNumThreads();
+  }
+  if (numThreads == currentCount) {
+    return;
+  }
+
+  if (m_decompressorPool != 0) {
+    delete m_decompressorPool;
+    m_decompressorPool = 0;
+  }
+  if (numThreads != 0) {
+    m_decompressorPool = new JpegDecompressorPool(numThreads);
+  }
+}
+
+bool TightDecoder::isDecodingInPlace() const
+{
+  return true;
+}
+
+void TightDecoder::notify(FbUpdateNotifier *fbNotifier,
+                          const Rect *rect)
+{
+  if (m_isRectPending) {
+    m_isRectPending = false;
+    return;
+  }
+  DecoderOfRectangle::notify(fbNotifier, rect);
+}
+
 void TightDecoder::decode(RfbInputGate *input,
                           FrameBuffer *fb,
                           const Rect *dstRect)
@@ -76,8 +155,15 @@ void TightDecoder::decode(RfbInputGate *input,
   if (!fb->getDimension().getRect().intersection(dstRect).isEqualTo(dstRect))
     throw Exception(_T("Error in protocol: incorrect size of rectangle (tight-decoder)"));
 
+  // Rectangles are drawn in the order of the update, so the pending JPEG
+  // rectangles under this one must be drawn before it.
+  if (compressionType != JPEG_TYPE && isPendingRect(dstRect)) {
+    flush();
+  }
+
   if (compressionType == FILL_TYPE) {
     UINT32 color = readTightPixel(input, bytesPerCPixel);
+    DrawingLock drawingLock(this);
     fb->fillRect(dstRect, color);
   } else if (compressionType == JPEG_TYPE) {
     processJpeg(input, fb, dstRect);
@@ -94,18 +180,6 @@ UINT32 TightDecoder::transformPixelToTight(UINT32 color)
   return result;
 }
 
-vector<UINT8> TightDecoder::transformArray(const vector<UINT8> &buffer)
-{
-  vector<UINT8> result(buffer.size() * 4 / 3);
-  for (size_t bi = 0, ri = 0; bi < buffer.size(); bi += 3, ri += 4) {
-    result[ri] = buffer[bi + 2];
-    result[ri + 1] = buffer[bi + 1];
-    result[ri + 2] = buffer[bi];
-    result[ri + 3] = 0;
-  }
-  return result;
-}
-
 UINT32 TightDecoder::readTightPixel(RfbInputGate *input, int bytesPerCPixel)
 {
   UINT32 color = 0;
@@ -160,22 +234,28 @@ void TightDecoder::processJpeg(RfbInputGate *input,
   UINT32 jpegBufLen = readCompactSize(input);
   if (jpegBufLen == 0)
     throw Exception(_T("Error in protocol: empty byffer of jpeg (tight-decoder)"));
-  vector<UINT8> buffer;
-  buffer.resize(jpegBufLen);
-  input->readFully(&buffer.front(), jpegBufLen);
+  if (m_decompressorPool != 0) {
+    submitJpeg(input, frameBuffer, dstRect, jpegBufLen);
+    return;
+  }
+  reserveScratch(&m_compressedData, jpegBufLen);
+  input->readFully(&m_compressedData.front(), jpegBufLen);
 
   if (dstRect->area() != 0) {
-    vector<UINT8> pixels;
-    pixels.resize(dstRect->area() * JpegDecompressor::BYTES_PER_PIXEL);
+    // If possible, libjpeg outputs pixels in the format of frame buffer.
+    PixelFormat pf = frameBuffer->getPixelFormat();
+    bool isDirect = JpegDecompressor::isDirectFormat(&pf);
+    size_t pixelsLength = dstRect->area() *
+                          (isDirect ? JpegDecompressor::DIRECT_BYTES_PER_PIXEL
+                                    : JpegDecompressor::BYTES_PER_PIXEL);
+    reserveScratch(&m_pixelData, pixelsLength);
 
     try {
-      m_jpeg.decompress(buffer, jpegBufLen, pixels, dstRect);
-      if (m_isCPixel) {
-        pixels = transformArray(pixels);
-        drawTightBytes(frameBuffer, &pixels, dstRect);
-      } else {
-        drawJpegBytes(frameBuffer, &pixels, dstRect);
-      }
+      m_jpeg.decompress(m_compressedData, jpegBufLen, m_pixelData, dstRect,
+                        isDirect ? &pf : 0);
+      DrawingLock drawingLock(this);
+      drawJpeg(frameBuffer, &m_pixelData.front(), pixelsLength, dstRect,
+               isDirect);
     } catch (const Exception &ex) {
       StringStorage error;
       error.format(_T("Error in tight-decoder, subencoding \"jpeg\": %s"), 
@@ -185,6 +265,82 @@ void TightDecoder::processJpeg(RfbInputGate *input,
   }
 }
 
+void TightDecoder::submitJpeg(RfbInputGate *input,
+                              FrameBuffer *frameBuffer,
+                              const Rect *dstRect,
+                              size_t jpegBufLen)
+{
+  JpegDecompressionJob *job;
+  if (m_freeJobs.empty()) {
+    job = new JpegDecompressionJob;
+  } else {
+    job = m_freeJobs.back();
+    m_freeJobs.pop_back();
+  }
+  try {
+    reserveScratch(&job->jpegData, jpegBufLen);
+    input->readFully(&job->jpegData.front(), jpegBufLen);
+    if (dstRect->area() == 0) {
+      m_freeJobs.push_back(job);
+      return;
+    }
+    job->rect = *dstRect;
+    job->jpegLength = jpegBufLen;
+    job->directFormat = frameBuffer->getPixelFormat();
+    job->isDirect = JpegDecompressor::isDirectFormat(&job->directFormat);
+    reserveScratch(&job->pixels, dstRect->area() *
+                   (job->isDirect ? JpegDecompressor::DIRECT_BYTES_PER_PIXEL
+                                  : JpegDecompressor::BYTES_PER_PIXEL));
+    m_pendingJobs.push_back(job);
+  } catch (...) {
+    delete job;
+    throw;
+  }
+  m_pendingFb = frameBuffer;
+  m_decompressorPool->submit(job);
+  m_isRectPending = true;
+
+  // Limit the number of jobs in progress so that we would not keep
+  // the data of the whole update in memory.
+  size_t maxPendingJobs = m_decompressorPool->getNumThreads() * 2;
+  while (m_pendingJobs.size() >= maxPendingJobs ||
+         (!m_pendingJobs.empty() &&
+          m_decompressorPool->isDone(m_pendingJobs.front()))) {
+    drawOldestJob();
+  }
+}
+
+void TightDecoder::drawOldestJob()
+{
+  JpegDecompressionJob *job = m_pendingJobs.front();
+  m_decompressorPool->waitForJob(job);
+  m_pendingJobs.pop_front();
+  m_freeJobs.push_back(job);
+
+  if (job->failed) {
+    m_logWriter->error(_T("Error in tight-decoder, subencoding \"jpeg\": %s"),
+                       job->errorMessage.getString());
+    return;
+  }
+  {
+    AutoLock al(m_fbLock);
+    drawJpeg(m_pendingFb, &job->pixels.front(), job->pixels.size(),
+             &job->rect, job->isDirect);
+  }
+  m_fbNotifier->onUpdate(&job->rect);
+}
+
+bool TightDecoder::isPendingRect(const Rect *rect) const
+{
+  std::deque<JpegDecompressionJob *>::const_iterator it;
+  for (it = m_pendingJobs.begin(); it != m_pendingJobs.end(); it++) {
+    if (!(*it)->rect.intersection(rect).isEmpty()) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void TightDecoder::processBasicTypes(RfbInputGate *input,
                                      FrameBuffer *fb,
                                      const Rect *dstRect,
@@ -202,15 +358,15 @@ void TightDecoder::processBasicTypes(RfbInputGate *input,
     lengthCurrentBpp = dstRect->area() * 3;
   }
 
-  vector<UINT8> buffer;
+  size_t dataLength;
 
   switch (filterId) {
   case COPY_FILTER:
-    readTightData(input, buffer, lengthCurrentBpp, decoderId);
-    if (m_isCPixel) {
-      buffer = transformArray(buffer);
+    dataLength = readTightData(input, lengthCurrentBpp, decoderId);
+    {
+      DrawingLock drawingLock(this);
+      drawTightBytes(fb, getPixelData(), dataLength, dstRect);
     }
-    drawTightBytes(fb, &buffer, dstRect);
     break;
 
   // The "gradient" filter and "jpeg" compression may be used only
@@ -218,19 +374,23 @@ void TightDecoder::processBasicTypes(RfbInputGate *input,
   case PALETTE_FILTER:
     {
       int paletteSize = input->readUInt8() + 1;
-      vector<UINT32> palette = readPalette(input, paletteSize, bytesPerCPixel);
-      size_t dataLength = dstRect->area();
+      readPalette(input, paletteSize, bytesPerCPixel);
+      size_t expectedLength = dstRect->area();
       if (paletteSize == 2) {
-        dataLength = (dstRect->getWidth() + 7) / 8 * dstRect->getHeight();
+        expectedLength = (dstRect->getWidth() + 7) / 8 * dstRect->getHeight();
       }
-      readTightData(input, buffer, dataLength, decoderId);
-      drawPalette(fb, palette, buffer, dstRect);
+      dataLength = readTightData(input, expectedLength, decoderId);
+      DrawingLock drawingLock(this);
+      drawPalette(fb, getPixelData(), dataLength, dstRect);
     }
     break;
 
   case GRADIENT_FILTER:
-    readTightData(input, buffer, lengthCurrentBpp, decoderId);
-    drawGradient(fb, buffer, dstRect);
+    dataLength = readTightData(input, lengthCurrentBpp, decoderId);
+    {
+      DrawingLock drawingLock(this);
+      drawGradient(fb, getPixelData(), dataLength, dstRect);
+    }
     break;
 
   default:
@@ -238,126 +398,183 @@ void TightDecoder::processBasicTypes(RfbInputGate *input,
   }
 }
 
-vector<UINT32> TightDecoder::readPalette(RfbInputGate *input,
-                                      int paletteSize,
-                                      int bytesPerCPixel)
+void TightDecoder::readPalette(RfbInputGate *input,
+                               int paletteSize,
+                               int bytesPerCPixel)
 {
-  vector<UINT32> palette(paletteSize);
+  // resize() keeps the capacity, so the palette is allocated only once.
+  m_palette.resize(paletteSize);
   for (int i = 0; i < paletteSize; i++) {
-    palette[i] = readTightPixel(input, bytesPerCPixel);
+    m_palette[i] = readTightPixel(input, bytesPerCPixel);
   }
-  return palette;
 }
 
-void TightDecoder::readTightData(RfbInputGate *input,
-                                 vector<UINT8> &buffer,
-                                 size_t expectedLength,
-                                 const int decoderId)
+size_t TightDecoder::readTightData(RfbInputGate *input,
+                                   size_t expectedLength,
+                                   const int decoderId)
 {
   if (expectedLength < MIN_SIZE_TO_COMPRESS) {
-    buffer.resize(expectedLength);
+    reserveScratch(&m_pixelData, expectedLength);
     if (expectedLength != 0) {
-      input->readFully(&buffer.front(), expectedLength);
+      input->readFully(&m_pixelData.front(), expectedLength);
     }
+    return expectedLength;
   } else {
-    readCompressedData(input, buffer, expectedLength, decoderId);
+    return readCompressedData(input, expectedLength, decoderId);
   }
 }
 
-void TightDecoder::readCompressedData(RfbInputGate *input,
-                                      vector<UINT8> &buffer,
-                                      size_t expectedLength,
-                                      const int decoderId)
+size_t TightDecoder::readCompressedData(RfbInputGate *input,
+                                        size_t expectedLength,
+                                        const int decoderId)
 {
   size_t rawDataLength = readCompactSize(input);
 
-  vector<char> compressed(rawDataLength);
-
-  // read compressed (raw) data behind space allocated for decompressed data
   if (rawDataLength != 0) {
-    input->readFully(&compressed.front(), rawDataLength);
+    reserveScratch(&m_compressedData, rawDataLength);
+    input->readFully(&m_compressedData.front(), rawDataLength);
 
+    // Inflate straight into the pixel data buffer.
+    reserveScratch(&m_pixelData, Inflater::getOutputCapacity(expectedLength));
     Inflater *decoder = m_inflater[decoderId];
-    decoder->setInput(&compressed.front(), rawDataLength);
-    decoder->setUnpackedSize(expectedLength);
-    decoder->inflate();
-
-    size_t size = decoder->getOutputSize();
-    const char *output = decoder->getOutput();
-    buffer.resize(size);
-    buffer.assign(output, output + size);
+    decoder->setInput((const char *)&m_compressedData.front(), rawDataLength);
+    return decoder->inflate((char *)&m_pixelData.front(), m_pixelData.size());
   } else {
     _ASSERT(rawDataLength != 0);
     m_logWriter->debug(_T("Tight decoder: Length of Raw compressed data is 0"));
-    buffer.resize(0);
+    return 0;
+  }
+}
+
+const UINT8 *TightDecoder::getPixelData()
+{
+  // The buffer is empty only if nothing has been read into it yet.
+  reserveScratch(&m_pixelData, 1);
+  return &m_pixelData.front();
+}
+
+void TightDecoder::checkDataLength(size_t pixelsLength,
+                                   size_t expectedLength)
+{
+  if (pixelsLength < expectedLength) {
+    throw Exception(_T("Error in protocol: not enough pixel data")
+                    _T(" (tight-decoder)"));
   }
 }
 
 void TightDecoder::drawPalette(FrameBuffer *fb,
-                               const vector<UINT32> &palette,
-                               const vector<UINT8> &pixels,
+                               const UINT8 *pixels,
+                               size_t pixelsLength,
                                const Rect *dstRect)
 {
-  // TODO: removed duplicate code (draw Tight bytes)
+  if (dstRect->area() == 0) {
+    return;
+  }
   int width = dstRect->getWidth();
   int height = dstRect->getHeight();
 
   int bytesPerPixel = fb->getBytesPerPixel();
 
-  int dstLength = dstRect->area();
-
-  int x = dstRect->left;
-  int y = dstRect->top;
-  if (palette.size() == 2) {
-    int offset = 8;
-    int index = -1;
-    for (int i = 0; i < dstLength; i++) {
-      void *pixelPtr = fb->getBufferPtr(x + i % width, y + i / width);
-      if (offset == 0 || i % width == 0) {
-        offset = 8;
-        index++;
-      }
-      offset--;
-      memcpy(pixelPtr, &palette[(pixels[index] >> offset) & 0x01], bytesPerPixel);
-
-    }
-  } else { // size of palette != 2
-    for (int i = 0; i < dstLength; i++) {
-      void *pixelPtr = fb->getBufferPtr(x + i % width, y + i / width);
-      if (pixels[i] < palette.size()) {
-        memcpy(pixelPtr, &palette[pixels[i]], bytesPerPixel);
-      } else {
-        m_logWriter->error(_T("Tight decoder: Invalid index in palette."));
-      }
+  // Rows of the monochrome data are padded to whole bytes.
+  bool isMono = m_palette.size() == 2;
+  size_t srcStride = isMono ? (width + 7) / 8 : width;
+  checkDataLength(pixelsLength, srcStride * height);
+
+  size_t dstStride = fb->getBytesPerRow();
+  UINT8 *dst = (UINT8 *)fb->getBufferPtr(dstRect->left, dstRect->top);
+  const UINT8 *src = pixels;
+  bool isValid = true;
+  for (int y = 0; y < height; y++, dst += dstStride, src += srcStride) {
+    if (isMono) {
+      RowBlitter::expandMonoRow(dst, src, width, m_palette[0], m_palette[1],
+                                bytesPerPixel);
+    } else {
+      isValid = RowBlitter::lookupRow(dst, src, width,
+                                      &m_palette.front(), m_palette.size(),
+                                      bytesPerPixel) && isValid;
     }
   }
+  if (!isValid) {
+    m_logWriter->error(_T("Tight decoder: Invalid index in palette."));
+  }
 }
 
 void TightDecoder::drawTightBytes(FrameBuffer *fb,
-                                  const vector<UINT8> *pixels,
+                                  const UINT8 *pixels,
+                                  size_t pixelsLength,
                                   const Rect *dstRect)
 {
-  // TODO: removed duplicate code (zrle)
+  if (dstRect->area() == 0) {
+    return;
+  }
   int width = dstRect->getWidth();
   int height = dstRect->getHeight();
 
   int bytesPerPixel = fb->getBytesPerPixel();
 
-  int dstLength = dstRect->area();
+  // CPIXELs are 3-byte, their order is R, G, B.
+  size_t srcStride = width * (m_isCPixel ? 3 : bytesPerPixel);
+  checkDataLength(pixelsLength, srcStride * height);
+
+  size_t dstStride = fb->getBytesPerRow();
+  UINT8 *dst = (UINT8 *)fb->getBufferPtr(dstRect->left, dstRect->top);
+  const UINT8 *src = pixels;
+  for (int y = 0; y < height; y++, dst += dstStride, src += srcStride) {
+    if (m_isCPixel) {
+      RowBlitter::expandCPixelRow((UINT32 *)dst, src, width,
+                                  RowBlitter::FIRST_BYTE_HIGH);
+    } else {
+      RowBlitter::copyRow(dst, src, width, bytesPerPixel);
+    }
+  }
+}
+
+void TightDecoder::drawJpeg(FrameBuffer *fb,
+                            const UINT8 *pixels,
+                            size_t pixelsLength,
+                            const Rect *dstRect,
+                            bool isDirect)
+{
+  if (isDirect) {
+    drawDirectBytes(fb, pixels, pixelsLength, dstRect);
+  } else if (m_isCPixel) {
+    drawTightBytes(fb, pixels, pixelsLength, dstRect);
+  } else {
+    drawJpegBytes(fb, pixels, pixelsLength, dstRect);
+  }
+}
+
+void TightDecoder::drawDirectBytes(FrameBuffer *fb,
+                                   const UINT8 *pixels,
+                                   size_t pixelsLength,
+                                   const Rect *dstRect)
+{
+  if (dstRect->area() == 0) {
+    return;
+  }
+  int width = dstRect->getWidth();
+  int height = dstRect->getHeight();
+
+  size_t srcStride = width * JpegDecompressor::DIRECT_BYTES_PER_PIXEL;
+  checkDataLength(pixelsLength, srcStride * height);
 
-  int x = dstRect->left;
-  int y = dstRect->top;
-  for (int i = 0; i < dstLength; i++) {
-    void *pixelPtr = fb->getBufferPtr(x + i % width, y + i / width);
-    memcpy(pixelPtr, &pixels->operator [](i * bytesPerPixel), bytesPerPixel);
+  size_t dstStride = fb->getBytesPerRow();
+  UINT8 *dst = (UINT8 *)fb->getBufferPtr(dstRect->left, dstRect->top);
+  const UINT8 *src = pixels;
+  for (int y = 0; y < height; y++, dst += dstStride, src += srcStride) {
+    RowBlitter::copyRow(dst, src, width,
+                        JpegDecompressor::DIRECT_BYTES_PER_PIXEL);
   }
 }
 
 void TightDecoder::drawJpegBytes(FrameBuffer *fb,
-                                 const vector<UINT8> *pixels,
+                                 const UINT8 *pixels,
+                                 size_t pixelsLength,
                                  const Rect *dstRect)
 {
-  // TODO: removed duplicate code (draw tight bytes)
+  if (dstRect->area() == 0) {
+    return;
+  }
   int width = dstRect->getWidth();
   int height = dstRect->getHeight();
 
@@ -365,19 +582,20 @@ void TightDecoder::drawJpegBytes(FrameBuffer *fb,
   int bytesPerCPixel = 3;
   PixelFormat pxFormat = fb->getPixelFormat();
 
-  int dstLength = dstRect->area();
-
-  int x = dstRect->left;
-  int y = dstRect->top;
-  for (int i = 0; i < dstLength; i++) {
-    UINT8 color[4] = {0, 0, 0, 0};
-    memcpy(&color, &pixels->operator [](i * bytesPerCPixel), bytesPerCPixel);
-    UINT32 pixel = (((UINT32)color[0] * pxFormat.redMax + 127) / 255 << pxFormat.redShift | 
-                   ((UINT32)color[1] * pxFormat.greenMax + 127) / 255 << pxFormat.greenShift |
-                   ((UINT32)color[2] * pxFormat.blueMax + 127) / 255 << pxFormat.blueShift);
-
-    void *pixelPtr = fb->getBufferPtr(x + i % width, y + i / width);
-    memcpy(pixelPtr, &pixel, fbBytesPerPixel);
+  checkDataLength(pixelsLength, (size_t)width * height * bytesPerCPixel);
+
+  size_t dstStride = fb->getBytesPerRow();
+  UINT8 *dstRow = (UINT8 *)fb->getBufferPtr(dstRect->left, dstRect->top);
+  const UINT8 *color = pixels;
+  for (int y = 0; y < height; y++, dstRow += dstStride) {
+    UINT8 *dst = dstRow;
+    for (int x = 0; x < width; x++, dst += fbBytesPerPixel,
+                                    color += bytesPerCPixel) {
+      UINT32 pixel = (((UINT32)color[0] * pxFormat.redMax + 127) / 255 << pxFormat.redShift | 
+                     ((UINT32)color[1] * pxFormat.greenMax + 127) / 255 << pxFormat.greenShift |
+                     ((UINT32)color[2] * pxFormat.blueMax + 127) / 255 << pxFormat.blueShift);
+      memcpy(dst, &pixel, fbBytesPerPixel);
+    }
   }
 }
 
@@ -399,76 +617,44 @@ void TightDecoder::drawJpegBytes(FrameBuffer *fb,
  */
 
 void TightDecoder::drawGradient(FrameBuffer *fb,
-                                const vector<UINT8> &pixels,
+                                const UINT8 *pixels,
+                                size_t pixelsLength,
                                 const Rect *dstRect)
 {
-  typedef vector<UINT16> RowType;
-  size_t opRowLength = dstRect->getWidth() * 3 + 3;
+  if (dstRect->area() == 0) {
+    return;
+  }
+  int width = dstRect->getWidth();
+  int height = dstRect->getHeight();
 
-  vector<RowType> opRows(2);
-  opRows[0].resize(opRowLength);
-  opRows[1].resize(opRowLength);
+  size_t opRowLength = width * 3 + 3;
+
+  reserveScratch(&m_gradientRows, opRowLength * 2);
+  UINT16 *opRows[2];
+  opRows[0] = &m_gradientRows.front();
+  opRows[1] = opRows[0] + opRowLength;
+
+  memset(opRows[0], 0, opRowLength * 2 * sizeof(UINT16));
 
-  memset(&opRows[0].front(), 0, opRowLength * sizeof(UINT16));
-  memset(&opRows[1].front(), 0, opRowLength * sizeof(UINT16));
-  
   PixelFormat pxFormat = fb->getPixelFormat();
   int fbBytesPerPixel = fb->getBytesPerPixel();
   int bytesPerCPixel = fbBytesPerPixel;
   if (m_isCPixel) {
     bytesPerCPixel = 3;
   }
+  size_t srcStride = width * bytesPerCPixel;
+  checkDataLength(pixelsLength, srcStride * height);
 
+  size_t dstStride = fb->getBytesPerRow();
+  UINT8 *dst = (UINT8 *)fb->getBufferPtr(dstRect->left, dstRect->top);
+  const UINT8 *src = pixels;
   int opRowIndex = 0;
-  UINT16 max[3] = {pxFormat.redMax, pxFormat.greenMax, pxFormat.blueMax};
-  UINT16 shift[3] = {pxFormat.redShift, pxFormat.greenShift, pxFormat.blueShift};
-  size_t pixelOffset = 0;
-
-  for (int i = 0; i < dstRect->getHeight(); ++i) {
+  for (int y = 0; y < height; y++, dst += dstStride, src += srcStride) {
     // exchange thisRow and prevRow:
-    RowType &thisRow = opRows[opRowIndex];
-    RowType &prevRow = opRows[opRowIndex = (opRowIndex + 1) % 2];
-
-    for (size_t j = 3; j < opRowLength; j += 3, pixelOffset += bytesPerCPixel) {
-      UINT8 rawColor[3];
-      fillRawComponents(&pxFormat, rawColor, pixels, pixelOffset);
-      UINT32 color = 0;
-      for (int index = 0; index < 3; index++) {
-        INT32 d = prevRow[j + index] +      // "upper" pixel (from prev row)
-                  thisRow[j + index - 3] -  // prev pixel
-                  prevRow[j + index - 3];   // "diagonal" prev pixel
-        UINT16 converted = d < 0 ? 0 : d > max[index] ? max[index] : d;
-        thisRow[j + index] = (converted + rawColor[index]) & max[index];
-        color |= (thisRow[j + index] & max[index]) << shift[index];
-      }
-      void *pixelPtr = fb->getBufferPtr(static_cast<int>(dstRect->left + j/3 - 1),
-                                        dstRect->top + i);
-      memcpy(pixelPtr, &color, fbBytesPerPixel);
-    }
-  }
-}
+    UINT16 *thisRow = opRows[opRowIndex];
+    UINT16 *prevRow = opRows[opRowIndex = (opRowIndex + 1) % 2];
 
-UINT32 TightDecoder::getRawTightColor(const PixelFormat *pxFormat,
-                                      const vector<UINT8> &pixels,
-                                      const size_t offset)
-{
-  if (m_isCPixel) {
-    return pixels[offset] << 16 |
-           pixels[offset + 1] << 8 |
-           pixels[offset + 2];
+    RowBlitter::gradientRow(dst, src, width, bytesPerCPixel, &pxFormat,
+                            thisRow, prevRow);
   }
-  UINT32 rawColor = 0;
-  memcpy(&rawColor, &pixels[offset], pxFormat->bitsPerPixel / 8);
-  return rawColor;
-}
-
-void TightDecoder::fillRawComponents(const PixelFormat *pxFormat,
-                                     UINT8 components[],
-                                     const vector<UINT8> &pixels,
-                                     const size_t pixelOffset)
-{
-  int rawColor = getRawTightColor(pxFormat, pixels, pixelOffset);
-  components[0] = rawColor >> pxFormat->redShift & pxFormat->redMax;
-  components[1] = rawColor >> pxFormat->greenShift & pxFormat->greenMax;
-  components[2] = rawColor >> pxFormat->blueShift & pxFormat->blueMax;
 }
@@ -25,12 +25,14 @@
 #ifndef _TIGHT_DECODER_H_
 #define _TIGHT_DECODER_H_
 
+#include <deque>
 #include <vector>
 
 #include "util/Inflater.h"
 
 #include "DecoderOfRectangle.h"
 #include "JpegDecompressor.h"
+#include "JpegDecompressorPool.h"
 
 class TightDecoder : public DecoderOfRectangle
 {
@@ -38,7 +40,36 @@ public:
   TightDecoder(LogWriter *logWriter);
   virtual ~TightDecoder();
 
+  virtual void process(RfbInputGate *input,
+                       FrameBuffer *frameBuffer,
+                       FrameBuffer *secondFrameBuffer,
+                       const Rect *rect,
+                       LocalMutex *fbLock,
+                       FbUpdateNotifier *fbNotifier);
+
+  //
+  // Draws the JPEG rectangles, which are still decompressed by worker
+  // threads, and notifies about them.
+  //
+  virtual void flush();
+
+  //
+  // Set the number of threads used to decompress JPEG rectangles. Values
+  // less than 2 disable parallel decompression. It must not be called while
+  // the decoder is processing an update.
+  //
+  void setThreadCount(int numThreads);
+
 protected:
+  virtual bool isDecodingInPlace() const;
+
+  //
+  // Doesn't notify about rectangle, which is left to a worker thread. The
+  // notification is sent when it's drawn.
+  //
+  virtual void notify(FbUpdateNotifier *fbNotifier,
+                      const Rect *rect);
+
   virtual void decode(RfbInputGate *input,
                       FrameBuffer *frameBuffer,
                       const Rect *dstRect);
@@ -48,52 +79,94 @@ private:
   void resetDecoders(UINT8 compControl);
   UINT32 readTightPixel(RfbInputGate *input, int bytesPerCPixel);
   int readCompactSize(RfbInputGate *input);
-  vector<UINT32> readPalette(RfbInputGate *input,
-                          int paletteSize,
-                          int bytesPerCPixel);
+  // Reads the palette into m_palette.
+  void readPalette(RfbInputGate *input,
+                   int paletteSize,
+                   int bytesPerCPixel);
   void processJpeg(RfbInputGate *input,
                    FrameBuffer *frameBuffer,
                    const Rect *dstRect);
+  // Reads the JPEG data and submits it to m_decompressorPool.
+  void submitJpeg(RfbInputGate *input,
+                  FrameBuffer *frameBuffer,
+                  const Rect *dstRect,
+                  size_t jpegBufLen);
+  // Waits for the oldest pending job, draws it and moves it to m_freeJobs.
+  void drawOldestJob();
+  // Returns true if the rectangle overlaps one of the pending jobs.
+  bool isPendingRect(const Rect *rect) const;
   void processBasicTypes(RfbInputGate *input,
                          FrameBuffer *frameBuffer,
                          const Rect *dstRect,
                          UINT8 compControl);
-  void readTightData(RfbInputGate *input,
-                     vector<UINT8> &buffer,
-                     size_t expectedLength,
-                     const int decoderId);
-  void readCompressedData(RfbInputGate *input,
-                          vector<UINT8> &buffer,
-                          size_t expectedLength,
-                          const int decoderId);
+  // Read the data into m_pixelData and return its length.
+  size_t readTightData(RfbInputGate *input,
+                       size_t expectedLength,
+                       const int decoderId);
+  size_t readCompressedData(RfbInputGate *input,
+                            size_t expectedLength,
+                            const int decoderId);
+  const UINT8 *getPixelData();
   void drawPalette(FrameBuffer *fb,
-                   const vector<UINT32> &palette,
-                   const vector<UINT8> &pixels,
+                   const UINT8 *pixels,
+                   size_t pixelsLength,
                    const Rect *dstRect);
   void drawGradient(FrameBuffer *fb,
-                    const vector<UINT8> &pixels,
+                    const UINT8 *pixels,
+                    size_t pixelsLength,
                     const Rect *dstRect);
   void drawTightBytes(FrameBuffer *fb,
-                     const vector<UINT8> *pixels,
-                     const Rect *dstRect);
+                      const UINT8 *pixels,
+                      size_t pixelsLength,
+                      const Rect *dstRect);
   void drawJpegBytes(FrameBuffer *fb,
-                     const vector<UINT8> *pixels,
+                     const UINT8 *pixels,
+                     size_t pixelsLength,
                      const Rect *dstRect);
-
-  UINT32 getRawTightColor(const PixelFormat *pxFormat,
-                          const vector<UINT8> &pixels,
-                          size_t offset);
-  void fillRawComponents(const PixelFormat *pxFormat,
-                         UINT8 components[],
-                         const vector<UINT8> &pixels,
-                         size_t pixelOffset);
+  // Draws the pixels decompressed by JpegDecompressor, either in the frame
+  // buffer format (isDirect is true) or in RGB.
+  void drawJpeg(FrameBuffer *fb,
+                const UINT8 *pixels,
+                size_t pixelsLength,
+                const Rect *dstRect,
+                bool isDirect);
+  void drawDirectBytes(FrameBuffer *fb,
+                       const UINT8 *pixels,
+                       size_t pixelsLength,
+                       const Rect *dstRect);
+
+  // Throws an exception if there is less decoded data than expected.
+  void checkDataLength(size_t pixelsLength, size_t expectedLength);
 
   UINT32 transformPixelToTight(UINT32 color);
-  vector<UINT8> TightDecoder::transformArray(const vector<UINT8> &buffer);
 
   vector<Inflater *> m_inflater;
   JpegDecompressor m_jpeg;
 
+  // Scratch buffers, reused by all rectangles. They only grow, so the
+  // decoder doesn't allocate memory once they have reached their working
+  // size.
+  vector<UINT8> m_compressedData;
+  vector<UINT8> m_pixelData;
+  vector<UINT32> m_palette;
+  vector<UINT16> m_gradientRows;
+
+  // Worker threads decompressing JPEG rectangles, 0 if parallel
+  // decompression is disabled.
+  JpegDecompressorPool *m_decompressorPool;
+  // Submitted jobs, in the order of the update. They are drawn in the same
+  // order, on the frame buffer m_pendingFb.
+  std::deque<JpegDecompressionJob *> m_pendingJobs;
+  FrameBuffer *m_pendingFb;
+  // Finished jobs, they are reused so that their buffers are allocated once.
+  std::vector<JpegDecompressionJob *> m_freeJobs;
+  // True if the last rectangle has been submitted to m_decompressorPool.
+  bool m_isRectPending;
+
+  // Lock and notifier of the frame buffer, passed to process().
+  LocalMutex *m_fbLock;
+  FbUpdateNotifier *m_fbNotifier;
+
   bool m_isCPixel;
 private:
   static const int MAX_SUBENCODING = 0x09;
@@ -111,6 +184,9 @@ private:
   static const int DECODERS_NUM = 4;
 
   static const int MIN_SIZE_TO_COMPRESS = 12;
+
+  // Maximum number of threads to use for JPEG decompression.
+  static const int MAX_THREAD_COUNT = 16;
 };
 
 #endif
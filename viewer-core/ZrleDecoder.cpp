@@ -25,6 +25,7 @@
 #include "ZrleDecoder.h"
 
 #include "io-lib/ByteArrayInputStream.h"
+#include "RowBlitter.h"
 
 #include <vector>
 
@@ -32,20 +33,26 @@ ZrleDecoder::ZrleDecoder(LogWriter *logWriter)
 : DecoderOfRectangle(logWriter)
 {
   m_encoding = EncodingDefs::ZRLE;
+
+  m_tilePixels.resize(TILE_SIZE * TILE_SIZE * 4);
 }
 
 ZrleDecoder::~ZrleDecoder()
 {
 }
 
+bool ZrleDecoder::isDecodingInPlace() const
+{
+  return true;
+}
+
 void ZrleDecoder::decode(RfbInputGate *input,
                          FrameBuffer *frameBuffer,
                          const Rect *dstRect)
 {
   size_t maxUnpackedSize = getMaxSizeOfRectangle(dstRect);
-  readAndInflate(input, maxUnpackedSize);
+  size_t unpackedDataSize = readAndInflate(input, maxUnpackedSize);
 
-  size_t unpackedDataSize = m_inflater.getOutputSize();
   if (unpackedDataSize == 0) {
     m_logWriter->debug(_T("Empty unpacked data (zrle-decoder)"));
     if (dstRect->area() != 0) {
@@ -55,11 +62,8 @@ void ZrleDecoder::decode(RfbInputGate *input,
     return;
   }
 
-  vector<unsigned char> unpackedData;
-  unpackedData.resize(unpackedDataSize);
-  unpackedData.assign(m_inflater.getOutput(), m_inflater.getOutput() + unpackedDataSize);
-  ByteArrayInputStream unpackedByteArrayStream(reinterpret_cast<char *>(&unpackedData.front()),
-                                               unpackedData.size());
+  ByteArrayInputStream unpackedByteArrayStream(&m_unpackedData.front(),
+                                               unpackedDataSize);
   DataInputStream unpackedDataStream(&unpackedByteArrayStream);
 
   m_numberFirstByte = 0;
@@ -95,10 +99,7 @@ void ZrleDecoder::decode(RfbInputGate *input,
       if (!frameBuffer->getDimension().getRect().intersection(&tileRect).isEqualTo(&tileRect)) {
         throw Exception(_T("Error in protocol: incorrect size of tile (zrle-decoder)"));
       }
-      size_t tileLength = tileRect.area();
-      size_t tileBytesLength = tileLength * m_bytesPerPixel;
-      vector<char> pixels;
-      pixels.resize(tileBytesLength);
+      vector<char> &pixels = m_tilePixels;
 
       int type = readType(&unpackedDataStream);
 
@@ -111,39 +112,35 @@ void ZrleDecoder::decode(RfbInputGate *input,
       } else if (type >= 2 && type <= 16) {
         // packed palette
         readPackedPaletteTile(&unpackedDataStream, pixels, &tileRect, type);
-      } else if (type >= 17 && type <= 127) {
-        // unused (no advantage over palette RLE)
-      } if (type == 128) {
+      } else if (type == 128) {
         // plain rle
         readPlainRleTile(&unpackedDataStream, pixels, &tileRect);
-      } if (type == 129) {
-        // invalid type
+      } else if (type >= 130 && type <= 255) {
+        // palette rle
+        readPaletteRleTile(&unpackedDataStream, pixels, &tileRect, type);
+      } else {
+        // 17..127 and 129 are unused, the pixels of such a tile are
+        // unknown.
         StringStorage error;
         error.format(_T("Error: subencoding %d of Zrle encoding is unused"), type);
         throw Exception(error.getString());
-      } if (type >= 130 && type <= 255) {
-        // palette rle
-        readPaletteRleTile(&unpackedDataStream, pixels, &tileRect, type);
       }
 
+      DrawingLock drawingLock(this);
       drawTile(frameBuffer, &tileRect, &pixels);
     } // tile(x, y)
   } // tile(..., y)
 }
 
-void ZrleDecoder::readAndInflate(RfbInputGate *input, size_t maximalUnpackedSize)
+size_t ZrleDecoder::readAndInflate(RfbInputGate *input, size_t maximalUnpackedSize)
 {
   UINT32 length = input->readUInt32();
-  std::vector<char> zlibData;
-  zlibData.resize(length);
-  if (length == 0) {
-    zlibData.resize(1);
-  }
-  input->readFully(&zlibData.front(), length);
+  reserveScratch(&m_zlibData, max(length, (UINT32)1));
+  input->readFully(&m_zlibData.front(), length);
 
-  m_inflater.setInput(&zlibData.front(), length);
-  m_inflater.setUnpackedSize(maximalUnpackedSize);
-  m_inflater.inflate();
+  reserveScratch(&m_unpackedData, Inflater::getOutputCapacity(maximalUnpackedSize));
+  m_inflater.setInput(&m_zlibData.front(), length);
+  return m_inflater.inflate(&m_unpackedData.front(), m_unpackedData.size());
 }
 
 size_t ZrleDecoder::getMaxSizeOfRectangle(const Rect *dstRect)
@@ -175,7 +172,8 @@ void ZrleDecoder::readPalette(DataInputStream *input,
                               const int paletteSize,
                               Palette *palette)
 {
-  palette->resize(paletteSize);
+  // assign() keeps the capacity, so the palette is allocated only once.
+  palette->assign(paletteSize, 0);
 
   for (int i = 0; i < paletteSize; i++) {
     input->readFully(&(*palette)[i] + m_numberFirstByte, m_bytesPerPixel);
@@ -217,7 +215,7 @@ void ZrleDecoder::readPackedPaletteTile(DataInputStream *input,
 
   // type and palette size is equal
   int paletteSize = type;
-  Palette palette;
+  Palette &palette = m_palette;
   readPalette(input, paletteSize, &palette);
 
   int m = 0;
@@ -274,7 +272,7 @@ void ZrleDecoder::readPlainRleTile(DataInputStream *input,
     // TODO: refactor this
     for(size_t i = 0; i < runLength; i++) {
       // FIXME: add check this condition in all similar areas.
-      if (indexPixel + m_bytesPerPixel <= pixels.size()) {
+      if (indexPixel + m_bytesPerPixel <= tileLength * m_bytesPerPixel) {
         memcpy(&pixels[indexPixel], color, m_bytesPerPixel);
       } else {
         throw Exception(_T("Corrupt protocol in Zrle-decoder (plain rle tile)."));
@@ -292,7 +290,7 @@ void ZrleDecoder::readPaletteRleTile(DataInputStream *input,
   size_t tileLength = tileRect->area();
 
   int paletteSize = type - 128;
-  Palette palette;
+  Palette &palette = m_palette;
   readPalette(input, paletteSize, &palette);
 
   for (size_t indexPixel = 0; indexPixel < tileLength;) {
@@ -318,23 +316,19 @@ void ZrleDecoder::drawTile(FrameBuffer *fb,
                            const vector<char> *pixels)
 {
   int width = tileRect->getWidth();
-  size_t fbBytesPerPixel = m_bytesPerPixel;
-
-  if (fbBytesPerPixel == 3) {
-    fbBytesPerPixel = 4;
-  }
+  int height = tileRect->getHeight();
 
-  int tileLength = tileRect->area();
-
-  int x = tileRect->left;
-  int y = tileRect->top;
-   
-  const char *pixelsPtr = &pixels->front();
-  char *bufferPtr = 0;
-  for (int i = 0; i < tileLength; i++) {
-    bufferPtr = (char*)fb->getBufferPtr(x + i % width, y + i / width);
-    memset(bufferPtr, 0, fbBytesPerPixel);
-    memcpy(bufferPtr, pixelsPtr, m_bytesPerPixel);
-    pixelsPtr+=m_bytesPerPixel;
+  size_t srcStride = width * m_bytesPerPixel;
+  size_t dstStride = fb->getBytesPerRow();
+  UINT8 *dst = (UINT8 *)fb->getBufferPtr(tileRect->left, tileRect->top);
+  const UINT8 *src = (const UINT8 *)&pixels->front();
+  for (int y = 0; y < height; y++, dst += dstStride, src += srcStride) {
+    if (m_bytesPerPixel == 3) {
+      // CPIXEL: the upper byte of the frame buffer pixel is zero.
+      RowBlitter::expandCPixelRow((UINT32 *)dst, src, width,
+                                  RowBlitter::FIRST_BYTE_LOW);
+    } else {
+      RowBlitter::copyRow(dst, src, width, m_bytesPerPixel);
+    }
   }
 }
@@ -40,12 +40,16 @@ protected:
   typedef vector<unsigned int> Palette;
 
 protected:
+  virtual bool isDecodingInPlace() const;
+
   virtual void decode(RfbInputGate *input,
                       FrameBuffer *frameBuffer,
                       const Rect *dstRect);
 
 
-  void readAndInflate(RfbInputGate *input, size_t maximalUnpackedSize);
+  // Reads the zlib data and inflates it into m_unpackedData.
+  // Returns the size of the unpacked data.
+  size_t readAndInflate(RfbInputGate *input, size_t maximalUnpackedSize);
 
   int readType(DataInputStream *input);
 
@@ -83,6 +87,15 @@ protected:
                 const vector<char> *pixels);
 
   Inflater m_inflater;
+
+  // Scratch buffers, reused by all rectangles. m_tilePixels has place for
+  // the largest tile, the other buffers only grow, so the decoder doesn't
+  // allocate memory once they have reached their working size.
+  vector<char> m_zlibData;
+  vector<char> m_unpackedData;
+  vector<char> m_tilePixels;
+  Palette m_palette;
+
   size_t m_bytesPerPixel;
   size_t m_numberFirstByte;
 
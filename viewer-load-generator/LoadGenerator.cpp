@@ -0,0 +1,168 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "LoadGenerator.h"
+
+#include "win-system/WindowsEvent.h"
+
+// Delay between starting sessions, so that the server would not get all the
+// connections at once.
+static const DWORD SESSION_START_INTERVAL = 20;
+
+LoadGenerator::LoadGenerator(const LoadSessionOptions *options,
+                             int numSessions)
+: m_options(*options),
+  m_numSessions(numSessions)
+{
+}
+
+LoadGenerator::~LoadGenerator()
+{
+  for (size_t i = 0; i < m_sessions.size(); i++) {
+    delete m_sessions[i];
+  }
+}
+
+void LoadGenerator::run(unsigned int durationSeconds)
+{
+  WindowsEvent sleepEvent;
+
+  for (int i = 0; i < m_numSessions; i++) {
+    LoadSession *session = new LoadSession(&m_options);
+    m_sessions.push_back(session);
+    try {
+      session->start();
+    } catch (Exception &e) {
+      _ftprintf(stderr, _T("Session %d: cannot connect: %s\n"),
+                i + 1, e.getMessage());
+    }
+    sleepEvent.waitForEvent(SESSION_START_INTERVAL);
+  }
+
+  UINT64 lastUpdates = 0;
+  for (unsigned int second = 0; second < durationSeconds; second++) {
+    sleepEvent.waitForEvent(1000);
+
+    UINT64 numUpdates = 0;
+    int numConnected = 0;
+    for (size_t i = 0; i < m_sessions.size(); i++) {
+      LoadSessionStatistics stats;
+      m_sessions[i]->getStatistics(&stats);
+      numUpdates += stats.numUpdates;
+      if (stats.connected && stats.error.isEmpty()) {
+        numConnected++;
+      }
+    }
+    _tprintf(_T("%4u s: %d sessions active, %.1f updates/s in total\n"),
+             second + 1, numConnected, (double)(numUpdates - lastUpdates));
+    lastUpdates = numUpdates;
+  }
+
+  m_results.clear();
+  for (size_t i = 0; i < m_sessions.size(); i++) {
+    m_sessions[i]->stop();
+    LoadSessionStatistics stats;
+    m_sessions[i]->getStatistics(&stats);
+    m_results.push_back(stats);
+  }
+}
+
+void LoadGenerator::writeReport(FILE *output, ReportFormat format)
+{
+  if (format == REPORT_JSON) {
+    writeJsonReport(output);
+  } else {
+    writeCsvReport(output);
+  }
+}
+
+void LoadGenerator::writeCsvReport(FILE *output)
+{
+  _ftprintf(output, _T("session,connected,duration_s,updates,fps,rects,")
+                    _T("bytes,mbit_s,avg_decode_ms,avg_latency_ms,")
+                    _T("max_latency_ms,error\n"));
+  for (size_t i = 0; i < m_results.size(); i++) {
+    const LoadSessionStatistics *s = &m_results[i];
+    double seconds = getSeconds(s->duration);
+    double fps = seconds > 0 ? (double)s->numUpdates / seconds : 0.0;
+    double mbits = seconds > 0 ? (double)s->bytesReceived * 8 / seconds / 1000000
+                               : 0.0;
+    // Quotes in the error message would break the CSV format.
+    StringStorage error(s->error);
+    error.replaceChar(_T('"'), _T('\''));
+    _ftprintf(output,
+              _T("%d,%d,%.3f,%I64u,%.2f,%I64u,%I64u,%.3f,%.3f,%.3f,%.3f,\"%s\"\n"),
+              (int)i + 1, s->connected ? 1 : 0, seconds,
+              s->numUpdates, fps, s->numRects, s->bytesReceived, mbits,
+              getAverageMillis(s->decodeTime, s->numUpdates),
+              getAverageMillis(s->latency, s->numUpdates),
+              getSeconds(s->maxLatency) * 1000.0,
+              error.getString());
+  }
+}
+
+void LoadGenerator::writeJsonReport(FILE *output)
+{
+  _ftprintf(output, _T("{\n  \"host\": \"%s\",\n  \"port\": %u,\n")
+                    _T("  \"encoding\": %d,\n  \"jpegQuality\": %d,\n")
+                    _T("  \"compressionLevel\": %d,\n  \"sessions\": [\n"),
+            m_options.host.getString(), (unsigned int)m_options.port,
+            m_options.encoding, m_options.jpegQuality,
+            m_options.compressionLevel);
+  for (size_t i = 0; i < m_results.size(); i++) {
+    const LoadSessionStatistics *s = &m_results[i];
+    double seconds = getSeconds(s->duration);
+    double fps = seconds > 0 ? (double)s->numUpdates / seconds : 0.0;
+    StringStorage error(s->error);
+    error.replaceChar(_T('"'), _T('\''));
+    error.replaceChar(_T('\\'), _T('/'));
+    _ftprintf(output,
+              _T("    {\"session\": %d, \"connected\": %s, ")
+              _T("\"durationSeconds\": %.3f, \"updates\": %I64u, ")
+              _T("\"fps\": %.2f, \"rects\": %I64u, \"bytes\": %I64u, ")
+              _T("\"avgDecodeMs\": %.3f, \"avgLatencyMs\": %.3f, ")
+              _T("\"maxLatencyMs\": %.3f, \"error\": \"%s\"}%s\n"),
+              (int)i + 1, s->connected ? _T("true") : _T("false"), seconds,
+              s->numUpdates, fps, s->numRects, s->bytesReceived,
+              getAverageMillis(s->decodeTime, s->numUpdates),
+              getAverageMillis(s->latency, s->numUpdates),
+              getSeconds(s->maxLatency) * 1000.0,
+              error.getString(),
+              i + 1 < m_results.size() ? _T(",") : _T(""));
+  }
+  _ftprintf(output, _T("  ]\n}\n"));
+}
+
+double LoadGenerator::getSeconds(UINT64 microseconds)
+{
+  return (double)microseconds / 1000000.0;
+}
+
+double LoadGenerator::getAverageMillis(UINT64 microseconds, UINT64 count)
+{
+  if (count == 0) {
+    return 0.0;
+  }
+  return (double)microseconds / (double)count / 1000.0;
+}
@@ -0,0 +1,66 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __LOADGENERATOR_H__
+#define __LOADGENERATOR_H__
+
+#include <stdio.h>
+#include <vector>
+
+#include "LoadSession.h"
+
+// Runs a number of identical viewer sessions against one server and
+// reports per-session statistics.
+class LoadGenerator
+{
+public:
+  enum ReportFormat {
+    REPORT_CSV,
+    REPORT_JSON
+  };
+
+  LoadGenerator(const LoadSessionOptions *options, int numSessions);
+  virtual ~LoadGenerator();
+
+  // Start all the sessions, let them run for the given time printing the
+  // total update rate to the console once a second, then stop them.
+  void run(unsigned int durationSeconds);
+
+  // Write the statistics of all the sessions collected by run().
+  void writeReport(FILE *output, ReportFormat format);
+
+protected:
+  void writeCsvReport(FILE *output);
+  void writeJsonReport(FILE *output);
+
+  static double getSeconds(UINT64 microseconds);
+  static double getAverageMillis(UINT64 microseconds, UINT64 count);
+
+  LoadSessionOptions m_options;
+  int m_numSessions;
+  std::vector<LoadSession *> m_sessions;
+  std::vector<LoadSessionStatistics> m_results;
+};
+
+#endif // __LOADGENERATOR_H__
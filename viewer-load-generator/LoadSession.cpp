@@ -0,0 +1,163 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "LoadSession.h"
+
+#include "network/socket/SocketAddressIPv4.h"
+#include "thread/AutoLock.h"
+#include "util/PreciseTimer.h"
+
+LoadSession::PasswordAuthHandler::
+PasswordAuthHandler(const StringStorage *password)
+: m_password(*password)
+{
+}
+
+void LoadSession::PasswordAuthHandler::getPassword(StringStorage *passString)
+{
+  *passString = m_password;
+}
+
+LoadSession::LoadSession(const LoadSessionOptions *options)
+: m_options(*options),
+  m_authHandler(&options->password),
+  m_socketStream(0),
+  m_countingInput(0),
+  m_input(0),
+  m_output(0),
+  m_startTime(0),
+  m_stopTime(0),
+  m_started(false)
+{
+  m_stats.connected = false;
+  m_stats.duration = 0;
+  m_stats.numUpdates = 0;
+  m_stats.numRects = 0;
+  m_stats.bytesReceived = 0;
+  m_stats.decodeTime = 0;
+  m_stats.latency = 0;
+  m_stats.maxLatency = 0;
+
+  m_authHandler.addAuthCapability(&m_core);
+  m_core.setPreferredEncoding(m_options.encoding);
+  m_core.setJpegQualityLevel(m_options.jpegQuality);
+  m_core.setCompressionLevel(m_options.compressionLevel);
+}
+
+LoadSession::~LoadSession()
+{
+  stop();
+  delete m_input;
+  delete m_output;
+  delete m_countingInput;
+  delete m_socketStream;
+}
+
+void LoadSession::start()
+{
+  SocketAddressIPv4 address(m_options.host.getString(), m_options.port);
+  m_socket.connect(address);
+  m_socket.enableNaggleAlgorithm(false);
+
+  m_socketStream = new SocketStream(&m_socket);
+  m_countingInput = new CountingInputStream(m_socketStream);
+  m_input = new RfbInputGate(m_countingInput);
+  m_output = new RfbOutputGate(m_socketStream);
+
+  {
+    AutoLock al(&m_statsLock);
+    m_startTime = PreciseTimer::getMicroseconds();
+    m_started = true;
+  }
+  m_core.start(m_input, m_output, this, true);
+}
+
+void LoadSession::stop()
+{
+  {
+    AutoLock al(&m_statsLock);
+    if (!m_started) {
+      return;
+    }
+    // Errors caused by closing the connection are not reported.
+    m_started = false;
+    m_stopTime = PreciseTimer::getMicroseconds();
+  }
+
+  m_core.stop();
+  // RemoteViewerCore doesn't close connections given as gates, so the input
+  // thread must be unblocked here.
+  try {
+    m_socketStream->close();
+  } catch (...) {
+  }
+  m_core.waitTermination();
+}
+
+void LoadSession::getStatistics(LoadSessionStatistics *stats)
+{
+  AutoLock al(&m_statsLock);
+  *stats = m_stats;
+  UINT64 endTime = m_stopTime != 0 ? m_stopTime : PreciseTimer::getMicroseconds();
+  stats->duration = m_startTime != 0 ? endTime - m_startTime : 0;
+  if (m_countingInput != 0 && !m_started) {
+    stats->bytesReceived = m_countingInput->getBytesRead();
+  }
+}
+
+void LoadSession::onConnected(RfbOutputGate *output)
+{
+  AutoLock al(&m_statsLock);
+  m_stats.connected = true;
+}
+
+void LoadSession::onDisconnect(const StringStorage *message)
+{
+  AutoLock al(&m_statsLock);
+  if (m_stats.error.isEmpty() && m_started) {
+    m_stats.error = *message;
+  }
+}
+
+void LoadSession::onError(const Exception *exception)
+{
+  AutoLock al(&m_statsLock);
+  if (m_stats.error.isEmpty() && m_started) {
+    m_stats.error.setString(exception->getMessage());
+  }
+}
+
+void LoadSession::onFrameBufferUpdateReceived(int numRects,
+                                              UINT64 decodeTime,
+                                              UINT64 latency)
+{
+  AutoLock al(&m_statsLock);
+  m_stats.numUpdates++;
+  m_stats.numRects += numRects;
+  m_stats.decodeTime += decodeTime;
+  m_stats.latency += latency;
+  if (latency > m_stats.maxLatency) {
+    m_stats.maxLatency = latency;
+  }
+}
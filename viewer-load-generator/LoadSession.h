@@ -0,0 +1,115 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#ifndef __LOADSESSION_H__
+#define __LOADSESSION_H__
+
+#include "viewer-core/RemoteViewerCore.h"
+#include "viewer-core/CoreEventsAdapter.h"
+#include "viewer-core/VncAuthenticationHandler.h"
+#include "network/socket/SocketIPv4.h"
+#include "network/socket/SocketStream.h"
+#include "thread/LocalMutex.h"
+#include "io-lib/CountingInputStream.h"
+
+struct LoadSessionOptions
+{
+  StringStorage host;
+  UINT16 port;
+  StringStorage password;
+  // Preferred encoding (see EncodingDefs).
+  int encoding;
+  // JPEG quality and compression level, -1 means not requested.
+  int jpegQuality;
+  int compressionLevel;
+};
+
+struct LoadSessionStatistics
+{
+  bool connected;
+  // Time in microseconds from connecting to the end of the session.
+  UINT64 duration;
+  UINT64 numUpdates;
+  UINT64 numRects;
+  UINT64 bytesReceived;
+  // Sums of the values reported for each update, in microseconds.
+  UINT64 decodeTime;
+  UINT64 latency;
+  UINT64 maxLatency;
+  StringStorage error;
+};
+
+// One viewer connection which does nothing but receive updates. The
+// RemoteViewerCore requests a new update as soon as the previous one has
+// been decoded, so the session runs as fast as the server can send.
+class LoadSession : public CoreEventsAdapter
+{
+public:
+  LoadSession(const LoadSessionOptions *options);
+  virtual ~LoadSession();
+
+  // Connects to the server and starts the RFB session. Throws Exception if
+  // the connection cannot be established.
+  void start();
+  // Closes the connection and waits until the session threads finish.
+  void stop();
+
+  void getStatistics(LoadSessionStatistics *stats);
+
+  // Inherited from CoreEventsAdapter.
+  virtual void onConnected(RfbOutputGate *output);
+  virtual void onDisconnect(const StringStorage *message);
+  virtual void onError(const Exception *exception);
+  virtual void onFrameBufferUpdateReceived(int numRects,
+                                           UINT64 decodeTime,
+                                           UINT64 latency);
+
+protected:
+  class PasswordAuthHandler : public VncAuthenticationHandler
+  {
+  public:
+    PasswordAuthHandler(const StringStorage *password);
+  protected:
+    virtual void getPassword(StringStorage *passString);
+    StringStorage m_password;
+  };
+
+  LoadSessionOptions m_options;
+  PasswordAuthHandler m_authHandler;
+
+  SocketIPv4 m_socket;
+  SocketStream *m_socketStream;
+  CountingInputStream *m_countingInput;
+  RfbInputGate *m_input;
+  RfbOutputGate *m_output;
+  RemoteViewerCore m_core;
+
+  LocalMutex m_statsLock;
+  LoadSessionStatistics m_stats;
+  UINT64 m_startTime;
+  UINT64 m_stopTime;
+  bool m_started;
+};
+
+#endif // __LOADSESSION_H__
@@ -0,0 +1,163 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+
+#include "LoadGenerator.h"
+#include "network/socket/WindowsSocket.h"
+#include "rfb/EncodingDefs.h"
+#include "util/Exception.h"
+#include "util/StringParser.h"
+#include <stdio.h>
+
+static void printUsage()
+{
+  _ftprintf(stderr,
+            _T("Usage: viewer-load-generator [options] <host>\n")
+            _T("Options:\n")
+            _T("  -port <port>          server port (default 5900)\n")
+            _T("  -password <password>  VNC password\n")
+            _T("  -sessions <n>         number of sessions (default 10)\n")
+            _T("  -duration <seconds>   test duration (default 30)\n")
+            _T("  -encoding <name>      raw, rre, hextile, zrle or tight")
+            _T(" (default tight)\n")
+            _T("  -quality <0..9>       JPEG quality level\n")
+            _T("  -compression <0..9>   compression level\n")
+            _T("  -report <file>        report file (default: console)\n")
+            _T("  -format <csv|json>    report format (default csv)\n"));
+}
+
+static bool parseEncoding(const TCHAR *name, int *encoding)
+{
+  static const struct {
+    const TCHAR *name;
+    int code;
+  } encodings[] = {
+    { _T("raw"), EncodingDefs::RAW },
+    { _T("rre"), EncodingDefs::RRE },
+    { _T("hextile"), EncodingDefs::HEXTILE },
+    { _T("zrle"), EncodingDefs::ZRLE },
+    { _T("tight"), EncodingDefs::TIGHT }
+  };
+  for (size_t i = 0; i < sizeof(encodings) / sizeof(encodings[0]); i++) {
+    if (_tcsicmp(name, encodings[i].name) == 0) {
+      *encoding = encodings[i].code;
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool parseLevel(const TCHAR *str, int *level)
+{
+  return StringParser::parseInt(str, level) && *level >= 0 && *level <= 9;
+}
+
+int _tmain(int argc, TCHAR *argv[])
+{
+  LoadSessionOptions options;
+  options.port = 5900;
+  options.encoding = EncodingDefs::TIGHT;
+  options.jpegQuality = -1;
+  options.compressionLevel = -1;
+  int numSessions = 10;
+  int duration = 30;
+  const TCHAR *reportFile = 0;
+  LoadGenerator::ReportFormat format = LoadGenerator::REPORT_CSV;
+
+  bool valid = true;
+  for (int i = 1; i < argc && valid; i++) {
+    const TCHAR *arg = argv[i];
+    const TCHAR *value = i + 1 < argc ? argv[i + 1] : 0;
+    if (arg[0] != _T('-')) {
+      if (!options.host.isEmpty()) {
+        valid = false;
+      }
+      options.host.setString(arg);
+      continue;
+    }
+    if (value == 0) {
+      valid = false;
+      break;
+    }
+    i++;
+    int intValue;
+    if (_tcscmp(arg, _T("-port")) == 0) {
+      valid = StringParser::parseInt(value, &intValue) &&
+              intValue > 0 && intValue < 65536;
+      options.port = (UINT16)intValue;
+    } else if (_tcscmp(arg, _T("-password")) == 0) {
+      options.password.setString(value);
+    } else if (_tcscmp(arg, _T("-sessions")) == 0) {
+      valid = StringParser::parseInt(value, &numSessions) && numSessions > 0;
+    } else if (_tcscmp(arg, _T("-duration")) == 0) {
+      valid = StringParser::parseInt(value, &duration) && duration > 0;
+    } else if (_tcscmp(arg, _T("-encoding")) == 0) {
+      valid = parseEncoding(value, &options.encoding);
+    } else if (_tcscmp(arg, _T("-quality")) == 0) {
+      valid = parseLevel(value, &options.jpegQuality);
+    } else if (_tcscmp(arg, _T("-compression")) == 0) {
+      valid = parseLevel(value, &options.compressionLevel);
+    } else if (_tcscmp(arg, _T("-report")) == 0) {
+      reportFile = value;
+    } else if (_tcscmp(arg, _T("-format")) == 0) {
+      if (_tcsicmp(value, _T("json")) == 0) {
+        format = LoadGenerator::REPORT_JSON;
+      } else if (_tcsicmp(value, _T("csv")) == 0) {
+        format = LoadGenerator::REPORT_CSV;
+      } else {
+        valid = false;
+      }
+    } else {
+      valid = false;
+    }
+  }
+  if (!valid || options.host.isEmpty()) {
+    printUsage();
+    return 1;
+  }
+
+  try {
+    WindowsSocket::startup(2, 1);
+
+    LoadGenerator generator(&options, numSessions);
+    generator.run(duration);
+
+    FILE *output = stdout;
+    if (reportFile != 0) {
+      output = _tfopen(reportFile, _T("wt"));
+      if (output == 0) {
+        StringStorage errMess;
+        errMess.format(_T("Cannot open the %s file"), reportFile);
+        throw Exception(errMess.getString());
+      }
+    }
+    generator.writeReport(output, format);
+    if (output != stdout) {
+      fclose(output);
+    }
+  } catch (Exception &e) {
+    _ftprintf(stderr, _T("Error: %s\n"), e.getMessage());
+    return 1;
+  }
+  return 0;
+}
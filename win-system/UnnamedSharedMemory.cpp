@@ -0,0 +1,127 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#include "UnnamedSharedMemory.h"
+#include "Environment.h"
+#include "util/Exception.h"
+
+UnnamedSharedMemory::UnnamedSharedMemory(size_t size, bool reserveOnly)
+: m_hSection(0),
+  m_memory(0),
+  m_size(size)
+{
+  DWORD lowSize = size & 0xffffffff;
+  DWORD highSize = (DWORD64)size >> 32 & 0xffffffff;
+
+  DWORD protect = PAGE_READWRITE;
+  if (reserveOnly) {
+    protect |= SEC_RESERVE;
+  }
+  m_hSection = CreateFileMapping(INVALID_HANDLE_VALUE, // use paging file
+                                 0,                    // default security
+                                 protect,
+                                 highSize,
+                                 lowSize,
+                                 0);                   // no name
+  if (m_hSection == NULL) {
+    m_hSection = 0;
+    StringStorage errText;
+    Environment::getErrStr(_T("Cannot create file mapping"), &errText);
+    throw Exception(errText.getString());
+  }
+  try {
+    mapViewOfFile();
+  } catch (...) {
+    freeRes();
+    throw;
+  }
+}
+
+UnnamedSharedMemory::UnnamedSharedMemory(HANDLE hSection, size_t size)
+: m_hSection(hSection),
+  m_memory(0),
+  m_size(size)
+{
+  try {
+    mapViewOfFile();
+  } catch (...) {
+    freeRes();
+    throw;
+  }
+}
+
+UnnamedSharedMemory::~UnnamedSharedMemory()
+{
+  freeRes();
+}
+
+HANDLE UnnamedSharedMemory::duplicateHandleFor(HANDLE hTargetProc)
+{
+  HANDLE hTarget = 0;
+  if (DuplicateHandle(GetCurrentProcess(), m_hSection, hTargetProc, &hTarget,
+                      0, FALSE, DUPLICATE_SAME_ACCESS) == 0) {
+    StringStorage errText;
+    Environment::getErrStr(_T("Cannot duplicate the shared memory handle"),
+                           &errText);
+    throw Exception(errText.getString());
+  }
+  return hTarget;
+}
+
+void UnnamedSharedMemory::commit(size_t size)
+{
+  if (size > m_size) {
+    throw Exception(_T("Cannot commit more than the shared memory size"));
+  }
+  if (size == 0) {
+    return;
+  }
+  if (VirtualAlloc(m_memory, size, MEM_COMMIT, PAGE_READWRITE) == NULL) {
+    StringStorage errText;
+    Environment::getErrStr(_T("Cannot commit shared memory"), &errText);
+    throw Exception(errText.getString());
+  }
+}
+
+void UnnamedSharedMemory::mapViewOfFile()
+{
+  m_memory = MapViewOfFile(m_hSection, FILE_MAP_WRITE, 0, 0, m_size);
+  if (m_memory == NULL) {
+    m_memory = 0;
+    StringStorage errText;
+    Environment::getErrStr(_T("Cannot map view of file"), &errText);
+    throw Exception(errText.getString());
+  }
+}
+
+void UnnamedSharedMemory::freeRes()
+{
+  if (m_memory != 0) {
+    UnmapViewOfFile(m_memory);
+    m_memory = 0;
+  }
+  if (m_hSection != 0) {
+    CloseHandle(m_hSection);
+    m_hSection = 0;
+  }
+}
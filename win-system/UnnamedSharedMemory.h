@@ -0,0 +1,68 @@
+// Copyright (C) 2012 GlavSoft LLC.
+// All rights reserved.
+//
+//-------------------------------------------------------------------------
+// This file is part of the TightVNC software.  Please visit our Web site:
+//
+//                       http://www.tightvnc.com/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//-------------------------------------------------------------------------
+//
+#ifndef __UNNAMEDSHAREDMEMORY_H__
+#define __UNNAMEDSHAREDMEMORY_H__
+
+#include "util/CommonHeader.h"
+
+// Shared memory section without a name, so that no other process can open
+// it. The creator passes the section to another process by duplicating its
+// handle to that process (like the AnonymousPipe handles).
+class UnnamedSharedMemory
+{
+public:
+  // Creates a new section of the given size. If reserveOnly is true the
+  // section only reserves the memory and the pages must be committed by
+  // the commit() function before they are touched by any process.
+  // @throw Exception
+  UnnamedSharedMemory(size_t size, bool reserveOnly = false);
+  // Maps an existing section. The object takes the ownership of the handle.
+  // @throw Exception
+  UnnamedSharedMemory(HANDLE hSection, size_t size);
+  virtual ~UnnamedSharedMemory();
+
+  void *getMemPointer() { return m_memory; }
+  size_t getSize() const { return m_size; }
+
+  // Commits the first size bytes of the section. The pages become
+  // available for every process that maps the section. Committing the
+  // pages that are already committed is not an error.
+  // @throw Exception
+  void commit(size_t size);
+
+  // Duplicates the section handle to the target process and returns the
+  // handle value that is valid in that process.
+  // @throw Exception
+  HANDLE duplicateHandleFor(HANDLE hTargetProc);
+
+private:
+  void mapViewOfFile();
+  void freeRes();
+
+  HANDLE m_hSection;
+  void *m_memory;
+  size_t m_size;
+};
+
+#endif // __UNNAMEDSHAREDMEMORY_H__